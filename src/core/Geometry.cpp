@@ -67,3 +67,51 @@ void BBox::BoundingSphere (Point *c, float *rad) const {
     *c = pMin * .5f + pMax * .5f;
     *rad = Inside (*c) ? Distance (*c, pMax) : 0.f;
 }
+
+bool BBox::IntersectP (const Ray &ray, float *hitt0, float *hitt1) const {
+    const float farScale = 1.f + 2.f * Gamma (3);
+    float t0, t1;
+
+#ifdef PB_RAY_SSE
+    __m128 o = _mm_set_ps (0.f, ray.o.z, ray.o.y, ray.o.x);
+    __m128 inv = _mm_div_ps (_mm_set1_ps (1.f),
+                             _mm_set_ps (1.f, ray.d.z, ray.d.y, ray.d.x));
+
+    // Lane 3 carries the ray's own range so that it is folded into the
+    // horizontal min / max below.
+    __m128 tLow = _mm_mul_ps (
+            _mm_sub_ps (_mm_set_ps (ray.mint, pMin.z, pMin.y, pMin.x), o), inv);
+    __m128 tHigh = _mm_mul_ps (
+            _mm_sub_ps (_mm_set_ps (ray.maxt, pMax.z, pMax.y, pMax.x), o), inv);
+
+    // Round the far distances up by their error bound; see the inline
+    // form in Geometry.h.
+    __m128 scale = _mm_set_ps (1.f, farScale, farScale, farScale);
+
+    t0 = HorizontalMax (_mm_min_ps (tLow, tHigh));
+    t1 = HorizontalMin (_mm_mul_ps (_mm_max_ps (tLow, tHigh), scale));
+#else
+    t0 = ray.mint;
+    t1 = ray.maxt;
+
+    for (int i = 0; i < 3; ++i) {
+        // Update the interval for the i'th bounding box slab.
+        float invRayDir = 1.f / ray.d[i];
+        float tNear = (pMin[i] - ray.o[i]) * invRayDir;
+        float tFar = (pMax[i] - ray.o[i]) * invRayDir;
+
+        t0 = max (t0, min (tNear, tFar));
+        t1 = min (t1, max (tNear, tFar) * farScale);
+    }
+#endif
+
+    if (t0 > t1)
+        return false;
+
+    if (hitt0)
+        *hitt0 = t0;
+    if (hitt1)
+        *hitt1 = t1;
+
+    return true;
+}
@@ -32,6 +32,7 @@
 #define GEOMETRY_H
 
 #include "pb_ray.h"
+#include "simd.h"
 
 /***************
  ***************
@@ -44,7 +45,9 @@ class Vector;
 class Point;
 class Normal;
 class Ray;
+class CompactRay;
 class RayDifferential;
+class CompactRayDifferential;
 class BBox;
 
 
@@ -53,8 +56,16 @@ class BBox;
  * Global Constants
  ***************
  ***************/
+
+// The default start of a ray. Rays leaving a surface should instead be
+//      made with Intersection::SpawnRay, which offsets the origin by the
+//      hit point's error bounds and needs no epsilon at all.
 #define RAY_EPSILON 1e-3f
 
+// The fraction of a shadow ray's length left off its far end so that it
+//      doesn't hit the surface it is aimed at.
+#define SHADOW_EPSILON 1e-4f
+
 
 /***************
  ***************
@@ -238,7 +249,7 @@ class Point {
         // Operators for adding and subracting Points from
         //  each other to get a new Point instead of a Vector.
         Point operator+ (const Point &p) const {
-            return Point (x + p.x, y + p.y, z + p.y);
+            return Point (x + p.x, y + p.y, z + p.z);
         }
 
         Point &operator+= (const Point &v) {
@@ -334,6 +345,8 @@ class Normal {
         {
         }
 
+        explicit Normal (const Vector &v); // Force an explicit conversion.
+
 
         // Operators
         Normal operator+(const Normal &v) const {
@@ -479,6 +492,67 @@ class Ray {
 };
 
 
+////////////////////
+// Class: CompactRay
+//
+// Purpose:
+//      A Ray packed into 32 aligned bytes for ray queues: the origin and
+//      the direction each fill a 16 byte SSE register, with maxt in the
+//      direction's fourth lane and mint and time sharing the origin's. Ray
+//      is 36 bytes with no particular alignment, so a queue of them
+//      straddles cache lines and needs unaligned loads.
+//
+//      mint keeps the top 16 bits of its float (a bfloat16: the full
+//      exponent and 7 bits of mantissa). Dropping the rest rounds it
+//      towards zero, so a CompactRay never excludes a hit the Ray it came
+//      from would have found. time is a half, which keeps about three
+//      decimal digits: enough to pick a point in a shutter interval.
+////////////////////
+class alignas(32) CompactRay {
+    public:
+        ///////////////
+        // Data Members
+        ///////////////
+        float ox, oy, oz;
+        uint16_t mint, time;    // See MinT and Time.
+        float dx, dy, dz;
+        float maxt;
+
+
+        ///////////////
+        // Constructors
+        ///////////////
+        CompactRay() { }
+
+        explicit CompactRay (const Ray &r)
+                : ox(r.o.x), oy(r.o.y), oz(r.o.z),
+                  mint(uint16_t (FloatToBits (r.mint) >> 16)),
+                  time(FloatToHalf (r.time)),
+                  dx(r.d.x), dy(r.d.y), dz(r.d.z), maxt(r.maxt) { }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        Point O() const { return Point (ox, oy, oz); }
+        Vector D() const { return Vector (dx, dy, dz); }
+        float MinT() const { return BitsToFloat (uint32_t (mint) << 16); }
+        float Time() const { return HalfToFloat (time); }
+
+        Ray ToRay() const { return Ray (O(), D(), MinT(), maxt, Time()); }
+
+#ifdef PB_RAY_SSE
+        // The origin (lane 3 holds the packed mint and time) and the
+        // direction (lane 3 holds maxt), each with one aligned load.
+        __m128 LoadOrigin() const { return _mm_load_ps (&ox); }
+        __m128 LoadDirection() const { return _mm_load_ps (&dx); }
+#endif
+};
+
+static_assert (sizeof (CompactRay) == 32,
+               "CompactRay should be exactly 32 bytes");
+
+
 ////////////////////
 // Class: RayDifferential
 //
@@ -519,6 +593,115 @@ class RayDifferential : public Ray {
 };
 
 
+////////////////////
+// Class: CompactRayDifferential
+//
+// Purpose:
+//      A RayDifferential that keeps only the change in origin and direction
+//      per pixel in x and y (dp/dx, dp/dy, dd/dx, dd/dy), in half
+//      precision, instead of two whole auxiliary rays. That makes it one 64
+//      byte cache line where RayDifferential takes 112, which matters for
+//      rays held in queues. The auxiliary rays are rebuilt only when asked
+//      for with RayX, RayY or Expand.
+//
+//      Half precision keeps about three decimal digits, which is plenty for
+//      differentials: they only pick texture filter widths.
+//
+// Inherits From: Ray
+////////////////////
+class CompactRayDifferential : public Ray {
+    public:
+        ///////////////
+        // Data Members
+        ///////////////
+        bool hasDifferentials;
+
+
+        ///////////////
+        // Constructors
+        ///////////////
+        CompactRayDifferential() : hasDifferentials(false) { }
+
+        CompactRayDifferential (const Point &org, const Vector &dir)
+                : Ray (org, dir), hasDifferentials(false) { }
+
+        explicit CompactRayDifferential (const Ray &ray)
+                : Ray (ray), hasDifferentials(false) { }
+
+        explicit CompactRayDifferential (const RayDifferential &rd)
+                : Ray (rd), hasDifferentials(false) {
+            if (rd.hasDifferentials)
+                SetDifferentials (rd.rx.o - rd.o, rd.ry.o - rd.o,
+                                  rd.rx.d - rd.d, rd.ry.d - rd.d);
+        }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        void SetDifferentials (const Vector &dpdx, const Vector &dpdy,
+                               const Vector &dddx, const Vector &dddy) {
+            Pack (0, dpdx);
+            Pack (1, dpdy);
+            Pack (2, dddx);
+            Pack (3, dddy);
+            hasDifferentials = true;
+        }
+
+        Vector DpDx() const { return Unpack (0); }
+        Vector DpDy() const { return Unpack (1); }
+        Vector DdDx() const { return Unpack (2); }
+        Vector DdDy() const { return Unpack (3); }
+
+        // The rays through the neighbouring pixels.
+        Ray RayX() const {
+            return Ray (o + DpDx(), d + DdDx(), mint, maxt, time);
+        }
+
+        Ray RayY() const {
+            return Ray (o + DpDy(), d + DdDy(), mint, maxt, time);
+        }
+
+        RayDifferential Expand() const {
+            RayDifferential rd (*this);
+
+            if (hasDifferentials) {
+                rd.rx = RayX();
+                rd.ry = RayY();
+                rd.hasDifferentials = true;
+            }
+
+            return rd;
+        }
+
+        // Scale the differentials for a pixel spacing of s pixels, as when
+        // taking several samples per pixel.
+        void ScaleDifferentials (float s) {
+            if (hasDifferentials)
+                SetDifferentials (DpDx() * s, DpDy() * s, DdDx() * s,
+                                  DdDy() * s);
+        }
+
+    private:
+        void Pack (int i, const Vector &v) {
+            differentials[i][0] = FloatToHalf (v.x);
+            differentials[i][1] = FloatToHalf (v.y);
+            differentials[i][2] = FloatToHalf (v.z);
+        }
+
+        Vector Unpack (int i) const {
+            return Vector (HalfToFloat (differentials[i][0]),
+                           HalfToFloat (differentials[i][1]),
+                           HalfToFloat (differentials[i][2]));
+        }
+
+        uint16_t differentials[4][3];
+};
+
+static_assert (sizeof (CompactRayDifferential) == 64,
+               "CompactRayDifferential should fill one cache line");
+
+
 
 ////////////////////
 // Class: BBox
@@ -640,16 +823,29 @@ class BBox {
 		}
 
         Vector Offset (const Point &p) const {
-            // A degenerate bounding box (by my definition where the corner
-            // points are the same) will crash this.
-            // - My assumption is that the book presumes that there will never
-            //   be a degenerate bounding box.
-            return Vector ((p.x - pMin.x) / (pMax.x - pMin.x),
-                           (p.y - pMin.y) / (pMax.x - pMin.y),
-                           (p.z - pMin.z) / (pMax.z - pMin.z));
+            // Along an axis where the box is flat every point is at
+            // offset 0 rather than dividing by zero.
+            Vector o = p - pMin;
+
+            o.x = pMax.x > pMin.x ? o.x / (pMax.x - pMin.x) : 0.f;
+            o.y = pMax.y > pMin.y ? o.y / (pMax.y - pMin.y) : 0.f;
+            o.z = pMax.z > pMin.z ? o.z / (pMax.z - pMin.z) : 0.f;
+
+            return o;
         }
 
         void BoundingSphere (Point*, float*) const;
+
+        // Ray-box slab tests.
+        //      The first form computes the reciprocal direction itself and
+        //      reports the parametric range [t0, t1] of the ray that lies
+        //      inside the box. The second is the one traversal code should
+        //      use: the caller precomputes 1/d and the sign of each
+        //      direction component once per ray.
+        bool IntersectP (const Ray &ray, float *hitt0 = NULL,
+                         float *hitt1 = NULL) const;
+        inline bool IntersectP (const Ray &ray, const Vector &invDir,
+                                const int dirIsNeg[3]) const;
 };
 
 
@@ -699,6 +895,10 @@ inline Vector::Vector (const Normal &n)
     : x(n.x), y(n.y), z(n.z) {
 }
 
+inline Normal::Normal (const Vector &v)
+    : x(v.x), y(v.y), z(v.z) {
+}
+
 
 /***************
  ***************
@@ -716,6 +916,72 @@ inline Point &BBox::operator[](int i) {
 }
 
 
+////////////////////
+// Function:
+//      BBox::IntersectP
+//
+// Purpose:
+//      Branch-free slab test of a ray against the box using a precomputed
+//      reciprocal direction. Since the sign of each direction component is
+//      known, the near and far planes of every slab can be picked up front
+//      instead of sorting the two plane distances.
+//
+//      The ray's [mint, maxt] range rides along in the fourth SSE lane so
+//      that it takes part in the same horizontal min / max as the slabs.
+//
+//      The far plane distances are rounded up by 2 * Gamma (3), their
+//      largest possible error, so that a ray grazing a box is never culled
+//      before it reaches a primitive that it hits.
+//
+// Parameters:
+//      const Ray &ray - The ray to test.
+//      const Vector &invDir - (1/d.x, 1/d.y, 1/d.z) for the ray.
+//      const int dirIsNeg[3] - 1 for each direction component that is < 0.
+//
+// Returns:
+//      true if the ray overlaps the box within [mint, maxt].
+////////////////////
+inline bool BBox::IntersectP (const Ray &ray, const Vector &invDir,
+                              const int dirIsNeg[3]) const {
+    const BBox &bounds = *this;
+    const float farScale = 1.f + 2.f * Gamma (3);
+
+#ifdef PB_RAY_SSE
+    __m128 nearPlanes = _mm_set_ps (ray.mint,
+                                    bounds[dirIsNeg[2]].z,
+                                    bounds[dirIsNeg[1]].y,
+                                    bounds[dirIsNeg[0]].x);
+    __m128 farPlanes = _mm_set_ps (ray.maxt,
+                                   bounds[1 - dirIsNeg[2]].z,
+                                   bounds[1 - dirIsNeg[1]].y,
+                                   bounds[1 - dirIsNeg[0]].x);
+    __m128 o = _mm_set_ps (0.f, ray.o.z, ray.o.y, ray.o.x);
+    __m128 inv = _mm_set_ps (1.f, invDir.z, invDir.y, invDir.x);
+
+    __m128 tNear = _mm_mul_ps (_mm_sub_ps (nearPlanes, o), inv);
+    __m128 tFar = _mm_mul_ps (_mm_mul_ps (_mm_sub_ps (farPlanes, o), inv),
+                              _mm_set_ps (1.f, farScale, farScale, farScale));
+
+    return HorizontalMax (tNear) <= HorizontalMin (tFar);
+#else
+    float txMin = (bounds[dirIsNeg[0]].x - ray.o.x) * invDir.x;
+    float txMax = (bounds[1 - dirIsNeg[0]].x - ray.o.x) * invDir.x *
+                  farScale;
+    float tyMin = (bounds[dirIsNeg[1]].y - ray.o.y) * invDir.y;
+    float tyMax = (bounds[1 - dirIsNeg[1]].y - ray.o.y) * invDir.y *
+                  farScale;
+    float tzMin = (bounds[dirIsNeg[2]].z - ray.o.z) * invDir.z;
+    float tzMax = (bounds[1 - dirIsNeg[2]].z - ray.o.z) * invDir.z *
+                  farScale;
+
+    float tNear = max (max (txMin, tyMin), max (tzMin, ray.mint));
+    float tFar = min (min (txMax, tyMax), min (tzMax, ray.maxt));
+
+    return tNear <= tFar;
+#endif
+}
+
+
 ////////////////////
 // Function:
 //      Cross
@@ -820,4 +1086,54 @@ inline float DistanceSquared (const Point &p1, const Point &p2) {
     return (p1 - p2).LengthSquared();
 }
 
+
+/***************
+ ***************
+ * Ray Inline Functions
+ ***************
+ ***************/
+
+////////////////////
+// Function:
+//      OffsetRayOrigin
+//
+// Purpose:
+//      Move a point computed with some floating point error off its
+//      surface, so that a ray leaving it can't hit the surface again.
+//
+//      The true point lies somewhere in the box pError around p. The
+//      origin is pushed along the normal, to the side that w leaves on,
+//      just past that box, and then rounded one more float away from the
+//      surface to make up for the rounding of the addition itself.
+//
+// Parameters:
+//      const Point &p - The computed point.
+//      const Vector &pError - Bounds on the error of each component of p.
+//      const Normal &n - The surface normal at p.
+//      const Vector &w - The direction the ray leaves in.
+//
+// Returns:
+//      The ray origin.
+////////////////////
+inline Point OffsetRayOrigin (const Point &p, const Vector &pError,
+                              const Normal &n, const Vector &w) {
+    float d = fabsf (n.x) * pError.x + fabsf (n.y) * pError.y +
+              fabsf (n.z) * pError.z;
+    Vector offset = Vector (n) * d;
+
+    if (Dot (w, n) < 0.f)
+        offset = -offset;
+
+    Point po = p + offset;
+
+    for (int i = 0; i < 3; ++i) {
+        if (offset[i] > 0.f)
+            po[i] = NextFloatUp (po[i]);
+        else if (offset[i] < 0.f)
+            po[i] = NextFloatDown (po[i]);
+    }
+
+    return po;
+}
+
 #endif
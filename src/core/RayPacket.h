@@ -0,0 +1,354 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: RayPacket.h
+ *
+ *  Purpose: Structure-of-arrays ray packets so that coherent rays can be
+ *           pushed through the vector units several at a time.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include <stdint.h>
+
+#include "Geometry.h"
+
+
+////////////////////
+// Class: PointPacket
+//
+// Purpose:
+//      N points stored as three component arrays. This is what a
+//      RayPacket hands back when it is evaluated at N parametric values.
+////////////////////
+template <int N>
+class PointPacket {
+    public:
+        alignas(16) float x[N];
+        alignas(16) float y[N];
+        alignas(16) float z[N];
+
+        Point operator[](int i) const {
+            assert ((i >= 0) && (i < N));
+            return Point (x[i], y[i], z[i]);
+        }
+};
+
+
+////////////////////
+// Class: RayPacket
+//
+// Purpose:
+//      Hold N rays in structure-of-arrays form. Each component of the
+//      origin, direction and parametric range lives in its own array so a
+//      single SIMD load picks up the same component of four (or eight)
+//      rays.
+//
+//      Lanes that don't carry a ray are tracked with the active mask; bit
+//      i is set when lane i holds a live ray. Everything that reports a
+//      per-lane result does so as a mask of the same form, already and-ed
+//      with the active mask.
+//
+//      The reciprocal direction is kept alongside the direction because
+//      every slab test needs it. SetRay() keeps the two in sync; code that
+//      writes the direction arrays directly must call
+//      UpdateInverseDirections() afterwards.
+//
+// Notes:
+//      N must be a multiple of 4 (4, 8 and 16 are the intended sizes) so
+//      that the lanes split evenly into SSE registers.
+////////////////////
+template <int N>
+class RayPacket {
+    static_assert ((N % 4) == 0 && N <= 32,
+                   "RayPacket width must be a multiple of 4, at most 32");
+
+    public:
+        ///////////////
+        // Data Members
+        //      These are public for the same reasons as in Ray.
+        ///////////////
+        alignas(16) float ox[N];
+        alignas(16) float oy[N];
+        alignas(16) float oz[N];
+
+        alignas(16) float dx[N];
+        alignas(16) float dy[N];
+        alignas(16) float dz[N];
+
+        alignas(16) float invDx[N];
+        alignas(16) float invDy[N];
+        alignas(16) float invDz[N];
+
+        alignas(16) float mint[N];
+        alignas(16) float maxt[N];
+        alignas(16) float time[N];
+
+        uint32_t activeMask;
+
+
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // An empty packet; every lane starts out inactive but holds a
+        // default Ray so that inactive lanes never contain garbage.
+        RayPacket() : activeMask(0) {
+            for (int i = 0; i < N; ++i)
+                SetLane (i, Ray());
+        }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        static int Width() { return N; }
+
+        bool IsActive (int i) const {
+            return (activeMask & (1u << i)) != 0;
+        }
+
+        // Store a ray in lane i and mark it active.
+        void SetRay (int i, const Ray &r) {
+            SetLane (i, r);
+            activeMask |= (1u << i);
+        }
+
+        // Rebuild the Ray held in lane i.
+        Ray GetRay (int i) const {
+            assert ((i >= 0) && (i < N));
+            return Ray (Point (ox[i], oy[i], oz[i]),
+                        Vector (dx[i], dy[i], dz[i]),
+                        mint[i], maxt[i], time[i]);
+        }
+
+        void Deactivate (int i) {
+            activeMask &= ~(1u << i);
+        }
+
+        void UpdateInverseDirections() {
+            for (int i = 0; i < N; ++i) {
+                invDx[i] = 1.f / dx[i];
+                invDy[i] = 1.f / dy[i];
+                invDz[i] = 1.f / dz[i];
+            }
+        }
+
+
+        ///////////////
+        // Operators
+        ///////////////
+
+        // Find the point at t[i] along each ray.
+        PointPacket<N> operator()(const float t[N]) const {
+            PointPacket<N> p;
+
+            for (int i = 0; i < N; ++i) {
+                p.x[i] = ox[i] + dx[i] * t[i];
+                p.y[i] = oy[i] + dy[i] * t[i];
+                p.z[i] = oz[i] + dz[i] * t[i];
+            }
+
+            return p;
+        }
+
+    private:
+        void SetLane (int i, const Ray &r) {
+            assert ((i >= 0) && (i < N));
+
+            ox[i] = r.o.x; oy[i] = r.o.y; oz[i] = r.o.z;
+            dx[i] = r.d.x; dy[i] = r.d.y; dz[i] = r.d.z;
+
+            invDx[i] = 1.f / r.d.x;
+            invDy[i] = 1.f / r.d.y;
+            invDz[i] = 1.f / r.d.z;
+
+            mint[i] = r.mint;
+            maxt[i] = r.maxt;
+            time[i] = r.time;
+        }
+};
+
+
+////////////////////
+// Class: RayDifferentialPacket
+//
+// Purpose:
+//      The packet counterpart of RayDifferential: the main rays plus the
+//      x and y offset rays, each in their own RayPacket. Whether lane i
+//      carries differentials is tracked in a mask like the active lanes.
+//
+// Inherits From: RayPacket
+////////////////////
+template <int N>
+class RayDifferentialPacket : public RayPacket<N> {
+    public:
+        ///////////////
+        // Data Members
+        ///////////////
+        RayPacket<N> rx, ry;
+        uint32_t hasDifferentials;
+
+
+        ///////////////
+        // Constructors
+        ///////////////
+        RayDifferentialPacket() : hasDifferentials(0) { }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        using RayPacket<N>::SetRay;
+
+        void SetRay (int i, const RayDifferential &r) {
+            RayPacket<N>::SetRay (i, r);
+
+            if (r.hasDifferentials) {
+                rx.SetRay (i, r.rx);
+                ry.SetRay (i, r.ry);
+                hasDifferentials |= (1u << i);
+            }
+            else {
+                rx.Deactivate (i);
+                ry.Deactivate (i);
+                hasDifferentials &= ~(1u << i);
+            }
+        }
+
+        RayDifferential GetRayDifferential (int i) const {
+            RayDifferential r (RayPacket<N>::GetRay (i));
+
+            if (hasDifferentials & (1u << i)) {
+                r.rx = rx.GetRay (i);
+                r.ry = ry.GetRay (i);
+                r.hasDifferentials = true;
+            }
+
+            return r;
+        }
+};
+
+
+////////////////////
+// Function:
+//      IntersectP
+//
+// Purpose:
+//      Packet form of BBox::IntersectP. Every active lane of the packet is
+//      slab tested against the box; as in the single ray version each
+//      lane's [mint, maxt] range bounds the overlap.
+//
+//      The direction signs differ between lanes, so the near and far plane
+//      distances are sorted with min / max rather than picked with
+//      dirIsNeg. The far distances are rounded up by their error bound,
+//      as in BBox::IntersectP.
+//
+// Parameters:
+//      const BBox &b - The box to test against.
+//      const RayPacket<N> &rays - The rays to test.
+//      float *hitt0 - Optional; receives the entry distance of each lane.
+//
+// Returns:
+//      A mask with bit i set when lane i is active and hits the box.
+////////////////////
+template <int N>
+inline uint32_t IntersectP (const BBox &b, const RayPacket<N> &rays,
+                            float *hitt0 = NULL) {
+    const float farScale = 1.f + 2.f * Gamma (3);
+    uint32_t hits = 0;
+
+#ifdef PB_RAY_SSE
+    const __m128 minX = _mm_set1_ps (b.pMin.x);
+    const __m128 minY = _mm_set1_ps (b.pMin.y);
+    const __m128 minZ = _mm_set1_ps (b.pMin.z);
+    const __m128 maxX = _mm_set1_ps (b.pMax.x);
+    const __m128 maxY = _mm_set1_ps (b.pMax.y);
+    const __m128 maxZ = _mm_set1_ps (b.pMax.z);
+
+    for (int i = 0; i < N; i += 4) {
+        __m128 ox = _mm_load_ps (&rays.ox[i]);
+        __m128 oy = _mm_load_ps (&rays.oy[i]);
+        __m128 oz = _mm_load_ps (&rays.oz[i]);
+        __m128 ix = _mm_load_ps (&rays.invDx[i]);
+        __m128 iy = _mm_load_ps (&rays.invDy[i]);
+        __m128 iz = _mm_load_ps (&rays.invDz[i]);
+
+        __m128 lx = _mm_mul_ps (_mm_sub_ps (minX, ox), ix);
+        __m128 hx = _mm_mul_ps (_mm_sub_ps (maxX, ox), ix);
+        __m128 ly = _mm_mul_ps (_mm_sub_ps (minY, oy), iy);
+        __m128 hy = _mm_mul_ps (_mm_sub_ps (maxY, oy), iy);
+        __m128 lz = _mm_mul_ps (_mm_sub_ps (minZ, oz), iz);
+        __m128 hz = _mm_mul_ps (_mm_sub_ps (maxZ, oz), iz);
+
+        __m128 t0 = _mm_max_ps (
+                _mm_max_ps (_mm_min_ps (lx, hx), _mm_min_ps (ly, hy)),
+                _mm_max_ps (_mm_min_ps (lz, hz), _mm_load_ps (&rays.mint[i])));
+        __m128 t1 = _mm_min_ps (
+                _mm_mul_ps (_mm_min_ps (_mm_max_ps (lx, hx),
+                                        _mm_max_ps (ly, hy)),
+                            _mm_set1_ps (farScale)),
+                _mm_min_ps (_mm_mul_ps (_mm_max_ps (lz, hz),
+                                        _mm_set1_ps (farScale)),
+                            _mm_load_ps (&rays.maxt[i])));
+
+        hits |= uint32_t (_mm_movemask_ps (_mm_cmple_ps (t0, t1))) << i;
+
+        if (hitt0)
+            _mm_storeu_ps (&hitt0[i], t0);
+    }
+#else
+    for (int i = 0; i < N; ++i) {
+        float lx = (b.pMin.x - rays.ox[i]) * rays.invDx[i];
+        float hx = (b.pMax.x - rays.ox[i]) * rays.invDx[i];
+        float ly = (b.pMin.y - rays.oy[i]) * rays.invDy[i];
+        float hy = (b.pMax.y - rays.oy[i]) * rays.invDy[i];
+        float lz = (b.pMin.z - rays.oz[i]) * rays.invDz[i];
+        float hz = (b.pMax.z - rays.oz[i]) * rays.invDz[i];
+
+        float t0 = max (max (min (lx, hx), min (ly, hy)),
+                        max (min (lz, hz), rays.mint[i]));
+        float t1 = min (min (max (lx, hx), max (ly, hy)) * farScale,
+                        min (max (lz, hz) * farScale, rays.maxt[i]));
+
+        if (t0 <= t1)
+            hits |= (1u << i);
+
+        if (hitt0)
+            hitt0[i] = t0;
+    }
+#endif
+
+    return hits & rays.activeMask;
+}
+
+
+// The packet sizes the renderer is expected to use.
+typedef RayPacket<4> RayPacket4;
+typedef RayPacket<8> RayPacket8;
+typedef RayPacket<16> RayPacket16;
+
+#endif
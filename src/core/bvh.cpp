@@ -0,0 +1,1386 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: bvh.cpp
+ *
+ *  Purpose: Build and traverse the bounding volume hierarchy.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bvh.h"
+#include "memory.h"
+#include "morton.h"
+#include "parallel.h"
+#include "stats.h"
+
+
+// Nodes with at least this many primitives compute their bounds and bins in
+// parallel chunks of kBuildGrainSize primitives.
+static const int kParallelBinningThreshold = 64 * 1024;
+static const int kBuildGrainSize = 16 * 1024;
+
+// Nodes with at least this many primitives build their two subtrees as
+// separate tasks. Below it the task overhead outweighs the work.
+static const int kParallelSubtreeThreshold = 4 * 1024;
+
+// The most primitives a LinearBVHNode can refer to.
+static const int kMaxLeafPrimitives = 0xFFFF;
+
+// The deepest a leaf may be. Traversal defers at most one node for every
+// interior node above the one it is in.
+static const int kMaxLeafDepth = kMaxTraversalDepth - 1;
+
+// SplitLBVH treelets are cut by the top 12 bits of their codes, so there
+// are at most 2^12 of them and the tree joining them needs 12 levels.
+static const int kTreeletDepth = 12;
+
+
+////////////////////
+// struct: BVHPrimitiveInfo
+//
+// Purpose:
+//      What the builder needs to know about each primitive; the bounds are
+//      queried once up front instead of on every pass over the primitives.
+////////////////////
+struct BVHPrimitiveInfo {
+    BVHPrimitiveInfo() : primitiveNumber(0) { }
+
+    BVHPrimitiveInfo (int pn, const BBox &b)
+            : primitiveNumber(pn), bounds(b) {
+        centroid = b.pMin * .5f + b.pMax * .5f;
+    }
+
+    int primitiveNumber;
+    Point centroid;
+    BBox bounds;
+};
+
+
+////////////////////
+// struct: BVHBuildNode
+//
+// Purpose:
+//      A node of the tree. Interior nodes have two children and record the
+//      axis they were split along; leaves have no children and refer to
+//      nPrimitives primitives starting at firstPrimOffset.
+////////////////////
+struct BVHBuildNode {
+    BVHBuildNode() : splitAxis(0), firstPrimOffset(0), nPrimitives(0) {
+        children[0] = children[1] = NULL;
+    }
+
+    void InitLeaf (int first, int n, const BBox &b) {
+        firstPrimOffset = first;
+        nPrimitives = n;
+        bounds = b;
+    }
+
+    void InitInterior (int axis, BVHBuildNode *c0, BVHBuildNode *c1) {
+        children[0] = c0;
+        children[1] = c1;
+        bounds = Union (c0->bounds, c1->bounds);
+        splitAxis = axis;
+        nPrimitives = 0;
+    }
+
+    BBox bounds;
+    BVHBuildNode *children[2];
+    int splitAxis, firstPrimOffset, nPrimitives;
+};
+
+
+// One bin of the SAH sweep.
+struct BucketInfo {
+    BucketInfo() : count(0) { }
+
+    int count;
+    BBox bounds;
+};
+
+
+// A primitive's place along the Morton curve, for the LBVH builder.
+struct MortonPrimitive {
+    int primitiveNumber;
+    uint64_t mortonCode;
+};
+
+
+////////////////////
+// BVHAccel Methods
+////////////////////
+BVHAccel::BVHAccel (const std::vector<std::shared_ptr<Primitive> > &prims,
+                    const BVHBuildOptions &opts)
+        : options(opts), primitives(prims),
+          triangles(std::make_shared<const PackedTriangles>()), root(NULL),
+          nodes(NULL), totalNodes(0), buildCost(0.f) {
+    assert (options.maxPrimsInNode >= 1);
+    assert (options.nBuckets >= 2);
+    assert (options.mortonBits == 30 || options.mortonBits == 63);
+
+    Build();
+}
+
+BVHAccel::~BVHAccel() {
+    FreeNodes (root);
+    FreeAligned (nodes);
+}
+
+void BVHAccel::Build() {
+    if (primitives.empty())
+        return;
+
+    std::vector<BVHPrimitiveInfo> primInfo (primitives.size());
+
+    ParallelFor (options.scheduler, 0, int64_t (primitives.size()),
+                 kBuildGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i)
+            primInfo[i] = BVHPrimitiveInfo (int (i),
+                                            primitives[i]->WorldBound());
+    });
+
+    // Leaves write their primitives to the slots matching their range of
+    // primInfo, so subtrees built in parallel never touch the same slots.
+    std::vector<std::shared_ptr<Primitive> > orderedPrims (primitives.size());
+
+    if (options.splitMethod == BVHBuildOptions::SplitLBVH)
+        root = BuildLBVH (primInfo, orderedPrims);
+    else
+        root = RecursiveBuild (primInfo, 0, int (primitives.size()), 0,
+                               orderedPrims);
+
+    primitives.swap (orderedPrims);
+
+    if (options.flattenTree) {
+        nodes = AllocAligned<LinearBVHNode> (totalNodes);
+
+        int offset = 0;
+        FlattenTree (root, &offset, 0);
+        assert (offset == totalNodes);
+
+        // A new object rather than packing in place: WideBVHAccels made
+        // from this tree share the old one.
+        std::shared_ptr<PackedTriangles> packed =
+                std::make_shared<PackedTriangles>();
+
+        packed->Pack (primitives);
+        triangles = packed;
+
+        FreeNodes (root);
+        root = NULL;
+    }
+
+    buildCost = SAHCost();
+}
+
+void BVHAccel::Rebuild() {
+    FreeNodes (root);
+    FreeAligned (nodes);
+    root = NULL;
+    nodes = NULL;
+    totalNodes = 0;
+    triangles = std::make_shared<const PackedTriangles>();
+
+    Build();
+}
+
+size_t BVHAccel::BytesUsed() const {
+    size_t nodeSize = nodes ? sizeof (LinearBVHNode) : sizeof (BVHBuildNode);
+
+    return sizeof (*this) + size_t (totalNodes) * nodeSize +
+           primitives.capacity() * sizeof (primitives[0]) +
+           triangles->BytesUsed();
+}
+
+void BVHAccel::FreeNodes (BVHBuildNode *node) {
+    if (!node)
+        return;
+
+    FreeNodes (node->children[0]);
+    FreeNodes (node->children[1]);
+
+    delete node;
+}
+
+BBox BVHAccel::WorldBound() const {
+    if (nodes)
+        return nodes[0].bounds;
+
+    return root ? root->bounds : BBox ();
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::FlattenTree
+//
+// Purpose:
+//      Copy the subtree under node into nodes[], depth first, starting at
+//      nodes[*offset].
+//
+// Parameters:
+//      const BVHBuildNode *node - The subtree to copy.
+//      int *offset - The next free slot of nodes[]; advanced past the
+//                    subtree.
+//      int depth - The depth of node in the tree.
+//
+// Returns:
+//      The index node was copied to.
+////////////////////
+int BVHAccel::FlattenTree (const BVHBuildNode *node, int *offset, int depth) {
+    // Traversal keeps at most one deferred node per level on its stack.
+    // The builders never put a leaf deeper than kMaxLeafDepth, so a deeper
+    // node is a builder bug that would overrun that stack.
+    if (depth > kMaxLeafDepth) {
+        fprintf (stderr, "BVH deeper than the %d level traversal stack\n",
+                 kMaxTraversalDepth);
+        abort();
+    }
+
+    LinearBVHNode *linearNode = &nodes[*offset];
+    int nodeOffset = (*offset)++;
+
+    linearNode->bounds = node->bounds;
+    linearNode->flags = 0;
+
+    if (node->nPrimitives > 0) {
+        assert (!node->children[0] && !node->children[1]);
+
+        // Likewise the builders never make a leaf too big for its count.
+        if (node->nPrimitives > kMaxLeafPrimitives) {
+            fprintf (stderr, "BVH leaf of %d primitives; the most is %d\n",
+                     node->nPrimitives, kMaxLeafPrimitives);
+            abort();
+        }
+
+        linearNode->primitivesOffset = node->firstPrimOffset;
+        linearNode->nPrimitives = uint16_t (node->nPrimitives);
+        linearNode->axis = 0;
+
+        if (AllTriangles (node->firstPrimOffset,
+                          node->firstPrimOffset + node->nPrimitives))
+            linearNode->flags |= kTriangleLeaf;
+    }
+    else {
+        linearNode->nPrimitives = 0;
+        linearNode->axis = uint8_t (node->splitAxis);
+
+        FlattenTree (node->children[0], offset, depth + 1);
+        linearNode->secondChildOffset = FlattenTree (node->children[1],
+                                                     offset, depth + 1);
+    }
+
+    return nodeOffset;
+}
+
+bool BVHAccel::AllTriangles (int start, int end) const {
+    for (int i = start; i < end; ++i) {
+        if (!dynamic_cast<const Triangle*> (primitives[i].get()))
+            return false;
+    }
+
+    return true;
+}
+
+
+////////////////////
+// Function:
+//      ComputeBounds
+//
+// Purpose:
+//      Find the bounds of the primitives in primInfo[start, end) and the
+//      bounds of their centroids. Large ranges are reduced in parallel
+//      chunks whose partial boxes are merged with Union.
+////////////////////
+static void ComputeBounds (TaskScheduler *scheduler,
+                           const std::vector<BVHPrimitiveInfo> &primInfo,
+                           int start, int end, BBox *bounds,
+                           BBox *centroidBounds) {
+    if (!scheduler || end - start < kParallelBinningThreshold) {
+        for (int i = start; i < end; ++i) {
+            *bounds = Union (*bounds, primInfo[i].bounds);
+            *centroidBounds = Union (*centroidBounds, primInfo[i].centroid);
+        }
+        return;
+    }
+
+    typedef std::pair<BBox, BBox> Bounds;
+
+    Bounds b = ParallelReduce (scheduler, start, end, kBuildGrainSize,
+                               Bounds (*bounds, *centroidBounds),
+                               [&](int64_t begin, int64_t stop) {
+        Bounds chunk;
+
+        for (int64_t i = begin; i < stop; ++i) {
+            chunk.first = Union (chunk.first, primInfo[i].bounds);
+            chunk.second = Union (chunk.second, primInfo[i].centroid);
+        }
+
+        return chunk;
+    }, [](const Bounds &a, const Bounds &c) {
+        return Bounds (Union (a.first, c.first), Union (a.second, c.second));
+    });
+
+    *bounds = b.first;
+    *centroidBounds = b.second;
+}
+
+
+// The factor that maps a centroid's offset from centroidMin to its SAH
+// bucket, or 0 if the centroids can't be binned: they coincide, or their
+// extent is so small (below about nBuckets / FLT_MAX) or so large that the
+// factor or the offsets overflow. Such nodes are treated as coincident.
+static inline float BucketScale (int nBuckets, float centroidMin,
+                                 float centroidMax) {
+    float scale = nBuckets / (centroidMax - centroidMin);
+
+    return scale < INFINITY ? scale : 0.f;
+}
+
+// Map a centroid coordinate to its SAH bucket.
+static inline int BucketIndex (float c, float centroidMin, float bucketScale,
+                               int nBuckets) {
+    return min (int ((c - centroidMin) * bucketScale), nBuckets - 1);
+}
+
+
+////////////////////
+// Function:
+//      ComputeBuckets
+//
+// Purpose:
+//      Bin the primitives of primInfo[start, end) by centroid along dim.
+//      Large ranges are binned in parallel chunks, each into its own set
+//      of buckets, and the sets are merged afterwards.
+////////////////////
+static void ComputeBuckets (TaskScheduler *scheduler,
+                            const std::vector<BVHPrimitiveInfo> &primInfo,
+                            int start, int end, int dim, float centroidMin,
+                            float bucketScale,
+                            std::vector<BucketInfo> &buckets) {
+    int nBuckets = int (buckets.size());
+
+    if (!scheduler || end - start < kParallelBinningThreshold) {
+        for (int i = start; i < end; ++i) {
+            int b = BucketIndex (primInfo[i].centroid[dim], centroidMin,
+                                 bucketScale, nBuckets);
+
+            buckets[b].count++;
+            buckets[b].bounds = Union (buckets[b].bounds, primInfo[i].bounds);
+        }
+        return;
+    }
+
+    int nChunks = (end - start + kBuildGrainSize - 1) / kBuildGrainSize;
+    std::vector<std::vector<BucketInfo> > chunkBuckets (
+            nChunks, std::vector<BucketInfo> (nBuckets));
+
+    ParallelFor (scheduler, start, end, kBuildGrainSize,
+                 [&](int64_t begin, int64_t stop) {
+        std::vector<BucketInfo> &local =
+                chunkBuckets[(begin - start) / kBuildGrainSize];
+
+        for (int64_t i = begin; i < stop; ++i) {
+            int b = BucketIndex (primInfo[i].centroid[dim], centroidMin,
+                                 bucketScale, nBuckets);
+
+            local[b].count++;
+            local[b].bounds = Union (local[b].bounds, primInfo[i].bounds);
+        }
+    });
+
+    for (int c = 0; c < nChunks; ++c) {
+        for (int b = 0; b < nBuckets; ++b) {
+            buckets[b].count += chunkBuckets[c][b].count;
+            buckets[b].bounds = Union (buckets[b].bounds,
+                                       chunkBuckets[c][b].bounds);
+        }
+    }
+}
+
+
+////////////////////
+// Function:
+//      FindSAHSplit
+//
+// Purpose:
+//      Evaluate the SAH cost of splitting after every bucket (see
+//      BVHAccel::RecursiveBuild for the cost model) and pick the cheapest.
+//
+// Parameters:
+//      const std::vector<BucketInfo> &buckets - The binned primitives.
+//      float nodeArea - The surface area of the node being split.
+//      float traversalCost - BVHBuildOptions::traversalCost.
+//      float *minCost - Receives the cost of the chosen split.
+//
+// Returns:
+//      The last bucket on the left side of the split, or -1 when no
+//      boundary has primitives on both sides.
+////////////////////
+static int FindSAHSplit (const std::vector<BucketInfo> &buckets,
+                         float nodeArea, float traversalCost,
+                         float *minCost) {
+    int nBuckets = int (buckets.size());
+
+    // Sweep from the right to get the area and count above every boundary,
+    // then from the left to evaluate the cost of each split.
+    std::vector<float> rightArea (nBuckets);
+    std::vector<int> rightCount (nBuckets);
+    BBox sweep;
+    int count = 0;
+
+    for (int i = nBuckets - 1; i > 0; --i) {
+        sweep = Union (sweep, buckets[i].bounds);
+        count += buckets[i].count;
+
+        rightArea[i] = count ? sweep.SurfaceArea() : 0.f;
+        rightCount[i] = count;
+    }
+
+    float invNodeArea = nodeArea > 0.f ? 1.f / nodeArea : 0.f;
+    int minCostSplitBucket = -1;
+
+    *minCost = INFINITY;
+    sweep = BBox ();
+    count = 0;
+
+    for (int i = 0; i < nBuckets - 1; ++i) {
+        sweep = Union (sweep, buckets[i].bounds);
+        count += buckets[i].count;
+
+        if (count == 0 || rightCount[i + 1] == 0)
+            continue;
+
+        float cost = traversalCost +
+                     (count * sweep.SurfaceArea() +
+                      rightCount[i + 1] * rightArea[i + 1]) * invNodeArea;
+
+        if (cost < *minCost) {
+            *minCost = cost;
+            minCostSplitBucket = i;
+        }
+    }
+
+    return minCostSplitBucket;
+}
+
+
+////////////////////
+// Function:
+//      MustSplitEvenly
+//
+// Purpose:
+//      Decide whether a node has to be split in half instead of where its
+//      heuristic likes. A lopsided split can leave one child with nearly
+//      all of the items and too few levels left to hold them; halving at
+//      every node from here down always fits, and is only forced on the
+//      levels nearest maxDepth.
+//
+// Parameters:
+//      int64_t n - The number of items under the node.
+//      int64_t leafSize - The most items a leaf can hold.
+//      int depth - The depth of the node, less than maxDepth.
+//      int maxDepth - The deepest a leaf may be.
+//
+// Returns:
+//      True if each child must get half of the items.
+////////////////////
+static inline bool MustSplitEvenly (int64_t n, int64_t leafSize, int depth,
+                                    int maxDepth) {
+    // The levels left below the children.
+    int levels = maxDepth - depth - 1;
+
+    return levels < 32 && n > (leafSize << levels);
+}
+
+
+BVHBuildNode *BVHAccel::MakeLeaf (
+        BVHBuildNode *node, const std::vector<BVHPrimitiveInfo> &primInfo,
+        int start, int end, const BBox &bounds,
+        std::vector<std::shared_ptr<Primitive> > &orderedPrims) const {
+    for (int i = start; i < end; ++i)
+        orderedPrims[i] = primitives[primInfo[i].primitiveNumber];
+
+    node->InitLeaf (start, end - start, bounds);
+    return node;
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::RecursiveBuild
+//
+// Purpose:
+//      Build the subtree over primInfo[start, end).
+//
+//      The centroids are binned into options.nBuckets buckets along the
+//      axis of largest centroid extent. Sweeping the buckets from both ends
+//      gives the bounds and counts on either side of every bucket boundary
+//      in linear time, and the SAH cost of splitting at boundary i is
+//
+//          traversalCost + (n_left * SA(left) + n_right * SA(right)) / SA(node)
+//
+//      which is compared against the cost of a leaf, n (one intersection
+//      per primitive).
+//
+//      Near kMaxLeafDepth the SAH gives way to splits at the median
+//      centroid, and nodes at kMaxLeafDepth become leaves, so that no
+//      clustering of the primitives can build a tree too deep to traverse.
+//
+// Parameters:
+//      std::vector<BVHPrimitiveInfo> &primInfo - Partitioned in place.
+//      int start, int end - The range to build over.
+//      int depth - The depth of the subtree's root.
+//      std::vector<...> &orderedPrims - Leaves store their primitives in
+//                                       orderedPrims[start, end).
+//
+// Returns:
+//      The root of the subtree.
+////////////////////
+BVHBuildNode *BVHAccel::RecursiveBuild (
+        std::vector<BVHPrimitiveInfo> &primInfo, int start, int end, int depth,
+        std::vector<std::shared_ptr<Primitive> > &orderedPrims) {
+    assert (start < end);
+
+    BVHBuildNode *node = new BVHBuildNode;
+    totalNodes.fetch_add (1, std::memory_order_relaxed);
+
+    BBox bounds, centroidBounds;
+    ComputeBounds (options.scheduler, primInfo, start, end, &bounds,
+                   &centroidBounds);
+
+    int nPrimitives = end - start;
+    int dim = centroidBounds.MaximumExtent();
+    float centroidMin = centroidBounds.pMin[dim];
+    float centroidMax = centroidBounds.pMax[dim];
+    int nBuckets = options.nBuckets;
+    float bucketScale = BucketScale (nBuckets, centroidMin, centroidMax);
+
+    // The splits above this node were even enough for it to fit.
+    if (depth == kMaxLeafDepth) {
+        assert (nPrimitives <= kMaxLeafPrimitives);
+        return MakeLeaf (node, primInfo, start, end, bounds, orderedPrims);
+    }
+
+    // A single primitive, or centroids that all coincide (or can't be
+    // binned, see BucketScale), can't be split by position. Flattened
+    // leaves hold at most kMaxLeafPrimitives, so larger runs of coincident
+    // centroids are simply cut in half.
+    int mid = -1;
+
+    if (nPrimitives == 1 || bucketScale == 0.f) {
+        if (nPrimitives <= kMaxLeafPrimitives)
+            return MakeLeaf (node, primInfo, start, end, bounds, orderedPrims);
+
+        mid = start + nPrimitives / 2;
+    }
+    else if (!MustSplitEvenly (nPrimitives, kMaxLeafPrimitives, depth,
+                               kMaxLeafDepth)) {
+        // Bin the centroids.
+        std::vector<BucketInfo> buckets (nBuckets);
+
+        ComputeBuckets (options.scheduler, primInfo, start, end, dim,
+                        centroidMin, bucketScale, buckets);
+
+        float minCost;
+        int minCostSplitBucket = FindSAHSplit (buckets, bounds.SurfaceArea(),
+                                               options.traversalCost,
+                                               &minCost);
+
+        float leafCost = float (nPrimitives);
+
+        // Make a leaf if splitting doesn't pay and the node is small enough,
+        // or if there is no split to take: every cost is NaN when the node's
+        // surface area is infinite. A node too big for one leaf is split at
+        // the median below instead.
+        bool leaf = minCostSplitBucket < 0 ||
+                    (nPrimitives <= options.maxPrimsInNode &&
+                     minCost >= leafCost);
+
+        if (leaf && nPrimitives <= kMaxLeafPrimitives)
+            return MakeLeaf (node, primInfo, start, end, bounds, orderedPrims);
+
+        if (!leaf) {
+            BVHPrimitiveInfo *pmid = std::partition (
+                    &primInfo[start], &primInfo[end - 1] + 1,
+                    [=](const BVHPrimitiveInfo &pi) {
+                        return BucketIndex (pi.centroid[dim], centroidMin,
+                                            bucketScale, nBuckets)
+                               <= minCostSplitBucket;
+                    });
+            mid = int (pmid - &primInfo[0]);
+        }
+    }
+
+    // Split at the median centroid near kMaxLeafDepth, or where the SAH
+    // would make a leaf too big to flatten.
+    if (mid < 0) {
+        mid = start + nPrimitives / 2;
+        std::nth_element (&primInfo[start], &primInfo[mid],
+                          &primInfo[end - 1] + 1,
+                          [=](const BVHPrimitiveInfo &a,
+                              const BVHPrimitiveInfo &b) {
+                              return a.centroid[dim] < b.centroid[dim];
+                          });
+    }
+
+    BVHBuildNode *children[2];
+
+    if (options.scheduler && nPrimitives >= kParallelSubtreeThreshold) {
+        TaskGroup group;
+
+        options.scheduler->Spawn (group, [&]() {
+            children[0] = RecursiveBuild (primInfo, start, mid, depth + 1,
+                                          orderedPrims);
+        });
+        children[1] = RecursiveBuild (primInfo, mid, end, depth + 1,
+                                      orderedPrims);
+
+        options.scheduler->Wait (group);
+    }
+    else {
+        children[0] = RecursiveBuild (primInfo, start, mid, depth + 1,
+                                      orderedPrims);
+        children[1] = RecursiveBuild (primInfo, mid, end, depth + 1,
+                                      orderedPrims);
+    }
+
+    node->InitInterior (dim, children[0], children[1]);
+
+    return node;
+}
+
+
+////////////////////
+// Function:
+//      RadixSort
+//
+// Purpose:
+//      Sort the primitives by Morton code with a least significant digit
+//      radix sort, eight bits per pass.
+//
+//      Each pass splits the array into chunks that are counted and then
+//      scattered in parallel. Output slots are handed out bucket by bucket
+//      and, within a bucket, chunk by chunk, so every pass is stable and
+//      the result does not depend on the number of threads. Passes whose
+//      digit is the same for every primitive are skipped.
+//
+// Parameters:
+//      TaskScheduler *scheduler - May be NULL.
+//      std::vector<MortonPrimitive> *v - The primitives to sort.
+//      int nBits - Only the low nBits bits of the codes are looked at.
+////////////////////
+static void RadixSort (TaskScheduler *scheduler,
+                       std::vector<MortonPrimitive> *v, int nBits) {
+    const int kBitsPerPass = 8;
+    const int kBuckets = 1 << kBitsPerPass;
+    const uint64_t kDigitMask = kBuckets - 1;
+
+    int n = int (v->size());
+    int nChunks = scheduler ? (n + kBuildGrainSize - 1) / kBuildGrainSize : 1;
+    int chunkSize = (n + nChunks - 1) / nChunks;
+
+    std::vector<MortonPrimitive> temp (n);
+    std::vector<MortonPrimitive> *in = v, *out = &temp;
+    std::vector<int> offsets (nChunks * kBuckets);
+
+    for (int shift = 0; shift < nBits; shift += kBitsPerPass) {
+        std::fill (offsets.begin(), offsets.end(), 0);
+
+        ParallelFor (scheduler, 0, nChunks, 1, [&](int64_t begin, int64_t end) {
+            for (int64_t c = begin; c < end; ++c) {
+                int *count = &offsets[c * kBuckets];
+                int stop = min (n, int (c + 1) * chunkSize);
+
+                for (int i = int (c) * chunkSize; i < stop; ++i)
+                    count[((*in)[i].mortonCode >> shift) & kDigitMask]++;
+            }
+        });
+
+        // Turn the counts into each chunk's first output slot per bucket.
+        int offset = 0;
+        bool oneBucket = false;
+
+        for (int b = 0; b < kBuckets; ++b) {
+            int bucketStart = offset;
+
+            for (int c = 0; c < nChunks; ++c) {
+                int count = offsets[c * kBuckets + b];
+                offsets[c * kBuckets + b] = offset;
+                offset += count;
+            }
+
+            if (offset - bucketStart == n)
+                oneBucket = true;
+        }
+
+        if (oneBucket)
+            continue;
+
+        ParallelFor (scheduler, 0, nChunks, 1, [&](int64_t begin, int64_t end) {
+            for (int64_t c = begin; c < end; ++c) {
+                int *slot = &offsets[c * kBuckets];
+                int stop = min (n, int (c + 1) * chunkSize);
+
+                for (int i = int (c) * chunkSize; i < stop; ++i) {
+                    const MortonPrimitive &mp = (*in)[i];
+                    (*out)[slot[(mp.mortonCode >> shift) & kDigitMask]++] = mp;
+                }
+            }
+        });
+
+        std::swap (in, out);
+    }
+
+    if (in != v)
+        v->swap (temp);
+}
+
+
+// Map a centroid offset in [0, 1] to one of scale Morton cells.
+static inline uint64_t QuantizeMorton (float offset, float scale) {
+    return uint64_t (min (offset * scale, scale - 1.f));
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::BuildLBVH
+//
+// Purpose:
+//      Build the tree as a linear BVH.
+//
+//      The primitive centroids are quantized on a grid over the centroid
+//      bounds and the cells are numbered along a Morton curve. After
+//      sorting by code, primitives that are close along the curve are
+//      close in space, and the codes of the primitives under any node
+//      share a common prefix: the node's two children are the primitives
+//      with the next bit clear and with it set. Every level of the tree is
+//      therefore found with a binary search instead of a SAH sweep, and
+//      the whole build is a sort plus linear work.
+//
+//      With options.sahTreeletTop the codes are first split into treelets
+//      by their top 12 bits. The treelets are built independently and
+//      their roots are joined by BuildUpperSAH.
+//
+// Parameters:
+//      const std::vector<BVHPrimitiveInfo> &primInfo - In primitive order.
+//      std::vector<...> &orderedPrims - Receives the primitives in leaf
+//                                       order.
+//
+// Returns:
+//      The root of the tree.
+////////////////////
+BVHBuildNode *BVHAccel::BuildLBVH (
+        const std::vector<BVHPrimitiveInfo> &primInfo,
+        std::vector<std::shared_ptr<Primitive> > &orderedPrims) {
+    int nPrimitives = int (primInfo.size());
+
+    BBox bounds, centroidBounds;
+    ComputeBounds (options.scheduler, primInfo, 0, nPrimitives, &bounds,
+                   &centroidBounds);
+
+    bool wide = options.mortonBits > 30;
+    float mortonScale = wide ? float (1 << 21) : float (1 << 10);
+    std::vector<MortonPrimitive> mortonPrims (nPrimitives);
+
+    ParallelFor (options.scheduler, 0, nPrimitives, kBuildGrainSize,
+                 [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            Vector o = centroidBounds.Offset (primInfo[i].centroid);
+            uint64_t x = QuantizeMorton (o.x, mortonScale);
+            uint64_t y = QuantizeMorton (o.y, mortonScale);
+            uint64_t z = QuantizeMorton (o.z, mortonScale);
+
+            mortonPrims[i].primitiveNumber = primInfo[i].primitiveNumber;
+            mortonPrims[i].mortonCode =
+                    wide ? EncodeMorton3 (x, y, z)
+                         : EncodeMorton3 (uint32_t (x), uint32_t (y),
+                                          uint32_t (z));
+        }
+    });
+
+    RadixSort (options.scheduler, &mortonPrims, options.mortonBits);
+
+    if (!options.sahTreeletTop)
+        return EmitLBVH (primInfo, mortonPrims, 0, nPrimitives, 0,
+                         orderedPrims);
+
+    // Each run of codes that agree in their top 12 bits is a treelet. The
+    // treelets are built as if they all sat at the bottom of the tree that
+    // joins them.
+    int treeletShift = options.mortonBits - kTreeletDepth;
+    std::vector<int> treeletStarts;
+
+    for (int i = 0; i < nPrimitives; ++i) {
+        if (i == 0 || (mortonPrims[i].mortonCode >> treeletShift) !=
+                      (mortonPrims[i - 1].mortonCode >> treeletShift))
+            treeletStarts.push_back (i);
+    }
+    treeletStarts.push_back (nPrimitives);
+
+    int nTreelets = int (treeletStarts.size()) - 1;
+    std::vector<BVHBuildNode*> treelets (nTreelets);
+
+    ParallelFor (options.scheduler, 0, nTreelets, 1,
+                 [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i)
+            treelets[i] = EmitLBVH (primInfo, mortonPrims, treeletStarts[i],
+                                    treeletStarts[i + 1], kTreeletDepth,
+                                    orderedPrims);
+    });
+
+    return BuildUpperSAH (treelets, 0, nTreelets, 0);
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::EmitLBVH
+//
+// Purpose:
+//      Build the subtree over the sorted mortonPrims[start, end).
+//
+//      The codes in the range agree above the highest bit in which the
+//      first and last code differ; the split is the first code with that
+//      bit set. A range whose codes are all equal can't be split and
+//      becomes a leaf whatever its size, or is cut in half if it is too
+//      big for a leaf, as in RecursiveBuild. Ranges are also cut in half
+//      near kMaxLeafDepth, where RecursiveBuild would split at the median,
+//      and become leaves at kMaxLeafDepth; codes can have up to 63 bits.
+//
+// Returns:
+//      The root of the subtree.
+////////////////////
+BVHBuildNode *BVHAccel::EmitLBVH (
+        const std::vector<BVHPrimitiveInfo> &primInfo,
+        const std::vector<MortonPrimitive> &mortonPrims, int start, int end,
+        int depth, std::vector<std::shared_ptr<Primitive> > &orderedPrims) {
+    assert (start < end);
+
+    BVHBuildNode *node = new BVHBuildNode;
+    totalNodes.fetch_add (1, std::memory_order_relaxed);
+
+    int nPrimitives = end - start;
+    uint64_t diff = mortonPrims[start].mortonCode ^
+                    mortonPrims[end - 1].mortonCode;
+
+    // The splits above this node were even enough for it to fit if it is
+    // at kMaxLeafDepth.
+    if (nPrimitives <= options.maxPrimsInNode ||
+        (diff == 0 && nPrimitives <= kMaxLeafPrimitives) ||
+        depth == kMaxLeafDepth) {
+        assert (nPrimitives <= kMaxLeafPrimitives);
+
+        BBox bounds;
+
+        for (int i = start; i < end; ++i) {
+            int pn = mortonPrims[i].primitiveNumber;
+
+            orderedPrims[i] = primitives[pn];
+            bounds = Union (bounds, primInfo[pn].bounds);
+        }
+
+        node->InitLeaf (start, nPrimitives, bounds);
+        return node;
+    }
+
+    int axis = 0;
+    int mid = start + nPrimitives / 2;
+
+    if (diff != 0) {
+        int bit = Log2Int (diff);
+        uint64_t mask = uint64_t (1) << bit;
+
+        // Bit b of a Morton code belongs to axis b % 3.
+        axis = bit % 3;
+
+        if (!MustSplitEvenly (nPrimitives, kMaxLeafPrimitives, depth,
+                              kMaxLeafDepth)) {
+            const MortonPrimitive *pmid = std::partition_point (
+                    &mortonPrims[start], &mortonPrims[end - 1] + 1,
+                    [=](const MortonPrimitive &mp) {
+                        return (mp.mortonCode & mask) == 0;
+                    });
+
+            mid = int (pmid - &mortonPrims[0]);
+        }
+    }
+
+    BVHBuildNode *children[2];
+
+    if (options.scheduler && nPrimitives >= kParallelSubtreeThreshold) {
+        TaskGroup group;
+
+        options.scheduler->Spawn (group, [&]() {
+            children[0] = EmitLBVH (primInfo, mortonPrims, start, mid,
+                                    depth + 1, orderedPrims);
+        });
+        children[1] = EmitLBVH (primInfo, mortonPrims, mid, end, depth + 1,
+                                orderedPrims);
+
+        options.scheduler->Wait (group);
+    }
+    else {
+        children[0] = EmitLBVH (primInfo, mortonPrims, start, mid, depth + 1,
+                                orderedPrims);
+        children[1] = EmitLBVH (primInfo, mortonPrims, mid, end, depth + 1,
+                                orderedPrims);
+    }
+
+    node->InitInterior (axis, children[0], children[1]);
+
+    return node;
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::BuildUpperSAH
+//
+// Purpose:
+//      Join the treelet roots in roots[start, end) into one tree, choosing
+//      every split with the binned SAH over the treelets' centroids. The
+//      treelets are always split down to single treelets, and the splits
+//      fall back to the median centroid where the SAH would leave some
+//      treelet deeper than kTreeletDepth.
+//
+// Returns:
+//      The root of the joined tree.
+////////////////////
+BVHBuildNode *BVHAccel::BuildUpperSAH (std::vector<BVHBuildNode*> &roots,
+                                       int start, int end, int depth) {
+    assert (start < end);
+
+    if (end - start == 1)
+        return roots[start];
+
+    assert (depth < kTreeletDepth);
+
+    BVHBuildNode *node = new BVHBuildNode;
+    totalNodes.fetch_add (1, std::memory_order_relaxed);
+
+    BBox bounds, centroidBounds;
+
+    for (int i = start; i < end; ++i) {
+        bounds = Union (bounds, roots[i]->bounds);
+        centroidBounds = Union (centroidBounds,
+                                roots[i]->bounds.pMin * .5f +
+                                roots[i]->bounds.pMax * .5f);
+    }
+
+    int dim = centroidBounds.MaximumExtent();
+    float centroidMin = centroidBounds.pMin[dim];
+    float centroidMax = centroidBounds.pMax[dim];
+    int nBuckets = options.nBuckets;
+    float bucketScale = BucketScale (nBuckets, centroidMin, centroidMax);
+    int mid = (start + end) / 2;
+
+    if (MustSplitEvenly (end - start, 1, depth, kTreeletDepth)) {
+        std::nth_element (&roots[start], &roots[mid], &roots[end - 1] + 1,
+                          [=](const BVHBuildNode *a, const BVHBuildNode *b) {
+                              return a->bounds.pMin[dim] + a->bounds.pMax[dim] <
+                                     b->bounds.pMin[dim] + b->bounds.pMax[dim];
+                          });
+    }
+    else if (bucketScale > 0.f) {
+        std::vector<BucketInfo> buckets (nBuckets);
+
+        for (int i = start; i < end; ++i) {
+            float c = roots[i]->bounds.pMin[dim] * .5f +
+                      roots[i]->bounds.pMax[dim] * .5f;
+            int b = BucketIndex (c, centroidMin, bucketScale, nBuckets);
+
+            buckets[b].count++;
+            buckets[b].bounds = Union (buckets[b].bounds, roots[i]->bounds);
+        }
+
+        float minCost;
+        int split = FindSAHSplit (buckets, bounds.SurfaceArea(),
+                                  options.traversalCost, &minCost);
+
+        if (split >= 0) {
+            BVHBuildNode **pmid = std::partition (
+                    &roots[start], &roots[end - 1] + 1,
+                    [=](const BVHBuildNode *n) {
+                        float c = n->bounds.pMin[dim] * .5f +
+                                  n->bounds.pMax[dim] * .5f;
+                        return BucketIndex (c, centroidMin, bucketScale,
+                                            nBuckets) <= split;
+                    });
+            mid = int (pmid - &roots[0]);
+        }
+    }
+
+    node->InitInterior (dim, BuildUpperSAH (roots, start, mid, depth + 1),
+                        BuildUpperSAH (roots, mid, end, depth + 1));
+
+    return node;
+}
+
+
+// Subtrees of at least this many flattened nodes are refitted as separate
+// tasks.
+static const int kParallelRefitThreshold = 8 * 1024;
+
+
+// Recompute the bounds of a build tree bottom up.
+static void RefitBuildTree (BVHBuildNode *node,
+                            const std::vector<std::shared_ptr<Primitive> >
+                                &prims) {
+    if (node->nPrimitives > 0) {
+        BBox bounds;
+
+        for (int i = 0; i < node->nPrimitives; ++i)
+            bounds = Union (bounds,
+                            prims[node->firstPrimOffset + i]->WorldBound());
+
+        node->bounds = bounds;
+        return;
+    }
+
+    RefitBuildTree (node->children[0], prims);
+    RefitBuildTree (node->children[1], prims);
+    node->bounds = Union (node->children[0]->bounds,
+                          node->children[1]->bounds);
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::Refit
+//
+// Purpose:
+//      Recompute the bounds of every node from the primitives' current
+//      bounds. The packed triangles gather the meshes' current vertices,
+//      so the bounds of triangle leaves can be read straight from them.
+////////////////////
+void BVHAccel::Refit() {
+    if (root)
+        RefitBuildTree (root, primitives);
+
+    if (!nodes)
+        return;
+
+    RefitNodes (0, totalNodes);
+}
+
+
+////////////////////
+// Function:
+//      BVHAccel::RefitNodes
+//
+// Purpose:
+//      Refit the subtree under nodes[first].
+//
+//      Depth-first order puts a subtree in a contiguous range of nodes[]
+//      with every node ahead of its children, so a small subtree is
+//      refitted with one backwards sweep over its range. Large subtrees
+//      refit their two children in parallel and then union them.
+//
+// Parameters:
+//      int first - The root of the subtree.
+//      int end - One past the subtree's last node.
+////////////////////
+void BVHAccel::RefitNodes (int first, int end) {
+    LinearBVHNode &top = nodes[first];
+
+    if (!options.scheduler || top.nPrimitives > 0 ||
+        end - first < kParallelRefitThreshold) {
+        for (int i = end - 1; i >= first; --i) {
+            LinearBVHNode &node = nodes[i];
+
+            if (node.nPrimitives == 0) {
+                node.bounds = Union (nodes[i + 1].bounds,
+                                     nodes[node.secondChildOffset].bounds);
+            }
+            else if (node.flags & kTriangleLeaf) {
+                node.bounds = triangles->Bounds (node.primitivesOffset,
+                                                node.nPrimitives);
+            }
+            else {
+                const std::shared_ptr<Primitive> *p =
+                        &primitives[node.primitivesOffset];
+                BBox bounds;
+
+                for (int j = 0; j < node.nPrimitives; ++j)
+                    bounds = Union (bounds, p[j]->WorldBound());
+
+                node.bounds = bounds;
+            }
+        }
+        return;
+    }
+
+    int second = top.secondChildOffset;
+    TaskGroup group;
+
+    options.scheduler->Spawn (group, [&]() {
+        RefitNodes (first + 1, second);
+    });
+    RefitNodes (second, end);
+
+    options.scheduler->Wait (group);
+
+    top.bounds = Union (nodes[first + 1].bounds, nodes[second].bounds);
+}
+
+bool BVHAccel::Update() {
+    Refit();
+
+    if (SAHCost() <= buildCost * (1.f + options.refitCostThreshold))
+        return false;
+
+    Rebuild();
+    return true;
+}
+
+
+// The sum of the surface areas of the nodes under node, each weighted by
+// its cost (see BVHAccel::SAHCost).
+static double BuildTreeCost (const BVHBuildNode *node, float traversalCost) {
+    double area = node->bounds.SurfaceArea();
+
+    if (node->nPrimitives > 0)
+        return area * node->nPrimitives;
+
+    return area * traversalCost +
+           BuildTreeCost (node->children[0], traversalCost) +
+           BuildTreeCost (node->children[1], traversalCost);
+}
+
+float BVHAccel::SAHCost() const {
+    double rootArea = WorldBound().SurfaceArea();
+    double cost = 0.;
+
+    if (nodes) {
+        for (int i = 0; i < totalNodes; ++i) {
+            const LinearBVHNode &node = nodes[i];
+
+            cost += double (node.bounds.SurfaceArea()) *
+                    (node.nPrimitives > 0 ? float (node.nPrimitives)
+                                          : options.traversalCost);
+        }
+    }
+    else if (root)
+        cost = BuildTreeCost (root, options.traversalCost);
+
+    return rootArea > 0. ? float (cost / rootArea) : 0.f;
+}
+
+
+////////////////////
+// Struct: FlatTree, PointerTree
+//
+// Purpose:
+//      The two node layouts as seen by Traverse, which is written once
+//      against this interface. FlatTree walks the LinearBVHNode array,
+//      PointerTree the build tree.
+////////////////////
+struct FlatTree {
+    typedef int NodeRef;
+
+    explicit FlatTree (const LinearBVHNode *n) : nodes(n) { }
+
+    NodeRef Root() const { return 0; }
+    const BBox &Bounds (NodeRef n) const { return nodes[n].bounds; }
+    int NumPrimitives (NodeRef n) const { return nodes[n].nPrimitives; }
+    int FirstPrimitive (NodeRef n) const { return nodes[n].primitivesOffset; }
+    int Axis (NodeRef n) const { return nodes[n].axis; }
+    bool TriangleLeaf (NodeRef n) const {
+        return (nodes[n].flags & kTriangleLeaf) != 0;
+    }
+    NodeRef FirstChild (NodeRef n) const { return n + 1; }
+    NodeRef SecondChild (NodeRef n) const { return nodes[n].secondChildOffset; }
+
+    const LinearBVHNode *nodes;
+};
+
+struct PointerTree {
+    typedef const BVHBuildNode *NodeRef;
+
+    explicit PointerTree (const BVHBuildNode *r) : root(r) { }
+
+    NodeRef Root() const { return root; }
+    const BBox &Bounds (NodeRef n) const { return n->bounds; }
+    int NumPrimitives (NodeRef n) const { return n->nPrimitives; }
+    int FirstPrimitive (NodeRef n) const { return n->firstPrimOffset; }
+    int Axis (NodeRef n) const { return n->splitAxis; }
+    bool TriangleLeaf (NodeRef) const { return false; }
+    NodeRef FirstChild (NodeRef n) const { return n->children[0]; }
+    NodeRef SecondChild (NodeRef n) const { return n->children[1]; }
+
+    const BVHBuildNode *root;
+};
+
+
+// Traversal statistics, reported once per traversal rather than per node.
+// A ray through instances is counted once for the top level tree and once
+// for each instance's tree it enters. Every visit is one ray-box test, so
+// the average times the count is also the total number of box tests.
+static StatDistribution nodesPerRay ("BVH/Nodes visited per ray");
+
+
+////////////////////
+// Function:
+//      Traverse
+//
+// Purpose:
+//      Walk the tree along the ray.
+//
+//      Nodes still to be visited are kept on a small fixed-size stack. At
+//      each interior node the child on the near side of the split plane
+//      (as given by the sign of the ray direction along the split axis) is
+//      visited first so that ray.maxt shrinks as early as possible and the
+//      far child is more likely to be culled.
+//
+//      AnyHit selects IntersectP semantics: the walk stops at the first
+//      primitive that reports a hit, and isect is not used. Children are
+//      still ordered by the sign of the direction, which costs nothing;
+//      visiting the child with the larger surface area first instead (the
+//      more likely one to hold an occluder) measured slower.
+//
+// Parameters:
+//      const Tree &tree - The tree to walk.
+//      const std::vector<...> &prims - The primitives in leaf order.
+//      const PackedTriangles &triangles - prims packed for leaves flagged
+//                                         as TriangleLeaf.
+//      const Ray &ray - The ray; its maxt shrinks as hits are found.
+//      Intersection *isect - Receives the closest hit.
+//      int *nodesVisited - If not NULL, the number of nodes whose bounds
+//                          were tested is added to it.
+//
+// Returns:
+//      Whether anything was hit.
+////////////////////
+template <typename Tree, bool AnyHit>
+static bool Traverse (const Tree &tree,
+                      const std::vector<std::shared_ptr<Primitive> > &prims,
+                      const PackedTriangles &triangles, const Ray &ray,
+                      Intersection *isect, int *nodesVisited) {
+    bool hit = false;
+    Vector invDir (1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+    int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+    typename Tree::NodeRef todo[kMaxTraversalDepth];
+    int todoOffset = 0;
+    typename Tree::NodeRef node = tree.Root();
+    int visited = 0;
+
+    while (true) {
+        ++visited;
+
+        if (tree.Bounds (node).IntersectP (ray, invDir, dirIsNeg)) {
+            int nPrimitives = tree.NumPrimitives (node);
+
+            if (nPrimitives > 0) {
+                int first = tree.FirstPrimitive (node);
+                const std::shared_ptr<Primitive> *p = &prims[first];
+
+                if (tree.TriangleLeaf (node)) {
+                    if (AnyHit ? triangles.IntersectP (first, nPrimitives, ray)
+                               : triangles.Intersect (&prims[0], first,
+                                                      nPrimitives, ray, isect))
+                        hit = true;
+                }
+                else {
+                    for (int i = 0; i < nPrimitives; ++i) {
+                        if (AnyHit ? p[i]->IntersectP (ray)
+                                   : p[i]->Intersect (ray, isect)) {
+                            hit = true;
+
+                            if (AnyHit)
+                                break;
+                        }
+                    }
+                }
+
+                if ((AnyHit && hit) || todoOffset == 0)
+                    break;
+                node = todo[--todoOffset];
+            }
+            else {
+                if (dirIsNeg[tree.Axis (node)]) {
+                    todo[todoOffset++] = tree.FirstChild (node);
+                    node = tree.SecondChild (node);
+                }
+                else {
+                    todo[todoOffset++] = tree.SecondChild (node);
+                    node = tree.FirstChild (node);
+                }
+            }
+        }
+        else {
+            if (todoOffset == 0)
+                break;
+            node = todo[--todoOffset];
+        }
+    }
+
+    nodesPerRay.ReportValue (visited);
+
+    if (nodesVisited)
+        *nodesVisited += visited;
+
+    return hit;
+}
+
+
+bool BVHAccel::Intersect (const Ray &ray, Intersection *isect) const {
+    if (nodes)
+        return Traverse<FlatTree, false> (FlatTree (nodes), primitives,
+                                          *triangles, ray, isect, NULL);
+    if (root)
+        return Traverse<PointerTree, false> (PointerTree (root), primitives,
+                                             *triangles, ray, isect, NULL);
+    return false;
+}
+
+bool BVHAccel::IntersectP (const Ray &ray) const {
+    if (nodes)
+        return Traverse<FlatTree, true> (FlatTree (nodes), primitives,
+                                         *triangles, ray, NULL, NULL);
+    if (root)
+        return Traverse<PointerTree, true> (PointerTree (root), primitives,
+                                            *triangles, ray, NULL, NULL);
+    return false;
+}
+
+int BVHAccel::NodeVisits (const Ray &r) const {
+    Ray ray = r;
+    Intersection isect;
+    int visited = 0;
+
+    if (nodes)
+        Traverse<FlatTree, false> (FlatTree (nodes), primitives, *triangles,
+                                   ray, &isect, &visited);
+    else if (root)
+        Traverse<PointerTree, false> (PointerTree (root), primitives,
+                                      *triangles, ray, &isect, &visited);
+
+    return visited;
+}
@@ -0,0 +1,296 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: bvh.h
+ *
+ *  Purpose: Define the bounding volume hierarchy accelerator.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "primitive.h"
+#include "trianglemesh.h"
+
+class TaskScheduler;
+
+struct BVHBuildNode;
+struct BVHPrimitiveInfo;
+struct MortonPrimitive;
+
+
+////////////////////
+// struct: BVHBuildOptions
+//
+// Purpose:
+//      The knobs of the BVH builder.
+//
+//      Costs are expressed relative to one ray-primitive intersection, so
+//      only the ratio of traversal to intersection cost matters.
+////////////////////
+struct BVHBuildOptions {
+    enum SplitMethod {
+        // Top down binned SAH: the best trees, the slowest build.
+        SplitSAH,
+
+        // Linear BVH: sort the primitives along a Morton curve and split
+        //      wherever the codes' bits change. Builds many times faster
+        //      than SplitSAH at some cost in trace speed, which makes
+        //      per-frame rebuilds of moving geometry affordable.
+        SplitLBVH
+    };
+
+    BVHBuildOptions()
+            : maxPrimsInNode(4), nBuckets(12), traversalCost(.125f),
+              scheduler(NULL), splitMethod(SplitSAH), mortonBits(30),
+              sahTreeletTop(true), flattenTree(true),
+              refitCostThreshold(.5f) { }
+
+    // Nodes with more primitives than this are always split.
+    int maxPrimsInNode;
+
+    // The number of bins the centroid range is split into when evaluating
+    // the surface area heuristic.
+    int nBuckets;
+
+    // The cost of visiting an interior node divided by the cost of one
+    // ray-primitive test.
+    float traversalCost;
+
+    // When set, the build runs on this scheduler's threads; otherwise it
+    // runs on the calling thread. The resulting tree is the same either
+    // way.
+    TaskScheduler *scheduler;
+
+    SplitMethod splitMethod;
+
+    // SplitLBVH: the length of the Morton codes, 30 (10 bits per axis) or
+    // 63 (21 bits per axis). Longer codes separate primitives in scenes
+    // with a large spread of scales but take twice the sorting passes.
+    int mortonBits;
+
+    // SplitLBVH: split the primitives into treelets by the top 12 bits of
+    // their codes and join the treelets with the SAH instead of by the
+    // Morton bits. The top of the tree is where a poor split costs the
+    // most, and there are few enough treelets for the SAH to be cheap.
+    bool sahTreeletTop;
+
+    // Copy the finished tree into one contiguous array of 32 byte nodes in
+    // depth-first order and traverse that. Turning this off keeps (and
+    // traverses) the pointer-linked build tree instead, which is only
+    // useful for measuring what the flat layout buys.
+    bool flattenTree;
+
+    // BVHAccel::Update rebuilds the tree once refitting has raised its SAH
+    // cost by more than this fraction of the cost it was built with.
+    float refitCostThreshold;
+};
+
+
+// The deepest tree BVHAccel can traverse; its traversal stack has this
+// many entries. The builders keep every leaf above this depth.
+static const int kMaxTraversalDepth = 64;
+
+
+////////////////////
+// struct: LinearBVHNode
+//
+// Purpose:
+//      A node of the flattened tree, sized and aligned so that two nodes
+//      share a cache line and no node straddles two.
+//
+//      Nodes are stored in depth-first order, so an interior node's first
+//      child is the next node in the array and only the second child's
+//      index is stored. Leaves instead store where their primitives start
+//      in BVHAccel::Primitives().
+//
+//      Leaves whose primitives are all Triangles are flagged with
+//      kTriangleLeaf so traversal intersects them in SIMD batches through
+//      BVHAccel::Triangles().
+////////////////////
+struct alignas(32) LinearBVHNode {
+    BBox bounds;
+
+    union {
+        int primitivesOffset;   // Leaves
+        int secondChildOffset;  // Interior nodes
+    };
+
+    uint16_t nPrimitives;       // 0 for interior nodes
+    uint8_t axis;               // Interior nodes' split axis
+    uint8_t flags;              // Leaves: kTriangleLeaf
+};
+
+static const uint8_t kTriangleLeaf = 1;
+
+static_assert (sizeof (LinearBVHNode) == 32,
+               "LinearBVHNode should be exactly 32 bytes");
+
+
+////////////////////
+// Class: BVHAccel
+//
+// Purpose:
+//      A bounding volume hierarchy over a set of primitives.
+//
+//      The tree is built top down. Each node's primitives are binned by
+//      centroid along the axis where the centroids spread the most, and the
+//      bin boundary with the lowest surface area heuristic cost is used as
+//      the split. A node becomes a leaf when no split is cheaper than
+//      intersecting all of its primitives (and it is small enough).
+//
+//      Build-time primitive order is rearranged so that every leaf refers
+//      to a contiguous range of primitives.
+//
+//      With a scheduler the build is parallel at every level: the bounds
+//      and bins of large nodes are computed in chunks whose partial results
+//      are merged with Union, and the two subtrees of large nodes are built
+//      as separate tasks.
+//
+//      SplitLBVH trades tree quality for build speed; see BuildLBVH.
+//
+//      Once built, the tree is flattened into an array of cache-aligned
+//      LinearBVHNodes in depth-first order: every interior node is
+//      immediately followed by its first child, and only the offset of the
+//      second child is stored.
+//
+// Inherits From: Primitive
+////////////////////
+class BVHAccel : public Primitive {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        BVHAccel (const std::vector<std::shared_ptr<Primitive> > &prims,
+                  const BVHBuildOptions &options = BVHBuildOptions());
+        ~BVHAccel();
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        BBox WorldBound() const;
+
+        bool Intersect (const Ray &ray, Intersection *isect) const;
+        bool IntersectP (const Ray &ray) const;
+
+        // Trace a copy of the ray as Intersect would and count the nodes
+        // whose bounds it was tested against.
+        int NodeVisits (const Ray &ray) const;
+
+        // Recompute every node's bounds bottom up from the primitives'
+        // current bounds, keeping the tree's topology. For primitives that
+        // move without being added or removed (deforming meshes), this is
+        // far cheaper than a rebuild, but the tree degrades as the
+        // primitives drift from where they were when it was built.
+        //
+        // BVH4Accel / BVH8Accel copies of the tree are not updated.
+        void Refit();
+
+        // Refit, then rebuild the tree if refitting has degraded it past
+        // options.refitCostThreshold. Returns whether it rebuilt.
+        bool Update();
+
+        // Build the tree again over the primitives' current bounds.
+        void Rebuild();
+
+        // The expected cost of a ray through the tree by the surface area
+        // heuristic, in units of one ray-primitive test: each node costs
+        // its share of the root's surface area times the traversal cost
+        // (interior nodes) or its primitive count (leaves).
+        float SAHCost() const;
+
+        // SAHCost() as of the last build.
+        float BuildSAHCost() const { return buildCost; }
+
+        int TotalNodes() const { return totalNodes; }
+
+        // The memory held by the accelerator: its nodes, its references to
+        // the primitives and their packed entries (not the primitives).
+        size_t BytesUsed() const;
+        const BVHBuildOptions &Options() const { return options; }
+
+        // The flattened tree (NULL if it is empty or wasn't flattened) and
+        // the primitives in the order its leaves refer to them, so other
+        // node layouts can be derived from this one. The packed triangles
+        // are shared with those layouts rather than copied.
+        const LinearBVHNode *Nodes() const { return nodes; }
+        const std::vector<std::shared_ptr<Primitive> > &Primitives() const {
+            return primitives;
+        }
+        const std::shared_ptr<const PackedTriangles> &Triangles() const {
+            return triangles;
+        }
+
+    private:
+        void Build();
+        void RefitNodes (int first, int end);
+        BVHBuildNode *RecursiveBuild (std::vector<BVHPrimitiveInfo> &primInfo,
+                                      int start, int end, int depth,
+                                      std::vector<std::shared_ptr<Primitive> >
+                                          &orderedPrims);
+        BVHBuildNode *MakeLeaf (BVHBuildNode *node,
+                                const std::vector<BVHPrimitiveInfo> &primInfo,
+                                int start, int end, const BBox &bounds,
+                                std::vector<std::shared_ptr<Primitive> >
+                                    &orderedPrims) const;
+        BVHBuildNode *BuildLBVH (const std::vector<BVHPrimitiveInfo> &primInfo,
+                                 std::vector<std::shared_ptr<Primitive> >
+                                     &orderedPrims);
+        BVHBuildNode *EmitLBVH (const std::vector<BVHPrimitiveInfo> &primInfo,
+                                const std::vector<MortonPrimitive>
+                                    &mortonPrims,
+                                int start, int end, int depth,
+                                std::vector<std::shared_ptr<Primitive> >
+                                    &orderedPrims);
+        BVHBuildNode *BuildUpperSAH (std::vector<BVHBuildNode*> &roots,
+                                     int start, int end, int depth);
+        int FlattenTree (const BVHBuildNode *node, int *offset, int depth);
+        bool AllTriangles (int start, int end) const;
+        void FreeNodes (BVHBuildNode *node);
+
+        ///////////////
+        // Data Members
+        ///////////////
+        BVHBuildOptions options;
+        std::vector<std::shared_ptr<Primitive> > primitives;
+        std::shared_ptr<const PackedTriangles> triangles;
+        BVHBuildNode *root;
+        LinearBVHNode *nodes;
+        std::atomic<int> totalNodes;
+        float buildCost;
+
+        // BVHAccel owns its nodes; copying would free them twice.
+        BVHAccel (const BVHAccel&);
+        BVHAccel &operator= (const BVHAccel&);
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: camera.cpp
+ *
+ *  Purpose: Implement the camera.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "camera.h"
+
+
+////////////////////
+// PerspectiveCamera Methods
+////////////////////
+PerspectiveCamera::PerspectiveCamera (const Transform &cameraToWorld,
+                                      float fov, int xRes, int yRes)
+        : xResolution(xRes), yResolution(yRes) {
+    assert (xResolution > 0 && yResolution > 0);
+    assert (fov > 0.f && fov < 180.f);
+
+    // The half extents of the image plane at z = 1.
+    float tanHalf = tanf (Radians (fov) * .5f);
+    float aspect = float (xResolution) / float (yResolution);
+    float halfX = aspect > 1.f ? tanHalf * aspect : tanHalf;
+    float halfY = aspect > 1.f ? tanHalf : tanHalf / aspect;
+
+    origin = cameraToWorld (Point (0, 0, 0));
+    corner = cameraToWorld (Vector (-halfX, halfY, 1.f));
+    dxRaster = cameraToWorld (Vector (2.f * halfX / xResolution, 0, 0));
+    dyRaster = cameraToWorld (Vector (0, -2.f * halfY / yResolution, 0));
+}
@@ -0,0 +1,90 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: camera.h
+ *
+ *  Purpose: Define the camera that generates rays through the image.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "Geometry.h"
+#include "transform.h"
+
+
+////////////////////
+// Class: PerspectiveCamera
+//
+// Purpose:
+//      A pinhole camera. Rays start at the camera's position and pass
+//      through the image plane, which spans fov degrees along the image's
+//      shorter axis.
+//
+//      In camera space the camera looks down +z with +y up, as set up by
+//      LookAt, and raster x increases along camera space +x.
+//
+//      The world space origin and the directions to the image's corner
+//      and along its rows and columns are worked out once, so generating a
+//      ray is a few multiply-adds and a normalize.
+////////////////////
+class PerspectiveCamera {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        PerspectiveCamera (const Transform &cameraToWorld, float fov,
+                           int xResolution, int yResolution);
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // The ray through raster position (rasterX, rasterY). Pixel (x, y)
+        // covers [x, x + 1) x [y, y + 1), and y increases downwards.
+        Ray GenerateRay (float rasterX, float rasterY,
+                         float time = 0.f) const {
+            Vector d = corner + dxRaster * rasterX + dyRaster * rasterY;
+
+            return Ray (origin, Normalize (d), 0.f, INFINITY, time);
+        }
+
+        int XResolution() const { return xResolution; }
+        int YResolution() const { return yResolution; }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        int xResolution, yResolution;
+        Point origin;
+
+        // The (unnormalized) direction to raster (0, 0), and its change per
+        // pixel in x and y.
+        Vector corner, dxRaster, dyRaster;
+};
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: film.cpp
+ *
+ *  Purpose: Implement the film.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdio.h>
+
+#include "film.h"
+#include "parallel.h"
+#include "pb_ray.h"
+
+
+// Encode a linear value with the sRGB curve and quantize it to 8 bits.
+static unsigned char ToSRGB8 (float v) {
+    v = min (max (v, 0.f), 1.f);
+    v = v <= .0031308f ? 12.92f * v : 1.055f * powf (v, 1.f / 2.4f) - .055f;
+
+    return (unsigned char) (v * 255.f + .5f);
+}
+
+
+////////////////////
+// FilmTile Methods
+////////////////////
+FilmTile::FilmTile (const Film &f, int x0, int y0, int x1, int y1)
+        : film(f) {
+    const Filter &filter = film.GetFilter();
+
+    // Samples in [x0, x1) reach the pixels whose centers, at i + .5, are
+    // within the filter's width of them.
+    px0 = max (int (ceilf (x0 - .5f - filter.xWidth)), 0);
+    py0 = max (int (ceilf (y0 - .5f - filter.yWidth)), 0);
+    px1 = min (int (ceilf (x1 - .5f + filter.xWidth)), film.XResolution());
+    py1 = min (int (ceilf (y1 - .5f + filter.yWidth)), film.YResolution());
+
+    Pixel zero = { { 0.f, 0.f, 0.f }, 0.f };
+    pixels.assign (size_t (px1 - px0) * (py1 - py0), zero);
+}
+
+void FilmTile::AddSample (float x, float y, const float rgb[3]) {
+    const Filter &filter = film.GetFilter();
+    const float *table = film.filterTable;
+
+    // The sample's position relative to the pixel centers' lattice.
+    float dx = x - .5f, dy = y - .5f;
+    int x0 = max (int (ceilf (dx - filter.xWidth)), px0);
+    int y0 = max (int (ceilf (dy - filter.yWidth)), py0);
+    int x1 = min (int (floorf (dx + filter.xWidth)) + 1, px1);
+    int y1 = min (int (floorf (dy + filter.yWidth)) + 1, py1);
+
+    for (int py = y0; py < y1; ++py) {
+        int iy = min (int (fabsf (py - dy) * filter.invYWidth *
+                           kFilterTableSize), kFilterTableSize - 1);
+
+        for (int px = x0; px < x1; ++px) {
+            int ix = min (int (fabsf (px - dx) * filter.invXWidth *
+                               kFilterTableSize), kFilterTableSize - 1);
+            float weight = table[iy * kFilterTableSize + ix];
+            Pixel &pixel = GetPixel (px, py);
+
+            pixel.rgbSum[0] += weight * rgb[0];
+            pixel.rgbSum[1] += weight * rgb[1];
+            pixel.rgbSum[2] += weight * rgb[2];
+            pixel.weightSum += weight;
+        }
+    }
+}
+
+
+////////////////////
+// Film Methods
+////////////////////
+Film::Film (int xRes, int yRes, const std::shared_ptr<const Filter> &f)
+        : xResolution(xRes), yResolution(yRes), filter(f),
+          pixels(3 * size_t (xRes) * yRes, 0.f) {
+    assert (xResolution > 0 && yResolution > 0);
+
+    if (!filter)
+        filter = std::make_shared<BoxFilter> (.5f, .5f);
+
+    // Sample the filter at the centers of the table's cells.
+    for (int iy = 0; iy < kFilterTableSize; ++iy) {
+        for (int ix = 0; ix < kFilterTableSize; ++ix) {
+            float x = (ix + .5f) * filter->xWidth / kFilterTableSize;
+            float y = (iy + .5f) * filter->yWidth / kFilterTableSize;
+
+            filterTable[iy * kFilterTableSize + ix] =
+                    filter->Evaluate (x, y);
+        }
+    }
+}
+
+Film::~Film() {
+}
+
+void Film::BeginTiles (int nTiles) {
+    tiles.clear();
+    tiles.resize (nTiles);
+}
+
+FilmTile *Film::GetFilmTile (int tile, int x0, int y0, int x1, int y1) {
+    assert (tile >= 0 && tile < int (tiles.size()));
+    assert (!tiles[tile]);
+    assert (x0 >= 0 && x1 <= xResolution && y0 >= 0 && y1 <= yResolution);
+
+    tiles[tile].reset (new FilmTile (*this, x0, y0, x1, y1));
+    return tiles[tile].get();
+}
+
+
+////////////////////
+// Function:
+//      Film::MergeTiles
+//
+// Purpose:
+//      Work out every pixel from the tiles' sums.
+//
+//      The image is split into bands of rows that are resolved in
+//      parallel. Each band goes through all of the tiles in tile number
+//      order and adds up the rows they share with it, so every pixel's
+//      sums are added in the same order whatever the banding.
+//
+// Parameters:
+//      TaskScheduler *scheduler - The threads to merge on; may be NULL.
+////////////////////
+void Film::MergeTiles (TaskScheduler *scheduler) {
+    ParallelFor (scheduler, 0, yResolution, 16,
+                 [&](int64_t yBegin, int64_t yEnd) {
+        std::vector<FilmTile::Pixel> sums (
+                size_t (yEnd - yBegin) * xResolution);
+        FilmTile::Pixel zero = { { 0.f, 0.f, 0.f }, 0.f };
+
+        std::fill (sums.begin(), sums.end(), zero);
+
+        for (size_t t = 0; t < tiles.size(); ++t) {
+            FilmTile *tile = tiles[t].get();
+            if (!tile)
+                continue;
+
+            int y0 = max (tile->py0, int (yBegin));
+            int y1 = min (tile->py1, int (yEnd));
+
+            for (int y = y0; y < y1; ++y) {
+                FilmTile::Pixel *sum =
+                        &sums[size_t (y - yBegin) * xResolution];
+
+                for (int x = tile->px0; x < tile->px1; ++x) {
+                    const FilmTile::Pixel &p = tile->GetPixel (x, y);
+
+                    sum[x].rgbSum[0] += p.rgbSum[0];
+                    sum[x].rgbSum[1] += p.rgbSum[1];
+                    sum[x].rgbSum[2] += p.rgbSum[2];
+                    sum[x].weightSum += p.weightSum;
+                }
+            }
+        }
+
+        for (int64_t y = yBegin; y < yEnd; ++y) {
+            for (int x = 0; x < xResolution; ++x) {
+                const FilmTile::Pixel &sum =
+                        sums[size_t (y - yBegin) * xResolution + x];
+                float rgb[3] = { 0.f, 0.f, 0.f };
+
+                if (sum.weightSum != 0.f) {
+                    float invWeight = 1.f / sum.weightSum;
+
+                    rgb[0] = sum.rgbSum[0] * invWeight;
+                    rgb[1] = sum.rgbSum[1] * invWeight;
+                    rgb[2] = sum.rgbSum[2] * invWeight;
+                }
+
+                SetPixel (x, int (y), rgb);
+            }
+        }
+    });
+
+    tiles.clear();
+}
+
+bool Film::WriteImage (const std::string &filename) const {
+    size_t n = filename.size();
+
+    if (n >= 4 && (filename.compare (n - 4, 4, ".pfm") == 0 ||
+                   filename.compare (n - 4, 4, ".PFM") == 0))
+        return WritePFM (filename);
+
+    return WritePPM (filename);
+}
+
+bool Film::WritePPM (const std::string &filename) const {
+    FILE *f = fopen (filename.c_str(), "wb");
+    if (!f)
+        return false;
+
+    std::vector<unsigned char> row (3 * size_t (xResolution));
+    bool ok = fprintf (f, "P6\n%d %d\n255\n", xResolution, yResolution) > 0;
+
+    for (int y = 0; ok && y < yResolution; ++y) {
+        const float *p = GetPixel (0, y);
+
+        for (size_t i = 0; i < row.size(); ++i)
+            row[i] = ToSRGB8 (p[i]);
+
+        ok = fwrite (&row[0], 1, row.size(), f) == row.size();
+    }
+
+    return (fclose (f) == 0) && ok;
+}
+
+bool Film::WritePFM (const std::string &filename) const {
+    FILE *f = fopen (filename.c_str(), "wb");
+    if (!f)
+        return false;
+
+    // A negative scale marks the data as little endian, which is what the
+    // floats are written as on every platform we build for. Rows run from
+    // the bottom of the image to the top.
+    bool ok = fprintf (f, "PF\n%d %d\n-1\n", xResolution, yResolution) > 0;
+
+    for (int y = yResolution - 1; ok && y >= 0; --y) {
+        size_t n = 3 * size_t (xResolution);
+        ok = fwrite (GetPixel (0, y), sizeof (float), n, f) == n;
+    }
+
+    return (fclose (f) == 0) && ok;
+}
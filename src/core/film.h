@@ -0,0 +1,187 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: film.h
+ *
+ *  Purpose: Define the film the renderer accumulates samples in, and the
+ *           per-tile buffers threads accumulate them in first.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef FILM_H
+#define FILM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "filter.h"
+
+class Film;
+class TaskScheduler;
+
+
+// The filter is tabulated over [0, xWidth] x [0, yWidth] at this many
+// entries per axis, so adding a sample costs table lookups, not filter
+// evaluations.
+static const int kFilterTableSize = 16;
+
+
+////////////////////
+// Class: FilmTile
+//
+// Purpose:
+//      The filtered sums of the samples taken in one tile of the image.
+//
+//      A tile covers the pixels its samples were taken in plus a margin
+//      as wide as the filter, since samples near the tile's edges also
+//      count towards the pixels across them. Each tile is filled by one
+//      thread and merged into the film once every tile is done, so
+//      threads never touch each other's sums.
+////////////////////
+class FilmTile {
+    public:
+        // Add a sample taken at raster position (x, y), which must be in
+        // the tile's sample bounds, to the pixels the filter reaches.
+        void AddSample (float x, float y, const float rgb[3]);
+
+        // The pixels [x0, x1) x [y0, y1) the tile holds sums for.
+        void PixelBounds (int *x0, int *y0, int *x1, int *y1) const {
+            *x0 = px0;
+            *y0 = py0;
+            *x1 = px1;
+            *y1 = py1;
+        }
+
+    private:
+        friend class Film;
+
+        struct Pixel {
+            float rgbSum[3];
+            float weightSum;
+        };
+
+        FilmTile (const Film &film, int x0, int y0, int x1, int y1);
+
+        Pixel &GetPixel (int x, int y) {
+            return pixels[size_t (y - py0) * (px1 - px0) + (x - px0)];
+        }
+
+        ///////////////
+        // Data Members
+        ///////////////
+        const Film &film;
+        int px0, py0, px1, py1;
+        std::vector<Pixel> pixels;
+};
+
+
+////////////////////
+// Class: Film
+//
+// Purpose:
+//      An RGB image of floats, and the code to write it to disk.
+//
+//      Each pixel is the filter weighted average of the samples around
+//      it. Samples reach the film through FilmTiles: BeginTiles makes room
+//      for a render's tiles, every tile is filled by one thread through
+//      GetFilmTile, and MergeTiles adds them up. Nothing is locked, since
+//      each thread only writes its own tile's slot.
+//
+//      Tiles overlap where their filter margins meet, and floating point
+//      sums depend on the order of the terms. MergeTiles therefore adds
+//      the tiles to every pixel in tile number order, however many threads
+//      filled them and whichever finished first, so the image is the same
+//      bit for bit from run to run and for any number of threads. The
+//      price is that every tile is kept until the end of the render.
+////////////////////
+class Film {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // A NULL filter means a box filter of width .5, which averages the
+        // samples in each pixel.
+        Film (int xResolution, int yResolution,
+              const std::shared_ptr<const Filter> &filter = NULL);
+        ~Film();
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        int XResolution() const { return xResolution; }
+        int YResolution() const { return yResolution; }
+        const Filter &GetFilter() const { return *filter; }
+
+        // Make room for nTiles tiles, dropping any that weren't merged.
+        void BeginTiles (int nTiles);
+
+        // The tile for samples in the pixels [x0, x1) x [y0, y1). Only one
+        // thread may ask for a given tile number between BeginTiles and
+        // MergeTiles; the film keeps the tile.
+        FilmTile *GetFilmTile (int tile, int x0, int y0, int x1, int y1);
+
+        // Replace the image with the tiles' weighted averages, using the
+        // scheduler's threads if there is one, and free the tiles.
+        void MergeTiles (TaskScheduler *scheduler);
+
+        void SetPixel (int x, int y, const float rgb[3]) {
+            float *p = &pixels[3 * (size_t (y) * xResolution + x)];
+            p[0] = rgb[0];
+            p[1] = rgb[1];
+            p[2] = rgb[2];
+        }
+
+        const float *GetPixel (int x, int y) const {
+            return &pixels[3 * (size_t (y) * xResolution + x)];
+        }
+
+        // Write the image. Names ending in .pfm get the raw floats as a
+        // Portable Float Map; anything else gets an 8 bit sRGB binary PPM.
+        // Returns false if the file couldn't be written.
+        bool WriteImage (const std::string &filename) const;
+
+    private:
+        friend class FilmTile;
+
+        bool WritePFM (const std::string &filename) const;
+        bool WritePPM (const std::string &filename) const;
+
+        ///////////////
+        // Data Members
+        ///////////////
+        int xResolution, yResolution;
+        std::shared_ptr<const Filter> filter;
+        float filterTable[kFilterTableSize * kFilterTableSize];
+        std::vector<float> pixels;
+        std::vector<std::unique_ptr<FilmTile> > tiles;
+
+        // Film hands out pointers to its tiles.
+        Film (const Film&);
+        Film &operator= (const Film&);
+};
+
+#endif
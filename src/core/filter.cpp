@@ -0,0 +1,55 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: filter.cpp
+ *
+ *  Purpose: Implement the pixel reconstruction filters.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "filter.h"
+
+
+////////////////////
+// BoxFilter Methods
+////////////////////
+float BoxFilter::Evaluate (float, float) const {
+    return 1.f;
+}
+
+
+////////////////////
+// TriangleFilter Methods
+////////////////////
+float TriangleFilter::Evaluate (float x, float y) const {
+    return max (0.f, xWidth - fabsf (x)) * max (0.f, yWidth - fabsf (y));
+}
+
+
+////////////////////
+// GaussianFilter Methods
+////////////////////
+float GaussianFilter::Evaluate (float x, float y) const {
+    return Gaussian (x, expX) * Gaussian (y, expY);
+}
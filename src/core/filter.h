@@ -0,0 +1,124 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: filter.h
+ *
+ *  Purpose: Define the filters that weigh each sample's contribution to the
+ *           pixels around it.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "pb_ray.h"
+
+
+////////////////////
+// Class: Filter
+//
+// Purpose:
+//      Abstract base class for pixel reconstruction filters.
+//
+//      A sample contributes to every pixel whose center is within xWidth
+//      and yWidth of it, weighted by Evaluate at the offset from the pixel
+//      center. The filter is zero outside that box.
+////////////////////
+class Filter {
+    public:
+        Filter (float xw, float yw)
+                : xWidth(xw), yWidth(yw), invXWidth(1.f / xw),
+                  invYWidth(1.f / yw) { }
+        virtual ~Filter() { }
+
+        // The weight of a sample at offset (x, y) from a pixel center,
+        // with |x| <= xWidth and |y| <= yWidth.
+        virtual float Evaluate (float x, float y) const = 0;
+
+        const float xWidth, yWidth;
+        const float invXWidth, invYWidth;
+};
+
+
+////////////////////
+// Class: BoxFilter
+//
+// Purpose:
+//      Weigh every sample within the box equally. With widths of .5 each
+//      pixel is the plain average of the samples inside it.
+//
+// Inherits From: Filter
+////////////////////
+class BoxFilter : public Filter {
+    public:
+        BoxFilter (float xw, float yw) : Filter (xw, yw) { }
+
+        float Evaluate (float x, float y) const;
+};
+
+
+////////////////////
+// Class: TriangleFilter
+//
+// Purpose:
+//      A weight falling off linearly from the center to the edges of the
+//      box, along each axis.
+//
+// Inherits From: Filter
+////////////////////
+class TriangleFilter : public Filter {
+    public:
+        TriangleFilter (float xw, float yw) : Filter (xw, yw) { }
+
+        float Evaluate (float x, float y) const;
+};
+
+
+////////////////////
+// Class: GaussianFilter
+//
+// Purpose:
+//      A Gaussian exp (-alpha d^2) along each axis, shifted down so that it
+//      reaches zero at the edges of the box. Smaller alphas blur more.
+//
+// Inherits From: Filter
+////////////////////
+class GaussianFilter : public Filter {
+    public:
+        GaussianFilter (float xw, float yw, float a)
+                : Filter (xw, yw), alpha(a), expX(expf (-a * xw * xw)),
+                  expY(expf (-a * yw * yw)) { }
+
+        float Evaluate (float x, float y) const;
+
+    private:
+        float Gaussian (float d, float expv) const {
+            return max (0.f, expf (-alpha * d * d) - expv);
+        }
+
+        const float alpha;
+        const float expX, expY;
+};
+
+#endif
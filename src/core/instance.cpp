@@ -0,0 +1,156 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *
+ *
+ *  File Name: instance.cpp
+ *
+ *  Purpose: Implement the instancing primitives.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "instance.h"
+
+
+////////////////////
+// Function:
+//      RayToObject
+//
+// Purpose:
+//      Carry a world space ray into an instance's object space.
+//
+//      Rounding moves the transformed origin by up to its error bound,
+//      which could put a ray spawned just off a surface back behind it. The
+//      origin is therefore advanced along the direction to the far side of
+//      its error box (and the range shortened to match), the same
+//      conservative step SpawnRay takes in world space.
+//
+// Parameters:
+//      const Transform &worldToObject - The instance's inverse transform.
+//      const Ray &ray - The world space ray.
+//      float *dt - Receives how far, in units of the ray parameter, the
+//                  origin was advanced. Object space hits at t are at
+//                  t + dt on the world space ray.
+//
+// Returns:
+//      The object space ray.
+////////////////////
+static Ray RayToObject (const Transform &worldToObject, const Ray &ray,
+                        float *dt) {
+    Vector oError;
+    Point o = worldToObject (ray.o, &oError);
+    Vector d = worldToObject (ray.d);
+    float lengthSquared = d.LengthSquared();
+
+    *dt = 0.f;
+    if (lengthSquared > 0.f)
+        *dt = (fabsf (d.x) * oError.x + fabsf (d.y) * oError.y +
+               fabsf (d.z) * oError.z) / lengthSquared;
+
+    return Ray (o + d * *dt, d, max (0.f, ray.mint - *dt), ray.maxt - *dt,
+                ray.time);
+}
+
+
+////////////////////
+// Function:
+//      IntersectInstance
+//
+// Purpose:
+//      Intersect a ray with a primitive placed by a transform and report
+//      the hit in world space, as Primitive::Intersect does.
+//
+// Parameters:
+//      const Primitive &primitive - The instanced primitive.
+//      const Transform &worldToObject - The instance's inverse transform.
+//      const Ray &ray - The world space ray; shortened on a hit.
+//      Intersection *isect - Receives the hit.
+//
+// Returns:
+//      Whether there was a hit.
+////////////////////
+static bool IntersectInstance (const Primitive &primitive,
+                               const Transform &worldToObject,
+                               const Ray &ray, Intersection *isect) {
+    float dt;
+    Ray r = RayToObject (worldToObject, ray, &dt);
+
+    if (!primitive.Intersect (r, isect))
+        return false;
+
+    Transform objectToWorld = Inverse (worldToObject);
+
+    ray.maxt = r.maxt + dt;
+    isect->tHit = ray.maxt;
+    isect->p = objectToWorld (isect->p, isect->pError, &isect->pError);
+    isect->n = Normalize (objectToWorld (isect->n));
+    return true;
+}
+
+
+////////////////////
+// TransformedPrimitive Methods
+////////////////////
+TransformedPrimitive::TransformedPrimitive (
+        const std::shared_ptr<Primitive> &prim, const Transform &objectToWorld)
+        : primitive(prim), worldToObject(Inverse (objectToWorld)),
+          worldBound(objectToWorld (prim->WorldBound())) {
+    assert (objectToWorld.IsAffine());
+}
+
+bool TransformedPrimitive::Intersect (const Ray &ray,
+                                      Intersection *isect) const {
+    return IntersectInstance (*primitive, worldToObject, ray, isect);
+}
+
+bool TransformedPrimitive::IntersectP (const Ray &ray) const {
+    float dt;
+    return primitive->IntersectP (RayToObject (worldToObject, ray, &dt));
+}
+
+
+////////////////////
+// AnimatedPrimitive Methods
+////////////////////
+AnimatedPrimitive::AnimatedPrimitive (const std::shared_ptr<Primitive> &prim,
+                                      const AnimatedTransform &objectToWorld)
+        : primitive(prim), objectToWorld(objectToWorld),
+          worldBound(objectToWorld.MotionBounds (prim->WorldBound())) {
+}
+
+bool AnimatedPrimitive::Intersect (const Ray &ray,
+                                   Intersection *isect) const {
+    Transform t;
+    objectToWorld.Interpolate (ray.time, &t);
+
+    return IntersectInstance (*primitive, Inverse (t), ray, isect);
+}
+
+bool AnimatedPrimitive::IntersectP (const Ray &ray) const {
+    Transform t;
+    float dt;
+    objectToWorld.Interpolate (ray.time, &t);
+
+    return primitive->IntersectP (RayToObject (Inverse (t), ray, &dt));
+}
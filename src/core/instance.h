@@ -0,0 +1,152 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *
+ *
+ *  File Name: instance.h
+ *
+ *  Purpose: Define primitives that place a shared copy of another
+ *           primitive (usually a whole BVH) into the scene.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <memory>
+
+#include "primitive.h"
+#include "transform.h"
+
+
+////////////////////
+// Class: TransformedPrimitive
+//
+// Purpose:
+//      One instance of a shared primitive, placed in the world by a
+//      transform. The primitive is typically the bottom level BVH of an
+//      asset, and a BVHAccel over many TransformedPrimitives forms the top
+//      level: its leaves hold instance bounds in world space, and rays are
+//      carried into each instance's object space when they reach it.
+//
+//      Memory then grows with the unique geometry plus a small fixed cost
+//      per instance (the transform, one pointer and the world bound),
+//      however large the asset.
+//
+//      Hits are reported in world space. Ray parameters are the same in
+//      both spaces, since the direction is transformed without being
+//      normalized. isect->primitive is the primitive hit inside the shared
+//      one, so it is the same for every instance.
+//
+// Notes:
+//      The transform must be affine.
+//
+// Inherits From: Primitive
+////////////////////
+class TransformedPrimitive : public Primitive {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        TransformedPrimitive (const std::shared_ptr<Primitive> &prim,
+                              const Transform &objectToWorld);
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        BBox WorldBound() const { return worldBound; }
+
+        bool Intersect (const Ray &ray, Intersection *isect) const;
+        bool IntersectP (const Ray &ray) const;
+
+        const std::shared_ptr<Primitive> &GetPrimitive() const {
+            return primitive;
+        }
+
+        // The object to world transform.
+        Transform ObjectToWorld() const { return Inverse (worldToObject); }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        std::shared_ptr<Primitive> primitive;
+        Transform worldToObject;
+        BBox worldBound;
+};
+
+
+////////////////////
+// Class: AnimatedPrimitive
+//
+// Purpose:
+//      An instance that moves: a TransformedPrimitive whose transform is
+//      evaluated at each ray's time, for motion blur.
+//
+//      The world bound is the AnimatedTransform's motion bound of the
+//      primitive, so a BVH over AnimatedPrimitives finds them at any time
+//      in the interval.
+//
+//      This is a separate class rather than an option of
+//      TransformedPrimitive so that static instances don't pay for the
+//      keyframes' storage.
+//
+// Inherits From: Primitive
+////////////////////
+class AnimatedPrimitive : public Primitive {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        AnimatedPrimitive (const std::shared_ptr<Primitive> &prim,
+                           const AnimatedTransform &objectToWorld);
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        BBox WorldBound() const { return worldBound; }
+
+        bool Intersect (const Ray &ray, Intersection *isect) const;
+        bool IntersectP (const Ray &ray) const;
+
+        const std::shared_ptr<Primitive> &GetPrimitive() const {
+            return primitive;
+        }
+
+        const AnimatedTransform &ObjectToWorld() const {
+            return objectToWorld;
+        }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        std::shared_ptr<Primitive> primitive;
+        AnimatedTransform objectToWorld;
+        BBox worldBound;
+};
+
+#endif
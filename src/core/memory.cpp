@@ -0,0 +1,145 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: memory.cpp
+ *
+ *  Purpose: Implement the cache-line aligned allocation functions.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdlib.h>
+
+#ifdef PB_RAY_WINDOWS
+#include <malloc.h>
+#endif
+
+#include "memory.h"
+#include "stats.h"
+
+
+static StatMemoryCounter arenaBytes ("Memory/Arena blocks allocated");
+
+
+void *AllocAligned (size_t size) {
+#ifdef PB_RAY_WINDOWS
+    return _aligned_malloc (size, PB_RAY_L1_CACHE_LINE_SIZE);
+#else
+    void *ptr;
+
+    if (posix_memalign (&ptr, PB_RAY_L1_CACHE_LINE_SIZE, size) != 0)
+        return NULL;
+
+    return ptr;
+#endif
+}
+
+void FreeAligned (void *ptr) {
+    if (!ptr)
+        return;
+
+#ifdef PB_RAY_WINDOWS
+    _aligned_free (ptr);
+#else
+    free (ptr);
+#endif
+}
+
+
+////////////////////
+// MemoryArena Methods
+////////////////////
+MemoryArena::MemoryArena (size_t bs)
+        : blockSize(bs), currentPos(0), currentSize(0), currentBlock(NULL) {
+}
+
+MemoryArena::~MemoryArena() {
+    FreeAligned (currentBlock);
+
+    for (size_t i = 0; i < usedBlocks.size(); ++i)
+        FreeAligned (usedBlocks[i].second);
+    for (size_t i = 0; i < availableBlocks.size(); ++i)
+        FreeAligned (availableBlocks[i].second);
+}
+
+void MemoryArena::FreeAll() {
+    currentPos = 0;
+    availableBlocks.insert (availableBlocks.end(), usedBlocks.begin(),
+                            usedBlocks.end());
+    usedBlocks.clear();
+}
+
+size_t MemoryArena::TotalAllocated() const {
+    size_t total = currentSize;
+
+    for (size_t i = 0; i < usedBlocks.size(); ++i)
+        total += usedBlocks[i].first;
+    for (size_t i = 0; i < availableBlocks.size(); ++i)
+        total += availableBlocks[i].first;
+
+    return total;
+}
+
+
+////////////////////
+// Function:
+//      MemoryArena::NewBlock
+//
+// Purpose:
+//      Retire the current block and make one with room for at least
+//      minSize bytes current, reusing a free block if one is big enough.
+//      Throws std::bad_alloc if a new block can't be allocated.
+////////////////////
+void MemoryArena::NewBlock (size_t minSize) {
+    if (currentBlock)
+        usedBlocks.push_back (std::make_pair (currentSize, currentBlock));
+
+    currentBlock = NULL;
+
+    for (size_t i = 0; i < availableBlocks.size(); ++i) {
+        if (availableBlocks[i].first >= minSize) {
+            currentSize = availableBlocks[i].first;
+            currentBlock = availableBlocks[i].second;
+            availableBlocks.erase (availableBlocks.begin() + i);
+            break;
+        }
+    }
+
+    if (!currentBlock) {
+        size_t size = max (minSize, blockSize);
+        char *block = static_cast<char*> (AllocAligned (size));
+
+        // Run out of memory the way new does. The arena is left empty, so
+        // the next Alloc tries again instead of writing through NULL.
+        if (!block) {
+            currentPos = currentSize = 0;
+            throw std::bad_alloc();
+        }
+
+        currentSize = size;
+        currentBlock = block;
+        arenaBytes += int64_t (currentSize);
+    }
+
+    currentPos = 0;
+}
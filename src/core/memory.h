@@ -0,0 +1,169 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: memory.h
+ *
+ *  Purpose: Declare the cache-line aligned allocation functions.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pb_ray.h"
+
+// The cache line size assumed when laying out hot data.
+#ifndef PB_RAY_L1_CACHE_LINE_SIZE
+#define PB_RAY_L1_CACHE_LINE_SIZE 64
+#endif
+
+
+////////////////////
+// Function:
+//      AllocAligned
+//
+// Purpose:
+//      Allocate memory that starts on a cache line boundary. Used for
+//      arrays of types that are laid out to fill cache lines exactly,
+//      which neither new (before C++17) nor std::vector will align.
+//
+// Parameters:
+//      size_t size - The number of bytes to allocate.
+//      size_t count - The number of objects of type T to allocate room for.
+//
+// Returns:
+//      The memory, or NULL if it couldn't be allocated. Release it with
+//      FreeAligned. The templated version does not construct the objects.
+////////////////////
+void *AllocAligned (size_t size);
+
+template <typename T>
+T *AllocAligned (size_t count) {
+    return static_cast<T*> (AllocAligned (count * sizeof (T)));
+}
+
+void FreeAligned (void *ptr);
+
+
+////////////////////
+// Class: MemoryArena
+//
+// Purpose:
+//      A bump pointer allocator for data that lives for one sample (or one
+//      batch of samples) and is then thrown away all at once.
+//
+//      Memory is handed out from the current block by moving a pointer
+//      forward; a block that is too full is set aside and the next one is
+//      taken. FreeAll makes every block available again without returning
+//      any of them to the heap, so once an arena has grown to what a
+//      sample needs, allocating from it never calls malloc, takes no lock
+//      and touches no memory another thread uses.
+//
+//      Each render thread owns one; an arena must not be shared between
+//      threads.
+//
+// Notes:
+//      Destructors are never run, so only trivially destructible types
+//      can be allocated.
+////////////////////
+class MemoryArena {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // Blocks are blockSize bytes, or bigger for larger allocations.
+        explicit MemoryArena (size_t blockSize = 262144);
+        ~MemoryArena();
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // size bytes aligned to align, which must be a power of two no
+        // bigger than PB_RAY_L1_CACHE_LINE_SIZE.
+        void *Alloc (size_t size, size_t align = 16) {
+            assert (align <= PB_RAY_L1_CACHE_LINE_SIZE &&
+                    (align & (align - 1)) == 0);
+
+            size_t pos = (currentPos + align - 1) & ~(align - 1);
+
+            if (pos + size > currentSize) {
+                NewBlock (size);
+                pos = 0;
+            }
+
+            currentPos = pos + size;
+            return currentBlock + pos;
+        }
+
+        // count default constructed Ts.
+        template <typename T>
+        T *Alloc (size_t count = 1) {
+            static_assert (std::is_trivially_destructible<T>::value,
+                           "MemoryArena never runs destructors");
+
+            size_t align = alignof (T) > 16 ? alignof (T) : 16;
+            T *ret = static_cast<T*> (Alloc (count * sizeof (T), align));
+
+            for (size_t i = 0; i < count; ++i)
+                new (&ret[i]) T();
+
+            return ret;
+        }
+
+        // Release everything allocated so far, keeping the blocks for
+        // reuse.
+        void FreeAll();
+
+        // The bytes of all the blocks the arena holds.
+        size_t TotalAllocated() const;
+
+    private:
+        void NewBlock (size_t minSize);
+
+        ///////////////
+        // Data Members
+        ///////////////
+        const size_t blockSize;
+        size_t currentPos, currentSize;
+        char *currentBlock;
+
+        // Blocks filled since the last FreeAll, and blocks free for reuse,
+        // with their sizes.
+        std::vector<std::pair<size_t, char*> > usedBlocks, availableBlocks;
+
+        MemoryArena (const MemoryArena&);
+        MemoryArena &operator= (const MemoryArena&);
+};
+
+#endif
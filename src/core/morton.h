@@ -0,0 +1,161 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: morton.h
+ *
+ *  Purpose: Morton (Z-order) codes, which map points in a cube to integers
+ *           so that points close in space tend to be close in the order.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <stdint.h>
+
+#include "pb_ray.h"
+
+
+////////////////////
+// Function:
+//      LeftShift3
+//
+// Purpose:
+//      Spread the bits of x out so that there are two zero bits between
+//      each of them: bit i of x ends up in bit 3i of the result.
+//
+// Parameters:
+//      uint32_t x - The value to spread. Only the low 10 bits are used.
+//      uint64_t x - The value to spread. Only the low 21 bits are used.
+//
+// Returns:
+//      The spread bits.
+////////////////////
+inline uint32_t LeftShift3 (uint32_t x) {
+    assert (x < (1u << 10));
+
+    x = (x | (x << 16)) & 0x030000FF;
+    x = (x | (x << 8))  & 0x0300F00F;
+    x = (x | (x << 4))  & 0x030C30C3;
+    x = (x | (x << 2))  & 0x09249249;
+    return x;
+}
+
+inline uint64_t LeftShift3 (uint64_t x) {
+    assert (x < (uint64_t (1) << 21));
+
+    x = (x | (x << 32)) & 0x001F00000000FFFFull;
+    x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+    x = (x | (x << 8))  & 0x100F00F00F00F00Full;
+    x = (x | (x << 4))  & 0x10C30C30C30C30C3ull;
+    x = (x | (x << 2))  & 0x1249249249249249ull;
+    return x;
+}
+
+
+////////////////////
+// Function:
+//      EncodeMorton3
+//
+// Purpose:
+//      Interleave the bits of three coordinates into one Morton code. The
+//      x bits land in bit positions 0, 3, 6, ..., y in 1, 4, 7, ... and z
+//      in 2, 5, 8, ..., so bit b of a code belongs to axis b % 3.
+//
+// Parameters:
+//      uint32_t x, y, z - 10 bit coordinates, giving a 30 bit code.
+//      uint64_t x, y, z - 21 bit coordinates, giving a 63 bit code.
+//
+// Returns:
+//      The Morton code.
+////////////////////
+inline uint32_t EncodeMorton3 (uint32_t x, uint32_t y, uint32_t z) {
+    return (LeftShift3 (z) << 2) | (LeftShift3 (y) << 1) | LeftShift3 (x);
+}
+
+inline uint64_t EncodeMorton3 (uint64_t x, uint64_t y, uint64_t z) {
+    return (LeftShift3 (z) << 2) | (LeftShift3 (y) << 1) | LeftShift3 (x);
+}
+
+
+////////////////////
+// Function:
+//      EncodeMorton2
+//
+// Purpose:
+//      Interleave the bits of two coordinates into one Morton code, x in
+//      the even bits and y in the odd ones. The renderer orders image
+//      tiles with it.
+//
+// Parameters:
+//      uint32_t x, y - 16 bit coordinates.
+//
+// Returns:
+//      The 32 bit Morton code.
+////////////////////
+inline uint32_t EncodeMorton2 (uint32_t x, uint32_t y) {
+    assert (x < (1u << 16) && y < (1u << 16));
+
+    uint32_t v[2] = { x, y };
+
+    for (int i = 0; i < 2; ++i) {
+        v[i] = (v[i] | (v[i] << 8)) & 0x00FF00FF;
+        v[i] = (v[i] | (v[i] << 4)) & 0x0F0F0F0F;
+        v[i] = (v[i] | (v[i] << 2)) & 0x33333333;
+        v[i] = (v[i] | (v[i] << 1)) & 0x55555555;
+    }
+
+    return (v[1] << 1) | v[0];
+}
+
+
+////////////////////
+// Function:
+//      Log2Int
+//
+// Purpose:
+//      Find the index of the highest set bit.
+//
+// Parameters:
+//      uint64_t v - Must not be zero.
+//
+// Returns:
+//      floor (log2 (v)).
+////////////////////
+inline int Log2Int (uint64_t v) {
+    assert (v != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll (v);
+#else
+    int bit = 0;
+
+    while (v >>= 1)
+        ++bit;
+
+    return bit;
+#endif
+}
+
+#endif
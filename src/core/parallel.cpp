@@ -0,0 +1,284 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: parallel.cpp
+ *
+ *  Purpose: Implement the work-stealing task scheduler.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <assert.h>
+
+#include "parallel.h"
+
+
+// The scheduler (if any) the current thread is a worker of, and its index.
+static thread_local const TaskScheduler *currentScheduler = NULL;
+static thread_local int currentIndex = 0;
+
+// How many times an idle worker looks for work before it parks.
+static const int kSpinsBeforeParking = 64;
+
+
+////////////////////
+// TaskScheduler Methods
+////////////////////
+TaskScheduler::TaskScheduler (int n)
+        : nThreads(n), queuedTasks(0), sleepingWorkers(0), shutdown(false) {
+    if (nThreads <= 0)
+        nThreads = std::max (1, int (std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < nThreads; ++i)
+        deques.push_back (std::unique_ptr<WorkStealingDeque<WorkItem> > (
+                new WorkStealingDeque<WorkItem>));
+
+    for (int i = 1; i < nThreads; ++i)
+        threads.push_back (std::thread (&TaskScheduler::WorkerLoop, this, i));
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock (sleepMutex);
+        shutdown = true;
+    }
+    sleepCondition.notify_all();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+}
+
+TaskScheduler *TaskScheduler::Shared (int n) {
+    static TaskScheduler shared (n);
+    return &shared;
+}
+
+int TaskScheduler::ThreadIndex() const {
+    return currentScheduler == this ? currentIndex : 0;
+}
+
+void TaskScheduler::Spawn (TaskGroup &group, const Task &task) {
+    WorkItem *item = new WorkItem;
+    item->task = task;
+    item->group = &group;
+
+    group.pending.fetch_add (1);
+
+    int index = ThreadIndex();
+
+    if (index > 0)
+        deques[index]->Push (item);
+    else {
+        std::lock_guard<std::mutex> lock (injectionMutex);
+        injection.push_back (item);
+    }
+
+    // Pairs with the check in WorkerLoop: either the parking worker sees
+    // the new task before it waits, or we see it parked and wake it.
+    queuedTasks.fetch_add (1);
+
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock (sleepMutex);
+        sleepCondition.notify_one();
+    }
+}
+
+void TaskScheduler::Wait (TaskGroup &group) {
+    uint32_t rngState = uint32_t (ThreadIndex()) * 2654435761u + 1u;
+
+    while (!group.Done()) {
+        if (!TryRunTask (ThreadIndex(), &rngState))
+            std::this_thread::yield();
+    }
+}
+
+
+////////////////////
+// Function:
+//      TaskScheduler::PopOrSteal
+//
+// Purpose:
+//      Find the next task for thread index: the newest task in its own
+//      deque (the newest in the injection queue for threads outside the
+//      pool), failing that the oldest task of the other deques, starting
+//      at a random victim, and finally the oldest injected task.
+//
+// Returns:
+//      The task, or NULL if none was found.
+////////////////////
+TaskScheduler::WorkItem *TaskScheduler::PopOrSteal (int index,
+                                                    uint32_t *rngState) {
+    WorkItem *item = NULL;
+
+    if (index > 0) {
+        if ((item = deques[index]->Pop()) != NULL)
+            return item;
+    }
+    else {
+        std::lock_guard<std::mutex> lock (injectionMutex);
+
+        if (!injection.empty()) {
+            item = injection.back();
+            injection.pop_back();
+            return item;
+        }
+    }
+
+    // xorshift; good enough to spread the thieves out.
+    uint32_t x = *rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *rngState = x;
+
+    int victim = 1 + int (x % uint32_t (std::max (nThreads - 1, 1)));
+
+    for (int i = 1; i < nThreads; ++i, victim = victim % (nThreads - 1) + 1) {
+        if (victim != index && (item = deques[victim]->Steal()) != NULL)
+            return item;
+    }
+
+    if (index > 0) {
+        std::lock_guard<std::mutex> lock (injectionMutex);
+
+        if (!injection.empty()) {
+            item = injection.front();
+            injection.pop_front();
+        }
+    }
+
+    return item;
+}
+
+bool TaskScheduler::TryRunTask (int index, uint32_t *rngState) {
+    if (queuedTasks.load() == 0)
+        return false;
+
+    WorkItem *item = PopOrSteal (index, rngState);
+
+    if (!item)
+        return false;
+
+    queuedTasks.fetch_sub (1);
+
+    item->task();
+    item->group->pending.fetch_sub (1);
+    delete item;
+
+    return true;
+}
+
+void TaskScheduler::WorkerLoop (int index) {
+    currentScheduler = this;
+    currentIndex = index;
+
+    uint32_t rngState = uint32_t (index) * 2654435761u + 1u;
+    int spins = 0;
+
+    while (!shutdown.load()) {
+        if (TryRunTask (index, &rngState)) {
+            spins = 0;
+            continue;
+        }
+
+        // A thief can lose a race for a task that someone else then
+        // finishes quickly, and tasks often come in bursts, so look
+        // again a few times before paying for a sleep and a wake up.
+        if (++spins < kSpinsBeforeParking) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        spins = 0;
+
+        // Nothing to run; park until a task is spawned.
+        std::unique_lock<std::mutex> lock (sleepMutex);
+        sleepingWorkers.fetch_add (1);
+
+        while (queuedTasks.load() == 0 && !shutdown.load())
+            sleepCondition.wait (lock);
+
+        sleepingWorkers.fetch_sub (1);
+    }
+}
+
+
+////////////////////
+// Function:
+//      ParallelFor
+////////////////////
+void ParallelFor (TaskScheduler *scheduler, int64_t start, int64_t end,
+                  int64_t grainSize,
+                  const std::function<void (int64_t, int64_t)> &func) {
+    assert (grainSize > 0);
+
+    if (!scheduler || scheduler->NumThreads() == 1 ||
+        end - start <= grainSize) {
+        if (start < end)
+            func (start, end);
+        return;
+    }
+
+    TaskGroup group;
+
+    for (int64_t chunk = start + grainSize; chunk < end; chunk += grainSize) {
+        int64_t chunkEnd = std::min (chunk + grainSize, end);
+
+        scheduler->Spawn (group, [&func, chunk, chunkEnd]() {
+            func (chunk, chunkEnd);
+        });
+    }
+
+    // The caller takes the first chunk itself.
+    func (start, std::min (start + grainSize, end));
+
+    scheduler->Wait (group);
+}
+
+
+////////////////////
+// Function:
+//      ParallelFor2D
+////////////////////
+void ParallelFor2D (TaskScheduler *scheduler, int x0, int y0, int x1, int y1,
+                    int tileSize,
+                    const std::function<void (int, int, int, int)> &func) {
+    assert (tileSize > 0);
+
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    int nTilesX = (x1 - x0 + tileSize - 1) / tileSize;
+    int nTilesY = (y1 - y0 + tileSize - 1) / tileSize;
+
+    ParallelFor (scheduler, 0, int64_t (nTilesX) * nTilesY, 1,
+                 [&](int64_t begin, int64_t end) {
+        for (int64_t tile = begin; tile < end; ++tile) {
+            int tx = x0 + int (tile % nTilesX) * tileSize;
+            int ty = y0 + int (tile / nTilesX) * tileSize;
+
+            func (tx, ty, std::min (tx + tileSize, x1),
+                  std::min (ty + tileSize, y1));
+        }
+    });
+}
@@ -0,0 +1,402 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: parallel.h
+ *
+ *  Purpose: Provide a work-stealing task scheduler and the parallel loops
+ *           built on top of it.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskScheduler;
+
+
+////////////////////
+// Class: WorkStealingDeque
+//
+// Purpose:
+//      A Chase-Lev deque of pointers: one owner thread pushes and pops at
+//      the bottom without locking, and any number of thieves take from
+//      the top with a compare-and-swap.
+//
+//      The owner only contends with thieves over the last item, so in the
+//      common case of a worker running the tasks it spawned itself no
+//      atomic read-modify-write happens at all.
+//
+//      The ring buffer doubles when it fills up. A thief may still be
+//      reading the old one, so old buffers are only freed with the deque.
+//
+// Notes:
+//      Push and Pop must only be called by the owner.
+////////////////////
+template <typename T>
+class WorkStealingDeque {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        explicit WorkStealingDeque (int64_t capacity = 256)
+                : top(0), bottom(0), buffer(new Buffer (capacity)) {
+            retired.push_back (std::unique_ptr<Buffer> (buffer.load()));
+        }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        void Push (T *item) {
+            int64_t b = bottom.load (std::memory_order_relaxed);
+            int64_t t = top.load (std::memory_order_acquire);
+            Buffer *a = buffer.load (std::memory_order_relaxed);
+
+            if (b - t >= a->capacity)
+                a = Grow (a, t, b);
+
+            a->Put (b, item);
+            std::atomic_thread_fence (std::memory_order_release);
+            bottom.store (b + 1, std::memory_order_relaxed);
+        }
+
+        // The newest item, or NULL if the deque is empty.
+        T *Pop() {
+            int64_t b = bottom.load (std::memory_order_relaxed) - 1;
+            Buffer *a = buffer.load (std::memory_order_relaxed);
+
+            bottom.store (b, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+
+            int64_t t = top.load (std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom.store (b + 1, std::memory_order_relaxed);
+                return NULL;
+            }
+
+            T *item = a->Get (b);
+
+            if (t == b) {
+                // The last item: race the thieves for it.
+                if (!top.compare_exchange_strong (t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed))
+                    item = NULL;
+                bottom.store (b + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        // The oldest item, or NULL if the deque is empty or another thread
+        // took it first.
+        T *Steal() {
+            int64_t t = top.load (std::memory_order_acquire);
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+            int64_t b = bottom.load (std::memory_order_acquire);
+
+            if (t >= b)
+                return NULL;
+
+            Buffer *a = buffer.load (std::memory_order_acquire);
+            T *item = a->Get (t);
+
+            if (!top.compare_exchange_strong (t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                return NULL;
+
+            return item;
+        }
+
+        // A snapshot; only exact when no other thread is using the deque.
+        int64_t Size() const {
+            int64_t b = bottom.load (std::memory_order_relaxed);
+            int64_t t = top.load (std::memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+
+    private:
+        struct Buffer {
+            explicit Buffer (int64_t c)
+                    : capacity(c), mask(c - 1), items(new std::atomic<T*>[c]) {
+                // The index arithmetic relies on a power of two.
+                assert (c > 0 && (c & (c - 1)) == 0);
+            }
+
+            T *Get (int64_t i) const {
+                return items[i & mask].load (std::memory_order_relaxed);
+            }
+
+            void Put (int64_t i, T *item) {
+                items[i & mask].store (item, std::memory_order_relaxed);
+            }
+
+            const int64_t capacity, mask;
+            std::unique_ptr<std::atomic<T*>[]> items;
+        };
+
+        Buffer *Grow (Buffer *a, int64_t t, int64_t b) {
+            Buffer *bigger = new Buffer (2 * a->capacity);
+
+            for (int64_t i = t; i < b; ++i)
+                bigger->Put (i, a->Get (i));
+
+            retired.push_back (std::unique_ptr<Buffer> (bigger));
+            buffer.store (bigger, std::memory_order_release);
+            return bigger;
+        }
+
+        ///////////////
+        // Data Members
+        ///////////////
+
+        // Thieves hammer top while the owner works at bottom; keep them on
+        // separate cache lines. (Padding rather than alignas, which plain
+        // new doesn't honour before C++17.)
+        std::atomic<int64_t> top;
+        char padding[64];
+        std::atomic<int64_t> bottom;
+        std::atomic<Buffer*> buffer;
+
+        // Every buffer the deque has used, owned by the owner thread.
+        std::vector<std::unique_ptr<Buffer> > retired;
+
+        WorkStealingDeque (const WorkStealingDeque&);
+        WorkStealingDeque &operator= (const WorkStealingDeque&);
+};
+
+
+////////////////////
+// Class: TaskGroup
+//
+// Purpose:
+//      Track a set of tasks so that a caller can wait for all of them.
+//      Tasks spawned into a group may spawn more tasks into the same (or
+//      another) group.
+////////////////////
+class TaskGroup {
+    public:
+        TaskGroup() : pending(0) { }
+
+        bool Done() const { return pending.load() == 0; }
+
+    private:
+        friend class TaskScheduler;
+
+        std::atomic<int> pending;
+
+        // Waiting on a copy would make no sense.
+        TaskGroup (const TaskGroup&);
+        TaskGroup &operator= (const TaskGroup&);
+};
+
+
+////////////////////
+// Class: TaskScheduler
+//
+// Purpose:
+//      A pool of worker threads that execute tasks with work stealing.
+//
+//      Every worker owns a WorkStealingDeque. A task spawned from a worker
+//      goes to the bottom of that worker's deque and the worker pops from
+//      the bottom, so it works depth first on the subtree of tasks it
+//      created itself (which keeps its data hot in cache). An idle worker
+//      steals from the top of a random victim's deque, which is where the
+//      oldest (and typically biggest) tasks are. None of this takes a
+//      lock. Tasks spawned from threads that are not workers go into a
+//      shared, locked injection queue.
+//
+//      Wait() doesn't block: the waiting thread runs tasks itself until the
+//      group is done, so recursive fork / join (spawn one half, do the
+//      other, wait) never deadlocks and never leaves a core idle. Workers
+//      that find nothing to do spin briefly, then park until more tasks
+//      are spawned.
+//
+//      Shared() is the pool the whole process is meant to use. Subsystems
+//      that each start their own pool end up with more threads than cores
+//      when they run at the same time; sharing one lets their tasks
+//      interleave on the same threads instead.
+//
+// Notes:
+//      The thread that constructs the scheduler is expected to take part
+//      through Wait(), so only nThreads - 1 worker threads are started.
+////////////////////
+class TaskScheduler {
+    public:
+        typedef std::function<void ()> Task;
+
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // nThreads <= 0 means one thread per hardware thread.
+        explicit TaskScheduler (int nThreads = 0);
+        ~TaskScheduler();
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // The process wide pool, started on first use with nThreads
+        // threads (one per hardware thread if nThreads <= 0). Later calls
+        // get the same pool whatever they ask for.
+        static TaskScheduler *Shared (int nThreads = 0);
+
+        int NumThreads() const { return nThreads; }
+
+        void Spawn (TaskGroup &group, const Task &task);
+        void Wait (TaskGroup &group);
+
+        // The index of the calling worker in [1, NumThreads()), or 0 for a
+        // thread that isn't one of this scheduler's workers.
+        int ThreadIndex() const;
+
+    private:
+        struct WorkItem {
+            Task task;
+            TaskGroup *group;
+        };
+
+        void WorkerLoop (int index);
+        bool TryRunTask (int index, uint32_t *rngState);
+        WorkItem *PopOrSteal (int index, uint32_t *rngState);
+
+        ///////////////
+        // Data Members
+        ///////////////
+        int nThreads;
+
+        // deques[i] belongs to worker i; deques[0] is unused, since threads
+        // outside the pool share the injection queue instead.
+        std::vector<std::unique_ptr<WorkStealingDeque<WorkItem> > > deques;
+        std::mutex injectionMutex;
+        std::deque<WorkItem*> injection;
+        std::vector<std::thread> threads;
+
+        std::atomic<int> queuedTasks;
+        std::atomic<int> sleepingWorkers;
+        std::atomic<bool> shutdown;
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+
+        TaskScheduler (const TaskScheduler&);
+        TaskScheduler &operator= (const TaskScheduler&);
+};
+
+
+////////////////////
+// Function:
+//      ParallelFor
+//
+// Purpose:
+//      Run func (begin, end) over [start, end) split into chunks of about
+//      grainSize iterations, in parallel on the scheduler. Returns once
+//      every chunk has run.
+//
+//      A NULL scheduler runs the whole range on the calling thread.
+////////////////////
+void ParallelFor (TaskScheduler *scheduler, int64_t start, int64_t end,
+                  int64_t grainSize,
+                  const std::function<void (int64_t, int64_t)> &func);
+
+
+////////////////////
+// Function:
+//      ParallelFor2D
+//
+// Purpose:
+//      Run func (x0, y0, x1, y1) over the tiles of tileSize x tileSize
+//      that [x0, x1) x [y0, y1) splits into (smaller along the right and
+//      bottom edges), one task per tile, in parallel on the scheduler.
+//      Returns once every tile has run.
+//
+//      A NULL scheduler runs the tiles in scanline order on the calling
+//      thread.
+////////////////////
+void ParallelFor2D (TaskScheduler *scheduler, int x0, int y0, int x1, int y1,
+                    int tileSize,
+                    const std::function<void (int, int, int, int)> &func);
+
+
+////////////////////
+// Function:
+//      ParallelReduce
+//
+// Purpose:
+//      Reduce [start, end) in chunks of about grainSize iterations in
+//      parallel: func (begin, end) reduces one chunk to a T, and the
+//      chunks' results are combined with combine (a, b), starting from
+//      identity.
+//
+//      The results are combined on the calling thread in chunk order, so
+//      for a given grainSize the result doesn't depend on the number of
+//      threads or on which chunk finished first, even if combine isn't
+//      associative (floating point sums).
+//
+// Returns:
+//      combine (... combine (combine (identity, r0), r1) ..., rN).
+////////////////////
+template <typename T, typename Func, typename Combine>
+T ParallelReduce (TaskScheduler *scheduler, int64_t start, int64_t end,
+                  int64_t grainSize, const T &identity, const Func &func,
+                  const Combine &combine) {
+    if (start >= end)
+        return identity;
+
+    int64_t nChunks = (end - start + grainSize - 1) / grainSize;
+    std::vector<T> results (nChunks, identity);
+
+    ParallelFor (scheduler, 0, nChunks, 1,
+                 [&](int64_t first, int64_t last) {
+        for (int64_t c = first; c < last; ++c) {
+            int64_t begin = start + c * grainSize;
+
+            results[c] = func (begin, std::min (begin + grainSize, end));
+        }
+    });
+
+    T result = identity;
+    for (int64_t c = 0; c < nChunks; ++c)
+        result = combine (result, results[c]);
+
+    return result;
+}
+
+#endif
@@ -28,18 +28,47 @@
  *  Last Modified: Mon 22 Jul 2013 05:01:08 PM PDT
  */
 
+#ifndef PB_RAY_H
+#define PB_RAY_H
+
 #if defined(_WIN32) || defined(WIN62)
 #define PB_RAY_WINDOWS
 #endif
 
+// SIMD support
+//      SSE is used for the small fixed-width kernels (slab tests, etc.)
+//      whenever the compiler targets it. Define PB_RAY_NO_SIMD to force
+//      the scalar code paths.
+#if !defined(PB_RAY_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PB_RAY_SSE
+#endif
+
+#if defined(__AVX__)
+#define PB_RAY_AVX
+#endif
+#endif
+
 #include <math.h>
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 #include <algorithm>
+#include <limits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 
 #ifndef INFINITY
 #define INFINITY FLT_MAX
 #endif
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 using std::min;
 using std::max;
 
@@ -47,4 +76,125 @@ using std::max;
 // Global Inline Functions
 inline float Lerp (float t, float v1, float v2) {
 	return (1.f - t) * v1 + t * v2;
-}
\ No newline at end of file
+}
+
+inline float Radians (float deg) {
+	return (float (M_PI) / 180.f) * deg;
+}
+
+inline float Degrees (float rad) {
+	return (180.f / float (M_PI)) * rad;
+}
+
+
+// Floating Point Error Bounds
+//      Every float operation is exact up to a relative error of
+//      MachineEpsilon, so a value computed with n operations is off by at
+//      most Gamma (n) times its magnitude. These bound the error of hit
+//      points so that rays leaving a surface can be offset just far enough
+//      not to hit it again.
+static const float MachineEpsilon =
+        std::numeric_limits<float>::epsilon() * .5f;
+
+inline float Gamma (int n) {
+	return (n * MachineEpsilon) / (1.f - n * MachineEpsilon);
+}
+
+inline uint32_t FloatToBits (float f) {
+	uint32_t bits;
+	memcpy (&bits, &f, sizeof (float));
+	return bits;
+}
+
+inline float BitsToFloat (uint32_t bits) {
+	float f;
+	memcpy (&f, &bits, sizeof (float));
+	return f;
+}
+
+// Convert between float and IEEE half precision, rounding to nearest
+// even. Values too large for a half become infinity; NaNs stay NaNs.
+// Builds targeting F16C (-mf16c, -march=native) use its instructions.
+inline uint16_t FloatToHalf (float f) {
+#if defined(__F16C__)
+	return uint16_t (_cvtss_sh (f, 0));
+#else
+	const uint32_t f16Max = (127 + 16) << 23;
+	const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+	uint32_t bits = FloatToBits (f);
+	uint32_t sign = bits & 0x80000000u;
+	uint32_t h;
+
+	bits ^= sign;
+
+	if (bits >= f16Max)
+		h = bits > 0x7F800000u ? 0x7E00 : 0x7C00;
+	else if (bits < (113u << 23)) {
+		// Denormal (or zero) result: adding the magic number lines the
+		// mantissa up with the bottom bits and rounds it.
+		h = FloatToBits (BitsToFloat (bits) + BitsToFloat (denormMagic)) -
+		    denormMagic;
+	}
+	else {
+		uint32_t mantOdd = (bits >> 13) & 1;
+
+		bits += (uint32_t (15 - 127) << 23) + 0xFFF + mantOdd;
+		h = bits >> 13;
+	}
+
+	return uint16_t (h | (sign >> 16));
+#endif
+}
+
+inline float HalfToFloat (uint16_t h) {
+#if defined(__F16C__)
+	return _cvtsh_ss (h);
+#else
+	const uint32_t shiftedExp = 0x7C00u << 13;
+	uint32_t bits = uint32_t (h & 0x7FFF) << 13;
+	uint32_t exp = bits & shiftedExp;
+
+	bits += (127 - 15) << 23;
+
+	if (exp == shiftedExp)
+		bits += (128 - 16) << 23;
+	else if (exp == 0) {
+		bits += 1 << 23;
+		bits = FloatToBits (BitsToFloat (bits) - BitsToFloat (113u << 23));
+	}
+
+	return BitsToFloat (bits | (uint32_t (h & 0x8000) << 16));
+#endif
+}
+
+// The next representable float above (below) v. Infinity maps to itself
+// and both zeros step to the smallest denormal.
+inline float NextFloatUp (float v) {
+	if (isinf (v) && v > 0.f)
+		return v;
+	if (v == -0.f)
+		v = 0.f;
+
+	uint32_t bits = FloatToBits (v);
+	if (v >= 0.f)
+		++bits;
+	else
+		--bits;
+	return BitsToFloat (bits);
+}
+
+inline float NextFloatDown (float v) {
+	if (isinf (v) && v < 0.f)
+		return v;
+	if (v == 0.f)
+		v = -0.f;
+
+	uint32_t bits = FloatToBits (v);
+	if (v > 0.f)
+		--bits;
+	else
+		++bits;
+	return BitsToFloat (bits);
+}
+
+#endif
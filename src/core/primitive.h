@@ -0,0 +1,130 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: primitive.h
+ *
+ *  Purpose: Define the interface every intersectable object (shapes,
+ *           aggregates, instances) presents to the rest of the renderer.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef PRIMITIVE_H
+#define PRIMITIVE_H
+
+#include "Geometry.h"
+
+class Primitive;
+
+
+////////////////////
+// struct: Intersection
+//
+// Purpose:
+//      Record where a ray hit a primitive. This is filled in by
+//      Primitive::Intersect for the closest hit found so far.
+//
+//      pError bounds the floating point error of p along each axis.
+//      Rays leaving the surface should be made with SpawnRay and SpawnRayTo,
+//      which use it to start just clear of the surface instead of relying
+//      on RAY_EPSILON.
+////////////////////
+struct Intersection {
+    Intersection() : tHit(INFINITY), u(0.f), v(0.f), primitive(NULL) { }
+
+    float tHit;     // The ray parameter of the hit.
+    Point p;        // The hit point.
+    Vector pError;  // Bounds on the error of p; zero if exact.
+    Normal n;       // The geometric normal at the hit point.
+    float u, v;     // Surface parameterization of the hit point.
+
+    const Primitive *primitive;
+
+    // A ray leaving the hit point in direction d.
+    Ray SpawnRay (const Vector &d) const {
+        return Ray (OffsetRayOrigin (p, pError, n, d), d, 0.f);
+    }
+
+    // A ray from the hit point towards p2 that stops just short of it, for
+    // shadow rays. It runs over t in [0, 1 - SHADOW_EPSILON].
+    Ray SpawnRayTo (const Point &p2) const {
+        Point o = OffsetRayOrigin (p, pError, n, p2 - p);
+        return Ray (o, p2 - o, 0.f, 1.f - SHADOW_EPSILON);
+    }
+};
+
+
+////////////////////
+// Class: Primitive
+//
+// Purpose:
+//      Abstract base class for anything a ray can be intersected with.
+//      Aggregates such as the BVH are Primitives themselves, so they can be
+//      nested.
+//
+//      Intersect looks for the closest hit in [ray.mint, ray.maxt]. When it
+//      finds one it shortens the ray by setting ray.maxt to the hit
+//      distance (that is why Ray::maxt is mutable), so later tests against
+//      other primitives only have to look closer than the current hit.
+//
+//      IntersectP only answers whether there is any hit in the range and
+//      must not touch the ray. Shadow rays use it, so implementations
+//      should skip everything that isn't needed for a yes / no answer.
+//
+//      Occluded tests a batch of shadow segments at once, so that a tile's
+//      worth of shadow rays can be handed over in one call.
+////////////////////
+class Primitive {
+    public:
+        virtual ~Primitive() { }
+
+        virtual BBox WorldBound() const = 0;
+
+        virtual bool Intersect (const Ray &ray, Intersection *isect) const = 0;
+        virtual bool IntersectP (const Ray &ray) const = 0;
+
+        // Whether anything blocks the segment from from[i] to to[i], for i
+        // in [0, n); occluded[i] receives the answer. The segments stop
+        // short of to[i] by SHADOW_EPSILON of their length, but start
+        // right at from[i], so points on surfaces should already be offset
+        // (see OffsetRayOrigin). Returns how many segments are blocked.
+        virtual int Occluded (const Point *from, const Point *to, int n,
+                              bool *occluded, float time = 0.f) const {
+            int nOccluded = 0;
+
+            for (int i = 0; i < n; ++i) {
+                float dist = Distance (from[i], to[i]);
+
+                occluded[i] = dist > 0.f &&
+                              IntersectP (Ray (from[i],
+                                               (to[i] - from[i]) / dist, 0.f,
+                                               dist * (1.f - SHADOW_EPSILON),
+                                               time));
+                nOccluded += occluded[i];
+            }
+
+            return nOccluded;
+        }
+};
+
+#endif
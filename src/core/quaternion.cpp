@@ -0,0 +1,150 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: quaternion.cpp
+ *
+ *  Purpose: Implementation of the Quaternion class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "quaternion.h"
+#include "transform.h"
+
+
+////////////////////
+// Function:
+//      Quaternion::Quaternion (const Transform&)
+//
+// Purpose:
+//      Extract the rotation of a rotation matrix. The largest of w, x, y
+//      and z is found from the diagonal first and the others are derived
+//      from it, so there is never a division by a small number.
+//
+// Parameters:
+//      const Transform &t - The rotation.
+////////////////////
+Quaternion::Quaternion (const Transform &t) {
+    const Matrix4x4 &m = t.GetMatrix();
+    float trace = m.m[0][0] + m.m[1][1] + m.m[2][2];
+
+    if (trace > 0.f) {
+        // |w| >= 1/2
+        float s = sqrtf (trace + 1.f);
+        w = s * .5f;
+        s = .5f / s;
+        v.x = (m.m[2][1] - m.m[1][2]) * s;
+        v.y = (m.m[0][2] - m.m[2][0]) * s;
+        v.z = (m.m[1][0] - m.m[0][1]) * s;
+    }
+    else {
+        // One of x, y or z is the largest; pick it with the diagonal.
+        const int next[3] = { 1, 2, 0 };
+        float q[3];
+        int i = 0;
+
+        if (m.m[1][1] > m.m[0][0])
+            i = 1;
+        if (m.m[2][2] > m.m[i][i])
+            i = 2;
+
+        int j = next[i];
+        int k = next[j];
+        float s = sqrtf ((m.m[i][i] - (m.m[j][j] + m.m[k][k])) + 1.f);
+
+        q[i] = s * .5f;
+        if (s != 0.f)
+            s = .5f / s;
+
+        w = (m.m[k][j] - m.m[j][k]) * s;
+        q[j] = (m.m[j][i] + m.m[i][j]) * s;
+        q[k] = (m.m[k][i] + m.m[i][k]) * s;
+
+        v.x = q[0];
+        v.y = q[1];
+        v.z = q[2];
+    }
+}
+
+
+////////////////////
+// Function:
+//      Quaternion::ToTransform
+//
+// Purpose:
+//      Build the rotation a unit quaternion represents.
+//
+// Returns:
+//      The rotation; its inverse is its transpose.
+////////////////////
+Transform Quaternion::ToTransform() const {
+    float r[3][3];
+    ToMatrix (r);
+
+    Matrix4x4 m (r[0][0], r[0][1], r[0][2], 0.f,
+                 r[1][0], r[1][1], r[1][2], 0.f,
+                 r[2][0], r[2][1], r[2][2], 0.f,
+                 0.f, 0.f, 0.f, 1.f);
+
+    return Transform (m, Transpose (m));
+}
+
+
+////////////////////
+// Function:
+//      Slerp
+//
+// Purpose:
+//      Spherical linear interpolation: q1 rotated towards q2 at constant
+//      angular speed. q2 is negated first if that brings it closer to q1,
+//      so the interpolation takes the shorter way round.
+//
+//      Nearly equal quaternions are interpolated linearly and renormalized
+//      instead, where the spherical formula would divide by almost zero.
+//
+// Parameters:
+//      float t - The interpolation parameter, in [0, 1].
+//      const Quaternion &q1 - The rotation at t = 0.
+//      const Quaternion &q2 - The rotation at t = 1.
+//
+// Returns:
+//      The interpolated unit quaternion.
+////////////////////
+Quaternion Slerp (float t, const Quaternion &q1, const Quaternion &q2) {
+    float cosTheta = Dot (q1, q2);
+    Quaternion q2Near = q2;
+
+    if (cosTheta < 0.f) {
+        cosTheta = -cosTheta;
+        q2Near = -q2;
+    }
+
+    if (cosTheta > .9995f)
+        return Normalize (q1 * (1.f - t) + q2Near * t);
+
+    // Rotate q1 by theta * t in the plane of q1 and q2, towards q2.
+    float theta = acosf (cosTheta) * t;
+    Quaternion qPerp = Normalize (q2Near - q1 * cosTheta);
+
+    return q1 * cosf (theta) + qPerp * sinf (theta);
+}
@@ -0,0 +1,152 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: quaternion.h
+ *
+ *  Purpose: Define unit quaternions, the representation of rotations that
+ *           can be interpolated.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include "Geometry.h"
+
+class Transform;
+
+
+////////////////////
+// Class: Quaternion
+//
+// Purpose:
+//      A quaternion v * (i, j, k) + w. Unit quaternions represent
+//      rotations: the rotation by theta about the unit axis a is
+//      (a * sin (theta / 2), cos (theta / 2)). Unlike rotation matrices
+//      they can be interpolated (see Slerp) without leaving the set of
+//      rotations.
+//
+//      q and -q are the same rotation.
+////////////////////
+class Quaternion {
+    public:
+        ///////////////
+        // Data Members
+        ///////////////
+        Vector v;
+        float w;
+
+
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // The identity rotation.
+        Quaternion() : v(0.f, 0.f, 0.f), w(1.f) { }
+
+        Quaternion (const Vector &vv, float ww) : v(vv), w(ww) { }
+
+        // The rotation of t, which must be a pure rotation (orthonormal,
+        //      no reflection).
+        explicit Quaternion (const Transform &t);
+
+
+        ///////////////
+        // Operators
+        ///////////////
+        Quaternion operator+ (const Quaternion &q) const {
+            return Quaternion (v + q.v, w + q.w);
+        }
+
+        Quaternion &operator+= (const Quaternion &q) {
+            v += q.v;
+            w += q.w;
+            return *this;
+        }
+
+        Quaternion operator- (const Quaternion &q) const {
+            return Quaternion (v - q.v, w - q.w);
+        }
+
+        Quaternion operator- () const {
+            return Quaternion (-v, -w);
+        }
+
+        Quaternion operator* (float f) const {
+            return Quaternion (v * f, w * f);
+        }
+
+        Quaternion operator/ (float f) const {
+            float inv = 1.f / f;
+            return Quaternion (v * inv, w * inv);
+        }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // The rotation matrix of a unit quaternion.
+        void ToMatrix (float m[3][3]) const {
+            float xx = v.x * v.x, yy = v.y * v.y, zz = v.z * v.z;
+            float xy = v.x * v.y, xz = v.x * v.z, yz = v.y * v.z;
+            float wx = v.x * w, wy = v.y * w, wz = v.z * w;
+
+            m[0][0] = 1.f - 2.f * (yy + zz);
+            m[0][1] = 2.f * (xy - wz);
+            m[0][2] = 2.f * (xz + wy);
+            m[1][0] = 2.f * (xy + wz);
+            m[1][1] = 1.f - 2.f * (xx + zz);
+            m[1][2] = 2.f * (yz - wx);
+            m[2][0] = 2.f * (xz - wy);
+            m[2][1] = 2.f * (yz + wx);
+            m[2][2] = 1.f - 2.f * (xx + yy);
+        }
+
+        Transform ToTransform() const;
+};
+
+
+/***************
+ ***************
+ * Quaternion Inline Functions
+ ***************
+ ***************/
+inline Quaternion operator* (float f, const Quaternion &q) {
+    return q * f;
+}
+
+inline float Dot (const Quaternion &q1, const Quaternion &q2) {
+    return Dot (q1.v, q2.v) + q1.w * q2.w;
+}
+
+inline Quaternion Normalize (const Quaternion &q) {
+    return q / sqrtf (Dot (q, q));
+}
+
+// Interpolate between two unit quaternions at constant angular speed along
+// the shorter of the two arcs between them.
+Quaternion Slerp (float t, const Quaternion &q1, const Quaternion &q2);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: renderer.cpp
+ *
+ *  Purpose: Implement the tile based renderer.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "renderer.h"
+#include "camera.h"
+#include "film.h"
+#include "memory.h"
+#include "morton.h"
+#include "parallel.h"
+#include "rng.h"
+#include "scene.h"
+#include "stats.h"
+
+
+// Counted per tile, alongside RenderStats.
+static StatCounter cameraRayCount ("Renderer/Camera rays");
+static StatRatio shadowRaysOccluded ("Renderer/Shadow rays occluded", true);
+
+// The surface reflectance and the light that reaches surfaces from
+// everywhere (so shadows aren't black), and the radiance of rays that
+// leave the scene.
+static const float kAlbedo = .7f;
+static const float kAmbient = .05f;
+static const float kBackground[3] = { .55f, .65f, .8f };
+
+
+// The distance along a Hilbert curve through an n x n grid (n a power of
+// two) of the cell (x, y).
+static uint32_t HilbertIndex (uint32_t n, uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) != 0;
+        uint32_t ry = (y & s) != 0;
+
+        d += s * s * ((3 * rx) ^ ry);
+
+        // Turn the quadrant so that the curve through it starts and ends
+        // where the curve through the bigger square expects.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            std::swap (x, y);
+        }
+    }
+
+    return d;
+}
+
+
+////////////////////
+// Function:
+//      OrderTiles
+//
+// Purpose:
+//      List the tiles of an nx x ny grid in the given order.
+//
+//      The Hilbert and Morton orders sort the tiles by where they fall on
+//      the curve through the smallest power of two square that holds the
+//      grid. The spiral walks right, down, left and up around the center
+//      tile with ever longer legs, skipping the steps that leave the
+//      grid, until it has seen every tile.
+//
+// Parameters:
+//      RenderOptions::TileOrder order - The order.
+//      int nx, ny - The number of tiles across and down.
+//
+// Returns:
+//      Every tile number (y * nx + x) once.
+////////////////////
+static std::vector<int> OrderTiles (RenderOptions::TileOrder order, int nx,
+                                    int ny) {
+    std::vector<int> tiles;
+    tiles.reserve (nx * ny);
+
+    if (order == RenderOptions::TileSpiral) {
+        static const int step[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 },
+                                        { 0, -1 } };
+        int x = (nx - 1) / 2, y = (ny - 1) / 2;
+
+        tiles.push_back (y * nx + x);
+
+        for (int leg = 0; int (tiles.size()) < nx * ny; ++leg) {
+            int dir = leg & 3;
+
+            for (int i = 0; i < leg / 2 + 1; ++i) {
+                x += step[dir][0];
+                y += step[dir][1];
+
+                if (x >= 0 && x < nx && y >= 0 && y < ny)
+                    tiles.push_back (y * nx + x);
+            }
+        }
+
+        return tiles;
+    }
+
+    for (int i = 0; i < nx * ny; ++i)
+        tiles.push_back (i);
+
+    if (order == RenderOptions::TileScanline)
+        return tiles;
+
+    uint32_t n = 1;
+    while (n < uint32_t (max (nx, ny)))
+        n *= 2;
+
+    std::vector<uint32_t> key (tiles.size());
+    for (int i = 0; i < nx * ny; ++i) {
+        uint32_t x = i % nx, y = i / nx;
+
+        key[i] = order == RenderOptions::TileHilbert ? HilbertIndex (n, x, y)
+                                                     : EncodeMorton2 (x, y);
+    }
+
+    std::sort (tiles.begin(), tiles.end(),
+               [&](int a, int b) { return key[a] < key[b]; });
+
+    return tiles;
+}
+
+
+////////////////////
+// struct: CameraSample
+//
+// Purpose:
+//      Where a camera ray of a tile was taken and the radiance it has
+//      gathered so far.
+////////////////////
+struct CameraSample {
+    float x, y;
+    float L[3];
+};
+
+
+////////////////////
+// TileRenderer Methods
+////////////////////
+TileRenderer::TileRenderer (const Scene &s, const PerspectiveCamera &c,
+                            const RenderOptions &opts)
+        : scene(s), camera(c), options(opts) {
+    assert (options.tileSize > 0);
+    assert (options.samplesPerPixel > 0);
+
+    nTilesX = (camera.XResolution() + options.tileSize - 1) /
+              options.tileSize;
+    nTilesY = (camera.YResolution() + options.tileSize - 1) /
+              options.tileSize;
+    sequence = OrderTiles (options.tileOrder, nTilesX, nTilesY);
+}
+
+void TileRenderer::TileBounds (int tile, int *x0, int *y0, int *x1,
+                               int *y1) const {
+    assert (tile >= 0 && tile < NumTiles());
+
+    *x0 = (tile % nTilesX) * options.tileSize;
+    *y0 = (tile / nTilesX) * options.tileSize;
+    *x1 = min (*x0 + options.tileSize, camera.XResolution());
+    *y1 = min (*y0 + options.tileSize, camera.YResolution());
+}
+
+RenderStats TileRenderer::Render (Film *film,
+                                  TaskScheduler *scheduler) const {
+    assert (film->XResolution() == camera.XResolution());
+    assert (film->YResolution() == camera.YResolution());
+
+    std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+
+    film->BeginTiles (NumTiles());
+
+    std::atomic<int> next (0);
+    std::atomic<int64_t> cameraRays (0), shadowRays (0);
+    int nTiles = NumTiles();
+
+    // The work of one thread: claim tiles until there are none left.
+    std::function<void ()> worker = [&]() {
+        MemoryArena arena;
+        RenderStats stats;
+        int i;
+
+        while ((i = next.fetch_add (1, std::memory_order_relaxed)) < nTiles)
+            RenderTile (sequence[i], film, arena, &stats);
+
+        cameraRays += stats.cameraRays;
+        shadowRays += stats.shadowRays;
+    };
+
+    if (scheduler && scheduler->NumThreads() > 1) {
+        TaskGroup group;
+
+        for (int i = 1; i < scheduler->NumThreads(); ++i)
+            scheduler->Spawn (group, worker);
+
+        worker();
+        scheduler->Wait (group);
+    }
+    else
+        worker();
+
+    film->MergeTiles (scheduler);
+
+    RenderStats stats;
+    stats.cameraRays = cameraRays;
+    stats.shadowRays = shadowRays;
+    stats.seconds = std::chrono::duration<double> (
+            std::chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
+
+
+////////////////////
+// Function:
+//      TileRenderer::RenderTile
+//
+// Purpose:
+//      Render one tile into its FilmTile.
+//
+//      Every camera ray of the tile is traced first. Hits get their
+//      ambient light at once and queue a shadow ray towards the light if
+//      it is on the side of the surface the camera sees; misses get the
+//      background. The queued shadow rays are then tested together, the
+//      unblocked ones add their direct light, and the samples go to the
+//      film tile.
+//
+//      The samples and shadow rays only live until the tile is done, so
+//      they are allocated from the thread's arena, which is reset at the
+//      end.
+//
+// Parameters:
+//      int tile - The tile to render.
+//      Film *film - Supplies the tile's FilmTile.
+//      MemoryArena &arena - The calling thread's arena.
+//      RenderStats *stats - The calling thread's ray counts.
+////////////////////
+void TileRenderer::RenderTile (int tile, Film *film, MemoryArena &arena,
+                               RenderStats *stats) const {
+    int x0, y0, x1, y1;
+    TileBounds (tile, &x0, &y0, &x1, &y1);
+
+    const PointLight &light = scene.Light();
+    int spp = options.samplesPerPixel;
+    int maxSamples = (x1 - x0) * (y1 - y0) * spp;
+    int nSamples = 0, nShadow = 0;
+
+    CameraSample *samples = arena.Alloc<CameraSample> (maxSamples);
+
+    // One entry per shadow ray: the sample it lights, the light it carries
+    // there per unit intensity, and its end points.
+    int *shadowSample = arena.Alloc<int> (maxSamples);
+    float *shadowWeight = arena.Alloc<float> (maxSamples);
+    Point *from = arena.Alloc<Point> (maxSamples);
+    Point *to = arena.Alloc<Point> (maxSamples);
+    bool *occluded = arena.Alloc<bool> (maxSamples);
+
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            RNG rng (uint64_t (y) * camera.XResolution() + x);
+
+            for (int s = 0; s < spp; ++s, ++nSamples) {
+                CameraSample &sample = samples[nSamples];
+
+                sample.x = x + rng.UniformFloat();
+                sample.y = y + rng.UniformFloat();
+
+                Ray ray = camera.GenerateRay (sample.x, sample.y);
+                Intersection isect;
+
+                if (!scene.Intersect (ray, &isect)) {
+                    for (int c = 0; c < 3; ++c)
+                        sample.L[c] = kBackground[c];
+                    continue;
+                }
+
+                for (int c = 0; c < 3; ++c)
+                    sample.L[c] = kAmbient * kAlbedo;
+
+                // Two sided: lit only if the light and the camera are on
+                // the same side of the surface.
+                Vector wl = light.position - isect.p;
+                float nDotL = Dot (wl, isect.n);
+
+                if (nDotL * Dot (ray.d, isect.n) >= 0.f)
+                    continue;
+
+                float dist2 = wl.LengthSquared();
+
+                shadowSample[nShadow] = nSamples;
+                shadowWeight[nShadow] = kAlbedo * float (1. / M_PI) *
+                                        fabsf (nDotL) /
+                                        (sqrtf (dist2) * dist2);
+                from[nShadow] = OffsetRayOrigin (isect.p, isect.pError,
+                                                 isect.n, wl);
+                to[nShadow] = light.position;
+                ++nShadow;
+            }
+        }
+    }
+
+    if (nShadow > 0)
+        scene.Occluded (from, to, nShadow, occluded);
+
+    int nOccluded = 0;
+
+    for (int i = 0; i < nShadow; ++i) {
+        if (occluded[i]) {
+            ++nOccluded;
+            continue;
+        }
+
+        float *L = samples[shadowSample[i]].L;
+
+        for (int c = 0; c < 3; ++c)
+            L[c] += shadowWeight[i] * light.intensity[c];
+    }
+
+    FilmTile *filmTile = film->GetFilmTile (tile, x0, y0, x1, y1);
+
+    for (int i = 0; i < nSamples; ++i)
+        filmTile->AddSample (samples[i].x, samples[i].y, samples[i].L);
+
+    stats->cameraRays += nSamples;
+    stats->shadowRays += nShadow;
+    cameraRayCount += nSamples;
+    shadowRaysOccluded.Add (nOccluded, nShadow);
+
+    arena.FreeAll();
+}
@@ -0,0 +1,165 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: renderer.h
+ *
+ *  Purpose: Define the tile based renderer that drives the threads.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+class Film;
+class MemoryArena;
+class PerspectiveCamera;
+class Scene;
+class TaskScheduler;
+
+
+////////////////////
+// struct: RenderOptions
+////////////////////
+struct RenderOptions {
+    // The order tiles are handed out to threads in. The threads render
+    // whichever tiles are next in the order at the same time, so an order
+    // that keeps consecutive tiles close together on the image keeps them
+    // working on the same part of the scene, and of the caches.
+    enum TileOrder {
+        // Row by row, top to bottom: each row of tiles sweeps across the
+        //      whole scene.
+        TileScanline,
+
+        // Outwards from the center tile, round and round.
+        TileSpiral,
+
+        // Along a Hilbert curve, which never jumps: every tile is next to
+        //      the one before it.
+        TileHilbert,
+
+        // Along a Morton (Z-order) curve: square blocks of tiles, with
+        //      jumps between blocks.
+        TileMorton
+    };
+
+    RenderOptions() : tileSize(32), samplesPerPixel(4),
+                      tileOrder(TileHilbert) { }
+
+    // Tiles are tileSize x tileSize pixels (smaller along the right and
+    // bottom edges of the image).
+    int tileSize;
+
+    int samplesPerPixel;
+
+    TileOrder tileOrder;
+};
+
+
+////////////////////
+// struct: RenderStats
+//
+// Purpose:
+//      What a render did, for reporting throughput.
+////////////////////
+struct RenderStats {
+    RenderStats() : cameraRays(0), shadowRays(0), seconds(0.) { }
+
+    int64_t cameraRays;
+    int64_t shadowRays;
+    double seconds;
+};
+
+
+////////////////////
+// Class: TileRenderer
+//
+// Purpose:
+//      Render a scene through a camera into a film, with the image split
+//      into square tiles that are handed out to threads.
+//
+//      Every thread of the scheduler runs one task that keeps claiming
+//      the next unrendered tile, in options.tileOrder, from an atomic
+//      counter until none are left. Nothing else is shared while
+//      rendering: each tile's samples go to its own FilmTile, and each
+//      thread keeps its own MemoryArena and counters. Tiles are small
+//      next to the image, so the threads finish within about one tile's
+//      time of each other however many there are. The film then merges
+//      the tiles in a fixed order.
+//
+//      Each pixel draws its samples from its own RNG, seeded with the
+//      pixel's index, so with the fixed merge order the image is the same
+//      bit for bit for any number of threads and any tile order.
+//
+//      Shading is direct lighting from the scene's point light on a grey
+//      diffuse surface, plus a little ambient light. All camera rays of a
+//      tile are traced first, then their shadow rays are tested in one
+//      Scene::Occluded call.
+////////////////////
+class TileRenderer {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        TileRenderer (const Scene &scene, const PerspectiveCamera &camera,
+                      const RenderOptions &options = RenderOptions());
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // Render the image into film, which must have the camera's
+        // resolution, on the scheduler's threads (or the calling thread if
+        // scheduler is NULL).
+        RenderStats Render (Film *film, TaskScheduler *scheduler) const;
+
+        int NumTiles() const { return nTilesX * nTilesY; }
+
+        // The pixels [x0, x1) x [y0, y1) of tile number tile; tiles are
+        // numbered in scanline order.
+        void TileBounds (int tile, int *x0, int *y0, int *x1,
+                         int *y1) const;
+
+        // The tile numbers in the order they are handed out.
+        const std::vector<int> &TileSequence() const { return sequence; }
+
+    private:
+        void RenderTile (int tile, Film *film, MemoryArena &arena,
+                         RenderStats *stats) const;
+
+        ///////////////
+        // Data Members
+        ///////////////
+        const Scene &scene;
+        const PerspectiveCamera &camera;
+        RenderOptions options;
+        int nTilesX, nTilesY;
+        std::vector<int> sequence;
+};
+
+#endif
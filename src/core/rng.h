@@ -0,0 +1,98 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: rng.h
+ *
+ *  Purpose: Define a small, fast pseudo-random number generator.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+#include "pb_ray.h"
+
+
+////////////////////
+// Class: RNG
+//
+// Purpose:
+//      A PCG32 generator: 64 bits of state, 32 bits of output per step.
+//
+//      Seeding is a couple of multiplies, so the renderer can give every
+//      pixel its own sequence, seeded by the pixel's position. The image
+//      then doesn't depend on which thread renders which pixel, or in
+//      what order.
+////////////////////
+class RNG {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        RNG() : state(0x853C49E6748FEA9BULL), inc(0xDA3E39CB94B95BDBULL) { }
+
+        explicit RNG (uint64_t sequence) { Seed (sequence); }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // Start the sequence with the given index. Different indices give
+        // independent sequences.
+        void Seed (uint64_t sequence) {
+            state = 0;
+            inc = (sequence << 1) | 1;
+            UniformUInt32();
+            state += 0x853C49E6748FEA9BULL;
+            UniformUInt32();
+        }
+
+        uint32_t UniformUInt32() {
+            uint64_t old = state;
+            state = old * 0x5851F42D4C957F2DULL + inc;
+
+            uint32_t xorShifted = uint32_t (((old >> 18) ^ old) >> 27);
+            uint32_t rot = uint32_t (old >> 59);
+
+            return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+        }
+
+        // A float in [0, 1).
+        float UniformFloat() {
+            // The top 24 bits, so the result is exact and never rounds up
+            // to 1.
+            return (UniformUInt32() >> 8) * (1.f / 16777216.f);
+        }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        uint64_t state, inc;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: scene.h
+ *
+ *  Purpose: Define the scene: the geometry to render and its light.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <memory>
+
+#include "primitive.h"
+
+
+////////////////////
+// struct: PointLight
+//
+// Purpose:
+//      A light that shines equally in every direction from one point.
+//      Intensity is in RGB, per unit solid angle.
+////////////////////
+struct PointLight {
+    PointLight (const Point &p, float r, float g, float b) : position(p) {
+        intensity[0] = r;
+        intensity[1] = g;
+        intensity[2] = b;
+    }
+
+    Point position;
+    float intensity[3];
+};
+
+
+////////////////////
+// Class: Scene
+//
+// Purpose:
+//      Everything the renderer traces rays against: one aggregate
+//      primitive (typically a BVHAccel, possibly over instances) and the
+//      light that illuminates it.
+////////////////////
+class Scene {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        Scene (const std::shared_ptr<Primitive> &agg, const PointLight &l)
+                : aggregate(agg), light(l), bound(agg->WorldBound()) { }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        bool Intersect (const Ray &ray, Intersection *isect) const {
+            return aggregate->Intersect (ray, isect);
+        }
+
+        bool IntersectP (const Ray &ray) const {
+            return aggregate->IntersectP (ray);
+        }
+
+        // See Primitive::Occluded.
+        int Occluded (const Point *from, const Point *to, int n,
+                      bool *occluded) const {
+            return aggregate->Occluded (from, to, n, occluded);
+        }
+
+        const BBox &WorldBound() const { return bound; }
+        const PointLight &Light() const { return light; }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        std::shared_ptr<Primitive> aggregate;
+        PointLight light;
+        BBox bound;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: simd.h
+ *
+ *  Purpose: Pull in the SIMD intrinsics and provide the handful of helpers
+ *           that the vectorized kernels share.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "pb_ray.h"
+
+#ifdef PB_RAY_SSE
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+#ifdef PB_RAY_AVX
+#include <immintrin.h>
+#endif
+
+
+#ifdef PB_RAY_SSE
+////////////////////
+// Function:
+//      HorizontalMin, HorizontalMax
+//
+// Purpose:
+//      Reduce the four lanes of an SSE register to a single float.
+//
+// Parameters:
+//      __m128 v - The register to reduce.
+//
+// Returns:
+//      The smallest (largest) of the four lanes.
+////////////////////
+inline float HorizontalMin (__m128 v) {
+    v = _mm_min_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1)));
+    v = _mm_min_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 0, 3, 2)));
+    return _mm_cvtss_f32 (v);
+}
+
+inline float HorizontalMax (__m128 v) {
+    v = _mm_max_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (2, 3, 0, 1)));
+    v = _mm_max_ps (v, _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 0, 3, 2)));
+    return _mm_cvtss_f32 (v);
+}
+#endif
+
+#endif
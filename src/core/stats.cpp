@@ -0,0 +1,379 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: stats.cpp
+ *
+ *  Purpose: Keep track of every statistic and each thread's slots, and merge
+ *           them into the report.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "stats.h"
+
+
+////////////////////
+// struct: StatRegistry
+//
+// Purpose:
+//      Every statistic, the slots of every live thread, and the merged
+//      slots of the threads that have exited.
+//
+//      Never destroyed, so that threads exiting during static destruction
+//      can still fold their slots in.
+////////////////////
+struct StatRegistry {
+    StatRegistry() : nSlots(0) {
+        for (int i = 0; i < kMaxStatSlots; ++i)
+            retired[i] = 0;
+    }
+
+    static StatRegistry &Get() {
+        static StatRegistry *registry = new StatRegistry;
+        return *registry;
+    }
+
+    // Fold one thread's slots into the totals in into, statistic by
+    // statistic. The caller holds the mutex.
+    void Fold (const std::atomic<int64_t> *slots, int64_t *into) const {
+        int64_t values[kMaxStatSlots];
+
+        for (int i = 0; i < nSlots; ++i)
+            values[i] = slots[i].load (std::memory_order_relaxed);
+
+        for (size_t i = 0; i < stats.size(); ++i) {
+            int first = offsets[i];
+
+            stats[i]->Fold (values + first, into + first);
+        }
+    }
+
+    // Every statistic merged over all threads, live and exited. The caller
+    // holds the mutex.
+    void Totals (int64_t *totals) const {
+        for (int i = 0; i < nSlots; ++i)
+            totals[i] = retired[i];
+
+        for (size_t i = 0; i < threads.size(); ++i)
+            Fold (threads[i]->values, totals);
+    }
+
+    std::mutex mutex;
+    std::vector<Stat*> stats;
+    std::vector<int> offsets;   // Each statistic's first slot
+    int nSlots;
+    std::vector<StatThreadSlots*> threads;
+    int64_t retired[kMaxStatSlots];
+};
+
+
+////////////////////
+// StatThreadSlots Methods
+////////////////////
+StatThreadSlots::StatThreadSlots() {
+    for (int i = 0; i < kMaxStatSlots; ++i)
+        values[i].store (0, std::memory_order_relaxed);
+
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+
+    registry.threads.push_back (this);
+}
+
+StatThreadSlots::~StatThreadSlots() {
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+
+    registry.Fold (values, registry.retired);
+
+    for (size_t i = 0; i < registry.threads.size(); ++i) {
+        if (registry.threads[i] == this) {
+            registry.threads.erase (registry.threads.begin() + i);
+            break;
+        }
+    }
+}
+
+
+////////////////////
+// Stat Methods
+////////////////////
+Stat::Stat (const char *t, int n) : title(t), nSlots(n) {
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+
+    // Every thread's slots are a fixed size array, so running out is fatal
+    // whatever the build.
+    if (registry.nSlots + n > kMaxStatSlots) {
+        fprintf (stderr, "Statistic \"%s\" needs %d slots but only %d of "
+                 "%d are left; raise kMaxStatSlots\n", t, n,
+                 kMaxStatSlots - registry.nSlots, kMaxStatSlots);
+        abort();
+    }
+
+    firstSlot = registry.nSlots;
+    registry.nSlots += n;
+    registry.stats.push_back (this);
+    registry.offsets.push_back (firstSlot);
+}
+
+// Threads can outlive static statistics at exit; stop folding into this
+// one once it is gone.
+Stat::~Stat() {
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+
+    for (size_t i = 0; i < registry.stats.size(); ++i) {
+        if (registry.stats[i] == this) {
+            registry.stats.erase (registry.stats.begin() + i);
+            registry.offsets.erase (registry.offsets.begin() + i);
+            break;
+        }
+    }
+}
+
+void Stat::Fold (const int64_t *from, int64_t *into) const {
+    for (int i = 0; i < nSlots; ++i)
+        into[i] += from[i];
+}
+
+void Stat::Merged (int64_t *values) const {
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    int64_t totals[kMaxStatSlots];
+
+    registry.Totals (totals);
+
+    for (int i = 0; i < nSlots; ++i)
+        values[i] = totals[firstSlot + i];
+}
+
+
+////////////////////
+// StatCounter Methods
+////////////////////
+int64_t StatCounter::Value() const {
+    int64_t value;
+
+    Merged (&value);
+    return value;
+}
+
+std::string StatCounter::Format (const int64_t *values) const {
+    char buf[64];
+
+    snprintf (buf, sizeof (buf), "%lld", (long long) values[0]);
+    return buf;
+}
+
+std::string StatMemoryCounter::Format (const int64_t *values) const {
+    double bytes = double (values[0]);
+    char buf[64];
+
+    if (bytes >= 1024. * 1024. * 1024.)
+        snprintf (buf, sizeof (buf), "%.2f GB",
+                  bytes / (1024. * 1024. * 1024.));
+    else if (bytes >= 1024. * 1024.)
+        snprintf (buf, sizeof (buf), "%.2f MB", bytes / (1024. * 1024.));
+    else
+        snprintf (buf, sizeof (buf), "%.2f kB", bytes / 1024.);
+
+    return buf;
+}
+
+
+////////////////////
+// StatDistribution Methods
+////////////////////
+int64_t StatDistribution::Count() const {
+    int64_t values[4];
+
+    Merged (values);
+    return values[kCount];
+}
+
+int64_t StatDistribution::Sum() const {
+    int64_t values[4];
+
+    Merged (values);
+    return values[kSum];
+}
+
+int64_t StatDistribution::Min() const {
+    int64_t values[4];
+
+    Merged (values);
+    return values[kMin];
+}
+
+int64_t StatDistribution::Max() const {
+    int64_t values[4];
+
+    Merged (values);
+    return values[kMax];
+}
+
+double StatDistribution::Average() const {
+    int64_t values[4];
+
+    Merged (values);
+    return values[kCount] ? double (values[kSum]) / values[kCount] : 0.;
+}
+
+// The minimum and maximum are only meaningful for threads that reported
+// at least one value.
+void StatDistribution::Fold (const int64_t *from, int64_t *into) const {
+    if (from[kCount] == 0)
+        return;
+
+    if (into[kCount] == 0) {
+        into[kMin] = from[kMin];
+        into[kMax] = from[kMax];
+    }
+    else {
+        into[kMin] = min (into[kMin], from[kMin]);
+        into[kMax] = max (into[kMax], from[kMax]);
+    }
+
+    into[kSum] += from[kSum];
+    into[kCount] += from[kCount];
+}
+
+std::string StatDistribution::Format (const int64_t *values) const {
+    char buf[128];
+
+    if (values[kCount] == 0)
+        return "no values";
+
+    snprintf (buf, sizeof (buf), "%.3f avg [%lld - %lld] over %lld",
+              double (values[kSum]) / values[kCount],
+              (long long) values[kMin], (long long) values[kMax],
+              (long long) values[kCount]);
+    return buf;
+}
+
+
+////////////////////
+// StatRatio Methods
+////////////////////
+int64_t StatRatio::Numerator() const {
+    int64_t values[2];
+
+    Merged (values);
+    return values[0];
+}
+
+int64_t StatRatio::Denominator() const {
+    int64_t values[2];
+
+    Merged (values);
+    return values[1];
+}
+
+std::string StatRatio::Format (const int64_t *values) const {
+    double ratio = values[1] ? double (values[0]) / values[1] : 0.;
+    char buf[128];
+
+    if (percent)
+        snprintf (buf, sizeof (buf), "%lld / %lld (%.2f%%)",
+                  (long long) values[0], (long long) values[1],
+                  100. * ratio);
+    else
+        snprintf (buf, sizeof (buf), "%lld / %lld (%.3f)",
+                  (long long) values[0], (long long) values[1], ratio);
+
+    return buf;
+}
+
+
+////////////////////
+// Reporting
+////////////////////
+std::string StatsReport() {
+#ifdef PB_RAY_NO_STATS
+    return std::string();
+#else
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    int64_t totals[kMaxStatSlots];
+
+    registry.Totals (totals);
+
+    // Category -> (name -> value), both sorted.
+    std::map<std::string, std::map<std::string, std::string> > lines;
+
+    for (size_t i = 0; i < registry.stats.size(); ++i) {
+        std::string title = registry.stats[i]->Title();
+        size_t slash = title.find ('/');
+        std::string category = slash == std::string::npos
+                                       ? std::string ("Other")
+                                       : title.substr (0, slash);
+        std::string name = slash == std::string::npos
+                                   ? title : title.substr (slash + 1);
+
+        lines[category][name] =
+                registry.stats[i]->Format (totals + registry.offsets[i]);
+    }
+
+    std::string report = "Statistics:\n";
+    char buf[256];
+
+    for (std::map<std::string, std::map<std::string, std::string> >
+                 ::const_iterator c = lines.begin(); c != lines.end(); ++c) {
+        report += "    " + c->first + "\n";
+
+        for (std::map<std::string, std::string>::const_iterator l =
+                     c->second.begin(); l != c->second.end(); ++l) {
+            snprintf (buf, sizeof (buf), "        %-40s %s\n",
+                      l->first.c_str(), l->second.c_str());
+            report += buf;
+        }
+    }
+
+    return report;
+#endif
+}
+
+void PrintStats (FILE *dest) {
+    std::string report = StatsReport();
+
+    fputs (report.c_str(), dest);
+}
+
+void ClearStats() {
+    StatRegistry &registry = StatRegistry::Get();
+    std::lock_guard<std::mutex> lock (registry.mutex);
+
+    for (int i = 0; i < kMaxStatSlots; ++i)
+        registry.retired[i] = 0;
+
+    for (size_t i = 0; i < registry.threads.size(); ++i)
+        for (int j = 0; j < kMaxStatSlots; ++j)
+            registry.threads[i]->values[j].store (
+                    0, std::memory_order_relaxed);
+}
@@ -0,0 +1,256 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: stats.h
+ *
+ *  Purpose: Low overhead statistics counters for the hot paths, kept per thread
+ *           and merged into a report on request.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <string>
+
+#include "pb_ray.h"
+
+// Statistics
+//      The counters below are collected unless PB_RAY_NO_STATS is defined
+//      (the PB_RAY_STATS CMake option), which compiles every update out of
+//      the hot paths. Release-fast builds should define it.
+
+
+// The most slots all the statistics in the program may use between them.
+static const int kMaxStatSlots = 256;
+
+
+////////////////////
+// struct: StatThreadSlots
+//
+// Purpose:
+//      One thread's values of every statistic. A thread's slots are made
+//      and registered for reporting the first time it updates a statistic,
+//      and folded into the totals of exited threads when it exits.
+//
+//      Only the owning thread writes its slots, so an update is a relaxed
+//      load and store (a plain add on x86) rather than a locked
+//      read-modify-write; they are atomics only so the report can read
+//      them while the thread runs.
+////////////////////
+struct StatThreadSlots {
+    StatThreadSlots();
+    ~StatThreadSlots();
+
+    std::atomic<int64_t> values[kMaxStatSlots];
+};
+
+inline std::atomic<int64_t> *ThreadStatSlots() {
+    static thread_local StatThreadSlots slots;
+    return slots.values;
+}
+
+
+////////////////////
+// Class: Stat
+//
+// Purpose:
+//      The base of the statistics. Each statistic is a static object that
+//      claims a few slots when it is constructed, and knows how to merge
+//      the slots of two threads and describe the result.
+//
+//      Titles are "Category/Name"; the report groups by category.
+////////////////////
+class Stat {
+    public:
+        virtual ~Stat();
+
+        const char *Title() const { return title; }
+        int NumSlots() const { return nSlots; }
+
+        // Merge the slots of one thread (from) into the running totals
+        // (into). Both point at this statistic's first slot.
+        virtual void Fold (const int64_t *from, int64_t *into) const;
+
+        // The value column of the report for merged slots.
+        virtual std::string Format (const int64_t *values) const = 0;
+
+    protected:
+        Stat (const char *title, int nSlots);
+
+        // Add v to slot i of the calling thread.
+        void Update (int i, int64_t v) {
+#ifndef PB_RAY_NO_STATS
+            std::atomic<int64_t> &s = ThreadStatSlots()[firstSlot + i];
+            s.store (s.load (std::memory_order_relaxed) + v,
+                     std::memory_order_relaxed);
+#else
+            (void) i;
+            (void) v;
+#endif
+        }
+
+        // This statistic's slots merged over every thread, live or exited.
+        void Merged (int64_t *values) const;
+
+        const char *title;
+        int firstSlot;
+        int nSlots;
+};
+
+
+////////////////////
+// Class: StatCounter
+//
+// Purpose:
+//      A count of events, summed over threads.
+////////////////////
+class StatCounter : public Stat {
+    public:
+        explicit StatCounter (const char *title) : Stat (title, 1) { }
+
+        StatCounter &operator++() { Update (0, 1); return *this; }
+        StatCounter &operator+= (int64_t n) { Update (0, n); return *this; }
+
+        int64_t Value() const;
+        std::string Format (const int64_t *values) const;
+};
+
+
+////////////////////
+// Class: StatMemoryCounter
+//
+// Purpose:
+//      A StatCounter of bytes, reported in kB, MB or GB.
+////////////////////
+class StatMemoryCounter : public StatCounter {
+    public:
+        explicit StatMemoryCounter (const char *title)
+                : StatCounter (title) { }
+
+        std::string Format (const int64_t *values) const;
+};
+
+
+////////////////////
+// Class: StatDistribution
+//
+// Purpose:
+//      The average, minimum and maximum of a series of values, such as the
+//      nodes visited by each ray.
+////////////////////
+class StatDistribution : public Stat {
+    public:
+        explicit StatDistribution (const char *title) : Stat (title, 4) { }
+
+        void ReportValue (int64_t v) {
+#ifndef PB_RAY_NO_STATS
+            std::atomic<int64_t> *s = ThreadStatSlots() + firstSlot;
+            int64_t count = s[kCount].load (std::memory_order_relaxed);
+
+            if (count == 0 || v < s[kMin].load (std::memory_order_relaxed))
+                s[kMin].store (v, std::memory_order_relaxed);
+            if (count == 0 || v > s[kMax].load (std::memory_order_relaxed))
+                s[kMax].store (v, std::memory_order_relaxed);
+
+            s[kSum].store (s[kSum].load (std::memory_order_relaxed) + v,
+                           std::memory_order_relaxed);
+            s[kCount].store (count + 1, std::memory_order_relaxed);
+#else
+            (void) v;
+#endif
+        }
+
+        int64_t Count() const;
+        int64_t Sum() const;
+        int64_t Min() const;
+        int64_t Max() const;
+        double Average() const;
+
+        void Fold (const int64_t *from, int64_t *into) const;
+        std::string Format (const int64_t *values) const;
+
+    private:
+        enum { kSum, kCount, kMin, kMax };
+};
+
+
+////////////////////
+// Class: StatRatio
+//
+// Purpose:
+//      How often something happens out of a number of tries, such as
+//      ray-triangle tests that hit, reported as a fraction or, if percent
+//      is set, as a percentage.
+////////////////////
+class StatRatio : public Stat {
+    public:
+        explicit StatRatio (const char *title, bool percent = false)
+                : Stat (title, 2), percent(percent) { }
+
+        void Add (int64_t numerator, int64_t denominator) {
+            Update (0, numerator);
+            Update (1, denominator);
+        }
+
+        int64_t Numerator() const;
+        int64_t Denominator() const;
+        std::string Format (const int64_t *values) const;
+
+    private:
+        bool percent;
+};
+
+
+////////////////////
+// Function:
+//      StatsReport, PrintStats
+//
+// Purpose:
+//      Merge every statistic over all threads, live and exited, and lay
+//      them out by category, one per line. The report is empty when the
+//      statistics are compiled out.
+//
+//      Values being updated while the report runs may or may not be
+//      counted; report once the work is done for exact numbers.
+////////////////////
+std::string StatsReport();
+void PrintStats (FILE *dest);
+
+
+////////////////////
+// Function:
+//      ClearStats
+//
+// Purpose:
+//      Reset every statistic to zero. No other thread may be updating
+//      statistics at the time.
+////////////////////
+void ClearStats();
+
+#endif
@@ -28,17 +28,118 @@
  *  Last Modified:
  */
 
+#include <stdio.h>
+
 #include "transform.h"
 
+
+////////////////////
 // Matrix4x4 Utility Methods
+////////////////////
 Matrix4x4 Transpose (const Matrix4x4 &m) {
+#ifdef PB_RAY_SSE
+    Matrix4x4 r;
+    __m128 r0 = m.Row (0), r1 = m.Row (1), r2 = m.Row (2), r3 = m.Row (3);
+
+    _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+    _mm_store_ps (&r.m[0][0], r0);
+    _mm_store_ps (&r.m[1][0], r1);
+    _mm_store_ps (&r.m[2][0], r2);
+    _mm_store_ps (&r.m[3][0], r3);
+
+    return r;
+#else
     return Matrix4x4 (m.m[0][0], m.m[1][0], m.m[2][0], m.m[3][0],
                       m.m[0][1], m.m[1][1], m.m[2][1], m.m[3][1],
                       m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2],
                       m.m[0][3], m.m[1][3], m.m[2][3], m.m[3][3]);
+#endif
 }
 
-Matrix4x4 Inverse (const Matrix4x4 &inputMatrix) {
+
+#ifdef PB_RAY_SSE
+// Broadcast lane C of v to all four lanes.
+template <int C>
+static inline __m128 Splat (__m128 v) {
+    return _mm_shuffle_ps (v, v, _MM_SHUFFLE (C, C, C, C));
+}
+
+////////////////////
+// Function:
+//      EliminateColumn
+//
+// Purpose:
+//      One step of SSE Gauss-Jordan elimination on the augmented matrix
+//      [a | b]: pick the row with the largest entry in column C (partial
+//      pivoting), swap it into row C, scale it so the pivot is one and
+//      subtract it from the other three rows.
+//
+//      Each row of a and b is one register, so the row operations are a
+//      single multiply and subtract per half.
+//
+// Returns:
+//      false if the column has no usable pivot, i.e. the matrix is
+//      singular.
+////////////////////
+template <int C>
+static inline bool EliminateColumn (__m128 a[4], __m128 b[4]) {
+    const __m128 absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+
+    int pivotRow = C;
+    float biggestValue = _mm_cvtss_f32 (_mm_and_ps (Splat<C> (a[C]), absMask));
+
+    for (int r = C + 1; r < 4; ++r) {
+        float value = _mm_cvtss_f32 (_mm_and_ps (Splat<C> (a[r]), absMask));
+
+        if (value > biggestValue) {
+            biggestValue = value;
+            pivotRow = r;
+        }
+    }
+
+    if (biggestValue == 0.f)
+        return false;
+
+    std::swap (a[C], a[pivotRow]);
+    std::swap (b[C], b[pivotRow]);
+
+    __m128 pivotInverse = _mm_div_ps (_mm_set1_ps (1.f), Splat<C> (a[C]));
+    a[C] = _mm_mul_ps (a[C], pivotInverse);
+    b[C] = _mm_mul_ps (b[C], pivotInverse);
+
+    for (int r = 0; r < 4; ++r) {
+        if (r != C) {
+            __m128 factor = Splat<C> (a[r]);
+            a[r] = _mm_sub_ps (a[r], _mm_mul_ps (factor, a[C]));
+            b[r] = _mm_sub_ps (b[r], _mm_mul_ps (factor, b[C]));
+        }
+    }
+
+    return true;
+}
+
+static Matrix4x4 GeneralInverse (const Matrix4x4 &inputMatrix) {
+    __m128 a[4] = { inputMatrix.Row (0), inputMatrix.Row (1),
+                    inputMatrix.Row (2), inputMatrix.Row (3) };
+    __m128 b[4] = { _mm_set_ps (0, 0, 0, 1), _mm_set_ps (0, 0, 1, 0),
+                    _mm_set_ps (0, 1, 0, 0), _mm_set_ps (1, 0, 0, 0) };
+
+    if (!EliminateColumn<0> (a, b) || !EliminateColumn<1> (a, b) ||
+        !EliminateColumn<2> (a, b) || !EliminateColumn<3> (a, b)) {
+        fprintf (stderr, "Singular matrix in Inverse\n");
+        return Matrix4x4 ();
+    }
+
+    Matrix4x4 r;
+
+    for (int i = 0; i < 4; ++i)
+        _mm_store_ps (&r.m[i][0], b[i]);
+
+    return r;
+}
+#else
+static Matrix4x4 GeneralInverse (const Matrix4x4 &inputMatrix) {
     int columnIndex[4], rowIndex[4];
     int pivot[4] = {0, 0, 0, 0};
     int i, j, k;
@@ -51,17 +152,734 @@ Matrix4x4 Inverse (const Matrix4x4 &inputMatrix) {
         
         // Choose a pivot
         for (j = 0; j < 4; j++) {
-            if (pivot[i] != 1) {
+            if (pivot[j] != 1) {
                 for (k = 0; k < 4; k++) {
-                    if (fabsf (inverseMatrix[j][k] >= biggestValue)) {
-                        biggestValue = float (fabs(inverseMatrix[j][k]));
-                        row = j;
-                        column = k;
+                    if (pivot[k] == 0) {
+                        if (fabsf (inverseMatrix[j][k]) >= biggestValue) {
+                            biggestValue = fabsf (inverseMatrix[j][k]);
+                            row = j;
+                            column = k;
+                        }
+                    }
+                    else if (pivot[k] > 1) {
+                        fprintf (stderr, "Singular matrix in Inverse\n");
+                        return Matrix4x4 ();
                     }
                 }
             }
         }
+
+        ++pivot[column];
+
+        // Swap rows so that the pivot ends up on the diagonal.
+        if (row != column)
+            std::swap (inverseMatrix[row], inverseMatrix[column]);
+
+        rowIndex[i] = row;
+        columnIndex[i] = column;
+
+        if (inverseMatrix[column][column] == 0.f) {
+            fprintf (stderr, "Singular matrix in Inverse\n");
+            return Matrix4x4 ();
+        }
+
+        // Scale the pivot row so that the pivot becomes one.
+        float pivotInverse = 1.f / inverseMatrix[column][column];
+        inverseMatrix[column][column] = 1.f;
+
+        for (j = 0; j < 4; j++)
+            inverseMatrix[column][j] *= pivotInverse;
+
+        // Subtract the pivot row from the others to zero out its column.
+        for (j = 0; j < 4; j++) {
+            if (j != column) {
+                float save = inverseMatrix[j][column];
+                inverseMatrix[j][column] = 0;
+
+                for (k = 0; k < 4; k++)
+                    inverseMatrix[j][k] -= inverseMatrix[column][k] * save;
+            }
+        }
+    }
+
+    // Undo the row swaps by swapping the corresponding columns back.
+    for (j = 3; j >= 0; j--) {
+        if (rowIndex[j] != columnIndex[j]) {
+            for (k = 0; k < 4; k++)
+                std::swap (inverseMatrix[k][rowIndex[j]],
+                           inverseMatrix[k][columnIndex[j]]);
+        }
     }
 
 	return Matrix4x4(inverseMatrix);
 }
+#endif
+
+
+////////////////////
+// Function:
+//      Inverse
+//
+// Purpose:
+//      Invert a matrix with Gauss-Jordan elimination. With SSE each row of
+//      the augmented matrix is one register and partial pivoting is used;
+//      the scalar build uses full pivoting.
+//
+//      Affine matrices, which is nearly every matrix a scene contains, skip
+//      the elimination entirely and go through AffineInverse().
+//
+//      A singular matrix is reported on stderr and the identity is
+//      returned in its place.
+//
+// Parameters:
+//      const Matrix4x4 &inputMatrix - The matrix to invert.
+//
+// Returns:
+//      The inverse of inputMatrix.
+////////////////////
+Matrix4x4 Inverse (const Matrix4x4 &inputMatrix) {
+    if (inputMatrix.IsAffine())
+        return AffineInverse (inputMatrix);
+
+    return GeneralInverse (inputMatrix);
+}
+
+
+////////////////////
+// Function:
+//      AffineInverse
+//
+// Purpose:
+//      Invert a matrix whose bottom row is (0, 0, 0, 1). The upper 3x3
+//      block is inverted in closed form (adjugate over determinant) and the
+//      translation becomes -A^-1 t, which is a fraction of the work of a
+//      general 4x4 inversion.
+//
+// Parameters:
+//      const Matrix4x4 &mat - The affine matrix to invert.
+//
+// Returns:
+//      The inverse of mat.
+////////////////////
+Matrix4x4 AffineInverse (const Matrix4x4 &mat) {
+    const std::array <std::array <float, 4>, 4> &m = mat.m;
+
+    assert (mat.IsAffine());
+
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+
+    if (det == 0.f) {
+        fprintf (stderr, "Singular matrix in Inverse\n");
+        return Matrix4x4 ();
+    }
+
+    float invDet = 1.f / det;
+
+    float r00 = c00 * invDet;
+    float r01 = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+    float r02 = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+    float r10 = c01 * invDet;
+    float r11 = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+    float r12 = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+    float r20 = c02 * invDet;
+    float r21 = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+    float r22 = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+    float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+
+    return Matrix4x4 (r00, r01, r02, -(r00 * tx + r01 * ty + r02 * tz),
+                      r10, r11, r12, -(r10 * tx + r11 * ty + r12 * tz),
+                      r20, r21, r22, -(r20 * tx + r21 * ty + r22 * tz),
+                      0, 0, 0, 1);
+}
+
+
+////////////////////
+// Transform Methods
+////////////////////
+Transform Transform::operator* (const Transform &t2) const {
+    return Transform (Matrix4x4::Mul (m, t2.m),
+                      Matrix4x4::Mul (t2.mInv, mInv));
+}
+
+bool Transform::IsIdentity() const {
+    return m == Matrix4x4 ();
+}
+
+bool Transform::HasScale() const {
+    float la2 = (*this)(Vector (1, 0, 0)).LengthSquared();
+    float lb2 = (*this)(Vector (0, 1, 0)).LengthSquared();
+    float lc2 = (*this)(Vector (0, 0, 1)).LengthSquared();
+
+#define NOT_ONE(x) ((x) < .999f || (x) > 1.001f)
+    return (NOT_ONE (la2) || NOT_ONE (lb2) || NOT_ONE (lc2));
+#undef NOT_ONE
+}
+
+bool Transform::SwapsHandedness() const {
+    float det = ((m.m[0][0] *
+                  (m.m[1][1] * m.m[2][2] -
+                   m.m[1][2] * m.m[2][1])) -
+                 (m.m[0][1] *
+                  (m.m[1][0] * m.m[2][2] -
+                   m.m[1][2] * m.m[2][0])) +
+                 (m.m[0][2] *
+                  (m.m[1][0] * m.m[2][1] -
+                   m.m[1][1] * m.m[2][0])));
+
+    return det < 0.f;
+}
+
+
+////////////////////
+// Function:
+//      Transform::operator() (const BBox&)
+//
+// Purpose:
+//      Bound the transformed box.
+//
+//      For affine transforms this uses Arvo's method: each output extent
+//      is the translation plus the smaller (larger) of the two products of
+//      every matrix entry with the input extents. That is exact and much
+//      cheaper than transforming all eight corners, which is still done for
+//      projective transforms.
+////////////////////
+BBox Transform::operator() (const BBox &b) const {
+    // An empty box stays empty; Arvo's method would turn it into NaNs.
+    if (b.pMin.x > b.pMax.x || b.pMin.y > b.pMax.y || b.pMin.z > b.pMax.z)
+        return BBox ();
+
+    if (!IsAffine()) {
+        const Transform &M = *this;
+        BBox ret (M (Point (b.pMin.x, b.pMin.y, b.pMin.z)));
+
+        ret = Union (ret, M (Point (b.pMax.x, b.pMin.y, b.pMin.z)));
+        ret = Union (ret, M (Point (b.pMin.x, b.pMax.y, b.pMin.z)));
+        ret = Union (ret, M (Point (b.pMin.x, b.pMin.y, b.pMax.z)));
+        ret = Union (ret, M (Point (b.pMin.x, b.pMax.y, b.pMax.z)));
+        ret = Union (ret, M (Point (b.pMax.x, b.pMax.y, b.pMin.z)));
+        ret = Union (ret, M (Point (b.pMax.x, b.pMin.y, b.pMax.z)));
+        ret = Union (ret, M (Point (b.pMax.x, b.pMax.y, b.pMax.z)));
+
+        return ret;
+    }
+
+    BBox ret;
+
+    for (int i = 0; i < 3; ++i) {
+        ret.pMin[i] = ret.pMax[i] = m.m[i][3];
+
+        for (int j = 0; j < 3; ++j) {
+            float a = m.m[i][j] * b.pMin[j];
+            float c = m.m[i][j] * b.pMax[j];
+
+            ret.pMin[i] += min (a, c);
+            ret.pMax[i] += max (a, c);
+        }
+    }
+
+    return ret;
+}
+
+
+////////////////////
+// Function:
+//      TransformBatch
+//
+// Purpose:
+//      The kernel behind the batch operator() overloads. Applies the upper
+//      3x4 part of a matrix (rows r[0..2]) to n packed xyz triples.
+//
+//      Points, Vectors and Normals are all three packed floats, so four of
+//      them fill exactly three SSE registers. Each group of four is
+//      shuffled into x, y and z registers, transformed with nine
+//      multiply-adds, and shuffled back before being stored.
+//
+// Parameters:
+//      const float r[3][4] - The rows of the matrix; r[i][3] is the
+//                            translation, zero for vectors and normals.
+//      const float *in - n packed triples.
+//      float *out - Receives n packed triples; may alias in.
+//      size_t n - The number of triples.
+////////////////////
+static void TransformBatch (const float r[3][4], const float *in, float *out,
+                            size_t n) {
+    size_t i = 0;
+
+#ifdef PB_RAY_SSE
+    __m128 m00 = _mm_set1_ps (r[0][0]), m01 = _mm_set1_ps (r[0][1]),
+           m02 = _mm_set1_ps (r[0][2]), m03 = _mm_set1_ps (r[0][3]);
+    __m128 m10 = _mm_set1_ps (r[1][0]), m11 = _mm_set1_ps (r[1][1]),
+           m12 = _mm_set1_ps (r[1][2]), m13 = _mm_set1_ps (r[1][3]);
+    __m128 m20 = _mm_set1_ps (r[2][0]), m21 = _mm_set1_ps (r[2][1]),
+           m22 = _mm_set1_ps (r[2][2]), m23 = _mm_set1_ps (r[2][3]);
+
+    for (; i + 4 <= n; i += 4) {
+        const float *src = in + 3 * i;
+        float *dst = out + 3 * i;
+
+        // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+        __m128 a = _mm_loadu_ps (src);
+        __m128 b = _mm_loadu_ps (src + 4);
+        __m128 c = _mm_loadu_ps (src + 8);
+
+        // Deinterleave into x, y and z registers.
+        __m128 x = _mm_shuffle_ps (a, _mm_shuffle_ps (b, c, _MM_SHUFFLE (1, 1, 2, 2)),
+                                   _MM_SHUFFLE (2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps (_mm_shuffle_ps (a, b, _MM_SHUFFLE (0, 0, 1, 1)),
+                                   _mm_shuffle_ps (b, c, _MM_SHUFFLE (2, 2, 3, 3)),
+                                   _MM_SHUFFLE (2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps (_mm_shuffle_ps (a, b, _MM_SHUFFLE (1, 1, 2, 2)),
+                                   _mm_shuffle_ps (c, c, _MM_SHUFFLE (3, 3, 0, 0)),
+                                   _MM_SHUFFLE (2, 0, 2, 0));
+
+        __m128 xp = _mm_add_ps (_mm_add_ps (_mm_mul_ps (m00, x), _mm_mul_ps (m01, y)),
+                                _mm_add_ps (_mm_mul_ps (m02, z), m03));
+        __m128 yp = _mm_add_ps (_mm_add_ps (_mm_mul_ps (m10, x), _mm_mul_ps (m11, y)),
+                                _mm_add_ps (_mm_mul_ps (m12, z), m13));
+        __m128 zp = _mm_add_ps (_mm_add_ps (_mm_mul_ps (m20, x), _mm_mul_ps (m21, y)),
+                                _mm_add_ps (_mm_mul_ps (m22, z), m23));
+
+        // Interleave back into x0 y0 z0 x1 / y1 z1 x2 y2 / z2 x3 y3 z3.
+        a = _mm_shuffle_ps (_mm_unpacklo_ps (xp, yp),
+                            _mm_shuffle_ps (zp, xp, _MM_SHUFFLE (1, 1, 0, 0)),
+                            _MM_SHUFFLE (2, 0, 1, 0));
+        b = _mm_shuffle_ps (_mm_shuffle_ps (yp, zp, _MM_SHUFFLE (1, 1, 1, 1)),
+                            _mm_shuffle_ps (xp, yp, _MM_SHUFFLE (2, 2, 2, 2)),
+                            _MM_SHUFFLE (2, 0, 2, 0));
+        c = _mm_shuffle_ps (_mm_shuffle_ps (zp, xp, _MM_SHUFFLE (3, 3, 2, 2)),
+                            _mm_shuffle_ps (yp, zp, _MM_SHUFFLE (3, 3, 3, 3)),
+                            _MM_SHUFFLE (2, 0, 2, 0));
+
+        _mm_storeu_ps (dst, a);
+        _mm_storeu_ps (dst + 4, b);
+        _mm_storeu_ps (dst + 8, c);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        float x = in[3 * i], y = in[3 * i + 1], z = in[3 * i + 2];
+
+        out[3 * i]     = r[0][0] * x + r[0][1] * y + r[0][2] * z + r[0][3];
+        out[3 * i + 1] = r[1][0] * x + r[1][1] * y + r[1][2] * z + r[1][3];
+        out[3 * i + 2] = r[2][0] * x + r[2][1] * y + r[2][2] * z + r[2][3];
+    }
+}
+
+static_assert (sizeof (Point) == 3 * sizeof (float) &&
+               sizeof (Vector) == 3 * sizeof (float) &&
+               sizeof (Normal) == 3 * sizeof (float),
+               "The batch transforms assume tightly packed xyz triples");
+
+void Transform::operator() (const Point *in, Point *out, size_t n) const {
+    // Projective transforms need the divide by w; leave those to the
+    // single point version.
+    if (!IsAffine()) {
+        for (size_t i = 0; i < n; ++i)
+            out[i] = (*this)(in[i]);
+        return;
+    }
+
+    const float r[3][4] = {
+        { m.m[0][0], m.m[0][1], m.m[0][2], m.m[0][3] },
+        { m.m[1][0], m.m[1][1], m.m[1][2], m.m[1][3] },
+        { m.m[2][0], m.m[2][1], m.m[2][2], m.m[2][3] }
+    };
+
+    TransformBatch (r, &in->x, &out->x, n);
+}
+
+void Transform::operator() (const Vector *in, Vector *out, size_t n) const {
+    const float r[3][4] = {
+        { m.m[0][0], m.m[0][1], m.m[0][2], 0.f },
+        { m.m[1][0], m.m[1][1], m.m[1][2], 0.f },
+        { m.m[2][0], m.m[2][1], m.m[2][2], 0.f }
+    };
+
+    TransformBatch (r, &in->x, &out->x, n);
+}
+
+void Transform::operator() (const Normal *in, Normal *out, size_t n) const {
+    // The inverse transpose, as in the single normal version.
+    const float r[3][4] = {
+        { mInv.m[0][0], mInv.m[1][0], mInv.m[2][0], 0.f },
+        { mInv.m[0][1], mInv.m[1][1], mInv.m[2][1], 0.f },
+        { mInv.m[0][2], mInv.m[1][2], mInv.m[2][2], 0.f }
+    };
+
+    TransformBatch (r, &in->x, &out->x, n);
+}
+
+void Transform::operator() (const Ray *in, Ray *out, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = (*this)(in[i]);
+}
+
+
+////////////////////
+// Transform Construction Functions
+////////////////////
+Transform Translate (const Vector &delta) {
+    Matrix4x4 m (1, 0, 0, delta.x,
+                 0, 1, 0, delta.y,
+                 0, 0, 1, delta.z,
+                 0, 0, 0, 1);
+
+    Matrix4x4 mInv (1, 0, 0, -delta.x,
+                    0, 1, 0, -delta.y,
+                    0, 0, 1, -delta.z,
+                    0, 0, 0, 1);
+
+    return Transform (m, mInv);
+}
+
+Transform Scale (float x, float y, float z) {
+    Matrix4x4 m (x, 0, 0, 0,
+                 0, y, 0, 0,
+                 0, 0, z, 0,
+                 0, 0, 0, 1);
+
+    Matrix4x4 mInv (1.f / x, 0, 0, 0,
+                    0, 1.f / y, 0, 0,
+                    0, 0, 1.f / z, 0,
+                    0, 0, 0, 1);
+
+    return Transform (m, mInv);
+}
+
+// The rotation matrices are orthogonal, so their inverse is the transpose.
+Transform RotateX (float angle) {
+    float sinTheta = sinf (Radians (angle));
+    float cosTheta = cosf (Radians (angle));
+
+    Matrix4x4 m (1, 0, 0, 0,
+                 0, cosTheta, -sinTheta, 0,
+                 0, sinTheta, cosTheta, 0,
+                 0, 0, 0, 1);
+
+    return Transform (m, Transpose (m));
+}
+
+Transform RotateY (float angle) {
+    float sinTheta = sinf (Radians (angle));
+    float cosTheta = cosf (Radians (angle));
+
+    Matrix4x4 m (cosTheta, 0, sinTheta, 0,
+                 0, 1, 0, 0,
+                 -sinTheta, 0, cosTheta, 0,
+                 0, 0, 0, 1);
+
+    return Transform (m, Transpose (m));
+}
+
+Transform RotateZ (float angle) {
+    float sinTheta = sinf (Radians (angle));
+    float cosTheta = cosf (Radians (angle));
+
+    Matrix4x4 m (cosTheta, -sinTheta, 0, 0,
+                 sinTheta, cosTheta, 0, 0,
+                 0, 0, 1, 0,
+                 0, 0, 0, 1);
+
+    return Transform (m, Transpose (m));
+}
+
+// Rotate by angle degrees about an arbitrary axis.
+Transform Rotate (float angle, const Vector &axis) {
+    Vector a = Normalize (axis);
+    float s = sinf (Radians (angle));
+    float c = cosf (Radians (angle));
+
+    Matrix4x4 m (a.x * a.x + (1.f - a.x * a.x) * c,
+                 a.x * a.y * (1.f - c) - a.z * s,
+                 a.x * a.z * (1.f - c) + a.y * s,
+                 0,
+                 a.x * a.y * (1.f - c) + a.z * s,
+                 a.y * a.y + (1.f - a.y * a.y) * c,
+                 a.y * a.z * (1.f - c) - a.x * s,
+                 0,
+                 a.x * a.z * (1.f - c) - a.y * s,
+                 a.y * a.z * (1.f - c) + a.x * s,
+                 a.z * a.z + (1.f - a.z * a.z) * c,
+                 0,
+                 0, 0, 0, 1);
+
+    return Transform (m, Transpose (m));
+}
+
+// Build the camera-to-world style transform that places the viewer at pos
+// looking towards look; the returned Transform maps world to camera space.
+Transform LookAt (const Point &pos, const Point &look, const Vector &up) {
+    Vector dir = Normalize (look - pos);
+    Vector left = Normalize (Cross (Normalize (up), dir));
+    Vector newUp = Cross (dir, left);
+
+    Matrix4x4 camToWorld (left.x, newUp.x, dir.x, pos.x,
+                          left.y, newUp.y, dir.y, pos.y,
+                          left.z, newUp.z, dir.z, pos.z,
+                          0, 0, 0, 1);
+
+    return Transform (Inverse (camToWorld), camToWorld);
+}
+
+
+////////////////////
+// AnimatedTransform Methods
+////////////////////
+AnimatedTransform::AnimatedTransform (const Transform &startTransform,
+                                      float startTime,
+                                      const Transform &endTransform,
+                                      float endTime)
+        : startTransform(startTransform), endTransform(endTransform),
+          startTime(startTime), endTime(endTime),
+          invDuration(endTime > startTime ? 1.f / (endTime - startTime) : 0.f),
+          actuallyAnimated(startTransform != endTransform),
+          hasRotation(false), theta(0.f) {
+    assert (startTransform.IsAffine() && endTransform.IsAffine());
+
+    Decompose (startTransform.GetMatrix(), &T[0], &R[0], &S[0]);
+    Decompose (endTransform.GetMatrix(), &T[1], &R[1], &S[1]);
+
+    if (Dot (R[0], R[1]) < 0.f)
+        R[1] = -R[1];
+
+    // The angle between the two quaternions, in a form that stays accurate
+    // when they are nearly equal (where acos of their dot product doesn't).
+    Quaternion diff = R[1] - R[0], sum = R[1] + R[0];
+    theta = 2.f * atan2f (sqrtf (Dot (diff, diff)), sqrtf (Dot (sum, sum)));
+    hasRotation = theta > 0.f;
+
+    // For tiny angles R[1] - R[0] cos (theta) is mostly rounding error, but
+    // the rotation is then linear in the parameter to within float
+    // precision anyway.
+    if (theta > 1e-3f)
+        rPerp = Normalize (R[1] - R[0] * cosf (theta));
+    else if (hasRotation)
+        rPerp = diff / theta;
+}
+
+
+////////////////////
+// Function:
+//      AnimatedTransform::Decompose
+//
+// Purpose:
+//      Split an affine matrix into translation, rotation and the remaining
+//      scale and shear, m = T R S.
+//
+//      R is the orthogonal factor of the polar decomposition of m's 3x3
+//      part, found by averaging the matrix with its inverse transpose until
+//      it stops changing. If m mirrors, R and S are both negated so that R
+//      is a proper rotation and a quaternion can represent it.
+//
+// Parameters:
+//      const Matrix4x4 &m - The matrix to decompose.
+//      Vector *T - Receives the translation.
+//      Quaternion *R - Receives the rotation.
+//      Matrix4x4 *S - Receives the scale and shear.
+////////////////////
+void AnimatedTransform::Decompose (const Matrix4x4 &m, Vector *T,
+                                   Quaternion *R, Matrix4x4 *S) {
+    assert (m.IsAffine());
+
+    *T = Vector (m.m[0][3], m.m[1][3], m.m[2][3]);
+
+    Matrix4x4 M = m;
+    for (int i = 0; i < 3; ++i)
+        M.m[i][3] = 0.f;
+
+    Matrix4x4 rot = M;
+    float norm;
+    int count = 0;
+
+    do {
+        Matrix4x4 next, invTrans = Inverse (Transpose (rot));
+
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                next.m[i][j] = .5f * (rot.m[i][j] + invTrans.m[i][j]);
+
+        norm = 0.f;
+        for (int i = 0; i < 3; ++i)
+            norm = max (norm, fabsf (rot.m[i][0] - next.m[i][0]) +
+                              fabsf (rot.m[i][1] - next.m[i][1]) +
+                              fabsf (rot.m[i][2] - next.m[i][2]));
+
+        rot = next;
+    } while (++count < 100 && norm > .0001f);
+
+    if (Transform (rot, Transpose (rot)).SwapsHandedness())
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                rot.m[i][j] = -rot.m[i][j];
+
+    *R = Quaternion (Transform (rot, Transpose (rot)));
+    *S = Matrix4x4::Mul (Transpose (rot), M);
+}
+
+
+////////////////////
+// Function:
+//      AnimatedTransform::Interpolate
+//
+// Purpose:
+//      Rebuild the transform at the given time from the keyframes'
+//      decompositions.
+//
+// Parameters:
+//      float time - The time to evaluate at; clamped to the interval.
+//      Transform *t - Receives the transform and its inverse.
+////////////////////
+void AnimatedTransform::Interpolate (float time, Transform *t) const {
+    if (!actuallyAnimated || time <= startTime) {
+        *t = startTransform;
+        return;
+    }
+
+    if (time >= endTime) {
+        *t = endTransform;
+        return;
+    }
+
+    float u = (time - startTime) * invDuration;
+    float r[3][3], s[3][3];
+
+    if (hasRotation) {
+        float angle = u * theta;
+        (R[0] * cosf (angle) + rPerp * sinf (angle)).ToMatrix (r);
+    }
+    else
+        R[0].ToMatrix (r);
+
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            s[i][j] = Lerp (u, S[0].m[i][j], S[1].m[i][j]);
+
+    Matrix4x4 m;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            m.m[i][j] = r[i][0] * s[0][j] + r[i][1] * s[1][j] +
+                        r[i][2] * s[2][j];
+
+        m.m[i][3] = Lerp (u, T[0][i], T[1][i]);
+    }
+
+    *t = Transform (m, AffineInverse (m));
+}
+
+Ray AnimatedTransform::operator() (const Ray &r) const {
+    if (!actuallyAnimated)
+        return startTransform (r);
+
+    Transform t;
+    Interpolate (r.time, &t);
+    return t (r);
+}
+
+Point AnimatedTransform::operator() (float time, const Point &p) const {
+    if (!actuallyAnimated)
+        return startTransform (p);
+
+    Transform t;
+    Interpolate (time, &t);
+    return t (p);
+}
+
+Vector AnimatedTransform::operator() (float time, const Vector &v) const {
+    if (!actuallyAnimated)
+        return startTransform (v);
+
+    Transform t;
+    Interpolate (time, &t);
+    return t (v);
+}
+
+
+// The number of times MotionBounds samples a rotating transform at.
+static const int kMotionBoundSamples = 16;
+
+
+////////////////////
+// Function:
+//      AnimatedTransform::MotionBounds
+//
+// Purpose:
+//      Bound the region a box sweeps over the interval.
+//
+//      Without rotation every point of the box moves along a straight line
+//      (T and S are linear in time), so the boxes at the two ends bound the
+//      sweep.
+//
+//      With rotation the box is transformed at kMotionBoundSamples + 1
+//      evenly spaced times and the union is padded by how far any point
+//      can move between two samples. The velocity of a point p, per unit of
+//      the interpolation parameter, is
+//          (T1 - T0) + R' S p + R (S1 - S0) p,
+//      and the rotation turns at 2 theta radians per unit, so its speed is
+//      at most |T1 - T0| + 2 theta |S p| + |(S1 - S0) p|. Both norms are
+//      convex in p and S, so their largest values over the box and the
+//      interval are at a corner of the box and a keyframe. Every point
+//      along the path is within half a sample spacing of a sample, which
+//      gives the padding.
+//
+// Parameters:
+//      const BBox &b - The box, in the space the transform maps from.
+//
+// Returns:
+//      A box containing b transformed at every time in the interval.
+////////////////////
+BBox AnimatedTransform::MotionBounds (const BBox &b) const {
+    if (!actuallyAnimated)
+        return startTransform (b);
+
+    if (!hasRotation)
+        return Union (startTransform (b), endTransform (b));
+
+    if (b.pMin.x > b.pMax.x || b.pMin.y > b.pMax.y || b.pMin.z > b.pMax.z)
+        return BBox ();
+
+    BBox bounds;
+
+    for (int i = 0; i <= kMotionBoundSamples; ++i) {
+        Transform t;
+        Interpolate (Lerp (float (i) / kMotionBoundSamples,
+                           startTime, endTime), &t);
+        bounds = Union (bounds, t (b));
+    }
+
+    float maxSp = 0.f, maxDSp = 0.f;
+
+    for (int c = 0; c < 8; ++c) {
+        Vector p ((c & 1) ? b.pMax.x : b.pMin.x,
+                  (c & 2) ? b.pMax.y : b.pMin.y,
+                  (c & 4) ? b.pMax.z : b.pMin.z);
+        Vector sp[2], dsp;
+
+        for (int i = 0; i < 3; ++i) {
+            for (int k = 0; k < 2; ++k)
+                sp[k][i] = S[k].m[i][0] * p.x + S[k].m[i][1] * p.y +
+                           S[k].m[i][2] * p.z;
+
+            dsp[i] = sp[1][i] - sp[0][i];
+        }
+
+        maxSp = max (maxSp, max (sp[0].Length(), sp[1].Length()));
+        maxDSp = max (maxDSp, dsp.Length());
+    }
+
+    float speed = (T[1] - T[0]).Length() + 2.f * theta * maxSp + maxDSp;
+
+    // The interpolated matrices and the points they map are rounded, by a
+    // few ulps of the largest coordinate involved.
+    float extent = 0.f;
+    for (int i = 0; i < 3; ++i)
+        extent = max (extent, max (fabsf (bounds.pMin[i]),
+                                   fabsf (bounds.pMax[i])));
+
+    bounds.Expand (speed * (.5f / kMotionBoundSamples) + Gamma (8) * extent);
+    return bounds;
+}
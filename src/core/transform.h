@@ -26,6 +26,15 @@
  *  Creation Date: 16-01-2014
  */
 
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stddef.h>
+#include <array>
+
+#include "Geometry.h"
+#include "quaternion.h"
+
 
 ////////////////////
 // struct: Matrix4x4
@@ -45,12 +54,10 @@
 //            (plain old data) that simply needs organization and no other
 //            functionality.
 ////////////////////
-
-#include <array>
-
 class Matrix4x4 {
     public:
-        std::array <std::array <float, 4>, 4> m;
+        // Aligned so that each row can be loaded into an SSE register.
+        alignas(16) std::array <std::array <float, 4>, 4> m;
 
         // Constructors
         Matrix4x4 () {
@@ -86,39 +93,54 @@ class Matrix4x4 {
 
 
     // Operators
-    bool operator== (Matrix4x4 mx) {
-        std::array <std::array <float, 4>, 4>::const_iterator it1, it2;
+    bool operator== (const Matrix4x4 &mx) const {
+#ifdef PB_RAY_SSE
+        __m128 eq = _mm_and_ps (
+                _mm_and_ps (_mm_cmpeq_ps (Row (0), mx.Row (0)),
+                            _mm_cmpeq_ps (Row (1), mx.Row (1))),
+                _mm_and_ps (_mm_cmpeq_ps (Row (2), mx.Row (2)),
+                            _mm_cmpeq_ps (Row (3), mx.Row (3))));
 
-        it1 = this->m.cbegin();
-        it2 = mx.m.cbegin();
-
-        for (; it1 < m.end(); ++it1, ++it2) {
-            if (*it1 != *it2)
-                return false;
-        }
-
-        return true;
+        return _mm_movemask_ps (eq) == 0xf;
+#else
+        return m == mx.m;
+#endif
     }
 
-    bool operator!= (Matrix4x4 mx) {
-        std::array <std::array <float, 4>, 4>::const_iterator it1, it2;
-
-        it1 = this->m.cbegin();
-        it2 = mx.m.cbegin();
+    bool operator!= (const Matrix4x4 &mx) const {
+        return !(*this == mx);
+    }
 
-        for (; it1 < m.end(); ++it1, ++it2) {
-            if (*it1 != *it2)
-                return true;
-        }
+    // Utility Methods
 
-        return false;
+    // True when the bottom row is (0, 0, 0, 1), i.e. the matrix is a 3x3
+    // linear part plus a translation.
+    bool IsAffine() const {
+        return m[3][0] == 0.f && m[3][1] == 0.f &&
+               m[3][2] == 0.f && m[3][3] == 1.f;
     }
 
-    // Utility Methods
-    static Matrix4x4 Mul (Matrix4x4 m1, Matrix4x4 m2)
+    static Matrix4x4 Mul (const Matrix4x4 &m1, const Matrix4x4 &m2)
     {
         Matrix4x4 r;
 
+#ifdef PB_RAY_SSE
+        // Row i of the product is the sum of the rows of m2 weighted by
+        // the entries of row i of m1.
+        __m128 b0 = m2.Row (0), b1 = m2.Row (1),
+               b2 = m2.Row (2), b3 = m2.Row (3);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128 row = _mm_add_ps (
+                    _mm_add_ps (_mm_mul_ps (_mm_set1_ps (m1.m[i][0]), b0),
+                                _mm_mul_ps (_mm_set1_ps (m1.m[i][1]), b1)),
+                    _mm_add_ps (_mm_mul_ps (_mm_set1_ps (m1.m[i][2]), b2),
+                                _mm_mul_ps (_mm_set1_ps (m1.m[i][3]), b3)));
+
+            _mm_store_ps (&r.m[i][0], row);
+        }
+#else
         for (int i = 0; i < 4; ++i)
         {
             for (int j = 0; j < 4; ++j)
@@ -129,10 +151,328 @@ class Matrix4x4 {
                             (m1.m[i][3] * m2.m[3][j]);
             }
         }
+#endif
 
         return r;
     }
 
+#ifdef PB_RAY_SSE
+    __m128 Row (int i) const { return _mm_load_ps (&m[i][0]); }
+#endif
+
     friend Matrix4x4 Transpose (const Matrix4x4&);
     friend Matrix4x4 Inverse (const Matrix4x4&);
+    friend Matrix4x4 AffineInverse (const Matrix4x4&);
+};
+
+Matrix4x4 Transpose (const Matrix4x4&);
+Matrix4x4 Inverse (const Matrix4x4&);
+Matrix4x4 AffineInverse (const Matrix4x4&);
+
+
+////////////////////
+// Class: Transform
+//
+// Purpose:
+//      Map points, vectors, normals, rays and bounding boxes from one
+//      coordinate system to another.
+//
+//      Both the matrix and its inverse are stored. Transforms are built
+//      once (at scene load) and applied many times, so the inverse is
+//      computed when the Transform is constructed and never again; taking
+//      the Inverse() of a Transform just swaps the two matrices.
+//
+// Notes:
+//      Normals are transformed by the inverse transpose, which is read
+//      straight out of mInv instead of being formed explicitly.
+////////////////////
+class Transform {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        Transform () { }
+
+        Transform (float mat[4][4]) : m(mat), mInv(Inverse (m)) { }
+
+        Transform (const Matrix4x4 &mat) : m(mat), mInv(Inverse (mat)) { }
+
+        // Use this one when the inverse is known analytically (translations,
+        // rotations, ...) to skip the general inversion.
+        Transform (const Matrix4x4 &mat, const Matrix4x4 &matInv)
+                : m(mat), mInv(matInv) { }
+
+
+        ///////////////
+        // Operators
+        ///////////////
+        bool operator== (const Transform &t) const {
+            return t.m == m && t.mInv == mInv;
+        }
+
+        bool operator!= (const Transform &t) const {
+            return t.m != m || t.mInv != mInv;
+        }
+
+        // Compose two transforms; (t1 * t2)(p) == t1 (t2 (p)).
+        Transform operator* (const Transform &t2) const;
+
+        // Apply the transform to a single element.
+        inline Point operator() (const Point &p) const;
+        inline Vector operator() (const Vector &v) const;
+        inline Normal operator() (const Normal &n) const;
+        inline Ray operator() (const Ray &r) const;
+        inline RayDifferential operator() (const RayDifferential &r) const;
+        inline CompactRayDifferential operator() (
+                const CompactRayDifferential &r) const;
+        BBox operator() (const BBox &b) const;
+
+        // Apply an affine transform to a point and bound the floating point
+        //      error of the result. The second form is for points that
+        //      already carry error bounds of their own, such as hit points.
+        inline Point operator() (const Point &p, Vector *pTransError) const;
+        inline Point operator() (const Point &p, const Vector &pError,
+                                 Vector *pTransError) const;
+
+        // Apply the transform to n contiguous elements.
+        //      in and out may be the same array. These are the overloads
+        //      to use when baking meshes into world space; they work four
+        //      elements at a time with SSE.
+        void operator() (const Point *in, Point *out, size_t n) const;
+        void operator() (const Vector *in, Vector *out, size_t n) const;
+        void operator() (const Normal *in, Normal *out, size_t n) const;
+        void operator() (const Ray *in, Ray *out, size_t n) const;
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        friend Transform Inverse (const Transform &t) {
+            return Transform (t.mInv, t.m);
+        }
+
+        const Matrix4x4 &GetMatrix() const { return m; }
+        const Matrix4x4 &GetInverseMatrix() const { return mInv; }
+
+        bool IsIdentity() const;
+
+        // True when the bottom row is (0, 0, 0, 1), i.e. no projection.
+        bool IsAffine() const { return m.IsAffine(); }
+
+        bool HasScale() const;
+        bool SwapsHandedness() const;
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        Matrix4x4 m, mInv;
 };
+
+
+/***************
+ ***************
+ * Transform Construction Functions
+ ***************
+ ***************/
+Transform Translate (const Vector &delta);
+Transform Scale (float x, float y, float z);
+Transform RotateX (float angle);
+Transform RotateY (float angle);
+Transform RotateZ (float angle);
+Transform Rotate (float angle, const Vector &axis);
+Transform LookAt (const Point &pos, const Point &look, const Vector &up);
+
+
+/***************
+ ***************
+ * Transform Inline Functions
+ ***************
+ ***************/
+inline Point Transform::operator() (const Point &p) const {
+    float x = p.x, y = p.y, z = p.z;
+
+    float xp = m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z + m.m[0][3];
+    float yp = m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z + m.m[1][3];
+    float zp = m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z + m.m[2][3];
+    float wp = m.m[3][0] * x + m.m[3][1] * y + m.m[3][2] * z + m.m[3][3];
+
+    assert (wp != 0);
+
+    if (wp == 1.f)
+        return Point (xp, yp, zp);
+    else
+        return Point (xp, yp, zp) / wp;
+}
+
+inline Vector Transform::operator() (const Vector &v) const {
+    float x = v.x, y = v.y, z = v.z;
+
+    return Vector (m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z,
+                   m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z,
+                   m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z);
+}
+
+inline Normal Transform::operator() (const Normal &n) const {
+    float x = n.x, y = n.y, z = n.z;
+
+    // Multiply by the transpose of mInv; note the swapped indices.
+    return Normal (mInv.m[0][0] * x + mInv.m[1][0] * y + mInv.m[2][0] * z,
+                   mInv.m[0][1] * x + mInv.m[1][1] * y + mInv.m[2][1] * z,
+                   mInv.m[0][2] * x + mInv.m[1][2] * y + mInv.m[2][2] * z);
+}
+
+inline Point Transform::operator() (const Point &p,
+                                    Vector *pTransError) const {
+    assert (IsAffine());
+    float x = p.x, y = p.y, z = p.z;
+
+    // Each component is a sum of four products.
+    for (int i = 0; i < 3; ++i)
+        (*pTransError)[i] = Gamma (3) * (fabsf (m.m[i][0] * x) +
+                                         fabsf (m.m[i][1] * y) +
+                                         fabsf (m.m[i][2] * z) +
+                                         fabsf (m.m[i][3]));
+
+    return Point (m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z + m.m[0][3],
+                  m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z + m.m[1][3],
+                  m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z + m.m[2][3]);
+}
+
+inline Point Transform::operator() (const Point &p, const Vector &pError,
+                                    Vector *pTransError) const {
+    assert (IsAffine());
+    float x = p.x, y = p.y, z = p.z;
+
+    // The rounding of the sums plus the input error carried through the
+    // matrix (and rounded itself).
+    for (int i = 0; i < 3; ++i)
+        (*pTransError)[i] =
+                Gamma (3) * (fabsf (m.m[i][0] * x) + fabsf (m.m[i][1] * y) +
+                             fabsf (m.m[i][2] * z) + fabsf (m.m[i][3])) +
+                (Gamma (3) + 1.f) * (fabsf (m.m[i][0]) * pError.x +
+                                     fabsf (m.m[i][1]) * pError.y +
+                                     fabsf (m.m[i][2]) * pError.z);
+
+    return Point (m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z + m.m[0][3],
+                  m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z + m.m[1][3],
+                  m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z + m.m[2][3]);
+}
+
+inline Ray Transform::operator() (const Ray &r) const {
+    return Ray ((*this)(r.o), (*this)(r.d), r.mint, r.maxt, r.time);
+}
+
+inline RayDifferential Transform::operator() (const RayDifferential &r) const {
+    RayDifferential ret ((*this)(Ray (r)));
+
+    ret.hasDifferentials = r.hasDifferentials;
+    ret.rx = (*this)(r.rx);
+    ret.ry = (*this)(r.ry);
+
+    return ret;
+}
+
+inline CompactRayDifferential Transform::operator() (
+        const CompactRayDifferential &r) const {
+    // Under a projective transform the differences between the rays don't
+    // transform like vectors.
+    if (!IsAffine())
+        return CompactRayDifferential ((*this)(r.Expand()));
+
+    CompactRayDifferential ret ((*this)(Ray (r)));
+
+    if (r.hasDifferentials)
+        ret.SetDifferentials ((*this)(r.DpDx()), (*this)(r.DpDy()),
+                              (*this)(r.DdDx()), (*this)(r.DdDy()));
+
+    return ret;
+}
+
+
+////////////////////
+// Class: AnimatedTransform
+//
+// Purpose:
+//      A transform that moves between two keyframes over [startTime,
+//      endTime], evaluated at each ray's time for motion blur.
+//
+//      Blending the keyframe matrices entry by entry doesn't give a motion
+//      anyone would animate: a rotation shrinks towards the middle of the
+//      interval. Each keyframe is instead decomposed once, at construction,
+//      into a translation T, a rotation R and a remaining scale and shear S
+//      (M = T R S). Then T and S are interpolated linearly and R along the
+//      great arc between the keyframe rotations, at constant angular speed.
+//
+//      The per-ray work in Interpolate is one sine / cosine pair, a few
+//      dozen multiply-adds to rebuild the matrix and the closed form inverse
+//      of its 3x3 part.
+//
+//      MotionBounds bounds everything a box sweeps over the interval, so a
+//      BVH can hold moving primitives; see AnimatedPrimitive.
+//
+// Notes:
+//      Both keyframes must be affine. Times outside the interval are
+//      clamped to it.
+////////////////////
+class AnimatedTransform {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        AnimatedTransform (const Transform &startTransform, float startTime,
+                           const Transform &endTransform, float endTime);
+
+
+        ///////////////
+        // Operators
+        ///////////////
+        Ray operator() (const Ray &r) const;
+        Point operator() (float time, const Point &p) const;
+        Vector operator() (float time, const Vector &v) const;
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // Split the affine m into m = T R S.
+        static void Decompose (const Matrix4x4 &m, Vector *T, Quaternion *R,
+                               Matrix4x4 *S);
+
+        // The transform at the given time.
+        void Interpolate (float time, Transform *t) const;
+
+        // A box containing b transformed at every time in the interval.
+        BBox MotionBounds (const BBox &b) const;
+
+        // False when both keyframes are the same transform.
+        bool IsAnimated() const { return actuallyAnimated; }
+
+        float StartTime() const { return startTime; }
+        float EndTime() const { return endTime; }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        Transform startTransform, endTransform;
+        float startTime, endTime, invDuration;
+        bool actuallyAnimated, hasRotation;
+
+        // The keyframes' decompositions. R[1] is negated if need be so
+        //      that R[0] turns towards it the short way.
+        Vector T[2];
+        Quaternion R[2];
+        Matrix4x4 S[2];
+
+        // The rotation at interpolation parameter u is
+        //      R[0] cos (u theta) + rPerp sin (u theta), where rPerp is the
+        //      unit quaternion orthogonal to R[0] in the plane of R[0] and
+        //      R[1]. Computing it once leaves only the sine and cosine to
+        //      evaluate per ray.
+        Quaternion rPerp;
+        float theta;
+};
+
+#endif
@@ -0,0 +1,735 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: trianglemesh.cpp
+ *
+ *  Purpose: Build triangle meshes and intersect rays with their triangles.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <unordered_map>
+
+#include "trianglemesh.h"
+#include "parallel.h"
+#include "simd.h"
+#include "stats.h"
+
+
+////////////////////
+// TriangleMesh Methods
+////////////////////
+TriangleMesh::TriangleMesh (const Transform &objectToWorld, int nt,
+                            const int *vi, int nv, const Point *P,
+                            const Normal *N, const float *uv)
+        : nTriangles(nt), nVertices(nv), vertexIndices(vi, vi + 3 * nt) {
+    if (nVertices > 0)
+        SetVertices (objectToWorld, P, N);
+
+    if (nVertices > 0 && uv) {
+        uvU.resize (nVertices);
+        uvV.resize (nVertices);
+
+        for (int i = 0; i < nVertices; ++i) {
+            uvU[i] = uv[2 * i];
+            uvV[i] = uv[2 * i + 1];
+        }
+    }
+
+    triangles.reserve (nTriangles);
+    for (int i = 0; i < nTriangles; ++i)
+        triangles.push_back (Triangle (this, i));
+}
+
+// Vertices per parallel chunk in SetVertices.
+static const int kVertexGrainSize = 16384;
+
+
+////////////////////
+// Function:
+//      TriangleMesh::SetVertices
+//
+// Purpose:
+//      Move the mesh's vertices, keeping its triangles. This is how
+//      deforming meshes are animated; accelerators built over the mesh
+//      must be refitted (see BVHAccel::Refit) or rebuilt afterwards.
+//
+// Parameters:
+//      const Transform &objectToWorld - Where the vertices are placed.
+//      const Point *P - The new positions, nVertices of them.
+//      const Normal *N - Optional; the new normals, nVertices of them.
+//      TaskScheduler *scheduler - May be NULL.
+////////////////////
+void TriangleMesh::SetVertices (const Transform &objectToWorld,
+                                const Point *P, const Normal *N,
+                                TaskScheduler *scheduler) {
+    px.resize (nVertices);
+    py.resize (nVertices);
+    pz.resize (nVertices);
+
+    if (N) {
+        nx.resize (nVertices);
+        ny.resize (nVertices);
+        nz.resize (nVertices);
+    }
+
+    ParallelFor (scheduler, 0, nVertices, kVertexGrainSize,
+                 [&](int64_t begin, int64_t end) {
+        // Transform a chunk at a time through a buffer that stays in
+        // cache, then scatter it into the SoA arrays.
+        Point worldP[256];
+        Normal worldN[256];
+
+        for (int64_t first = begin; first < end; first += 256) {
+            int n = int (std::min<int64_t> (256, end - first));
+
+            objectToWorld (P + first, worldP, n);
+            for (int i = 0; i < n; ++i) {
+                px[first + i] = worldP[i].x;
+                py[first + i] = worldP[i].y;
+                pz[first + i] = worldP[i].z;
+            }
+
+            if (!N)
+                continue;
+
+            objectToWorld (N + first, worldN, n);
+            for (int i = 0; i < n; ++i) {
+                nx[first + i] = worldN[i].x;
+                ny[first + i] = worldN[i].y;
+                nz[first + i] = worldN[i].z;
+            }
+        }
+    });
+}
+
+std::vector<std::shared_ptr<Primitive> > TriangleMesh::CreateTriangles (
+        const std::shared_ptr<TriangleMesh> &mesh) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    prims.reserve (mesh->nTriangles);
+
+    // The aliasing constructor: each pointer shares the mesh's reference
+    // count but points at one of its triangles.
+    for (int i = 0; i < mesh->nTriangles; ++i)
+        prims.push_back (std::shared_ptr<Primitive> (mesh,
+                                                     &mesh->triangles[i]));
+
+    return prims;
+}
+
+size_t TriangleMesh::BytesUsed() const {
+    return sizeof (*this) +
+           vertexIndices.capacity() * sizeof (int) +
+           (px.capacity() + py.capacity() + pz.capacity() +
+            nx.capacity() + ny.capacity() + nz.capacity() +
+            uvU.capacity() + uvV.capacity()) * sizeof (float) +
+           triangles.capacity() * sizeof (Triangle);
+}
+
+
+////////////////////
+// struct: RayShear
+//
+// Purpose:
+//      The per-ray part of the watertight triangle test: the permutation
+//      of the axes that makes z the largest component of the direction,
+//      and the shear that then turns the direction into (0, 0, 1).
+////////////////////
+struct RayShear {
+    explicit RayShear (const Ray &ray) {
+        float ax = fabsf (ray.d.x), ay = fabsf (ray.d.y);
+        float az = fabsf (ray.d.z);
+
+        kz = (ax > ay) ? ((ax > az) ? 0 : 2) : ((ay > az) ? 1 : 2);
+        kx = (kz + 1) % 3;
+        ky = (kx + 1) % 3;
+
+        sx = -ray.d[kx] / ray.d[kz];
+        sy = -ray.d[ky] / ray.d[kz];
+        sz = 1.f / ray.d[kz];
+    }
+
+    int kx, ky, kz;
+    float sx, sy, sz;
+};
+
+
+////////////////////
+// Function:
+//      IntersectWatertight
+//
+// Purpose:
+//      Intersect a ray with the triangle p0 p1 p2 without gaps or double
+//      hits along edges shared with other triangles.
+//
+//      The vertices are moved into a space where the ray starts at the
+//      origin and runs along +z, which reduces the test to whether the
+//      origin is inside the triangle's 2D projection. The three edge
+//      functions that decide that are evaluated the same way for any
+//      triangle sharing an edge, so a ray on the edge is inside one of
+//      them; exact zeros are re-evaluated in double precision. Hits closer
+//      than the error bound on t are rejected, so a ray can't hit the
+//      surface it left.
+//
+//      PackedTriangles::IntersectBatch does the same arithmetic lane by
+//      lane, so the two agree up to rounding (the compiler may fuse
+//      multiply-adds in one and not the other).
+//
+// Parameters:
+//      const Point &p0, &p1, &p2 - The vertices.
+//      const Ray &ray - The ray; hits outside [mint, maxt] are ignored.
+//      const RayShear &shear - The ray's shear.
+//      float *tHit, *b1, *b2 - Receive the hit distance and the weights of
+//                              p1 and p2 at the hit.
+//
+// Returns:
+//      Whether the triangle is hit.
+////////////////////
+static bool IntersectWatertight (const Point &p0, const Point &p1,
+                                 const Point &p2, const Ray &ray,
+                                 const RayShear &shear, float *tHit,
+                                 float *b1, float *b2) {
+    const int kx = shear.kx, ky = shear.ky, kz = shear.kz;
+
+    float x0 = p0[kx] - ray.o[kx], y0 = p0[ky] - ray.o[ky];
+    float z0 = p0[kz] - ray.o[kz];
+    float x1 = p1[kx] - ray.o[kx], y1 = p1[ky] - ray.o[ky];
+    float z1 = p1[kz] - ray.o[kz];
+    float x2 = p2[kx] - ray.o[kx], y2 = p2[ky] - ray.o[ky];
+    float z2 = p2[kz] - ray.o[kz];
+
+    x0 += shear.sx * z0; y0 += shear.sy * z0;
+    x1 += shear.sx * z1; y1 += shear.sy * z1;
+    x2 += shear.sx * z2; y2 += shear.sy * z2;
+
+    float e0 = x1 * y2 - y1 * x2;
+    float e1 = x2 * y0 - y2 * x0;
+    float e2 = x0 * y1 - y0 * x1;
+
+    if (e0 == 0.f || e1 == 0.f || e2 == 0.f) {
+        e0 = float (double (x1) * double (y2) - double (y1) * double (x2));
+        e1 = float (double (x2) * double (y0) - double (y2) * double (x0));
+        e2 = float (double (x0) * double (y1) - double (y0) * double (x1));
+    }
+
+    if ((e0 < 0.f || e1 < 0.f || e2 < 0.f) &&
+        (e0 > 0.f || e1 > 0.f || e2 > 0.f))
+        return false;
+
+    float det = e0 + e1 + e2;
+
+    if (det == 0.f)
+        return false;
+
+    z0 *= shear.sz;
+    z1 *= shear.sz;
+    z2 *= shear.sz;
+
+    float invDet = 1.f / det;
+    float t = (e0 * z0 + e1 * z1 + e2 * z2) * invDet;
+
+    if (!(t >= ray.mint && t <= ray.maxt))
+        return false;
+
+    // Bound the error of t and reject hits that could be at or behind the
+    // origin.
+    float maxXt = max (fabsf (x0), max (fabsf (x1), fabsf (x2)));
+    float maxYt = max (fabsf (y0), max (fabsf (y1), fabsf (y2)));
+    float maxZt = max (fabsf (z0), max (fabsf (z1), fabsf (z2)));
+    float maxE = max (fabsf (e0), max (fabsf (e1), fabsf (e2)));
+
+    float deltaX = Gamma (5) * (maxXt + maxZt);
+    float deltaY = Gamma (5) * (maxYt + maxZt);
+    float deltaZ = Gamma (3) * maxZt;
+    float deltaE = 2.f * (Gamma (2) * maxXt * maxYt + deltaY * maxXt +
+                          deltaX * maxYt);
+    float deltaT = 3.f * (Gamma (3) * maxE * maxZt + deltaE * maxZt +
+                          deltaZ * maxE) * fabsf (invDet);
+
+    if (t <= deltaT)
+        return false;
+
+    *tHit = t;
+    *b1 = e1 * invDet;
+    *b2 = e2 * invDet;
+    return true;
+}
+
+
+// Ray-triangle tests and how many of them hit, one at a time or batched.
+static StatRatio triangleHits ("Intersections/Ray-triangle hits / tests",
+                               true);
+
+static inline int PopCount (uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount (v);
+#else
+    int n = 0;
+
+    for (; v; v &= v - 1)
+        ++n;
+
+    return n;
+#endif
+}
+
+
+////////////////////
+// Triangle Methods
+////////////////////
+BBox Triangle::WorldBound() const {
+    const int *vi = mesh->Indices (triNumber);
+
+    return Union (BBox (mesh->P (vi[0]), mesh->P (vi[1])), mesh->P (vi[2]));
+}
+
+bool Triangle::Intersect (const Ray &ray, Intersection *isect) const {
+    const int *vi = mesh->Indices (triNumber);
+    float t, b1, b2;
+
+    bool hit = IntersectWatertight (mesh->P (vi[0]), mesh->P (vi[1]),
+                                    mesh->P (vi[2]), ray, RayShear (ray),
+                                    &t, &b1, &b2);
+
+    triangleHits.Add (hit, 1);
+
+    if (!hit)
+        return false;
+
+    GetIntersection (ray, t, b1, b2, isect);
+    return true;
+}
+
+bool Triangle::IntersectP (const Ray &ray) const {
+    const int *vi = mesh->Indices (triNumber);
+    float t, b1, b2;
+    bool hit = IntersectWatertight (mesh->P (vi[0]), mesh->P (vi[1]),
+                                    mesh->P (vi[2]), ray, RayShear (ray),
+                                    &t, &b1, &b2);
+
+    triangleHits.Add (hit, 1);
+    return hit;
+}
+
+void Triangle::GetIntersection (const Ray &ray, float t, float b1, float b2,
+                                Intersection *isect) const {
+    const int *vi = mesh->Indices (triNumber);
+    Point p0 = mesh->P (vi[0]);
+    Point p1 = mesh->P (vi[1]);
+    Point p2 = mesh->P (vi[2]);
+    float b0 = 1.f - b1 - b2;
+
+    // The geometric normal faces the same way as the shading normals, if
+    // there are any.
+    Normal n = Normal (Normalize (Cross (p0 - p2, p1 - p2)));
+
+    if (mesh->HasNormals()) {
+        Normal ns = mesh->N (vi[0]) * b0 + mesh->N (vi[1]) * b1 +
+                    mesh->N (vi[2]) * b2;
+
+        if (Dot (n, ns) < 0.f)
+            n = -n;
+    }
+
+    // Without uvs the vertices get (0, 0), (1, 0) and (1, 1).
+    if (mesh->HasUVs()) {
+        isect->u = b0 * mesh->U (vi[0]) + b1 * mesh->U (vi[1]) +
+                   b2 * mesh->U (vi[2]);
+        isect->v = b0 * mesh->V (vi[0]) + b1 * mesh->V (vi[1]) +
+                   b2 * mesh->V (vi[2]);
+    }
+    else {
+        isect->u = b1 + b2;
+        isect->v = b2;
+    }
+
+    // Each component of p is a sum of three products, so its error is
+    // bounded by Gamma (7) times the sum of their magnitudes.
+    float xAbsSum = fabsf (b0 * p0.x) + fabsf (b1 * p1.x) + fabsf (b2 * p2.x);
+    float yAbsSum = fabsf (b0 * p0.y) + fabsf (b1 * p1.y) + fabsf (b2 * p2.y);
+    float zAbsSum = fabsf (b0 * p0.z) + fabsf (b1 * p1.z) + fabsf (b2 * p2.z);
+
+    ray.maxt = t;
+    isect->tHit = t;
+    isect->p = p0 * b0 + p1 * b1 + p2 * b2;
+    isect->pError = Vector (xAbsSum, yAbsSum, zAbsSum) * Gamma (7);
+    isect->n = n;
+    isect->primitive = this;
+}
+
+
+////////////////////
+// PackedTriangles Methods
+////////////////////
+void PackedTriangles::Pack (
+        const std::vector<std::shared_ptr<Primitive> > &prims) {
+    entries.clear();
+    meshes.clear();
+
+    bool anyTriangles = false;
+    for (size_t i = 0; i < prims.size() && !anyTriangles; ++i)
+        anyTriangles = dynamic_cast<const Triangle*> (prims[i].get()) != NULL;
+
+    if (!anyTriangles)
+        return;
+
+    entries.resize (prims.size());
+
+    // Runs of triangles nearly always share a mesh, so the last one found
+    // is checked before searching the table.
+    std::unordered_map<const TriangleMesh*, int32_t> meshIndex;
+    const TriangleMesh *lastMesh = NULL;
+    int32_t lastIndex = -1;
+
+    for (size_t i = 0; i < prims.size(); ++i) {
+        const Triangle *tri = dynamic_cast<const Triangle*> (prims[i].get());
+        Entry &entry = entries[i];
+
+        if (!tri) {
+            entry.mesh = -1;
+            entry.triangle = 0;
+            continue;
+        }
+
+        if (tri->Mesh() != lastMesh) {
+            lastMesh = tri->Mesh();
+
+            std::unordered_map<const TriangleMesh*, int32_t>::const_iterator
+                    found = meshIndex.find (lastMesh);
+
+            if (found != meshIndex.end())
+                lastIndex = found->second;
+            else {
+                lastIndex = int32_t (meshes.size());
+                meshIndex[lastMesh] = lastIndex;
+                meshes.push_back (lastMesh);
+            }
+        }
+
+        entry.mesh = lastIndex;
+        entry.triangle = tri->Index();
+    }
+}
+
+BBox PackedTriangles::Bounds (int start, int n) const {
+    BBox bounds;
+
+    for (int i = start; i < start + n; ++i) {
+        const Entry &entry = entries[i];
+
+        if (entry.mesh < 0)
+            continue;
+
+        const TriangleMesh *mesh = meshes[entry.mesh];
+        const int *vi = mesh->Indices (entry.triangle);
+
+        for (int v = 0; v < 3; ++v)
+            bounds = Union (bounds, mesh->P (vi[v]));
+    }
+
+    return bounds;
+}
+
+uint32_t PackedTriangles::Gather (int start, int n,
+                                  float (*rows)[kTriangleBatchSize]) const {
+    uint32_t valid = 0;
+
+    for (int lane = 0; lane < kTriangleBatchSize; ++lane) {
+        const Entry *entry = lane < n ? &entries[start + lane] : NULL;
+
+        if (!entry || entry->mesh < 0) {
+            for (int r = 0; r < kRows; ++r)
+                rows[r][lane] = 0.f;
+            continue;
+        }
+
+        const TriangleMesh *mesh = meshes[entry->mesh];
+        const int *vi = mesh->Indices (entry->triangle);
+
+        for (int v = 0; v < 3; ++v) {
+            Point p = mesh->P (vi[v]);
+
+            rows[P0X + 3 * v][lane] = p.x;
+            rows[P0Y + 3 * v][lane] = p.y;
+            rows[P0Z + 3 * v][lane] = p.z;
+        }
+
+        valid |= 1u << lane;
+    }
+
+    return valid;
+}
+
+
+#ifdef PB_RAY_SSE
+////////////////////
+// struct: FloatBatch
+//
+// Purpose:
+//      kTriangleBatchSize floats in one AVX or SSE register, with just the
+//      operators the batched triangle test needs. Wrapping the register in
+//      a struct lets the test be written once for both widths.
+////////////////////
+#ifdef PB_RAY_AVX
+struct FloatBatch {
+    FloatBatch (__m256 r) : v(r) { }
+    explicit FloatBatch (float f) : v(_mm256_set1_ps (f)) { }
+    explicit FloatBatch (const float *p) : v(_mm256_loadu_ps (p)) { }
+
+    FloatBatch operator+ (FloatBatch b) const { return _mm256_add_ps (v, b.v); }
+    FloatBatch operator- (FloatBatch b) const { return _mm256_sub_ps (v, b.v); }
+    FloatBatch operator* (FloatBatch b) const { return _mm256_mul_ps (v, b.v); }
+    FloatBatch operator/ (FloatBatch b) const { return _mm256_div_ps (v, b.v); }
+    FloatBatch operator& (FloatBatch b) const { return _mm256_and_ps (v, b.v); }
+
+    FloatBatch operator>= (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_GE_OQ);
+    }
+    FloatBatch operator<= (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_LE_OQ);
+    }
+    FloatBatch operator!= (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_NEQ_OQ);
+    }
+    FloatBatch operator== (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_EQ_OQ);
+    }
+    FloatBatch operator< (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_LT_OQ);
+    }
+    FloatBatch operator> (FloatBatch b) const {
+        return _mm256_cmp_ps (v, b.v, _CMP_GT_OQ);
+    }
+    FloatBatch operator| (FloatBatch b) const { return _mm256_or_ps (v, b.v); }
+
+    friend FloatBatch Abs (FloatBatch a) {
+        return _mm256_andnot_ps (_mm256_set1_ps (-0.f), a.v);
+    }
+    friend FloatBatch Max (FloatBatch a, FloatBatch b) {
+        return _mm256_max_ps (a.v, b.v);
+    }
+
+    uint32_t MoveMask() const { return uint32_t (_mm256_movemask_ps (v)); }
+    void Store (float *p) const { _mm256_store_ps (p, v); }
+
+    __m256 v;
+};
+#else
+struct FloatBatch {
+    FloatBatch (__m128 r) : v(r) { }
+    explicit FloatBatch (float f) : v(_mm_set1_ps (f)) { }
+    explicit FloatBatch (const float *p) : v(_mm_loadu_ps (p)) { }
+
+    FloatBatch operator+ (FloatBatch b) const { return _mm_add_ps (v, b.v); }
+    FloatBatch operator- (FloatBatch b) const { return _mm_sub_ps (v, b.v); }
+    FloatBatch operator* (FloatBatch b) const { return _mm_mul_ps (v, b.v); }
+    FloatBatch operator/ (FloatBatch b) const { return _mm_div_ps (v, b.v); }
+    FloatBatch operator& (FloatBatch b) const { return _mm_and_ps (v, b.v); }
+
+    FloatBatch operator>= (FloatBatch b) const { return _mm_cmpge_ps (v, b.v); }
+    FloatBatch operator<= (FloatBatch b) const { return _mm_cmple_ps (v, b.v); }
+    FloatBatch operator!= (FloatBatch b) const {
+        return _mm_cmpneq_ps (v, b.v);
+    }
+    FloatBatch operator== (FloatBatch b) const { return _mm_cmpeq_ps (v, b.v); }
+    FloatBatch operator< (FloatBatch b) const { return _mm_cmplt_ps (v, b.v); }
+    FloatBatch operator> (FloatBatch b) const { return _mm_cmpgt_ps (v, b.v); }
+    FloatBatch operator| (FloatBatch b) const { return _mm_or_ps (v, b.v); }
+
+    friend FloatBatch Abs (FloatBatch a) {
+        return _mm_andnot_ps (_mm_set1_ps (-0.f), a.v);
+    }
+    friend FloatBatch Max (FloatBatch a, FloatBatch b) {
+        return _mm_max_ps (a.v, b.v);
+    }
+
+    uint32_t MoveMask() const { return uint32_t (_mm_movemask_ps (v)); }
+    void Store (float *p) const { _mm_store_ps (p, v); }
+
+    __m128 v;
+};
+#endif
+#endif
+
+
+////////////////////
+// Function:
+//      PackedTriangles::IntersectBatch
+//
+// Purpose:
+//      Run IntersectWatertight on up to kTriangleBatchSize triangles at
+//      once. Lanes where an edge function comes out exactly zero, which is
+//      rare, are redone one at a time by IntersectWatertight for its double
+//      precision fallback.
+//
+// Parameters:
+//      int start - The first triangle.
+//      int n - The number of triangles, at most kTriangleBatchSize.
+//      const Ray &ray - The ray; hits outside [mint, maxt] are ignored.
+//      const RayShear &shear - The ray's shear.
+//      float *t, *b1, *b2 - kTriangleBatchSize aligned floats each; receive
+//                           the hit distance and barycentrics per lane.
+//
+// Returns:
+//      A mask with bit i set when triangle start + i is hit.
+////////////////////
+uint32_t PackedTriangles::IntersectBatch (int start, int n, const Ray &ray,
+                                          const RayShear &shear, float *t,
+                                          float *b1, float *b2) const {
+    assert (n <= kTriangleBatchSize);
+    alignas(32) float rows[kRows][kTriangleBatchSize];
+    const uint32_t laneMask = Gather (start, n, rows);
+    uint32_t hits = 0, redo = 0;
+
+#ifdef PB_RAY_SSE
+    const int kx = shear.kx, ky = shear.ky, kz = shear.kz;
+    FloatBatch ox (ray.o[kx]), oy (ray.o[ky]), oz (ray.o[kz]);
+    FloatBatch sx (shear.sx), sy (shear.sy), sz (shear.sz);
+
+    FloatBatch z0 = FloatBatch (rows[P0X + kz]) - oz;
+    FloatBatch z1 = FloatBatch (rows[P1X + kz]) - oz;
+    FloatBatch z2 = FloatBatch (rows[P2X + kz]) - oz;
+    FloatBatch x0 = FloatBatch (rows[P0X + kx]) - ox + sx * z0;
+    FloatBatch y0 = FloatBatch (rows[P0X + ky]) - oy + sy * z0;
+    FloatBatch x1 = FloatBatch (rows[P1X + kx]) - ox + sx * z1;
+    FloatBatch y1 = FloatBatch (rows[P1X + ky]) - oy + sy * z1;
+    FloatBatch x2 = FloatBatch (rows[P2X + kx]) - ox + sx * z2;
+    FloatBatch y2 = FloatBatch (rows[P2X + ky]) - oy + sy * z2;
+
+    FloatBatch e0 = x1 * y2 - y1 * x2;
+    FloatBatch e1 = x2 * y0 - y2 * x0;
+    FloatBatch e2 = x0 * y1 - y0 * x1;
+
+    FloatBatch zero (0.f);
+    redo = ((e0 == zero) | (e1 == zero) | (e2 == zero)).MoveMask() &
+           laneMask;
+
+    FloatBatch mixedSigns = ((e0 < zero) | (e1 < zero) | (e2 < zero)) &
+                            ((e0 > zero) | (e1 > zero) | (e2 > zero));
+    FloatBatch det = e0 + e1 + e2;
+
+    z0 = z0 * sz;
+    z1 = z1 * sz;
+    z2 = z2 * sz;
+
+    FloatBatch invDet = FloatBatch (1.f) / det;
+    FloatBatch tHit = (e0 * z0 + e1 * z1 + e2 * z2) * invDet;
+
+    FloatBatch maxXt = Max (Abs (x0), Max (Abs (x1), Abs (x2)));
+    FloatBatch maxYt = Max (Abs (y0), Max (Abs (y1), Abs (y2)));
+    FloatBatch maxZt = Max (Abs (z0), Max (Abs (z1), Abs (z2)));
+    FloatBatch maxE = Max (Abs (e0), Max (Abs (e1), Abs (e2)));
+
+    FloatBatch deltaX = FloatBatch (Gamma (5)) * (maxXt + maxZt);
+    FloatBatch deltaY = FloatBatch (Gamma (5)) * (maxYt + maxZt);
+    FloatBatch deltaZ = FloatBatch (Gamma (3)) * maxZt;
+    FloatBatch deltaE = FloatBatch (2.f) *
+                        (FloatBatch (Gamma (2)) * maxXt * maxYt +
+                         deltaY * maxXt + deltaX * maxYt);
+    FloatBatch deltaT = FloatBatch (3.f) *
+                        (FloatBatch (Gamma (3)) * maxE * maxZt +
+                         deltaE * maxZt + deltaZ * maxE) * Abs (invDet);
+
+    FloatBatch hit = (det != zero) & (tHit >= FloatBatch (ray.mint)) &
+                     (tHit <= FloatBatch (ray.maxt)) & (tHit > deltaT);
+
+    hits = hit.MoveMask() & ~mixedSigns.MoveMask() & laneMask & ~redo;
+
+    tHit.Store (t);
+    (e1 * invDet).Store (b1);
+    (e2 * invDet).Store (b2);
+#else
+    redo = laneMask;
+#endif
+
+    for (int i = 0; i < n; ++i) {
+        if (!(redo & (1u << i)))
+            continue;
+
+        Point p0 (rows[P0X][i], rows[P0Y][i], rows[P0Z][i]);
+        Point p1 (rows[P1X][i], rows[P1Y][i], rows[P1Z][i]);
+        Point p2 (rows[P2X][i], rows[P2Y][i], rows[P2Z][i]);
+
+        if (IntersectWatertight (p0, p1, p2, ray, shear, &t[i], &b1[i],
+                                 &b2[i]))
+            hits |= (1u << i);
+    }
+
+    triangleHits.Add (PopCount (hits), n);
+    return hits;
+}
+
+bool PackedTriangles::Intersect (const std::shared_ptr<Primitive> *prims,
+                                 int start, int n, const Ray &ray,
+                                 Intersection *isect) const {
+    RayShear shear (ray);
+    bool hit = false;
+
+    for (int i = start; i < start + n; i += kTriangleBatchSize) {
+        alignas(32) float t[kTriangleBatchSize];
+        alignas(32) float b1[kTriangleBatchSize];
+        alignas(32) float b2[kTriangleBatchSize];
+
+        uint32_t mask = IntersectBatch (
+                i, min (kTriangleBatchSize, start + n - i), ray, shear, t, b1,
+                b2);
+
+        if (!mask)
+            continue;
+
+        // On a tie the later triangle wins, as it would if the triangles
+        // were tested one after another.
+        int closest = -1;
+        float tClosest = ray.maxt;
+
+        for (int lane = 0; lane < kTriangleBatchSize; ++lane) {
+            if ((mask & (1u << lane)) && t[lane] <= tClosest) {
+                closest = lane;
+                tClosest = t[lane];
+            }
+        }
+
+        static_cast<const Triangle*> (prims[i + closest].get())
+                ->GetIntersection (ray, t[closest], b1[closest], b2[closest],
+                                   isect);
+        hit = true;
+    }
+
+    return hit;
+}
+
+bool PackedTriangles::IntersectP (int start, int n, const Ray &ray) const {
+    RayShear shear (ray);
+
+    for (int i = start; i < start + n; i += kTriangleBatchSize) {
+        alignas(32) float t[kTriangleBatchSize];
+        alignas(32) float b1[kTriangleBatchSize];
+        alignas(32) float b2[kTriangleBatchSize];
+
+        if (IntersectBatch (i, min (kTriangleBatchSize, start + n - i), ray,
+                            shear, t, b1, b2))
+            return true;
+    }
+
+    return false;
+}
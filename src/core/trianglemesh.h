@@ -0,0 +1,256 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: trianglemesh.h
+ *
+ *  Purpose: Define triangle meshes and the triangle primitive.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef TRIANGLEMESH_H
+#define TRIANGLEMESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "primitive.h"
+#include "transform.h"
+
+class TaskScheduler;
+class TriangleMesh;
+struct RayShear;
+
+
+////////////////////
+// Class: Triangle
+//
+// Purpose:
+//      One triangle of a TriangleMesh. It holds only the mesh and its own
+//      index; the vertices are looked up in the mesh.
+//
+//      Triangles live in an array owned by their mesh and are handed out
+//      by TriangleMesh::CreateTriangles as shared_ptrs that share the
+//      mesh's reference count, so there is no allocation or reference
+//      count per triangle.
+//
+// Inherits From: Primitive
+////////////////////
+class Triangle : public Primitive {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+        Triangle (const TriangleMesh *m, int n) : mesh(m), triNumber(n) { }
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        BBox WorldBound() const;
+
+        // The watertight test of Woop et al.; see PackedTriangles for the
+        // batched form.
+        bool Intersect (const Ray &ray, Intersection *isect) const;
+        bool IntersectP (const Ray &ray) const;
+
+        // Fill in isect for a hit at ray (t) with barycentric coordinates
+        // b1 and b2 (the weights of the second and third vertex).
+        void GetIntersection (const Ray &ray, float t, float b1, float b2,
+                              Intersection *isect) const;
+
+        const TriangleMesh *Mesh() const { return mesh; }
+        int Index() const { return triNumber; }
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        const TriangleMesh *mesh;
+        int triNumber;
+};
+
+
+////////////////////
+// Class: TriangleMesh
+//
+// Purpose:
+//      An indexed triangle mesh. Vertex attributes are stored as structure
+//      of arrays (one array per component) and shared between triangles
+//      through the index buffer; the vertices are transformed to world
+//      space once when the mesh is made.
+//
+//      Normals and uvs are optional.
+////////////////////
+class TriangleMesh {
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // P, N and uv (two floats per vertex) hold nVertices entries;
+        // vertexIndices holds three indices per triangle.
+        TriangleMesh (const Transform &objectToWorld, int nTriangles,
+                      const int *vertexIndices, int nVertices,
+                      const Point *P, const Normal *N = NULL,
+                      const float *uv = NULL);
+
+
+        ///////////////
+        // Methods
+        ///////////////
+
+        // Make the primitives for every triangle of the mesh. They keep the
+        // mesh alive.
+        static std::vector<std::shared_ptr<Primitive> > CreateTriangles (
+                const std::shared_ptr<TriangleMesh> &mesh);
+
+        // Replace the vertex positions, and the normals if N isn't NULL,
+        // keeping the triangles. Both arrays hold NumVertices() entries.
+        // With a scheduler the vertices are transformed in parallel.
+        void SetVertices (const Transform &objectToWorld, const Point *P,
+                          const Normal *N = NULL,
+                          TaskScheduler *scheduler = NULL);
+
+        int NumTriangles() const { return nTriangles; }
+        int NumVertices() const { return nVertices; }
+        bool HasNormals() const { return !nx.empty(); }
+        bool HasUVs() const { return !uvU.empty(); }
+
+        // The three vertex indices of triangle i.
+        const int *Indices (int i) const { return &vertexIndices[3 * i]; }
+
+        Point P (int v) const { return Point (px[v], py[v], pz[v]); }
+        Normal N (int v) const { return Normal (nx[v], ny[v], nz[v]); }
+        float U (int v) const { return uvU[v]; }
+        float V (int v) const { return uvV[v]; }
+
+        // The memory held by the mesh, triangles included.
+        size_t BytesUsed() const;
+
+    private:
+        ///////////////
+        // Data Members
+        ///////////////
+        int nTriangles, nVertices;
+        std::vector<int> vertexIndices;
+        std::vector<float> px, py, pz;
+        std::vector<float> nx, ny, nz;
+        std::vector<float> uvU, uvV;
+        std::vector<Triangle> triangles;
+
+        // Triangles point back at their mesh.
+        TriangleMesh (const TriangleMesh&);
+        TriangleMesh &operator= (const TriangleMesh&);
+};
+
+
+// The number of triangles PackedTriangles tests at once.
+#ifdef PB_RAY_AVX
+static const int kTriangleBatchSize = 8;
+#else
+static const int kTriangleBatchSize = 4;
+#endif
+
+
+////////////////////
+// Class: PackedTriangles
+//
+// Purpose:
+//      The triangles of a primitive array, laid out for intersecting a ray
+//      with runs of them (such as the contents of a BVH leaf)
+//      kTriangleBatchSize at a time.
+//
+//      Each triangle is stored as 8 bytes, at the same index as in the
+//      primitive array: which of the packed meshes it belongs to and its
+//      number within that mesh. A batch gathers its vertices through the
+//      meshes' index buffers and SoA position arrays into registers, which
+//      skips the chase through the primitives but keeps every vertex
+//      stored once, in its mesh. Meshes that move their vertices are seen
+//      without packing again.
+//
+//      Primitives that aren't Triangles get entries that are never hit.
+////////////////////
+class PackedTriangles {
+    public:
+        ///////////////
+        // Methods
+        ///////////////
+
+        // Replace the contents with the triangles of prims. Nothing is
+        // stored if there are none.
+        void Pack (const std::vector<std::shared_ptr<Primitive> > &prims);
+
+        bool Empty() const { return entries.empty(); }
+
+        // The bounds of triangles [start, start + n).
+        BBox Bounds (int start, int n) const;
+
+        // Intersect the ray with triangles [start, start + n). prims must
+        // be the array that was packed; the closest hit's Triangle fills
+        // in isect and shortens the ray.
+        bool Intersect (const std::shared_ptr<Primitive> *prims, int start,
+                        int n, const Ray &ray, Intersection *isect) const;
+        bool IntersectP (int start, int n, const Ray &ray) const;
+
+        size_t BytesUsed() const {
+            return entries.capacity() * sizeof (Entry) +
+                   meshes.capacity() * sizeof (meshes[0]);
+        }
+
+    private:
+        // The rows Gather fills, one vertex component per row.
+        enum { P0X, P0Y, P0Z, P1X, P1Y, P1Z, P2X, P2Y, P2Z, kRows };
+
+        // Copy the vertices of triangles [start, start + n), where n is at
+        // most kTriangleBatchSize, into the lanes of rows. Lanes past n
+        // and entries that aren't triangles are zeroed and left out of the
+        // returned mask.
+        uint32_t Gather (int start, int n,
+                         float (*rows)[kTriangleBatchSize]) const;
+
+        // Find the hits among triangles [start, start + n), where n is at
+        // most kTriangleBatchSize, as a mask with the hit distances and
+        // barycentrics in t, b1 and b2.
+        uint32_t IntersectBatch (int start, int n, const Ray &ray,
+                                 const RayShear &shear, float *t, float *b1,
+                                 float *b2) const;
+
+        // A packed triangle: triangle number triangle of meshes[mesh], or
+        // mesh -1 if the primitive isn't a Triangle.
+        struct Entry {
+            int32_t mesh;
+            int32_t triangle;
+        };
+
+        ///////////////
+        // Data Members
+        ///////////////
+        std::vector<Entry> entries;
+        std::vector<const TriangleMesh*> meshes;
+};
+
+#endif
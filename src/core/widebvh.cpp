@@ -0,0 +1,477 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: widebvh.cpp
+ *
+ *  Purpose: Collapse binary BVHs into wide ones and traverse them.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "widebvh.h"
+#include "memory.h"
+#include "simd.h"
+#include "stats.h"
+
+
+// Traversal statistics, reported once per traversal. Every node visit
+// tests the ray against all N child boxes.
+static StatCounter wideRayBoxTests ("Wide BVH/Ray-box tests");
+static StatDistribution wideNodesPerRay ("Wide BVH/Nodes visited per ray");
+
+
+////////////////////
+// WideBVHAccel Methods
+////////////////////
+template <int N>
+WideBVHAccel<N>::WideBVHAccel (const BVHAccel &bvh)
+        : nodes(NULL), nNodes(0) {
+    Init (bvh);
+}
+
+template <int N>
+WideBVHAccel<N>::WideBVHAccel (
+        const std::vector<std::shared_ptr<Primitive> > &prims,
+        const BVHBuildOptions &options)
+        : nodes(NULL), nNodes(0) {
+    BVHBuildOptions flatOptions = options;
+    flatOptions.flattenTree = true;
+
+    BVHAccel bvh (prims, flatOptions);
+    Init (bvh);
+}
+
+template <int N>
+WideBVHAccel<N>::~WideBVHAccel() {
+    FreeAligned (nodes);
+}
+
+template <int N>
+void WideBVHAccel<N>::Init (const BVHAccel &bvh) {
+    const LinearBVHNode *binary = bvh.Nodes();
+
+    // Only the flattened layout can be collapsed.
+    assert (binary || bvh.TotalNodes() == 0);
+
+    primitives = bvh.Primitives();
+    triangles = bvh.Triangles();
+
+    if (!binary)
+        return;
+
+    // Every wide node uses up at least one binary interior node, except
+    // for a root that is a lone leaf.
+    int nInterior = (bvh.TotalNodes() - 1) / 2;
+
+    nodes = AllocAligned<WideBVHNode<N> > (max (1, nInterior));
+    bounds = binary[0].bounds;
+
+    Collapse (binary, 0, 0);
+}
+
+
+////////////////////
+// Function:
+//      WideBVHAccel::Collapse
+//
+// Purpose:
+//      Make the wide node for the binary subtree at binary[index] and,
+//      recursively, for every interior node below it.
+//
+// Parameters:
+//      const LinearBVHNode *binary - The flattened binary tree.
+//      int index - The binary node to start from.
+//      int depth - The depth of the new wide node.
+//
+// Returns:
+//      The index of the new wide node.
+////////////////////
+template <int N>
+int WideBVHAccel<N>::Collapse (const LinearBVHNode *binary, int index,
+                               int depth) {
+    // Every wide node takes up at least one level of the binary tree, so
+    // this only fails if the binary builders broke their depth limit.
+    if (depth >= kMaxTraversalDepth) {
+        fprintf (stderr, "Wide BVH deeper than the %d level traversal stack\n",
+                 kMaxTraversalDepth);
+        abort();
+    }
+
+    int nodeIndex = nNodes++;
+    int children[N];
+    int nChildren;
+
+    if (binary[index].nPrimitives > 0) {
+        children[0] = index;
+        nChildren = 1;
+    }
+    else {
+        children[0] = index + 1;
+        children[1] = binary[index].secondChildOffset;
+        nChildren = 2;
+    }
+
+    // Open up the biggest interior child until the node is full.
+    while (nChildren < N) {
+        int best = -1;
+        float bestArea = -1.f;
+
+        for (int i = 0; i < nChildren; ++i) {
+            const LinearBVHNode &c = binary[children[i]];
+
+            if (c.nPrimitives == 0 && c.bounds.SurfaceArea() > bestArea) {
+                best = i;
+                bestArea = c.bounds.SurfaceArea();
+            }
+        }
+
+        if (best < 0)
+            break;
+
+        int opened = children[best];
+        children[best] = opened + 1;
+        children[nChildren++] = binary[opened].secondChildOffset;
+    }
+
+    // nodes[] was allocated up front, so the reference stays valid while
+    // the children are collapsed.
+    WideBVHNode<N> &node = nodes[nodeIndex];
+
+    for (int i = 0; i < N; ++i) {
+        if (i >= nChildren) {
+            for (int axis = 0; axis < 3; ++axis) {
+                node.bounds[0][axis][i] = INFINITY;
+                node.bounds[1][axis][i] = -INFINITY;
+            }
+
+            node.child[i] = 0;
+            node.nPrimitives[i] = 0;
+            node.flags[i] = 0;
+            continue;
+        }
+
+        const LinearBVHNode &c = binary[children[i]];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            node.bounds[0][axis][i] = c.bounds.pMin[axis];
+            node.bounds[1][axis][i] = c.bounds.pMax[axis];
+        }
+
+        node.flags[i] = c.flags;
+
+        if (c.nPrimitives > 0) {
+            node.child[i] = c.primitivesOffset;
+            node.nPrimitives[i] = c.nPrimitives;
+        }
+        else {
+            node.child[i] = Collapse (binary, children[i], depth + 1);
+            node.nPrimitives[i] = 0;
+        }
+    }
+
+    return nodeIndex;
+}
+
+
+////////////////////
+// Function:
+//      IntersectChildren
+//
+// Purpose:
+//      Slab test a ray against the bounds of all N children of a node.
+//
+//      As in BBox::IntersectP, dirIsNeg picks which of each child's two
+//      planes along an axis is the near one, so no min / max is needed to
+//      order them. The slab distances are passed first to max / min: SSE
+//      returns the second operand when either is NaN, so a NaN distance
+//      (a ray lying in a slab plane) leaves the interval unchanged. Far
+//      distances are rounded up by their error bound, as in BBox::IntersectP.
+//
+// Parameters:
+//      const WideBVHNode<N> &node - The node whose children are tested.
+//      const float o[3], invDir[3] - The ray origin and 1 / direction.
+//      const int dirIsNeg[3] - Whether each direction component is < 0.
+//      float mint, maxt - The ray's parametric range.
+//      float tNear[N] - Receives the entry distance of each child.
+//
+// Returns:
+//      A mask with bit i set when child i is hit.
+////////////////////
+template <int N>
+static inline uint32_t IntersectChildren (const WideBVHNode<N> &node,
+                                          const float o[3],
+                                          const float invDir[3],
+                                          const int dirIsNeg[3],
+                                          float mint, float maxt,
+                                          float tNear[N]) {
+    const float farScale = 1.f + 2.f * Gamma (3);
+
+#ifdef PB_RAY_AVX
+    if (N == 8) {
+        __m256 t0 = _mm256_set1_ps (mint);
+        __m256 t1 = _mm256_set1_ps (maxt);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            __m256 org = _mm256_set1_ps (o[axis]);
+            __m256 inv = _mm256_set1_ps (invDir[axis]);
+            __m256 near = _mm256_mul_ps (_mm256_sub_ps (_mm256_load_ps (
+                    node.bounds[dirIsNeg[axis]][axis]), org), inv);
+            __m256 far = _mm256_mul_ps (_mm256_sub_ps (_mm256_load_ps (
+                    node.bounds[1 - dirIsNeg[axis]][axis]), org), inv);
+            far = _mm256_mul_ps (far, _mm256_set1_ps (farScale));
+
+            t0 = _mm256_max_ps (near, t0);
+            t1 = _mm256_min_ps (far, t1);
+        }
+
+        _mm256_storeu_ps (tNear, t0);
+        return uint32_t (_mm256_movemask_ps (_mm256_cmp_ps (t0, t1,
+                                                            _CMP_LE_OQ)));
+    }
+#endif
+
+#ifdef PB_RAY_SSE
+    uint32_t hits = 0;
+
+    for (int i = 0; i < N; i += 4) {
+        __m128 t0 = _mm_set1_ps (mint);
+        __m128 t1 = _mm_set1_ps (maxt);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            __m128 org = _mm_set1_ps (o[axis]);
+            __m128 inv = _mm_set1_ps (invDir[axis]);
+            __m128 near = _mm_mul_ps (_mm_sub_ps (_mm_load_ps (
+                    &node.bounds[dirIsNeg[axis]][axis][i]), org), inv);
+            __m128 far = _mm_mul_ps (_mm_sub_ps (_mm_load_ps (
+                    &node.bounds[1 - dirIsNeg[axis]][axis][i]), org), inv);
+            far = _mm_mul_ps (far, _mm_set1_ps (farScale));
+
+            t0 = _mm_max_ps (near, t0);
+            t1 = _mm_min_ps (far, t1);
+        }
+
+        hits |= uint32_t (_mm_movemask_ps (_mm_cmple_ps (t0, t1))) << i;
+        _mm_storeu_ps (&tNear[i], t0);
+    }
+
+    return hits;
+#else
+    uint32_t hits = 0;
+
+    for (int i = 0; i < N; ++i) {
+        float t0 = mint, t1 = maxt;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float near = (node.bounds[dirIsNeg[axis]][axis][i] - o[axis]) *
+                         invDir[axis];
+            float far = (node.bounds[1 - dirIsNeg[axis]][axis][i] - o[axis]) *
+                        invDir[axis] * farScale;
+
+            // Written so that a NaN distance leaves the interval alone.
+            t0 = near > t0 ? near : t0;
+            t1 = far < t1 ? far : t1;
+        }
+
+        if (t0 <= t1)
+            hits |= (1u << i);
+        tNear[i] = t0;
+    }
+
+    return hits;
+#endif
+}
+
+
+////////////////////
+// Function:
+//      WideBVHAccel::Traverse
+//
+// Purpose:
+//      Walk the tree along the ray.
+//
+//      The children a ray hits are sorted by entry distance; the nearest
+//      is visited next and the rest are pushed farthest first, together
+//      with their entry distances so that entries behind the closest hit
+//      found since can be dropped when they are popped. Leaves are pushed
+//      like nodes, as ~(node * N + slot).
+//
+//      AnyHit selects IntersectP semantics: the walk stops at the first
+//      primitive that reports a hit, children are not sorted, and isect is
+//      not used.
+//
+// Parameters:
+//      const Ray &ray - The ray; its maxt shrinks as hits are found.
+//      Intersection *isect - Receives the closest hit.
+//      int *nodesVisited - If not NULL, the number of nodes whose children
+//                          were tested is added to it.
+//
+// Returns:
+//      Whether anything was hit.
+////////////////////
+template <int N>
+template <bool AnyHit>
+bool WideBVHAccel<N>::Traverse (const Ray &ray, Intersection *isect,
+                                int *nodesVisited) const {
+    bool hit = false;
+    float o[3] = { ray.o.x, ray.o.y, ray.o.z };
+    float invDir[3] = { 1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z };
+    int dirIsNeg[3] = { invDir[0] < 0, invDir[1] < 0, invDir[2] < 0 };
+
+    // Each level of the tree leaves at most N - 1 children on the stack.
+    int32_t todo[kMaxTraversalDepth * (N - 1)];
+    float todoT[kMaxTraversalDepth * (N - 1)];
+    int todoOffset = 0;
+    int32_t ref = 0;
+    int visited = 0;
+
+    while (true) {
+        if (ref >= 0) {
+            const WideBVHNode<N> &node = nodes[ref];
+            alignas(32) float tNear[N];
+            uint32_t mask = IntersectChildren<N> (node, o, invDir, dirIsNeg,
+                                                  ray.mint, ray.maxt, tNear);
+            ++visited;
+
+            if (mask) {
+                int32_t refs[N];
+                float ts[N];
+                int nHits = 0;
+
+                for (int i = 0; i < N; ++i) {
+                    if (!(mask & (1u << i)))
+                        continue;
+
+                    int j = nHits++;
+
+                    while (!AnyHit && j > 0 && ts[j - 1] > tNear[i]) {
+                        refs[j] = refs[j - 1];
+                        ts[j] = ts[j - 1];
+                        --j;
+                    }
+
+                    refs[j] = node.nPrimitives[i] ? ~(ref * N + i)
+                                                  : node.child[i];
+                    ts[j] = tNear[i];
+                }
+
+                for (int j = nHits - 1; j > 0; --j) {
+                    todo[todoOffset] = refs[j];
+                    todoT[todoOffset++] = ts[j];
+                }
+
+                ref = refs[0];
+                continue;
+            }
+        }
+        else {
+            int slot = ~ref;
+            const WideBVHNode<N> &node = nodes[slot / N];
+            int first = node.child[slot % N];
+            const std::shared_ptr<Primitive> *p = &primitives[first];
+            int nPrimitives = node.nPrimitives[slot % N];
+
+            if (node.flags[slot % N] & kTriangleLeaf) {
+                if (AnyHit ? triangles->IntersectP (first, nPrimitives, ray)
+                           : triangles->Intersect (&primitives[0], first,
+                                                  nPrimitives, ray, isect))
+                    hit = true;
+            }
+            else {
+                for (int i = 0; i < nPrimitives; ++i) {
+                    if (AnyHit ? p[i]->IntersectP (ray)
+                               : p[i]->Intersect (ray, isect)) {
+                        hit = true;
+
+                        if (AnyHit)
+                            break;
+                    }
+                }
+            }
+
+            if (AnyHit && hit)
+                break;
+        }
+
+        // Pop the next entry that starts before the closest hit so far.
+        bool found = false;
+
+        while (todoOffset > 0) {
+            --todoOffset;
+
+            if (todoT[todoOffset] <= ray.maxt) {
+                ref = todo[todoOffset];
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            break;
+    }
+
+    wideRayBoxTests += int64_t (visited) * N;
+    wideNodesPerRay.ReportValue (visited);
+
+    if (nodesVisited)
+        *nodesVisited += visited;
+
+    return hit;
+}
+
+
+template <int N>
+bool WideBVHAccel<N>::Intersect (const Ray &ray, Intersection *isect) const {
+    return nodes ? Traverse<false> (ray, isect, NULL) : false;
+}
+
+template <int N>
+bool WideBVHAccel<N>::IntersectP (const Ray &ray) const {
+    return nodes ? Traverse<true> (ray, NULL, NULL) : false;
+}
+
+template <int N>
+int WideBVHAccel<N>::NodeVisits (const Ray &r) const {
+    Ray ray = r;
+    Intersection isect;
+    int visited = 0;
+
+    if (nodes)
+        Traverse<false> (ray, &isect, &visited);
+
+    return visited;
+}
+
+template <int N>
+size_t WideBVHAccel<N>::BytesUsed() const {
+    return sizeof (*this) + size_t (nNodes) * sizeof (WideBVHNode<N>) +
+           primitives.capacity() * sizeof (primitives[0]) +
+           triangles->BytesUsed();
+}
+
+
+// Instantiate the widths declared in widebvh.h.
+template class WideBVHAccel<4>;
+template class WideBVHAccel<8>;
@@ -0,0 +1,152 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: widebvh.h
+ *
+ *  Purpose: Define the 4 and 8 wide bounding volume hierarchies.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef WIDEBVH_H
+#define WIDEBVH_H
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "bvh.h"
+
+
+////////////////////
+// struct: WideBVHNode
+//
+// Purpose:
+//      A node with up to N children whose bounds are stored as structure of
+//      arrays, so one SIMD register holds the same bound of all N children.
+//      bounds[0] holds the children's minimum corners and bounds[1] their
+//      maximum corners, one row per axis.
+//
+//      A child with nPrimitives[i] == 0 is an interior node at index
+//      child[i]; otherwise it is a leaf whose primitives start at child[i].
+//      Unused slots have empty (inverted) bounds, which no ray can hit.
+//      flags[i] carries the LinearBVHNode flags of leaf children.
+//
+//      With N == 4 a node fills two cache lines, with N == 8 four.
+////////////////////
+template <int N>
+struct alignas(64) WideBVHNode {
+    float bounds[2][3][N];
+    int32_t child[N];
+    uint16_t nPrimitives[N];
+    uint8_t flags[N];
+};
+
+
+////////////////////
+// Class: WideBVHAccel
+//
+// Purpose:
+//      A bounding volume hierarchy with N children per node (N = 4 suits
+//      SSE, N = 8 suits AVX).
+//
+//      The tree is made by collapsing a binary BVHAccel: each wide node
+//      takes a binary node's two children and keeps replacing the interior
+//      child with the largest surface area by its own two children until
+//      it has N children or only leaves are left. This roughly halves (4)
+//      or thirds (8) the depth of the tree and the number of nodes a ray
+//      visits, and a ray tests all N children of a node with one SIMD slab
+//      test.
+//
+//      Hit children are visited nearest first.
+//
+// Inherits From: Primitive
+////////////////////
+template <int N>
+class WideBVHAccel : public Primitive {
+    static_assert (N == 4 || N == 8, "WideBVHAccel must be 4 or 8 wide");
+
+    public:
+        ///////////////
+        // Constructors
+        ///////////////
+
+        // Collapse an existing (flattened) binary BVH.
+        explicit WideBVHAccel (const BVHAccel &bvh);
+
+        // Build a binary BVH with the given options and collapse it.
+        WideBVHAccel (const std::vector<std::shared_ptr<Primitive> > &prims,
+                      const BVHBuildOptions &options = BVHBuildOptions());
+        ~WideBVHAccel();
+
+
+        ///////////////
+        // Methods
+        ///////////////
+        static int Width() { return N; }
+
+        BBox WorldBound() const { return bounds; }
+
+        bool Intersect (const Ray &ray, Intersection *isect) const;
+        bool IntersectP (const Ray &ray) const;
+
+        // Trace a copy of the ray as Intersect would and count the wide
+        // nodes whose children's bounds it was tested against.
+        int NodeVisits (const Ray &ray) const;
+
+        int TotalNodes() const { return nNodes; }
+
+        // As BVHAccel::BytesUsed. The packed triangles are shared with the
+        // BVHAccel the tree was made from and counted by both.
+        size_t BytesUsed() const;
+
+    private:
+        void Init (const BVHAccel &bvh);
+        int Collapse (const LinearBVHNode *binary, int index, int depth);
+
+        template <bool AnyHit>
+        bool Traverse (const Ray &ray, Intersection *isect,
+                       int *nodesVisited) const;
+
+        ///////////////
+        // Data Members
+        ///////////////
+        std::vector<std::shared_ptr<Primitive> > primitives;
+        std::shared_ptr<const PackedTriangles> triangles;
+        WideBVHNode<N> *nodes;
+        int nNodes;
+        BBox bounds;
+
+        // WideBVHAccel owns its nodes; copying would free them twice.
+        WideBVHAccel (const WideBVHAccel&);
+        WideBVHAccel &operator= (const WideBVHAccel&);
+};
+
+
+// The widths the renderer is built for; the templates are instantiated
+// for these in widebvh.cpp.
+typedef WideBVHAccel<4> BVH4Accel;
+typedef WideBVHAccel<8> BVH8Accel;
+
+#endif
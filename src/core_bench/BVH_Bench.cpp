@@ -0,0 +1,258 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: BVH_Bench.cpp
+ *
+ *  Purpose: Benchmark BVH construction and traversal.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+#include <thread>
+
+#include "core_bench.h"
+#include "bvh.h"
+#include "widebvh.h"
+#include "parallel.h"
+
+
+// Build a BVH over state.range(0) primitives on state.range(1) threads and
+// report the build rate in millions of primitives per second.
+static void BuildBVH (benchmark::State &state, BVHBuildOptions options) {
+    std::vector<std::shared_ptr<Primitive> > prims =
+            RandomSpheres (int (state.range (0)));
+    TaskScheduler scheduler (int (state.range (1)));
+    options.scheduler = &scheduler;
+
+    for (auto _ : state) {
+        BVHAccel bvh (prims, options);
+        benchmark::DoNotOptimize (bvh.TotalNodes());
+    }
+
+    state.counters["Mprims"] = benchmark::Counter (
+            double (state.iterations()) * state.range (0) / 1e6,
+            benchmark::Counter::kIsRate);
+}
+
+static void BM_BVHBuild (benchmark::State &state) {
+    BuildBVH (state, BVHBuildOptions ());
+}
+
+static void BM_LBVHBuild (benchmark::State &state) {
+    BVHBuildOptions options;
+    options.splitMethod = BVHBuildOptions::SplitLBVH;
+    BuildBVH (state, options);
+}
+
+static void BM_LBVHBuildNoSAHTop (benchmark::State &state) {
+    BVHBuildOptions options;
+    options.splitMethod = BVHBuildOptions::SplitLBVH;
+    options.sahTreeletTop = false;
+    BuildBVH (state, options);
+}
+
+static void BuildArguments (benchmark::internal::Benchmark *b) {
+    int maxThreads = std::max (1, int (std::thread::hardware_concurrency()));
+
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        b->Args ({ 1 << 20, threads });
+    b->Args ({ 1 << 20, maxThreads });
+}
+
+BENCHMARK(BM_BVHBuild)->Apply (BuildArguments)
+                      ->ArgNames ({ "prims", "threads" })
+                      ->Unit (benchmark::kMillisecond)
+                      ->UseRealTime();
+BENCHMARK(BM_LBVHBuild)->Apply (BuildArguments)
+                       ->ArgNames ({ "prims", "threads" })
+                       ->Unit (benchmark::kMillisecond)
+                       ->UseRealTime();
+BENCHMARK(BM_LBVHBuildNoSAHTop)->Apply (BuildArguments)
+                               ->ArgNames ({ "prims", "threads" })
+                               ->Unit (benchmark::kMillisecond)
+                               ->UseRealTime();
+
+
+// One frame of a deforming mesh of state.range(0) triangles on
+// state.range(1) threads: move every vertex, then refit the BVH
+// (DoRefit) or rebuild it.
+template <bool DoRefit>
+static void BM_DeformingMeshFrame (benchmark::State &state) {
+    std::shared_ptr<TriangleMesh> mesh =
+            RandomTriangleMesh (int (state.range (0)));
+    TaskScheduler scheduler (int (state.range (1)));
+    BVHBuildOptions options;
+    options.scheduler = &scheduler;
+
+    BVHAccel bvh (TriangleMesh::CreateTriangles (mesh), options);
+
+    // Alternate between the rest pose and a slightly bent one.
+    std::vector<Point> poses[2];
+    for (int v = 0; v < mesh->NumVertices(); ++v) {
+        Point p = mesh->P (v);
+
+        poses[0].push_back (p);
+        poses[1].push_back (p + Vector (.2f * sinf (p.y * .05f), 0.f,
+                                        .2f * cosf (p.x * .05f)));
+    }
+
+    // The first refit records where the packed triangles' vertices live;
+    // that is a one-off cost, not a per-frame one.
+    if (DoRefit)
+        bvh.Refit();
+
+    int frame = 0;
+    for (auto _ : state) {
+        mesh->SetVertices (Transform(), &poses[++frame & 1][0]);
+
+        if (DoRefit)
+            bvh.Refit();
+        else
+            bvh.Rebuild();
+    }
+
+    state.counters["SAH"] = bvh.SAHCost();
+}
+
+BENCHMARK_TEMPLATE(BM_DeformingMeshFrame, true)->Apply (BuildArguments)
+                                ->ArgNames ({ "tris", "threads" })
+                                ->Unit (benchmark::kMillisecond)
+                                ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DeformingMeshFrame, false)->Apply (BuildArguments)
+                                ->ArgNames ({ "tris", "threads" })
+                                ->Unit (benchmark::kMillisecond)
+                                ->UseRealTime();
+
+
+// Trace state.range(1) random rays through bvh and report the time and
+// number of node visits per ray.
+template <typename Accel>
+static void TraceRays (benchmark::State &state, const Accel &bvh) {
+    std::mt19937 rng (2);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<Ray> rays (state.range (1));
+    int64_t nodeVisits = 0;
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        Point o (150.f * u (rng), 150.f * u (rng), 150.f * u (rng));
+        Point target (100.f * u (rng), 100.f * u (rng), 100.f * u (rng));
+
+        rays[i] = Ray (o, Normalize (target - o), 0.f);
+        nodeVisits += bvh.NodeVisits (rays[i]);
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Ray r = rays[i];
+            Intersection isect;
+
+            benchmark::DoNotOptimize (bvh.Intersect (r, &isect));
+        }
+    }
+
+    state.counters["time/ray"] = benchmark::Counter (
+            double (state.iterations()) * rays.size(),
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["visits/ray"] = double (nodeVisits) / rays.size();
+}
+
+// Binary BVH over state.range(0) primitives, flattened or not as
+// state.range(2) says.
+static void BM_BVHTrace (benchmark::State &state) {
+    BVHBuildOptions options;
+    options.flattenTree = state.range (2) != 0;
+    BVHAccel bvh (RandomSpheres (int (state.range (0))), options);
+
+    TraceRays (state, bvh);
+}
+
+template <int N>
+static void BM_WideBVHTrace (benchmark::State &state) {
+    WideBVHAccel<N> bvh (RandomSpheres (int (state.range (0))));
+
+    TraceRays (state, bvh);
+}
+
+BENCHMARK(BM_BVHTrace)->Args ({ 1 << 20, 1 << 14, 0 })
+                      ->Args ({ 1 << 20, 1 << 14, 1 })
+                      ->ArgNames ({ "prims", "rays", "flat" })
+                      ->Unit (benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WideBVHTrace, 4)->Args ({ 1 << 20, 1 << 14 })
+                                      ->ArgNames ({ "prims", "rays" })
+                                      ->Unit (benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WideBVHTrace, 8)->Args ({ 1 << 20, 1 << 14 })
+                                      ->ArgNames ({ "prims", "rays" })
+                                      ->Unit (benchmark::kMillisecond);
+
+
+// Test state.range(1) random shadow segments against a BVH over
+// state.range(0) spheres in one Occluded call, or (state.range(2) == 0)
+// find the closest hit along each instead, which is what shadow rays cost
+// without an any-hit path.
+static void BM_BVHShadowRays (benchmark::State &state) {
+    BVHAccel bvh (RandomSpheres (int (state.range (0))));
+    std::mt19937 rng (3);
+    std::uniform_real_distribution<float> u (-150.f, 150.f);
+    int nRays = int (state.range (1));
+    std::vector<Point> from, to;
+
+    for (int i = 0; i < nRays; ++i) {
+        from.push_back (Point (u (rng), u (rng), u (rng)));
+        to.push_back (Point (u (rng), u (rng), u (rng)));
+    }
+
+    std::unique_ptr<bool[]> occluded (new bool[nRays]);
+    int nOccluded = 0;
+
+    for (auto _ : state) {
+        if (state.range (2)) {
+            nOccluded = bvh.Occluded (&from[0], &to[0], nRays,
+                                      occluded.get());
+        }
+        else {
+            nOccluded = 0;
+
+            for (int i = 0; i < nRays; ++i) {
+                float dist = Distance (from[i], to[i]);
+                Ray r (from[i], (to[i] - from[i]) / dist, 0.f,
+                       dist * (1.f - SHADOW_EPSILON));
+                Intersection isect;
+
+                nOccluded += bvh.Intersect (r, &isect);
+            }
+        }
+
+        benchmark::DoNotOptimize (nOccluded);
+    }
+
+    state.counters["time/ray"] = benchmark::Counter (
+            double (state.iterations()) * nRays,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["occluded"] = double (nOccluded) / nRays;
+}
+
+BENCHMARK(BM_BVHShadowRays)->Args ({ 1 << 20, 1 << 14, 0 })
+                           ->Args ({ 1 << 20, 1 << 14, 1 })
+                           ->ArgNames ({ "prims", "rays", "anyhit" })
+                           ->Unit (benchmark::kMillisecond);
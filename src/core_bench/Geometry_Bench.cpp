@@ -0,0 +1,308 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Geometry_Bench.cpp
+ *
+ *  Purpose: Benchmark the core geometry operations over batches of vectors,
+ *           boxes, matrices and rays.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "core_bench.h"
+#include "transform.h"
+
+
+// Every benchmark here applies one operation to each element of a batch of
+// state.range(0) inputs. Small batches stay in L1 and measure the
+// arithmetic; the largest ones are tens of megabytes and measure how well
+// the operation keeps up with memory.
+#define GEOMETRY_BENCHMARK(name) \
+    BENCHMARK(name)->RangeMultiplier (8)->Range (1 << 8, 1 << 20) \
+                   ->ArgName ("n")
+
+
+static std::vector<Vector> RandomVectors (int n, unsigned seed) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<Vector> v (n);
+
+    for (int i = 0; i < n; ++i)
+        v[i] = Vector (u (rng), u (rng), u (rng));
+
+    return v;
+}
+
+// Boxes of up to 10 units a side in the [-100, 100]^3 cube, so that a fair
+// share of neighbouring pairs overlap.
+static std::vector<BBox> RandomBoxes (int n, unsigned seed) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> pos (-100.f, 100.f);
+    std::uniform_real_distribution<float> size (0.f, 10.f);
+    std::vector<BBox> b (n);
+
+    for (int i = 0; i < n; ++i) {
+        Point p (pos (rng), pos (rng), pos (rng));
+        b[i] = BBox (p, p + Vector (size (rng), size (rng), size (rng)));
+    }
+
+    return b;
+}
+
+// Random matrices with a dominant diagonal, so that they are all safely
+// invertible.
+static std::vector<Matrix4x4> RandomMatrices (int n, unsigned seed) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<Matrix4x4> m (n);
+
+    for (int i = 0; i < n; ++i)
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c)
+                m[i].m[r][c] = u (rng) + (r == c ? 4.f : 0.f);
+
+    return m;
+}
+
+
+static void BM_Dot (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Vector> a = RandomVectors (n, 1), b = RandomVectors (n, 2);
+    float sum = 0.f;
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            sum += Dot (a[i], b[i]);
+
+        benchmark::DoNotOptimize (sum);
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 2 * sizeof (Vector));
+}
+GEOMETRY_BENCHMARK(BM_Dot);
+
+
+static void BM_Cross (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Vector> a = RandomVectors (n, 1), b = RandomVectors (n, 2);
+    std::vector<Vector> out (n);
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            out[i] = Cross (a[i], b[i]);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 3 * sizeof (Vector));
+}
+GEOMETRY_BENCHMARK(BM_Cross);
+
+
+static void BM_Normalize (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Vector> a = RandomVectors (n, 1);
+    std::vector<Vector> out (n);
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            out[i] = Normalize (a[i]);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 2 * sizeof (Vector));
+}
+GEOMETRY_BENCHMARK(BM_Normalize);
+
+
+// Grow one box by every box of the batch, as bounds computations over a
+// node's primitives do.
+static void BM_BBoxUnion (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<BBox> boxes = RandomBoxes (n, 1);
+
+    for (auto _ : state) {
+        BBox bounds;
+
+        for (int i = 0; i < n; ++i)
+            bounds = Union (bounds, boxes[i]);
+
+        benchmark::DoNotOptimize (bounds);
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * sizeof (BBox));
+}
+GEOMETRY_BENCHMARK(BM_BBoxUnion);
+
+
+// Test each box against its neighbour in the batch.
+static void BM_BBoxOverlaps (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<BBox> boxes = RandomBoxes (n, 1);
+    int hits = 0;
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            hits += boxes[i].Overlaps (boxes[(i + 1) & (n - 1)]);
+
+        benchmark::DoNotOptimize (hits);
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * sizeof (BBox));
+}
+GEOMETRY_BENCHMARK(BM_BBoxOverlaps);
+
+
+static void BM_BBoxSurfaceArea (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<BBox> boxes = RandomBoxes (n, 1);
+    float sum = 0.f;
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            sum += boxes[i].SurfaceArea();
+
+        benchmark::DoNotOptimize (sum);
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * sizeof (BBox));
+}
+GEOMETRY_BENCHMARK(BM_BBoxSurfaceArea);
+
+
+static void BM_MatrixMul (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Matrix4x4> a = RandomMatrices (n, 1),
+                           b = RandomMatrices (n, 2);
+    std::vector<Matrix4x4> out (n);
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            out[i] = Matrix4x4::Mul (a[i], b[i]);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 3 *
+                             sizeof (Matrix4x4));
+}
+GEOMETRY_BENCHMARK(BM_MatrixMul);
+
+
+static void BM_MatrixInverse (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Matrix4x4> a = RandomMatrices (n, 1);
+    std::vector<Matrix4x4> out (n);
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            out[i] = Inverse (a[i]);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 2 *
+                             sizeof (Matrix4x4));
+}
+GEOMETRY_BENCHMARK(BM_MatrixInverse);
+
+
+static void BM_MatrixTranspose (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<Matrix4x4> a = RandomMatrices (n, 1);
+    std::vector<Matrix4x4> out (n);
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            out[i] = Transpose (a[i]);
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 2 *
+                             sizeof (Matrix4x4));
+}
+GEOMETRY_BENCHMARK(BM_MatrixTranspose);
+
+
+// Test rays from around the [-100, 100]^3 cube against the batch of boxes,
+// through the slab test traversal uses (Precomputed = true: reciprocal
+// direction and signs computed once per ray) or the general one.
+template <bool Precomputed>
+static void BM_RayBBox (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<BBox> boxes = RandomBoxes (n, 1);
+    std::vector<Vector> dirs = RandomVectors (n, 2);
+    std::vector<Ray> rays (n);
+    std::vector<Vector> invDirs (n);
+    std::vector<int> signs (3 * n);
+
+    // Each ray starts outside its box and points at a spot near its
+    // corner, so that the tests hit and miss unpredictably (about one in
+    // ten hits).
+    for (int i = 0; i < n; ++i) {
+        Point target = boxes[i].pMin + dirs[(i + 1) & (n - 1)] * 10.f;
+        rays[i] = Ray (target - dirs[i] * 50.f, dirs[i]);
+        invDirs[i] = Vector (1.f / dirs[i].x, 1.f / dirs[i].y,
+                             1.f / dirs[i].z);
+
+        for (int a = 0; a < 3; ++a)
+            signs[3 * i + a] = invDirs[i][a] < 0.f;
+    }
+
+    int hits = 0;
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i) {
+            if (Precomputed)
+                hits += boxes[i].IntersectP (rays[i], invDirs[i],
+                                             &signs[3 * i]);
+            else
+                hits += boxes[i].IntersectP (rays[i]);
+        }
+
+        benchmark::DoNotOptimize (hits);
+    }
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.counters["hit rate"] =
+        float (hits) / float (state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_RayBBox, false)->RangeMultiplier (8)
+                                     ->Range (1 << 8, 1 << 20)
+                                     ->ArgName ("n");
+BENCHMARK_TEMPLATE(BM_RayBBox, true)->RangeMultiplier (8)
+                                    ->Range (1 << 8, 1 << 20)
+                                    ->ArgName ("n");
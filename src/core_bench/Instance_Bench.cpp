@@ -0,0 +1,130 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Instance_Bench.cpp
+ *
+ *  Purpose: Benchmark tracing rays through instanced geometry.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "core_bench.h"
+#include "instance.h"
+#include "widebvh.h"
+
+
+// Scatter state.range(1) instances of one state.range(0) triangle asset
+// through the [-1000, 1000]^3 cube, with random rotations and scales, and
+// trace state.range(2) random rays through a BVH4 over them.
+//
+// Reports the trace rate, the memory of the whole scene (mesh, bottom and
+// top level BVHs and the instances; allocator overhead not counted) and
+// the part of it each instance adds.
+static void BM_InstancedTrace (benchmark::State &state) {
+    int nTriangles = int (state.range (0));
+    int nInstances = int (state.range (1));
+    std::shared_ptr<TriangleMesh> mesh = RandomTriangleMesh (nTriangles);
+    std::shared_ptr<BVH4Accel> blas = std::make_shared<BVH4Accel> (
+            TriangleMesh::CreateTriangles (mesh));
+
+    std::mt19937 rng (2);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<std::shared_ptr<Primitive> > instances;
+    instances.reserve (nInstances);
+
+    for (int i = 0; i < nInstances; ++i) {
+        Vector axis = Normalize (Vector (u (rng), u (rng), u (rng) + 2.f));
+        Transform objectToWorld =
+                Translate (Vector (1000.f * u (rng), 1000.f * u (rng),
+                                   1000.f * u (rng))) *
+                Rotate (180.f * u (rng), axis) *
+                Scale (.01f, .01f, .01f);
+
+        instances.push_back (std::make_shared<TransformedPrimitive> (
+                blas, objectToWorld));
+    }
+
+    BVH4Accel tlas (instances);
+    std::vector<Ray> rays (state.range (2));
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        Point o (1500.f * u (rng), 1500.f * u (rng), 1500.f * u (rng));
+        Point target (1000.f * u (rng), 1000.f * u (rng), 1000.f * u (rng));
+
+        rays[i] = Ray (o, Normalize (target - o), 0.f);
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Ray r = rays[i];
+            Intersection isect;
+
+            benchmark::DoNotOptimize (tlas.Intersect (r, &isect));
+        }
+    }
+
+    double instanceBytes = double (nInstances) *
+                           sizeof (TransformedPrimitive) + tlas.BytesUsed();
+
+    state.counters["Mrays"] = benchmark::Counter (
+            double (state.iterations()) * rays.size() / 1e6,
+            benchmark::Counter::kIsRate);
+    state.counters["MB"] = (mesh->BytesUsed() + blas->BytesUsed() +
+                            instanceBytes) / 1e6;
+    state.counters["bytes/inst"] = instanceBytes / nInstances;
+}
+
+BENCHMARK(BM_InstancedTrace)->Args ({ 1 << 16, 1 << 16, 1 << 14 })
+                            ->Args ({ 1 << 20, 1 << 20, 1 << 12 })
+                            ->ArgNames ({ "tris", "instances", "rays" })
+                            ->Unit (benchmark::kMillisecond);
+
+
+// The per-ray cost of evaluating a rotating, translating and scaling
+// AnimatedTransform: rebuilding the matrix and its inverse at each ray's
+// time and carrying the ray through it.
+static void BM_AnimatedTransformRay (benchmark::State &state) {
+    AnimatedTransform objectToWorld (
+            Translate (Vector (1, 2, 3)) * Rotate (30.f, Vector (1, 1, 0)) *
+            Scale (1, 2, 1), 0.f,
+            Translate (Vector (4, 0, -2)) * Rotate (160.f, Vector (0, 1, 1)) *
+            Scale (2, 2, 2), 1.f);
+    std::mt19937 rng (3);
+    std::uniform_real_distribution<float> u (0.f, 1.f);
+    std::vector<Ray> rays (1024);
+
+    for (size_t i = 0; i < rays.size(); ++i)
+        rays[i] = Ray (Point (u (rng), u (rng), u (rng)),
+                       Vector (u (rng), u (rng), 1.f), 0.f, INFINITY, u (rng));
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < rays.size(); ++i)
+            benchmark::DoNotOptimize (objectToWorld (rays[i]));
+    }
+
+    state.SetItemsProcessed (state.iterations() * rays.size());
+}
+
+BENCHMARK(BM_AnimatedTransformRay);
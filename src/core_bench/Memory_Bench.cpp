@@ -0,0 +1,95 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Memory_Bench.cpp
+ *
+ *  Purpose: Benchmark MemoryArena against the heap for per-sample allocations.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdlib.h>
+
+#include <thread>
+
+#include "core_bench.h"
+#include "memory.h"
+
+
+// What one shading point might allocate: an interaction record, a BSDF
+// with a few lobes and some scratch space.
+static const size_t kSizes[] = { 96, 160, 48, 48, 256 };
+static const int kAllocsPerSample = sizeof (kSizes) / sizeof (kSizes[0]);
+
+
+// Allocate a sample's worth of blocks from the heap, touch them and free
+// them, state.range(0) samples per iteration, on every benchmark thread.
+static void BM_SampleAllocHeap (benchmark::State &state) {
+    void *p[kAllocsPerSample];
+
+    for (auto _ : state) {
+        for (int s = 0; s < state.range (0); ++s) {
+            for (int i = 0; i < kAllocsPerSample; ++i) {
+                p[i] = malloc (kSizes[i]);
+                static_cast<char*> (p[i])[0] = char (i);
+            }
+            benchmark::DoNotOptimize (p);
+
+            for (int i = 0; i < kAllocsPerSample; ++i)
+                free (p[i]);
+        }
+    }
+
+    state.SetItemsProcessed (state.iterations() * state.range (0));
+}
+
+// The same from a per-thread arena that is reset after every sample.
+static void BM_SampleAllocArena (benchmark::State &state) {
+    MemoryArena arena;
+    void *p[kAllocsPerSample];
+
+    for (auto _ : state) {
+        for (int s = 0; s < state.range (0); ++s) {
+            for (int i = 0; i < kAllocsPerSample; ++i) {
+                p[i] = arena.Alloc (kSizes[i]);
+                static_cast<char*> (p[i])[0] = char (i);
+            }
+            benchmark::DoNotOptimize (p);
+
+            arena.FreeAll();
+        }
+    }
+
+    state.SetItemsProcessed (state.iterations() * state.range (0));
+}
+
+static int MaxThreads() {
+    return std::max (1, int (std::thread::hardware_concurrency()));
+}
+
+BENCHMARK(BM_SampleAllocHeap)->Arg (1024)->ArgName ("samples")
+                             ->ThreadRange (1, MaxThreads())
+                             ->UseRealTime();
+BENCHMARK(BM_SampleAllocArena)->Arg (1024)->ArgName ("samples")
+                              ->ThreadRange (1, MaxThreads())
+                              ->UseRealTime();
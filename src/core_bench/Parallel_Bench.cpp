@@ -0,0 +1,107 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Parallel_Bench.cpp
+ *
+ *  Purpose: Benchmark the task scheduler's overhead.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <thread>
+
+#include "core_bench.h"
+#include "parallel.h"
+
+
+// Recursive fork / join down to single leaves, so nearly all of the time
+// goes to spawning, stealing and waiting.
+static int64_t ForkJoin (TaskScheduler &scheduler, int depth) {
+    if (depth == 0)
+        return 1;
+
+    int64_t left = 0;
+    TaskGroup group;
+
+    scheduler.Spawn (group, [&]() { left = ForkJoin (scheduler, depth - 1); });
+    int64_t right = ForkJoin (scheduler, depth - 1);
+    scheduler.Wait (group);
+
+    return left + right;
+}
+
+// 2^state.range(0) leaf tasks on state.range(1) threads; reports the
+// cost per task.
+static void BM_ForkJoin (benchmark::State &state) {
+    TaskScheduler scheduler (int (state.range (1)));
+    int depth = int (state.range (0));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize (ForkJoin (scheduler, depth));
+
+    state.counters["time/task"] = benchmark::Counter (
+            double (state.iterations()) * (int64_t (1) << depth),
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// A ParallelFor over state.range(0) chunks of trivial work on
+// state.range(1) threads.
+static void BM_ParallelForChunks (benchmark::State &state) {
+    TaskScheduler scheduler (int (state.range (1)));
+    int64_t nChunks = state.range (0);
+    std::vector<int64_t> out (nChunks);
+
+    for (auto _ : state) {
+        ParallelFor (&scheduler, 0, nChunks, 1,
+                     [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i)
+                out[i] = i;
+        });
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["time/chunk"] = benchmark::Counter (
+            double (state.iterations()) * nChunks,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+static void ThreadArguments (benchmark::internal::Benchmark *b,
+                             int64_t size) {
+    int maxThreads = std::max (1, int (std::thread::hardware_concurrency()));
+
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        b->Args ({ size, threads });
+    b->Args ({ size, maxThreads });
+}
+
+BENCHMARK(BM_ForkJoin)->Apply ([](benchmark::internal::Benchmark *b) {
+                           ThreadArguments (b, 16);
+                       })
+                      ->ArgNames ({ "depth", "threads" })
+                      ->UseRealTime();
+BENCHMARK(BM_ParallelForChunks)->Apply (
+                                   [](benchmark::internal::Benchmark *b) {
+                                       ThreadArguments (b, 1 << 14);
+                                   })
+                               ->ArgNames ({ "chunks", "threads" })
+                               ->UseRealTime();
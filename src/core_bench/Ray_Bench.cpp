@@ -0,0 +1,93 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Ray_Bench.cpp
+ *
+ *  Purpose: Benchmark moving rays through queues in the Ray and CompactRay
+ *           layouts.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "core_bench.h"
+#include "memory.h"
+
+
+// How a queue entry is made from a Ray and turned back into one.
+static inline void Store (const Ray &r, Ray *entry) { *entry = r; }
+static inline Ray Load (const Ray &entry) { return entry; }
+
+static inline void Store (const Ray &r, CompactRay *entry) {
+    *entry = CompactRay (r);
+}
+static inline Ray Load (const CompactRay &entry) { return entry.ToRay(); }
+
+
+// Push state.range(0) rays through a queue of Entry records and pop them
+// again, as a wavefront renderer does between its stages, and report rays
+// moved per second. Queues larger than the caches show the difference the
+// smaller record makes to memory traffic.
+template <typename Entry>
+static void BM_RayQueue (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+
+    // A small set of rays to feed the queue, so that reading the source
+    // doesn't dominate.
+    std::vector<Ray> source (1024);
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = Ray (Point (u (rng), u (rng), u (rng)),
+                         Vector (u (rng), u (rng), u (rng)), 0.f,
+                         10.f + u (rng), .5f + .5f * u (rng));
+
+    Entry *queue = AllocAligned<Entry> (n);
+    float sum = 0.f;
+
+    for (auto _ : state) {
+        for (int i = 0; i < n; ++i)
+            Store (source[i & 1023], &queue[i]);
+
+        benchmark::ClobberMemory();
+
+        for (int i = 0; i < n; ++i) {
+            Ray r = Load (queue[i]);
+            sum += r.o.x + r.d.y + r.mint + r.maxt + r.time;
+        }
+    }
+
+    benchmark::DoNotOptimize (sum);
+    FreeAligned (queue);
+
+    state.SetItemsProcessed (state.iterations() * n);
+    state.SetBytesProcessed (state.iterations() * n * 2 * sizeof (Entry));
+}
+
+BENCHMARK_TEMPLATE(BM_RayQueue, Ray)->RangeMultiplier (16)
+                                    ->Range (1 << 10, 1 << 22)
+                                    ->ArgName ("rays");
+BENCHMARK_TEMPLATE(BM_RayQueue, CompactRay)->RangeMultiplier (16)
+                                           ->Range (1 << 10, 1 << 22)
+                                           ->ArgName ("rays");
@@ -0,0 +1,221 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Renderer_Bench.cpp
+ *
+ *  Purpose: Benchmark the tile renderer's tile orders.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <limits.h>
+
+#include <thread>
+#include <unordered_map>
+
+#include "core_bench.h"
+#include "bvh.h"
+#include "camera.h"
+#include "film.h"
+#include "parallel.h"
+#include "renderer.h"
+#include "scene.h"
+
+
+static const int kXResolution = 1280, kYResolution = 720;
+
+
+// A rolling terrain of 2n^2 triangles over [-100, 100]^2, big enough that
+// its BVH is many times the size of the caches.
+static std::shared_ptr<TriangleMesh> TerrainMesh (int n) {
+    std::vector<Point> P;
+    std::vector<int> indices;
+
+    P.reserve ((n + 1) * (n + 1));
+    indices.reserve (6 * n * n);
+
+    for (int i = 0; i <= n; ++i) {
+        for (int j = 0; j <= n; ++j) {
+            float x = 200.f * i / n - 100.f, z = 200.f * j / n - 100.f;
+            float y = 4.f * sinf (x * .11f) * cosf (z * .07f) +
+                      .5f * sinf (x * 1.3f + z * .9f);
+
+            P.push_back (Point (x, y, z));
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            int v00 = i * (n + 1) + j, v01 = v00 + 1;
+            int v10 = v00 + n + 1, v11 = v10 + 1;
+            int quad[6] = { v00, v10, v11, v00, v11, v01 };
+
+            indices.insert (indices.end(), quad, quad + 6);
+        }
+    }
+
+    return std::make_shared<TriangleMesh> (Transform(), 2 * n * n,
+                                           &indices[0], int (P.size()),
+                                           &P[0]);
+}
+
+
+// The terrain, built once, and a camera looking across it.
+struct TerrainScene {
+    TerrainScene()
+            : camera (Inverse (LookAt (Point (-60, 25, -110), Point (0, 0, 0),
+                                       Vector (0, 1, 0))),
+                      60.f, kXResolution, kYResolution) {
+        bvh = std::make_shared<BVHAccel> (
+                TriangleMesh::CreateTriangles (TerrainMesh (1024)));
+        scene.reset (new Scene (bvh, PointLight (Point (50, 80, -40), 9000.f,
+                                                 8500.f, 8000.f)));
+    }
+
+    static const TerrainScene &Get() {
+        static TerrainScene s;
+        return s;
+    }
+
+    PerspectiveCamera camera;
+    std::shared_ptr<BVHAccel> bvh;
+    std::unique_ptr<Scene> scene;
+};
+
+
+////////////////////
+// Function:
+//      TileLocality
+//
+// Purpose:
+//      Work out cache miss proxies for rendering the terrain's tiles in
+//      the renderer's order, by tracing one ray through each pixel.
+//
+//      The BVH keeps primitives that are close in space close in memory,
+//      so the primitives are grouped into runs of 64 in the BVH's order,
+//      each standing for a subtree's nodes and triangles. Of the groups a
+//      tile's rays hit, a group counts as reused if one of the `window`
+//      tiles handed out just before hit it too: with that many tiles in
+//      flight at once, its data is likely to still be in a shared cache.
+//      The rest are the tile's likely cache misses.
+//
+// Parameters:
+//      const TileRenderer &renderer - Supplies the tiles and their order.
+//      int window - The number of tiles in flight.
+//      double *reuse - Receives the fraction of the groups that were
+//          reused.
+//      double *visits - Receives the BVH nodes visited per ray, which
+//          doesn't depend on the order; only where the visits go does.
+////////////////////
+static void TileLocality (const TileRenderer &renderer, int window,
+                          double *reuse, double *visits) {
+    const TerrainScene &s = TerrainScene::Get();
+    const std::vector<std::shared_ptr<Primitive> > &prims =
+            s.bvh->Primitives();
+    std::unordered_map<const Primitive*, int> group;
+
+    for (size_t i = 0; i < prims.size(); ++i)
+        group[prims[i].get()] = int (i / 64);
+
+    std::vector<int> lastTouched ((prims.size() + 63) / 64, INT_MIN / 2);
+    const std::vector<int> &sequence = renderer.TileSequence();
+    int64_t nRays = 0, nGroups = 0, nReused = 0, nVisits = 0;
+
+    for (int i = 0; i < int (sequence.size()); ++i) {
+        int x0, y0, x1, y1;
+        renderer.TileBounds (sequence[i], &x0, &y0, &x1, &y1);
+
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                Ray ray = s.camera.GenerateRay (x + .5f, y + .5f);
+                Intersection isect;
+
+                ++nRays;
+                nVisits += s.bvh->NodeVisits (ray);
+
+                if (!s.bvh->Intersect (ray, &isect))
+                    continue;
+
+                int &last = lastTouched[group[isect.primitive]];
+
+                if (last == i)
+                    continue;
+
+                ++nGroups;
+                nReused += last >= i - window;
+                last = i;
+            }
+        }
+    }
+
+    *reuse = nGroups ? double (nReused) / nGroups : 0.;
+    *visits = double (nVisits) / nRays;
+}
+
+
+// Render the terrain at 1 sample per pixel with 16 x 16 pixel tiles handed
+// out in tile order state.range(0) to state.range(1) threads, and report
+// the camera ray rate alongside the order's cache miss proxies: reuse
+// with as many tiles in flight as there are threads, and with 16 in
+// flight, which is what a many-core machine sees.
+static void BM_RenderTileOrder (benchmark::State &state) {
+    const TerrainScene &s = TerrainScene::Get();
+    TaskScheduler scheduler (int (state.range (1)));
+    RenderOptions options;
+    options.tileSize = 16;
+    options.samplesPerPixel = 1;
+    options.tileOrder = RenderOptions::TileOrder (state.range (0));
+
+    TileRenderer renderer (*s.scene, s.camera, options);
+    Film film (kXResolution, kYResolution);
+    int64_t nRays = 0;
+
+    for (auto _ : state)
+        nRays += renderer.Render (&film, &scheduler).cameraRays;
+
+    double reuse, reuse16, visits;
+    TileLocality (renderer, scheduler.NumThreads(), &reuse, &visits);
+    TileLocality (renderer, 16, &reuse16, &visits);
+
+    state.counters["Mrays"] = benchmark::Counter (
+            double (nRays) / 1e6, benchmark::Counter::kIsRate);
+    state.counters["reuse"] = reuse;
+    state.counters["reuse16"] = reuse16;
+    state.counters["visits/ray"] = visits;
+}
+
+static void TileOrderArguments (benchmark::internal::Benchmark *b) {
+    int maxThreads = std::max (1, int (std::thread::hardware_concurrency()));
+
+    for (int order = RenderOptions::TileScanline;
+         order <= RenderOptions::TileMorton; ++order) {
+        b->Args ({ order, 1 });
+        if (maxThreads > 1)
+            b->Args ({ order, maxThreads });
+    }
+}
+
+BENCHMARK(BM_RenderTileOrder)->Apply (TileOrderArguments)
+                             ->ArgNames ({ "order", "threads" })
+                             ->Unit (benchmark::kMillisecond)
+                             ->UseRealTime();
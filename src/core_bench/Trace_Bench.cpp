@@ -0,0 +1,327 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Trace_Bench.cpp
+ *
+ *  Purpose: Benchmark end to end ray casting throughput over procedural
+ *           reference scenes.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include "bvh.h"
+#include "camera.h"
+#include "core_bench.h"
+#include "instance.h"
+#include "parallel.h"
+
+
+// The reference scenes.
+enum TraceSceneKind { SceneSoup, SceneStadium, SceneForest, kNumScenes };
+
+// The rays traced through them.
+enum TraceRays { RaysPrimary, RaysRandom };
+
+static const char *kSceneNames[kNumScenes] = { "soup", "stadium", "forest" };
+
+// Primary rays are one per pixel of a kImageSize^2 image; there are as
+// many random ones.
+static const int kImageSize = 512;
+static const int kRaysPerChunk = 1024;
+
+
+// Sweep a profile of (radius, height) points around the y axis in nPhi
+// steps. Profile points on the axis give degenerate triangles, which the
+// ray-triangle test never hits.
+static std::vector<std::shared_ptr<Primitive> > Lathe (
+        const std::vector<std::pair<float, float> > &profile, int nPhi,
+        const Transform &objectToWorld = Transform()) {
+    std::vector<Point> P;
+    std::vector<int> indices;
+    int nProfile = int (profile.size());
+
+    for (int i = 0; i < nProfile; ++i) {
+        for (int j = 0; j <= nPhi; ++j) {
+            float phi = 2.f * float (M_PI) * j / nPhi;
+
+            P.push_back (Point (profile[i].first * cosf (phi),
+                                profile[i].second,
+                                profile[i].first * sinf (phi)));
+        }
+    }
+
+    for (int i = 0; i < nProfile - 1; ++i) {
+        for (int j = 0; j < nPhi; ++j) {
+            int v00 = i * (nPhi + 1) + j, v01 = v00 + 1;
+            int v10 = v00 + nPhi + 1, v11 = v10 + 1;
+            int quad[6] = { v00, v10, v11, v00, v11, v01 };
+
+            indices.insert (indices.end(), quad, quad + 6);
+        }
+    }
+
+    return TriangleMesh::CreateTriangles (std::make_shared<TriangleMesh> (
+            objectToWorld, int (indices.size() / 3), &indices[0],
+            int (P.size()), &P[0]));
+}
+
+// A square of side 2 * halfSize on the y = 0 plane.
+static std::vector<std::shared_ptr<Primitive> > Ground (float halfSize) {
+    const int indices[6] = { 0, 1, 2, 0, 2, 3 };
+    const Point P[4] = { Point (-halfSize, 0, -halfSize),
+                         Point (halfSize, 0, -halfSize),
+                         Point (halfSize, 0, halfSize),
+                         Point (-halfSize, 0, halfSize) };
+
+    return TriangleMesh::CreateTriangles (std::make_shared<TriangleMesh> (
+            Transform(), 2, indices, 4, P));
+}
+
+static void Append (std::vector<std::shared_ptr<Primitive> > *prims,
+                    const std::vector<std::shared_ptr<Primitive> > &more) {
+    prims->insert (prims->end(), more.begin(), more.end());
+}
+
+
+////////////////////
+// struct: TraceScene
+//
+// Purpose:
+//      One of the reference scenes, built on first use, with a camera to
+//      make coherent rays from and the box random rays start in.
+//
+//      SceneSoup: a million small triangles scattered uniformly through a
+//          cube. Every ray crosses many overlapping leaves.
+//      SceneStadium: a finely tessellated pot of 260K triangles about a
+//          unit in size in the middle of a stadium a thousand units
+//          across made of a few hundred huge triangles; the classic case
+//          where large and small primitives share the tree's nodes.
+//      SceneForest: 10,000 instances of one 4K triangle tree on a ground
+//          plane, 40M triangles in all, through a BVH of instances.
+////////////////////
+struct TraceScene {
+    TraceScene (TraceSceneKind kind);
+
+    static const TraceScene &Get (int kind) {
+        static std::unique_ptr<TraceScene> scenes[kNumScenes];
+
+        if (!scenes[kind])
+            scenes[kind].reset (new TraceScene (TraceSceneKind (kind)));
+
+        return *scenes[kind];
+    }
+
+    std::shared_ptr<Primitive> accel;
+    std::unique_ptr<PerspectiveCamera> camera;
+    BBox rayBounds;
+};
+
+TraceScene::TraceScene (TraceSceneKind kind) {
+    BVHBuildOptions buildOptions;
+    buildOptions.scheduler = TaskScheduler::Shared();
+
+    std::vector<std::shared_ptr<Primitive> > prims;
+    Point eye, target;
+
+    switch (kind) {
+        case SceneSoup:
+            prims = TriangleMesh::CreateTriangles (
+                    RandomTriangleMesh (1 << 20));
+            eye = Point (30, 20, -250);
+            target = Point (0, 0, 0);
+            rayBounds = BBox (Point (-100, -100, -100),
+                              Point (100, 100, 100));
+            break;
+
+        case SceneStadium: {
+            std::vector<std::pair<float, float> > pot, stands;
+
+            for (int i = 0; i <= 256; ++i) {
+                float theta = float (M_PI) * i / 256;
+                float r = sinf (theta) * (1.f + .1f * sinf (6.f * theta));
+
+                pot.push_back (std::make_pair (r, .8f * (1.f - cosf (theta))));
+            }
+
+            stands.push_back (std::make_pair (0.f, 0.f));
+            stands.push_back (std::make_pair (400.f, 0.f));
+            stands.push_back (std::make_pair (600.f, 150.f));
+            stands.push_back (std::make_pair (600.f, 170.f));
+
+            prims = Lathe (pot, 512);
+            Append (&prims, Lathe (stands, 64));
+            eye = Point (-3, 1.5f, -5);
+            target = Point (0, .8f, 0);
+            rayBounds = BBox (Point (-600, 0, -600), Point (600, 170, 600));
+            break;
+        }
+
+        case SceneForest: {
+            std::vector<std::pair<float, float> > trunk, canopy;
+
+            trunk.push_back (std::make_pair (0.f, 0.f));
+            trunk.push_back (std::make_pair (.3f, 0.f));
+            trunk.push_back (std::make_pair (.2f, 4.f));
+            trunk.push_back (std::make_pair (0.f, 4.f));
+
+            for (int i = 0; i <= 40; ++i) {
+                float s = i / 40.f;
+
+                canopy.push_back (std::make_pair (
+                        2.5f * (1.f - s) * (1.f + .15f * sinf (20.f * s)),
+                        2.5f + 7.f * s));
+            }
+
+            std::vector<std::shared_ptr<Primitive> > tree = Lathe (trunk, 16);
+            Append (&tree, Lathe (canopy, 48));
+            std::shared_ptr<Primitive> treeBVH =
+                    std::make_shared<BVHAccel> (tree, buildOptions);
+
+            std::mt19937 rng (3);
+            std::uniform_real_distribution<float> u (-1.f, 1.f);
+
+            for (int i = 0; i < 100; ++i) {
+                for (int j = 0; j < 100; ++j) {
+                    float scale = 1.f + .3f * u (rng);
+                    float x = 20.f * i - 990.f + 8.f * u (rng);
+                    float z = 20.f * j - 990.f + 8.f * u (rng);
+                    Transform objectToWorld =
+                            Translate (Vector (x, 0.f, z)) *
+                            RotateY (180.f * u (rng)) *
+                            Scale (scale, scale, scale);
+
+                    prims.push_back (std::make_shared<TransformedPrimitive> (
+                            treeBVH, objectToWorld));
+                }
+            }
+
+            Append (&prims, Ground (1200.f));
+            eye = Point (-40, 8, -1050);
+            target = Point (0, 5, 0);
+            rayBounds = BBox (Point (-1000, 0, -1000), Point (1000, 15, 1000));
+            break;
+        }
+
+        default:
+            assert (false);
+    }
+
+    accel = std::make_shared<BVHAccel> (prims, buildOptions);
+    camera.reset (new PerspectiveCamera (
+            Inverse (LookAt (eye, target, Vector (0, 1, 0))), 60.f,
+            kImageSize, kImageSize));
+}
+
+
+// kImageSize^2 rays through the scene: one through the centre of each
+// pixel of the camera's image in scanline order, or from random points in
+// the scene's ray bounds in random directions.
+static std::vector<Ray> MakeRays (const TraceScene &s, TraceRays kind) {
+    std::vector<Ray> rays (kImageSize * kImageSize);
+
+    if (kind == RaysPrimary) {
+        for (int y = 0; y < kImageSize; ++y)
+            for (int x = 0; x < kImageSize; ++x)
+                rays[y * kImageSize + x] =
+                        s.camera->GenerateRay (x + .5f, y + .5f);
+
+        return rays;
+    }
+
+    std::mt19937 rng (4);
+    std::uniform_real_distribution<float> u (0.f, 1.f);
+    const BBox &b = s.rayBounds;
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        Point o (b.pMin.x + u (rng) * (b.pMax.x - b.pMin.x),
+                 b.pMin.y + u (rng) * (b.pMax.y - b.pMin.y),
+                 b.pMin.z + u (rng) * (b.pMax.z - b.pMin.z));
+        float z = 1.f - 2.f * u (rng), phi = 2.f * float (M_PI) * u (rng);
+        float r = sqrtf (std::max (0.f, 1.f - z * z));
+
+        rays[i] = Ray (o, Vector (r * cosf (phi), r * sinf (phi), z), 0.f);
+    }
+
+    return rays;
+}
+
+
+// Trace state.range(1) rays through scene state.range(0) with closest hit
+// (state.range(2) == 0) or any hit queries, on state.range(3) threads, and
+// report millions of rays per second of wall clock time. The scene is
+// built on first use and kept for the other runs, so the first run of each
+// scene takes a while to start.
+static void BM_Trace (benchmark::State &state) {
+    const TraceScene &s = TraceScene::Get (int (state.range (0)));
+    std::vector<Ray> rays = MakeRays (s, TraceRays (state.range (1)));
+    bool anyHit = state.range (2) != 0;
+    TaskScheduler scheduler (int (state.range (3)));
+    std::atomic<int64_t> hits (0);
+
+    for (auto _ : state) {
+        ParallelFor (&scheduler, 0, int64_t (rays.size()), kRaysPerChunk,
+                     [&](int64_t begin, int64_t end) {
+            int64_t chunkHits = 0;
+
+            for (int64_t i = begin; i < end; ++i) {
+                Ray r = rays[i];
+                Intersection isect;
+
+                chunkHits += anyHit ? s.accel->IntersectP (r)
+                                    : s.accel->Intersect (r, &isect);
+            }
+
+            hits += chunkHits;
+        });
+    }
+
+    double nRays = double (state.iterations()) * rays.size();
+
+    state.SetLabel (kSceneNames[state.range (0)]);
+    state.counters["Mrays"] = benchmark::Counter (
+            nRays / 1e6, benchmark::Counter::kIsRate);
+    state.counters["hit rate"] = double (hits) / nRays;
+}
+
+static void TraceArguments (benchmark::internal::Benchmark *b) {
+    int maxThreads = std::max (1, int (std::thread::hardware_concurrency()));
+
+    for (int scene = 0; scene < kNumScenes; ++scene) {
+        for (int rays = RaysPrimary; rays <= RaysRandom; ++rays) {
+            for (int anyHit = 0; anyHit <= 1; ++anyHit) {
+                b->Args ({ scene, rays, anyHit, 1 });
+                if (maxThreads > 1)
+                    b->Args ({ scene, rays, anyHit, maxThreads });
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Trace)->Apply (TraceArguments)
+                   ->ArgNames ({ "scene", "random", "anyhit", "threads" })
+                   ->Unit (benchmark::kMillisecond)
+                   ->UseRealTime();
@@ -0,0 +1,131 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Triangle_Bench.cpp
+ *
+ *  Purpose: Benchmark triangle intersection and tracing rays through meshes.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "core_bench.h"
+#include "widebvh.h"
+
+
+// Intersect rays with a leaf's worth (state.range(0)) of triangles, one
+// at a time through the Primitive interface or in SIMD batches, and report
+// the rate in millions of ray-triangle tests per second.
+template <bool Batched>
+static void BM_TriangleIntersect (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (RandomTriangleMesh (n));
+    PackedTriangles packed;
+    packed.Pack (prims);
+
+    // Rays from around the origin towards the triangles, so that about
+    // half of them hit.
+    std::mt19937 rng (2);
+    std::uniform_real_distribution<float> u (-.3f, .3f);
+    std::vector<Ray> rays (1024);
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        BBox b = prims[i % n]->WorldBound();
+        Point target = (b.pMin + b.pMax) * .5f + Vector (u (rng), u (rng),
+                                                         u (rng));
+
+        rays[i] = Ray (Point (0, 0, 0), Normalize (target - Point (0, 0, 0)),
+                       0.f);
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Ray r = rays[i];
+            Intersection isect;
+
+            if (Batched) {
+                benchmark::DoNotOptimize (
+                        packed.Intersect (&prims[0], 0, n, r, &isect));
+            }
+            else {
+                for (int j = 0; j < n; ++j)
+                    benchmark::DoNotOptimize (prims[j]->Intersect (r,
+                                                                   &isect));
+            }
+        }
+    }
+
+    state.counters["Mtests"] = benchmark::Counter (
+            double (state.iterations()) * rays.size() * n / 1e6,
+            benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_TEMPLATE(BM_TriangleIntersect, false)->Arg (4)->Arg (8)->Arg (16)
+                                               ->ArgNames ({ "tris" });
+BENCHMARK_TEMPLATE(BM_TriangleIntersect, true)->Arg (4)->Arg (8)->Arg (16)
+                                              ->ArgNames ({ "tris" });
+
+
+// Trace random rays through a BVH4 over a mesh of state.range(0)
+// triangles. Reports the trace rate and the memory each triangle costs:
+// its share of the mesh, its pointer in the BVH and its packed copy (the
+// nodes are not counted).
+static void BM_TriangleMeshTrace (benchmark::State &state) {
+    int n = int (state.range (0));
+    std::shared_ptr<TriangleMesh> mesh = RandomTriangleMesh (n);
+    BVHAccel binary (TriangleMesh::CreateTriangles (mesh));
+    BVH4Accel bvh (binary);
+
+    std::mt19937 rng (3);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<Ray> rays (state.range (1));
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        Point o (150.f * u (rng), 150.f * u (rng), 150.f * u (rng));
+        Point target (100.f * u (rng), 100.f * u (rng), 100.f * u (rng));
+
+        rays[i] = Ray (o, Normalize (target - o), 0.f);
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < rays.size(); ++i) {
+            Ray r = rays[i];
+            Intersection isect;
+
+            benchmark::DoNotOptimize (bvh.Intersect (r, &isect));
+        }
+    }
+
+    state.counters["Mrays"] = benchmark::Counter (
+            double (state.iterations()) * rays.size() / 1e6,
+            benchmark::Counter::kIsRate);
+    state.counters["bytes/tri"] =
+            double (mesh->BytesUsed() + binary.Triangles()->BytesUsed()) / n +
+            sizeof (std::shared_ptr<Primitive>);
+}
+
+BENCHMARK(BM_TriangleMeshTrace)->Args ({ 1 << 20, 1 << 14 })
+                               ->ArgNames ({ "tris", "rays" })
+                               ->Unit (benchmark::kMillisecond);
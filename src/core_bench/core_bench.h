@@ -0,0 +1,144 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: core_bench.h
+ *
+ *  Purpose: Shared includes and scene helpers for the core benchmarks.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#ifndef CORE_BENCH_H
+#define CORE_BENCH_H
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "primitive.h"
+#include "trianglemesh.h"
+
+
+////////////////////
+// Class: BenchSphere
+//
+// Purpose:
+//      A small analytic primitive to fill benchmark scenes with.
+////////////////////
+class BenchSphere : public Primitive {
+    public:
+        BenchSphere (const Point &c, float r) : center(c), radius(r) { }
+
+        BBox WorldBound() const {
+            return BBox (center - Vector (radius, radius, radius),
+                         center + Vector (radius, radius, radius));
+        }
+
+        bool Intersect (const Ray &ray, Intersection *isect) const {
+            float t;
+            if (!Hit (ray, &t))
+                return false;
+
+            ray.maxt = t;
+            isect->tHit = t;
+            isect->primitive = this;
+            return true;
+        }
+
+        bool IntersectP (const Ray &ray) const {
+            float t;
+            return Hit (ray, &t);
+        }
+
+    private:
+        bool Hit (const Ray &ray, float *tHit) const {
+            Vector oc = ray.o - center;
+            float a = Dot (ray.d, ray.d);
+            float b = 2.f * Dot (oc, ray.d);
+            float c = Dot (oc, oc) - radius * radius;
+            float disc = b * b - 4.f * a * c;
+
+            if (disc < 0.f)
+                return false;
+
+            float root = sqrtf (disc);
+            float t0 = (-b - root) / (2.f * a);
+            float t1 = (-b + root) / (2.f * a);
+
+            if (t0 >= ray.mint && t0 <= ray.maxt)
+                *tHit = t0;
+            else if (t1 >= ray.mint && t1 <= ray.maxt)
+                *tHit = t1;
+            else
+                return false;
+
+            return true;
+        }
+
+        Point center;
+        float radius;
+};
+
+
+// n small spheres scattered uniformly through the [-100, 100]^3 cube.
+inline std::vector<std::shared_ptr<Primitive> > RandomSpheres (int n) {
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> pos (-100.f, 100.f);
+    std::uniform_real_distribution<float> rad (.01f, .2f);
+    std::vector<std::shared_ptr<Primitive> > prims;
+
+    prims.reserve (n);
+    for (int i = 0; i < n; ++i)
+        prims.push_back (std::make_shared<BenchSphere> (
+                Point (pos (rng), pos (rng), pos (rng)), rad (rng)));
+
+    return prims;
+}
+
+// n small random triangles scattered through the [-100, 100]^3 cube, as
+// one mesh.
+inline std::shared_ptr<TriangleMesh> RandomTriangleMesh (int n) {
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> pos (-100.f, 100.f);
+    std::uniform_real_distribution<float> off (-.3f, .3f);
+    std::vector<Point> P;
+    std::vector<int> indices;
+
+    P.reserve (3 * n);
+    indices.reserve (3 * n);
+
+    for (int i = 0; i < n; ++i) {
+        Point c (pos (rng), pos (rng), pos (rng));
+
+        for (int j = 0; j < 3; ++j) {
+            indices.push_back (int (P.size()));
+            P.push_back (c + Vector (off (rng), off (rng), off (rng)));
+        }
+    }
+
+    return std::make_shared<TriangleMesh> (Transform(), n, &indices[0],
+                                           int (P.size()), &P[0]);
+}
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: AnimatedTransform_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the AnimatedTransform class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "AnimatedTransform_Tests.h"
+
+
+static const float kTolerance = 1e-4f;
+
+static void ExpectMatrixNear (const Matrix4x4 &expected,
+                              const Matrix4x4 &actual) {
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (expected.m[i][j], actual.m[i][j], kTolerance)
+                    << "entry " << i << ", " << j;
+}
+
+static void ExpectPointNear (const Point &expected, const Point &actual) {
+    EXPECT_NEAR (expected.x, actual.x, kTolerance);
+    EXPECT_NEAR (expected.y, actual.y, kTolerance);
+    EXPECT_NEAR (expected.z, actual.z, kTolerance);
+}
+
+static Matrix4x4 Compose (const Vector &T, const Quaternion &R,
+                          const Matrix4x4 &S) {
+    return (Translate (T) * R.ToTransform() * Transform (S)).GetMatrix();
+}
+
+
+TEST_F(AnimatedTransformTest, DecomposeSplitsTranslationRotationScale) {
+    Transform rotation = Rotate (75.f, Vector (1, 2, -1));
+    Transform m = Translate (Vector (4, -5, 6)) * rotation * Scale (2, 3, .5f);
+    Vector T;
+    Quaternion R;
+    Matrix4x4 S;
+
+    AnimatedTransform::Decompose (m.GetMatrix(), &T, &R, &S);
+
+    EXPECT_EQ (Vector (4, -5, 6), T);
+    EXPECT_NEAR (1.f, fabsf (Dot (Quaternion (rotation), R)), kTolerance);
+    ExpectMatrixNear (Scale (2, 3, .5f).GetMatrix(), S);
+    ExpectMatrixNear (m.GetMatrix(), Compose (T, R, S));
+}
+
+TEST_F(AnimatedTransformTest, DecomposeHandlesShearAndMirrors) {
+    Matrix4x4 shear (1, .5f, 0, 0,
+                     0, 1, .25f, 0,
+                     0, 0, 1, 0,
+                     0, 0, 0, 1);
+    Transform m = Translate (Vector (1, 2, 3)) *
+                  Rotate (-40.f, Vector (0, 1, 1)) * Transform (shear) *
+                  Scale (-1, 2, 2);
+    Vector T;
+    Quaternion R;
+    Matrix4x4 S;
+
+    AnimatedTransform::Decompose (m.GetMatrix(), &T, &R, &S);
+
+    EXPECT_NEAR (1.f, Dot (R, R), kTolerance);
+    EXPECT_FALSE (R.ToTransform().SwapsHandedness());
+    ExpectMatrixNear (m.GetMatrix(), Compose (T, R, S));
+}
+
+TEST_F(AnimatedTransformTest, KeyframesAreReproducedExactly) {
+    Transform t0 = Translate (Vector (1, 2, 3)) * RotateX (30.f);
+    Transform t1 = Translate (Vector (-1, 0, 5)) * RotateY (100.f) *
+                   Scale (2, 2, 2);
+    AnimatedTransform at (t0, 1.f, t1, 3.f);
+    Transform t;
+
+    EXPECT_TRUE (at.IsAnimated());
+
+    at.Interpolate (1.f, &t);
+    EXPECT_EQ (t0, t);
+    at.Interpolate (3.f, &t);
+    EXPECT_EQ (t1, t);
+
+    // Times outside the interval are clamped.
+    at.Interpolate (-5.f, &t);
+    EXPECT_EQ (t0, t);
+    at.Interpolate (10.f, &t);
+    EXPECT_EQ (t1, t);
+}
+
+TEST_F(AnimatedTransformTest, RotationIsInterpolatedAtConstantSpeed) {
+    AnimatedTransform at (RotateZ (0.f), 0.f, RotateZ (120.f), 1.f);
+
+    for (int i = 0; i <= 8; ++i) {
+        float u = i / 8.f;
+        Transform t;
+
+        at.Interpolate (u, &t);
+        ExpectMatrixNear (RotateZ (120.f * u).GetMatrix(), t.GetMatrix());
+    }
+}
+
+TEST_F(AnimatedTransformTest, TranslationAndScaleAreInterpolatedLinearly) {
+    AnimatedTransform at (Translate (Vector (0, 0, 0)) * Scale (1, 1, 1), 0.f,
+                          Translate (Vector (8, 4, 0)) * Scale (3, 1, 1), 2.f);
+    Transform t;
+
+    at.Interpolate (.5f, &t);
+    ExpectMatrixNear ((Translate (Vector (2, 1, 0)) *
+                       Scale (1.5f, 1, 1)).GetMatrix(), t.GetMatrix());
+}
+
+TEST_F(AnimatedTransformTest, InterpolatedTransformHasItsInverse) {
+    AnimatedTransform at (Translate (Vector (1, 2, 3)) * Scale (1, 2, 3), 0.f,
+                          Rotate (150.f, Vector (1, 1, 1)) *
+                          Scale (.5f, .5f, 4.f), 1.f);
+
+    for (int i = 1; i < 10; ++i) {
+        Transform t;
+
+        at.Interpolate (i / 10.f, &t);
+        ExpectMatrixNear (Matrix4x4(), Matrix4x4::Mul (t.GetMatrix(),
+                                                      t.GetInverseMatrix()));
+    }
+}
+
+TEST_F(AnimatedTransformTest, StaticTransformIsNotAnimated) {
+    Transform t0 = Rotate (20.f, Vector (1, 0, 1)) * Scale (2, 1, 1);
+    AnimatedTransform at (t0, 0.f, t0, 1.f);
+    BBox b (Point (-1, -2, -3), Point (1, 2, 3));
+
+    EXPECT_FALSE (at.IsAnimated());
+    EXPECT_EQ (t0 (b).pMin, at.MotionBounds (b).pMin);
+    EXPECT_EQ (t0 (b).pMax, at.MotionBounds (b).pMax);
+    EXPECT_EQ (t0 (Point (1, 2, 3)), at (.5f, Point (1, 2, 3)));
+}
+
+TEST_F(AnimatedTransformTest, RaysAreTransformedAtTheirTime) {
+    AnimatedTransform at (Translate (Vector (0, 0, 0)), 0.f,
+                          Translate (Vector (10, 0, 0)), 1.f);
+    Ray r (Point (0, 0, 0), Vector (0, 0, 1), 0.f, INFINITY, .3f);
+    Ray moved = at (r);
+
+    ExpectPointNear (Point (3, 0, 0), moved.o);
+    EXPECT_EQ (r.d, moved.d);
+    EXPECT_EQ (r.time, moved.time);
+    ExpectPointNear (Point (7, 0, 0), at (.7f, Point (0, 0, 0)));
+    EXPECT_EQ (Vector (0, 1, 0), at (.7f, Vector (0, 1, 0)));
+}
+
+TEST_F(AnimatedTransformTest, MotionBoundsContainTheSweptBox) {
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    BBox b (Point (-1, -2, 0), Point (3, 1, 2));
+
+    for (int trial = 0; trial < 20; ++trial) {
+        Transform t0 = Translate (Vector (5 * u (rng), 5 * u (rng), 0)) *
+                       Rotate (180.f * u (rng),
+                               Vector (u (rng), u (rng), 1.f)) *
+                       Scale (1.f + .5f * u (rng), 1.f, 1.f);
+        Transform t1 = Translate (Vector (5 * u (rng), 0, 5 * u (rng))) *
+                       Rotate (180.f * u (rng),
+                               Vector (1.f, u (rng), u (rng))) *
+                       Scale (1.f, 1.f + .5f * u (rng), 2.f);
+        AnimatedTransform at (t0, 0.f, t1, 1.f);
+        BBox bounds = at.MotionBounds (b);
+        BBox swept;
+
+        for (int i = 0; i <= 1000; ++i) {
+            float time = i / 1000.f;
+
+            for (int c = 0; c < 8; ++c) {
+                Point p = at (time, Point (b[c & 1].x, b[(c >> 1) & 1].y,
+                                           b[c >> 2].z));
+
+                ASSERT_TRUE (bounds.Inside (p)) << trial << " at " << time;
+                swept = Union (swept, p);
+            }
+        }
+
+        // And the padding doesn't make them much larger than the sweep.
+        EXPECT_LT (bounds.SurfaceArea(), 1.5f * swept.SurfaceArea());
+    }
+}
+
+TEST_F(AnimatedTransformTest, MotionBoundsWithoutRotationAreTheEndBoxes) {
+    Transform t0 = Translate (Vector (1, 0, 0)) * Scale (1, 2, 1);
+    Transform t1 = Translate (Vector (0, 5, 0)) * Scale (3, 1, 1);
+    AnimatedTransform at (t0, 0.f, t1, 1.f);
+    BBox b (Point (-1, -1, -1), Point (1, 1, 1));
+    BBox expected = Union (t0 (b), t1 (b));
+
+    EXPECT_EQ (expected.pMin, at.MotionBounds (b).pMin);
+    EXPECT_EQ (expected.pMax, at.MotionBounds (b).pMax);
+}
@@ -350,16 +350,44 @@ TEST_F(BBoxTest, OffsetOutsideOfTheBoxWorks) {
     EXPECT_EQ (1.5, v.z);
 }
 
-// This test crashes because Offset has no
-// divide by zero checking.
+TEST_F(BBoxTest, OffsetUsesEachAxisExtent) {
+    BBox b (Point (0, 0, 0), Point (2, 4, 8));
+
+    Vector v = b.Offset (Point (1, 1, 1));
+
+    EXPECT_EQ (.5, v.x);
+    EXPECT_EQ (.25, v.y);
+    EXPECT_EQ (.125, v.z);
+}
+
+TEST_F(BBoxTest, OffsetAlongAFlatAxisIsZero) {
+    BBox b (Point (0, 0, 0), Point (2, 0, 2));
+
+    Vector v = b.Offset (Point (1, 0, 1));
+
+    EXPECT_EQ (.5, v.x);
+    EXPECT_EQ (0, v.y);
+    EXPECT_EQ (.5, v.z);
+}
+
 TEST_F(BBoxTest, OffsetDegenerateWorks) {
     BBox b (Point (0, 0, 0), Point (0, 0, 0));
 
     Vector v = b.Offset (Point (1, 1, 1));
 
+    EXPECT_EQ (0, v.x);
+    EXPECT_EQ (0, v.y);
+    EXPECT_EQ (0, v.z);
+}
+
+TEST_F(BBoxTest, OffsetOffAFlatAxisIsZero) {
+    BBox b (Point (0, 0, 0), Point (2, 0, 2));
+
+    Vector v = b.Offset (Point (1, 3, -1));
+
     EXPECT_EQ (.5, v.x);
-    EXPECT_EQ (.5, v.y);
-    EXPECT_EQ (.5, v.z);
+    EXPECT_EQ (0, v.y);
+    EXPECT_EQ (-.5, v.z);
 }
 
 // Bounding Sphere Tests
@@ -409,3 +437,84 @@ TEST_F(BBoxTest, BoundingSphereDegenerateWorks) {
 
     //EXPECT_EQ (?, radius);
 //}
+
+
+// IntersectP Tests
+TEST_F(BBoxTest, IntersectPHitReportsEntryAndExit) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (-1, 1, 1), Vector (1, 0, 0));
+
+    float t0, t1;
+    bool result = b.IntersectP (r, &t0, &t1);
+
+    EXPECT_TRUE (result);
+    EXPECT_FLOAT_EQ (1, t0);
+    EXPECT_FLOAT_EQ (3, t1);
+}
+
+TEST_F(BBoxTest, IntersectPMissWorks) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (-1, 3, 1), Vector (1, 0, 0));
+
+    bool result = b.IntersectP (r);
+
+    EXPECT_FALSE (result);
+}
+
+TEST_F(BBoxTest, IntersectPBoxBehindRayMisses) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (3, 1, 1), Vector (1, 0, 0));
+
+    bool result = b.IntersectP (r);
+
+    EXPECT_FALSE (result);
+}
+
+TEST_F(BBoxTest, IntersectPOriginInsideClampsToMint) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (1, 1, 1), Vector (0, 0, -1));
+
+    float t0, t1;
+    bool result = b.IntersectP (r, &t0, &t1);
+
+    EXPECT_TRUE (result);
+    EXPECT_FLOAT_EQ (r.mint, t0);
+    EXPECT_FLOAT_EQ (1, t1);
+}
+
+TEST_F(BBoxTest, IntersectPHonorsMaxt) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (-1, 1, 1), Vector (1, 0, 0), 0.f, .5f);
+
+    bool result = b.IntersectP (r);
+
+    EXPECT_FALSE (result);
+}
+
+TEST_F(BBoxTest, IntersectPFastMatchesSlowVersion) {
+    BBox b (Point (-1, -2, -3), Point (1, 2, 3));
+
+    // Sweep a fan of rays with mixed direction signs over the box.
+    for (int i = 0; i < 64; ++i) {
+        float a = float (i) * .1f;
+        Ray r (Point (4 * cosf (a), 3 * sinf (a), 5 - float (i % 7)),
+               Vector (-cosf (a * 1.3f), -sinf (a), (i % 3) - 1.f + .25f));
+
+        Vector invDir (1.f / r.d.x, 1.f / r.d.y, 1.f / r.d.z);
+        int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+        EXPECT_EQ (b.IntersectP (r), b.IntersectP (r, invDir, dirIsNeg));
+    }
+}
+
+TEST_F(BBoxTest, IntersectPFastNegativeDirectionWorks) {
+    BBox b (Point (0, 0, 0), Point (2, 2, 2));
+    Ray r (Point (3, 1, 1), Vector (-1, 0, 0));
+    Vector invDir (1.f / r.d.x, 1.f / r.d.y, 1.f / r.d.z);
+    int dirIsNeg[3] = { 1, 0, 0 };
+
+    EXPECT_TRUE (b.IntersectP (r, invDir, dirIsNeg));
+
+    r.maxt = .5f;
+    EXPECT_FALSE (b.IntersectP (r, invDir, dirIsNeg));
+}
@@ -0,0 +1,665 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: BVH_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the BVHAccel class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <algorithm>
+
+#include "BVH_Tests.h"
+
+
+TEST_F(BVHTest, EmptyBVHNeverHits) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    BVHAccel bvh (prims);
+    Ray r (Point (0, 0, 0), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_FALSE (bvh.Intersect (r, &isect));
+    EXPECT_FALSE (bvh.IntersectP (r));
+    EXPECT_EQ (0, bvh.TotalNodes());
+}
+
+
+TEST_F(BVHTest, SinglePrimitiveWorks) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 5), 1.f));
+    BVHAccel bvh (prims);
+
+    Ray r (Point (0, 0, 0), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (4.f, isect.tHit);
+    EXPECT_FLOAT_EQ (4.f, r.maxt);
+    EXPECT_EQ (prims[0].get(), isect.primitive);
+    EXPECT_EQ (1, bvh.TotalNodes());
+}
+
+
+TEST_F(BVHTest, WorldBoundEnclosesAllPrimitives) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (200, 1);
+    BVHAccel bvh (prims);
+    BBox bounds = bvh.WorldBound();
+
+    for (size_t i = 0; i < prims.size(); ++i) {
+        BBox b = prims[i]->WorldBound();
+        EXPECT_TRUE (bounds.Inside (b.pMin));
+        EXPECT_TRUE (bounds.Inside (b.pMax));
+    }
+}
+
+
+TEST_F(BVHTest, IntersectFindsTheClosestHit) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (500, 2);
+    BVHAccel bvh (prims);
+    std::mt19937 rng (3);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        Ray rBrute = r;
+        Intersection isect, isectBrute;
+
+        bool hit = bvh.Intersect (r, &isect);
+        bool hitBrute = BruteForceIntersect (prims, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, hit);
+        if (hit) {
+            EXPECT_EQ (isectBrute.primitive, isect.primitive);
+            EXPECT_FLOAT_EQ (isectBrute.tHit, isect.tHit);
+        }
+    }
+}
+
+
+TEST_F(BVHTest, IntersectPMatchesIntersect) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (500, 4);
+    BVHAccel bvh (prims);
+    std::mt19937 rng (5);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        r.maxt = 12.f;
+        Intersection isect;
+
+        bool occluded = bvh.IntersectP (r);
+
+        EXPECT_EQ (bvh.Intersect (r, &isect), occluded);
+    }
+}
+
+
+TEST_F(BVHTest, OnePrimitivePerLeafMakesAFullTree) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (100, 6);
+    BVHBuildOptions options;
+    options.maxPrimsInNode = 1;
+    options.traversalCost = 0.f;
+
+    BVHAccel bvh (prims, options);
+
+    EXPECT_EQ (2 * 100 - 1, bvh.TotalNodes());
+}
+
+
+TEST_F(BVHTest, CoincidentCentroidsMakeALeaf) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+
+    for (int i = 0; i < 10; ++i)
+        prims.push_back (std::make_shared<TestSphere> (Point (1, 2, 3),
+                                                       .1f * (i + 1)));
+
+    BVHAccel bvh (prims);
+    Ray r (Point (1, 2, -5), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_EQ (1, bvh.TotalNodes());
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (7.f, isect.tHit);
+}
+
+
+TEST_F(BVHTest, UnbinnableCentroidExtentsMakeALeaf) {
+    // Extents whose bucket scale or offsets overflow a float: one too small
+    // (a denormal) and one too large.
+    const float extents[][2] = { { 0.f, 3e-39f }, { -3e38f, 3e38f } };
+
+    for (int i = 0; i < 2; ++i) {
+        std::vector<std::shared_ptr<Primitive> > prims;
+
+        for (int j = 0; j < 2; ++j)
+            prims.push_back (std::make_shared<TestSphere> (
+                    Point (extents[i][j], 0, 0), 0.f));
+
+        BVHAccel bvh (prims);
+
+        EXPECT_EQ (1, bvh.TotalNodes());
+        EXPECT_EQ (2u, bvh.Primitives().size());
+    }
+}
+
+
+TEST_F(BVHTest, UnsplittableNodesTooBigForALeafAreSplit) {
+    // A sphere with an infinite surface area makes every SAH cost NaN, so
+    // the SAH finds no split for the more than kMaxLeafPrimitives spheres.
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (69999,
+                                                                    19);
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 0), 1e38f));
+
+    BVHAccel bvh (prims);
+    const LinearBVHNode *nodes = bvh.Nodes();
+    int nLeafPrimitives = 0;
+
+    for (int i = 0; i < bvh.TotalNodes(); ++i)
+        nLeafPrimitives += nodes[i].nPrimitives;
+
+    EXPECT_LT (1, bvh.TotalNodes());
+    EXPECT_EQ (70000, nLeafPrimitives);
+}
+
+
+TEST_F(BVHTest, ParallelBuildMatchesSerialBuild) {
+    // Big enough that both the parallel binning and the subtree tasks
+    // kick in.
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (150000, 7);
+    TaskScheduler scheduler (4);
+    BVHBuildOptions parallelOptions;
+    parallelOptions.scheduler = &scheduler;
+
+    BVHAccel serial (prims);
+    BVHAccel parallel (prims, parallelOptions);
+
+    EXPECT_EQ (serial.TotalNodes(), parallel.TotalNodes());
+    EXPECT_EQ (serial.WorldBound().pMin, parallel.WorldBound().pMin);
+    EXPECT_EQ (serial.WorldBound().pMax, parallel.WorldBound().pMax);
+
+    std::mt19937 rng (8);
+
+    for (int i = 0; i < 200; ++i) {
+        Ray r1 = RandomRay (rng);
+        Ray r2 = r1;
+        Intersection i1, i2;
+
+        ASSERT_EQ (serial.Intersect (r1, &i1), parallel.Intersect (r2, &i2));
+        EXPECT_EQ (i1.primitive, i2.primitive);
+    }
+}
+
+
+// LBVH Tests
+static BVHBuildOptions LBVHOptions (int mortonBits, bool sahTreeletTop) {
+    BVHBuildOptions options;
+    options.splitMethod = BVHBuildOptions::SplitLBVH;
+    options.mortonBits = mortonBits;
+    options.sahTreeletTop = sahTreeletTop;
+    return options;
+}
+
+TEST_F(BVHTest, LBVHFindsTheClosestHit) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (2000, 9);
+
+    for (int bits = 30; bits <= 63; bits += 33) {
+        for (int top = 0; top < 2; ++top) {
+            BVHAccel bvh (prims, LBVHOptions (bits, top != 0));
+            std::mt19937 rng (10);
+
+            for (int i = 0; i < 300; ++i) {
+                Ray r = RandomRay (rng);
+                Ray rBrute = r;
+                Intersection isect, isectBrute;
+
+                bool hit = bvh.Intersect (r, &isect);
+                bool hitBrute = BruteForceIntersect (prims, rBrute,
+                                                     &isectBrute);
+
+                ASSERT_EQ (hitBrute, hit);
+                if (hit) {
+                    EXPECT_EQ (isectBrute.primitive, isect.primitive);
+                    EXPECT_FLOAT_EQ (isectBrute.tHit, isect.tHit);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(BVHTest, LBVHIntersectPMatchesIntersect) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (1000, 11);
+    BVHAccel bvh (prims, LBVHOptions (30, true));
+    std::mt19937 rng (12);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        r.maxt = 12.f;
+        Intersection isect;
+
+        bool occluded = bvh.IntersectP (r);
+
+        EXPECT_EQ (bvh.Intersect (r, &isect), occluded);
+    }
+}
+
+TEST_F(BVHTest, LBVHKeepsEveryPrimitive) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (500, 13);
+    BVHBuildOptions options = LBVHOptions (63, false);
+    options.maxPrimsInNode = 1;
+
+    BVHAccel bvh (prims, options);
+    BBox bounds = bvh.WorldBound();
+
+    // Distinct centroids and one primitive per leaf give a full binary tree.
+    EXPECT_EQ (2 * 500 - 1, bvh.TotalNodes());
+
+    for (size_t i = 0; i < prims.size(); ++i) {
+        BBox b = prims[i]->WorldBound();
+        EXPECT_TRUE (bounds.Inside (b.pMin));
+        EXPECT_TRUE (bounds.Inside (b.pMax));
+    }
+}
+
+TEST_F(BVHTest, LBVHCoincidentCentroidsMakeALeaf) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+
+    for (int i = 0; i < 10; ++i)
+        prims.push_back (std::make_shared<TestSphere> (Point (1, 2, 3),
+                                                       .1f * (i + 1)));
+
+    BVHAccel bvh (prims, LBVHOptions (30, true));
+    Ray r (Point (1, 2, -5), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_EQ (1, bvh.TotalNodes());
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (7.f, isect.tHit);
+}
+
+TEST_F(BVHTest, ParallelLBVHMatchesSerialLBVH) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (150000, 14);
+    TaskScheduler scheduler (4);
+    BVHBuildOptions serialOptions = LBVHOptions (30, true);
+    BVHBuildOptions parallelOptions = serialOptions;
+    parallelOptions.scheduler = &scheduler;
+
+    BVHAccel serial (prims, serialOptions);
+    BVHAccel parallel (prims, parallelOptions);
+
+    EXPECT_EQ (serial.TotalNodes(), parallel.TotalNodes());
+
+    std::mt19937 rng (15);
+
+    for (int i = 0; i < 200; ++i) {
+        Ray r1 = RandomRay (rng);
+        Ray r2 = r1;
+        Intersection i1, i2;
+
+        ASSERT_EQ (serial.Intersect (r1, &i1), parallel.Intersect (r2, &i2));
+        EXPECT_EQ (i1.primitive, i2.primitive);
+    }
+}
+
+
+// Layout Tests
+TEST_F(BVHTest, FlatLayoutMatchesPointerLayout) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (5000, 16);
+    BVHBuildOptions pointerOptions;
+    pointerOptions.flattenTree = false;
+
+    BVHAccel flat (prims);
+    BVHAccel pointer (prims, pointerOptions);
+
+    EXPECT_EQ (pointer.TotalNodes(), flat.TotalNodes());
+    EXPECT_EQ (pointer.WorldBound().pMin, flat.WorldBound().pMin);
+    EXPECT_EQ (pointer.WorldBound().pMax, flat.WorldBound().pMax);
+
+    std::mt19937 rng (17);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r1 = RandomRay (rng);
+        Ray r2 = r1;
+        Intersection i1, i2;
+
+        // Same tree, same order: the walks should be identical.
+        EXPECT_EQ (pointer.NodeVisits (r1), flat.NodeVisits (r1));
+        EXPECT_EQ (pointer.IntersectP (r1), flat.IntersectP (r1));
+
+        ASSERT_EQ (pointer.Intersect (r1, &i1), flat.Intersect (r2, &i2));
+        EXPECT_EQ (i1.primitive, i2.primitive);
+        EXPECT_EQ (r1.maxt, r2.maxt);
+    }
+}
+
+TEST_F(BVHTest, NodeVisitsLeavesTheRayAlone) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (200, 18);
+    BVHAccel bvh (prims);
+    Ray r (Point (-20, 0, 0), Vector (1, 0, 0));
+
+    EXPECT_LE (1, bvh.NodeVisits (r));
+    EXPECT_EQ (INFINITY, r.maxt);
+}
+
+TEST_F(BVHTest, HugeCoincidentRunsAreSplit) {
+    // More coincident primitives than a flattened leaf can hold.
+    std::shared_ptr<Primitive> sphere =
+            std::make_shared<TestSphere> (Point (0, 0, 0), 1.f);
+    std::vector<std::shared_ptr<Primitive> > prims (70000, sphere);
+
+    for (int lbvh = 0; lbvh < 2; ++lbvh) {
+        BVHBuildOptions options;
+        if (lbvh)
+            options.splitMethod = BVHBuildOptions::SplitLBVH;
+
+        BVHAccel bvh (prims, options);
+        Ray r (Point (0, 0, -5), Vector (0, 0, 1));
+        Intersection isect;
+
+        EXPECT_EQ (3, bvh.TotalNodes());
+        EXPECT_TRUE (bvh.Intersect (r, &isect));
+        EXPECT_FLOAT_EQ (4.f, isect.tHit);
+    }
+}
+
+
+// The number of interior nodes above the deepest leaf under nodes[i].
+static int TreeDepth (const LinearBVHNode *nodes, int i) {
+    if (nodes[i].nPrimitives > 0)
+        return 0;
+
+    return 1 + max (TreeDepth (nodes, i + 1),
+                    TreeDepth (nodes, nodes[i].secondChildOffset));
+}
+
+TEST_F(BVHTest, SkewedScenesStayShallowEnoughToTraverse) {
+    // Spheres halving in size and distance towards the origin along each
+    // axis; the SAH peels only a few off per level and, unchecked, builds
+    // a tree deeper than 80 levels.
+    std::vector<std::shared_ptr<Primitive> > prims;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int e = 40; e >= -120; --e) {
+            Point p (0, 0, 0);
+            p[axis] = ldexpf (1.f, e);
+            prims.push_back (std::make_shared<TestSphere> (p,
+                                                           p[axis] * .25f));
+        }
+    }
+
+    BVHAccel bvh (prims);
+    std::mt19937 rng (17);
+
+    EXPECT_GT (kMaxTraversalDepth, TreeDepth (bvh.Nodes(), 0));
+
+    for (int i = 0; i < 200; ++i) {
+        Ray r = RandomRay (rng);
+        Ray bruteRay = r;
+        Intersection isect, bruteIsect;
+
+        bool hit = bvh.Intersect (r, &isect);
+        ASSERT_EQ (BruteForceIntersect (prims, bruteRay, &bruteIsect), hit);
+
+        if (hit) {
+            EXPECT_EQ (bruteIsect.tHit, isect.tHit);
+        }
+    }
+}
+
+TEST_F(BVHTest, LBVHLongCodeChainsStayShallowEnoughToTraverse) {
+    // Points whose 63 bit Morton codes are 1 << j, for every j, so that
+    // each level of the LBVH splits off one of them, ending at a
+    // coincident run too big for one leaf; unchecked, 65 levels.
+    std::vector<std::shared_ptr<Primitive> > prims (
+            2 * 65536, std::make_shared<TestSphere> (Point (0, 0, 0), 1.f));
+
+    prims.push_back (std::make_shared<TestSphere> (Point (1, 1, 1), 0.f));
+
+    for (int j = 0; j < 63; ++j) {
+        Point p (0, 0, 0);
+        p[j % 3] = ldexpf (1.f, j / 3 - 21);
+        prims.push_back (std::make_shared<TestSphere> (p, 0.f));
+    }
+
+    BVHAccel bvh (prims, LBVHOptions (63, false));
+    Ray r (Point (0, 0, -5), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_GT (kMaxTraversalDepth, TreeDepth (bvh.Nodes(), 0));
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (4.f, isect.tHit);
+}
+
+
+// Refit Tests
+
+// Move every sphere of prims by up to maxOffset along each axis.
+static void JitterSpheres (const std::vector<std::shared_ptr<Primitive> >
+                               &prims, float maxOffset, unsigned seed) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> u (-maxOffset, maxOffset);
+
+    for (size_t i = 0; i < prims.size(); ++i) {
+        TestSphere *sphere = static_cast<TestSphere*> (prims[i].get());
+        sphere->center += Vector (u (rng), u (rng), u (rng));
+    }
+}
+
+TEST_F(BVHTest, RefitTracksMovedPrimitives) {
+    for (int flat = 0; flat < 2; ++flat) {
+        std::vector<std::shared_ptr<Primitive> > prims =
+                RandomSpheres (2000, 30);
+        BVHBuildOptions options;
+        options.flattenTree = flat != 0;
+
+        BVHAccel bvh (prims, options);
+        int nodes = bvh.TotalNodes();
+
+        JitterSpheres (prims, 2.f, 31);
+        bvh.Refit();
+
+        BBox bounds;
+        for (size_t i = 0; i < prims.size(); ++i)
+            bounds = Union (bounds, prims[i]->WorldBound());
+
+        EXPECT_EQ (nodes, bvh.TotalNodes());
+        EXPECT_EQ (bounds.pMin, bvh.WorldBound().pMin);
+        EXPECT_EQ (bounds.pMax, bvh.WorldBound().pMax);
+
+        std::mt19937 rng (32);
+
+        for (int i = 0; i < 500; ++i) {
+            Ray r1 = RandomRay (rng);
+            Ray r2 = r1;
+            Intersection i1, i2;
+
+            bool hit = BruteForceIntersect (prims, r2, &i2);
+
+            ASSERT_EQ (hit, bvh.Intersect (r1, &i1));
+            EXPECT_EQ (hit, bvh.IntersectP (Ray (r1.o, r1.d, 0.f)));
+            EXPECT_EQ (i2.primitive, i1.primitive);
+        }
+    }
+}
+
+TEST_F(BVHTest, ParallelRefitMatchesSerialRefit) {
+    // Enough nodes for the subtrees to be refitted as separate tasks.
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (60000, 33);
+    TaskScheduler scheduler (4);
+    BVHBuildOptions parallelOptions;
+    parallelOptions.scheduler = &scheduler;
+
+    BVHAccel serial (prims);
+    BVHAccel parallel (prims, parallelOptions);
+
+    JitterSpheres (prims, .5f, 34);
+    serial.Refit();
+    parallel.Refit();
+
+    ASSERT_EQ (serial.TotalNodes(), parallel.TotalNodes());
+    for (int i = 0; i < serial.TotalNodes(); ++i) {
+        ASSERT_EQ (serial.Nodes()[i].bounds.pMin,
+                   parallel.Nodes()[i].bounds.pMin);
+        ASSERT_EQ (serial.Nodes()[i].bounds.pMax,
+                   parallel.Nodes()[i].bounds.pMax);
+    }
+}
+
+TEST_F(BVHTest, RefitWithoutMotionKeepsTheCost) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (1000, 35);
+    BVHAccel bvh (prims);
+    float cost = bvh.SAHCost();
+
+    EXPECT_GT (cost, 1.f);
+    EXPECT_EQ (cost, bvh.BuildSAHCost());
+
+    EXPECT_FALSE (bvh.Update());
+    EXPECT_EQ (cost, bvh.SAHCost());
+}
+
+TEST_F(BVHTest, UpdateRebuildsDegradedTrees) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (3000, 36);
+    BVHAccel bvh (prims);
+
+    // Small motion only refits.
+    JitterSpheres (prims, .05f, 37);
+    EXPECT_FALSE (bvh.Update());
+
+    // Swapping the spheres' places wrecks the tree's spatial coherence.
+    std::mt19937 rng (38);
+    std::vector<Point> centers;
+    for (size_t i = 0; i < prims.size(); ++i)
+        centers.push_back (static_cast<TestSphere*> (prims[i].get())->center);
+    std::shuffle (centers.begin(), centers.end(), rng);
+    for (size_t i = 0; i < prims.size(); ++i)
+        static_cast<TestSphere*> (prims[i].get())->center = centers[i];
+
+    float freshCost = BVHAccel (prims).SAHCost();
+
+    EXPECT_TRUE (bvh.Update());
+    EXPECT_EQ (bvh.SAHCost(), bvh.BuildSAHCost());
+    EXPECT_NEAR (freshCost, bvh.SAHCost(), freshCost * .05f);
+
+    std::mt19937 rayRng (39);
+    for (int i = 0; i < 200; ++i) {
+        Ray r1 = RandomRay (rayRng);
+        Ray r2 = r1;
+        Intersection i1, i2;
+
+        ASSERT_EQ (BruteForceIntersect (prims, r2, &i2),
+                   bvh.Intersect (r1, &i1));
+        EXPECT_EQ (i2.primitive, i1.primitive);
+    }
+}
+
+
+// Shadow Ray Tests
+
+// Whether any of prims blocks the ray, the slow way.
+static bool BruteForceIntersectP (
+        const std::vector<std::shared_ptr<Primitive> > &prims,
+        const Ray &ray) {
+    for (size_t i = 0; i < prims.size(); ++i) {
+        if (prims[i]->IntersectP (ray))
+            return true;
+    }
+
+    return false;
+}
+
+TEST_F(BVHTest, IntersectPMatchesBruteForceInBothLayouts) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (1500, 42);
+    BVHBuildOptions pointerOptions;
+    pointerOptions.flattenTree = false;
+
+    BVHAccel flat (prims);
+    BVHAccel pointer (prims, pointerOptions);
+    std::mt19937 rng (43);
+    int nOccluded = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        Ray r = RandomRay (rng);
+        r.maxt = 2.f + 3.f * (i % 7);
+
+        bool occluded = BruteForceIntersectP (prims, r);
+
+        ASSERT_EQ (occluded, flat.IntersectP (r));
+        ASSERT_EQ (occluded, pointer.IntersectP (r));
+        EXPECT_EQ (r.maxt, 2.f + 3.f * (i % 7));
+        nOccluded += occluded;
+    }
+
+    // Both answers should be well represented.
+    EXPECT_GT (nOccluded, 100);
+    EXPECT_LT (nOccluded, 900);
+}
+
+TEST_F(BVHTest, OccludedTestsEverySegment) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (1000, 44);
+    BVHAccel bvh (prims);
+    std::mt19937 rng (45);
+    std::uniform_real_distribution<float> u (-12.f, 12.f);
+
+    std::vector<Point> from, to;
+    for (int i = 0; i < 300; ++i) {
+        from.push_back (Point (u (rng), u (rng), u (rng)));
+        to.push_back (Point (u (rng), u (rng), u (rng)));
+    }
+
+    // A segment of zero length is never blocked.
+    to[5] = from[5];
+
+    bool occluded[300];
+    int nOccluded = bvh.Occluded (&from[0], &to[0], 300, occluded);
+    int expected = 0;
+
+    for (int i = 0; i < 300; ++i) {
+        float dist = Distance (from[i], to[i]);
+        bool blocked = i != 5 &&
+                       BruteForceIntersectP (prims,
+                               Ray (from[i], (to[i] - from[i]) / dist, 0.f,
+                                    dist * (1.f - SHADOW_EPSILON)));
+
+        EXPECT_EQ (blocked, occluded[i]);
+        expected += blocked;
+    }
+
+    EXPECT_FALSE (occluded[5]);
+    EXPECT_EQ (expected, nOccluded);
+    EXPECT_GT (nOccluded, 0);
+}
+
+TEST_F(BVHTest, OccludedStopsShortOfTheTarget) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 0), 1.f));
+    BVHAccel bvh (prims);
+
+    // Segments ending on the sphere (a light sample on its surface) or in
+    // front of it are clear; one passing through it is not.
+    Point from[3] = { Point (-5, 0, 0), Point (-5, 0, 0), Point (-5, 0, 0) };
+    Point to[3] = { Point (-1, 0, 0), Point (-2, 0, 0), Point (5, 0, 0) };
+    bool occluded[3];
+
+    EXPECT_EQ (1, bvh.Occluded (from, to, 3, occluded));
+    EXPECT_FALSE (occluded[0]);
+    EXPECT_FALSE (occluded[1]);
+    EXPECT_TRUE (occluded[2]);
+}
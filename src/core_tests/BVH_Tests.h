@@ -0,0 +1,164 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: BVH_Tests.h
+ *
+ *  Purpose: Hold the test class for the BVHAccel class.
+ *
+ *  Creation Date: 17-10-2026
+ */
+
+#include <random>
+
+#include "bvh.h"
+#include "parallel.h"
+#include "gtest/gtest.h"
+
+
+////////////////////
+// Class: TestSphere
+//
+// Purpose:
+//      A minimal analytic sphere so that the BVH can be tested without
+//      depending on any particular shape.
+////////////////////
+class TestSphere : public Primitive {
+    public:
+        TestSphere (const Point &c, float r) : center(c), radius(r) { }
+
+        BBox WorldBound() const {
+            return BBox (center - Vector (radius, radius, radius),
+                         center + Vector (radius, radius, radius));
+        }
+
+        bool Intersect (const Ray &ray, Intersection *isect) const {
+            float t;
+            if (!Hit (ray, &t))
+                return false;
+
+            ray.maxt = t;
+            isect->tHit = t;
+            isect->p = ray (t);
+            isect->n = Normal (Normalize (isect->p - center));
+            isect->primitive = this;
+            return true;
+        }
+
+        bool IntersectP (const Ray &ray) const {
+            float t;
+            return Hit (ray, &t);
+        }
+
+        Point center;
+        float radius;
+
+    private:
+        bool Hit (const Ray &ray, float *tHit) const {
+            Vector oc = ray.o - center;
+            float a = Dot (ray.d, ray.d);
+            float b = 2.f * Dot (oc, ray.d);
+            float c = Dot (oc, oc) - radius * radius;
+            float disc = b * b - 4.f * a * c;
+
+            if (disc < 0.f)
+                return false;
+
+            float root = sqrtf (disc);
+            float t0 = (-b - root) / (2.f * a);
+            float t1 = (-b + root) / (2.f * a);
+
+            if (t0 >= ray.mint && t0 <= ray.maxt)
+                *tHit = t0;
+            else if (t1 >= ray.mint && t1 <= ray.maxt)
+                *tHit = t1;
+            else
+                return false;
+
+            return true;
+        }
+};
+
+
+// Scatter n random spheres through the [-10, 10]^3 cube.
+inline std::vector<std::shared_ptr<Primitive> > RandomSpheres (int n,
+                                                               unsigned seed) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> pos (-10.f, 10.f);
+    std::uniform_real_distribution<float> rad (.05f, .5f);
+    std::vector<std::shared_ptr<Primitive> > prims;
+
+    for (int i = 0; i < n; ++i)
+        prims.push_back (std::make_shared<TestSphere> (
+                Point (pos (rng), pos (rng), pos (rng)), rad (rng)));
+
+    return prims;
+}
+
+// Find the closest hit the slow way.
+inline bool BruteForceIntersect (
+        const std::vector<std::shared_ptr<Primitive> > &prims,
+        const Ray &ray, Intersection *isect) {
+    bool hit = false;
+
+    for (size_t i = 0; i < prims.size(); ++i)
+        hit |= prims[i]->Intersect (ray, isect);
+
+    return hit;
+}
+
+// A random ray starting somewhere around the sphere cloud.
+inline Ray RandomRay (std::mt19937 &rng) {
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+
+    Point o (15.f * u (rng), 15.f * u (rng), 15.f * u (rng));
+    Point target (8.f * u (rng), 8.f * u (rng), 8.f * u (rng));
+
+    return Ray (o, Normalize (target - o), 0.f);
+}
+
+class BVHTest : public ::testing::Test {
+ protected:
+  // You can remove any or all of the following functions if its body
+  // is empty.
+
+  BVHTest() {
+    // You can do set-up work for each test here.
+  }
+
+  virtual ~BVHTest() {
+    // You can do clean-up work that doesn't throw exceptions here.
+  }
+
+  // If the constructor and destructor are not enough for setting up
+  // and cleaning up each test, you can define the following methods:
+
+  virtual void SetUp() {
+    // Code here will be called immediately after the constructor (right
+    // before each test).
+  }
+
+  virtual void TearDown() {
+    // Code here will be called immediately after each test (right
+    // before the destructor).
+  }
+
+  // Objects declared here can be used by all tests in the test case for Foo.
+};
@@ -0,0 +1,92 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Camera_Tests.cpp
+ *
+ *  Purpose: Test the rays the perspective camera generates.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "Camera_Tests.h"
+
+
+static PerspectiveCamera LookAtCamera (float fov, int xRes, int yRes) {
+    return PerspectiveCamera (Inverse (LookAt (Point (1, 2, 3),
+                                               Point (1, 2, 13),
+                                               Vector (0, 1, 0))),
+                              fov, xRes, yRes);
+}
+
+
+TEST_F(CameraTest, CenterRayLooksAtTarget) {
+    PerspectiveCamera camera = LookAtCamera (60.f, 64, 48);
+    Ray r = camera.GenerateRay (32.f, 24.f);
+
+    EXPECT_FLOAT_EQ (1.f, r.o.x);
+    EXPECT_FLOAT_EQ (2.f, r.o.y);
+    EXPECT_FLOAT_EQ (3.f, r.o.z);
+    EXPECT_NEAR (0.f, r.d.x, 1e-6f);
+    EXPECT_NEAR (0.f, r.d.y, 1e-6f);
+    EXPECT_FLOAT_EQ (1.f, r.d.z);
+    EXPECT_EQ (0.f, r.mint);
+}
+
+TEST_F(CameraTest, DirectionsAreNormalized) {
+    PerspectiveCamera camera = LookAtCamera (90.f, 16, 16);
+
+    for (int y = 0; y <= 16; y += 4) {
+        for (int x = 0; x <= 16; x += 4)
+            EXPECT_FLOAT_EQ (1.f, camera.GenerateRay (x, y).d.Length());
+    }
+}
+
+TEST_F(CameraTest, FieldOfViewSpansTheShorterAxis) {
+    // Wide image: the field of view is vertical.
+    PerspectiveCamera wide = LookAtCamera (90.f, 200, 100);
+    Ray top = wide.GenerateRay (100.f, 0.f);
+    EXPECT_NEAR (45.f, Degrees (acosf (top.d.z)), 1e-3f);
+    EXPECT_GT (top.d.y, 0.f);
+
+    // Tall image: it's horizontal.
+    PerspectiveCamera tall = LookAtCamera (90.f, 100, 200);
+    Ray left = tall.GenerateRay (0.f, 100.f);
+    EXPECT_NEAR (45.f, Degrees (acosf (left.d.z)), 1e-3f);
+}
+
+TEST_F(CameraTest, RasterAxesFollowTheImage) {
+    PerspectiveCamera camera = LookAtCamera (60.f, 64, 64);
+    Ray topLeft = camera.GenerateRay (0.f, 0.f);
+    Ray bottomRight = camera.GenerateRay (64.f, 64.f);
+
+    // y increases downwards in raster space.
+    EXPECT_GT (topLeft.d.y, 0.f);
+    EXPECT_LT (bottomRight.d.y, 0.f);
+    EXPECT_FLOAT_EQ (-topLeft.d.x, bottomRight.d.x);
+}
+
+TEST_F(CameraTest, TimeIsPassedThrough) {
+    PerspectiveCamera camera = LookAtCamera (60.f, 8, 8);
+
+    EXPECT_EQ (.25f, camera.GenerateRay (4.f, 4.f, .25f).time);
+}
@@ -0,0 +1,256 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Film_Tests.cpp
+ *
+ *  Purpose: Test the film's pixel storage and image output.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Film_Tests.h"
+
+
+// Read a whole file into a string; empty if it can't be read.
+static std::string ReadFile (const std::string &filename) {
+    std::string contents;
+    FILE *f = fopen (filename.c_str(), "rb");
+
+    if (f) {
+        char buf[4096];
+        size_t n;
+
+        while ((n = fread (buf, 1, sizeof (buf), f)) > 0)
+            contents.append (buf, n);
+        fclose (f);
+    }
+
+    return contents;
+}
+
+
+TEST_F(FilmTest, PixelsStartBlack) {
+    Film film (5, 3);
+
+    for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            EXPECT_EQ (0.f, film.GetPixel (x, y)[0]);
+            EXPECT_EQ (0.f, film.GetPixel (x, y)[1]);
+            EXPECT_EQ (0.f, film.GetPixel (x, y)[2]);
+        }
+    }
+}
+
+TEST_F(FilmTest, SetPixelOnlyChangesThatPixel) {
+    Film film (5, 3);
+    const float rgb[3] = { .25f, .5f, .75f };
+
+    film.SetPixel (3, 1, rgb);
+
+    EXPECT_EQ (.25f, film.GetPixel (3, 1)[0]);
+    EXPECT_EQ (.5f, film.GetPixel (3, 1)[1]);
+    EXPECT_EQ (.75f, film.GetPixel (3, 1)[2]);
+    EXPECT_EQ (0.f, film.GetPixel (2, 1)[2]);
+    EXPECT_EQ (0.f, film.GetPixel (4, 1)[0]);
+    EXPECT_EQ (0.f, film.GetPixel (3, 0)[0]);
+    EXPECT_EQ (0.f, film.GetPixel (3, 2)[0]);
+}
+
+TEST_F(FilmTest, WritesSRGBPPM) {
+    Film film (2, 1);
+    const float black[3] = { 0.f, 0.f, 0.f };
+    const float white[3] = { 1.f, 2.f, .5f };
+
+    film.SetPixel (0, 0, black);
+    film.SetPixel (1, 0, white);
+
+    const std::string filename = "Film_Tests_WritesSRGBPPM.ppm";
+    ASSERT_TRUE (film.WriteImage (filename));
+
+    std::string header = "P6\n2 1\n255\n";
+    std::string contents = ReadFile (filename);
+    remove (filename.c_str());
+
+    ASSERT_EQ (header.size() + 6, contents.size());
+    EXPECT_EQ (header, contents.substr (0, header.size()));
+
+    const unsigned char *p =
+            (const unsigned char*) contents.data() + header.size();
+    EXPECT_EQ (0, p[0]);
+    EXPECT_EQ (0, p[2]);
+    EXPECT_EQ (255, p[3]);
+    EXPECT_EQ (255, p[4]);      // Clamped
+    EXPECT_EQ (188, p[5]);      // sRGB encoded .5
+}
+
+TEST_F(FilmTest, WritesPFMBottomRowFirst) {
+    Film film (1, 2);
+    const float top[3] = { 1.f, 2.f, 3.f };
+    const float bottom[3] = { 4.f, 5.f, 6.f };
+
+    film.SetPixel (0, 0, top);
+    film.SetPixel (0, 1, bottom);
+
+    const std::string filename = "Film_Tests_WritesPFMBottomRowFirst.pfm";
+    ASSERT_TRUE (film.WriteImage (filename));
+
+    std::string header = "PF\n1 2\n-1\n";
+    std::string contents = ReadFile (filename);
+    remove (filename.c_str());
+
+    ASSERT_EQ (header.size() + 6 * sizeof (float), contents.size());
+    EXPECT_EQ (header, contents.substr (0, header.size()));
+
+    float data[6];
+    memcpy (data, contents.data() + header.size(), sizeof (data));
+    EXPECT_EQ (4.f, data[0]);
+    EXPECT_EQ (6.f, data[2]);
+    EXPECT_EQ (1.f, data[3]);
+    EXPECT_EQ (3.f, data[5]);
+}
+
+TEST_F(FilmTest, WriteImageFailsForBadPath) {
+    Film film (1, 1);
+
+    EXPECT_FALSE (film.WriteImage ("no/such/directory/image.ppm"));
+}
+
+TEST_F(FilmTest, FiltersVanishAtTheirEdges) {
+    TriangleFilter triangle (2.f, 1.f);
+    GaussianFilter gaussian (1.5f, 1.5f, 2.f);
+
+    EXPECT_EQ (1.f, BoxFilter (.5f, .5f).Evaluate (.4f, -.3f));
+    EXPECT_FLOAT_EQ (2.f, triangle.Evaluate (0.f, 0.f));
+    EXPECT_FLOAT_EQ (.5f, triangle.Evaluate (1.f, .5f));
+    EXPECT_EQ (0.f, triangle.Evaluate (2.f, 0.f));
+    EXPECT_GT (gaussian.Evaluate (0.f, 0.f), gaussian.Evaluate (.5f, 0.f));
+    EXPECT_EQ (0.f, gaussian.Evaluate (1.5f, 0.f));
+    EXPECT_FLOAT_EQ (gaussian.Evaluate (.7f, .2f),
+                     gaussian.Evaluate (-.7f, -.2f));
+}
+
+TEST_F(FilmTest, TilesReachAsFarAsTheFilter) {
+    Film box (64, 64);
+    Film wide (64, 64, std::make_shared<GaussianFilter> (2.f, 1.f, 2.f));
+    int x0, y0, x1, y1;
+
+    box.BeginTiles (1);
+    box.GetFilmTile (0, 16, 16, 32, 32)->PixelBounds (&x0, &y0, &x1, &y1);
+    EXPECT_EQ (15, x0);
+    EXPECT_EQ (15, y0);
+    EXPECT_EQ (32, x1);
+    EXPECT_EQ (32, y1);
+
+    wide.BeginTiles (2);
+    wide.GetFilmTile (0, 16, 16, 32, 32)->PixelBounds (&x0, &y0, &x1, &y1);
+    EXPECT_EQ (14, x0);
+    EXPECT_EQ (15, y0);
+    EXPECT_EQ (34, x1);
+    EXPECT_EQ (33, y1);
+
+    // Clipped to the image.
+    wide.GetFilmTile (1, 0, 0, 8, 8)->PixelBounds (&x0, &y0, &x1, &y1);
+    EXPECT_EQ (0, x0);
+    EXPECT_EQ (0, y0);
+}
+
+TEST_F(FilmTest, BoxFilterAveragesEachPixelsSamples) {
+    Film film (2, 1);
+    const float a[3] = { 1.f, 2.f, 3.f }, b[3] = { 3.f, 4.f, 5.f };
+
+    film.BeginTiles (1);
+    FilmTile *tile = film.GetFilmTile (0, 0, 0, 2, 1);
+    tile->AddSample (.25f, .5f, a);
+    tile->AddSample (.75f, .25f, b);
+    tile->AddSample (1.5f, .5f, b);
+    film.MergeTiles (NULL);
+
+    EXPECT_EQ (2.f, film.GetPixel (0, 0)[0]);
+    EXPECT_EQ (4.f, film.GetPixel (0, 0)[2]);
+    EXPECT_EQ (3.f, film.GetPixel (1, 0)[0]);
+    EXPECT_EQ (5.f, film.GetPixel (1, 0)[2]);
+}
+
+TEST_F(FilmTest, SamplesSpillIntoNeighboringTiles) {
+    Film film (4, 1, std::make_shared<TriangleFilter> (1.5f, .5f));
+    const float white[3] = { 1.f, 1.f, 1.f };
+    const float black[3] = { 0.f, 0.f, 0.f };
+
+    // A white sample in the middle of the left tile, a black one in the
+    // middle of the right. Pixels 1 and 2 see both.
+    film.BeginTiles (2);
+    film.GetFilmTile (0, 0, 0, 2, 1)->AddSample (1.f, .5f, white);
+    film.GetFilmTile (1, 2, 0, 4, 1)->AddSample (3.f, .5f, black);
+    film.MergeTiles (NULL);
+
+    EXPECT_EQ (1.f, film.GetPixel (0, 0)[0]);
+    EXPECT_GT (film.GetPixel (1, 0)[0], .5f);
+    EXPECT_LT (film.GetPixel (1, 0)[0], 1.f);
+    EXPECT_GT (film.GetPixel (2, 0)[0], 0.f);
+    EXPECT_LT (film.GetPixel (2, 0)[0], .5f);
+    EXPECT_EQ (0.f, film.GetPixel (3, 0)[0]);
+}
+
+TEST_F(FilmTest, MergeDoesNotDependOnFillOrderOrThreads) {
+    const int nx = 6, ny = 4, size = 8;
+    std::shared_ptr<const Filter> filter =
+            std::make_shared<GaussianFilter> (2.f, 2.f, 1.f);
+    Film reference (nx * size, ny * size, filter);
+    Film film (nx * size, ny * size, filter);
+    TaskScheduler scheduler (3);
+
+    // Fill the tiles of one film front to back on one thread and the
+    // other's back to front on three.
+    for (int f = 0; f < 2; ++f) {
+        Film &target = f == 0 ? reference : film;
+
+        target.BeginTiles (nx * ny);
+
+        ParallelFor (f == 0 ? NULL : &scheduler, 0, nx * ny, 1,
+                     [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                int t = f == 0 ? int (i) : nx * ny - 1 - int (i);
+                int x0 = (t % nx) * size, y0 = (t / nx) * size;
+                FilmTile *tile = target.GetFilmTile (t, x0, y0, x0 + size,
+                                                     y0 + size);
+                RNG rng (t);
+
+                for (int s = 0; s < 4 * size * size; ++s) {
+                    float rgb[3] = { rng.UniformFloat(), rng.UniformFloat(),
+                                     rng.UniformFloat() };
+
+                    tile->AddSample (x0 + size * rng.UniformFloat(),
+                                     y0 + size * rng.UniformFloat(), rgb);
+                }
+            }
+        });
+
+        target.MergeTiles (f == 0 ? NULL : &scheduler);
+    }
+
+    EXPECT_EQ (0, memcmp (reference.GetPixel (0, 0), film.GetPixel (0, 0),
+                          3 * sizeof (float) * nx * ny * size * size));
+}
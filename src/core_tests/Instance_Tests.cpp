@@ -0,0 +1,273 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Instance_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the instancing primitives.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "Instance_Tests.h"
+
+
+// Results are compared between an instance and the same mesh baked into
+// world space, which round differently.
+static const float kTolerance = 1e-4f;
+
+static Transform SomeTransform() {
+    return Translate (Vector (5.f, -3.f, 2.f)) *
+           Rotate (50.f, Normalize (Vector (1, -1, 2))) * Scale (1, 2, 3);
+}
+
+
+TEST_F(InstanceTest, WorldBoundIsTransformed) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            RandomTriangles (100, 1));
+    Transform objectToWorld = Translate (Vector (10, 20, 30)) *
+                              Scale (2, 2, 2);
+    TransformedPrimitive instance (blas, objectToWorld);
+    BBox b = blas->WorldBound();
+
+    EXPECT_EQ (objectToWorld (b.pMin), instance.WorldBound().pMin);
+    EXPECT_EQ (objectToWorld (b.pMax), instance.WorldBound().pMax);
+    EXPECT_EQ (blas, instance.GetPrimitive());
+    EXPECT_EQ (objectToWorld.GetMatrix(),
+               instance.ObjectToWorld().GetMatrix());
+}
+
+TEST_F(InstanceTest, HitsMatchBakedGeometry) {
+    std::shared_ptr<TriangleMesh> mesh = RandomTriangleMesh (300, 2);
+    std::shared_ptr<TriangleMesh> baked = RandomTriangleMesh (
+            300, 2, SomeTransform());
+    TransformedPrimitive instance (std::make_shared<BVHAccel> (
+            TriangleMesh::CreateTriangles (mesh)), SomeTransform());
+    BVHAccel bakedBVH (TriangleMesh::CreateTriangles (baked));
+    std::mt19937 rng (3);
+    int hits = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        Ray r = RandomRay (rng);
+        r.o = r.o * 2.f;
+        Ray rBaked = r;
+        Intersection isect, isectBaked;
+
+        bool hit = instance.Intersect (r, &isect);
+        bool hitBaked = bakedBVH.Intersect (rBaked, &isectBaked);
+
+        ASSERT_EQ (hitBaked, hit);
+        EXPECT_EQ (hit, instance.IntersectP (Ray (r.o, r.d, 0.f)));
+        if (!hit)
+            continue;
+        ++hits;
+
+        // The same triangle, at the same place, facing the same way.
+        EXPECT_EQ (static_cast<const Triangle*> (isectBaked.primitive)
+                           ->Index(),
+                   static_cast<const Triangle*> (isect.primitive)->Index());
+        EXPECT_NEAR (isectBaked.tHit, isect.tHit, kTolerance * isect.tHit);
+        EXPECT_EQ (isect.tHit, r.maxt);
+        EXPECT_NEAR (1.f, Dot (isectBaked.n, isect.n), kTolerance);
+
+        for (int axis = 0; axis < 3; ++axis)
+            EXPECT_NEAR (isectBaked.p[axis], isect.p[axis],
+                         kTolerance * (1.f + fabsf (isect.p[axis])));
+    }
+
+    EXPECT_GT (hits, 100);
+}
+
+TEST_F(InstanceTest, TopLevelBVHFindsTheClosestInstance) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            RandomTriangles (500, 4));
+    std::mt19937 rng (5);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<std::shared_ptr<Primitive> > instances;
+
+    for (int i = 0; i < 200; ++i) {
+        Transform objectToWorld =
+                Translate (Vector (100.f * u (rng), 100.f * u (rng),
+                                   100.f * u (rng))) *
+                Rotate (180.f * u (rng), Normalize (Vector (u (rng), u (rng),
+                                                            u (rng) + 2.f))) *
+                Scale (.5f + u (rng) * .25f, .5f, .5f);
+
+        instances.push_back (std::make_shared<TransformedPrimitive> (
+                blas, objectToWorld));
+    }
+
+    BVHAccel tlas (instances);
+    BVH4Accel tlas4 (tlas);
+    int hits = 0;
+
+    for (int i = 0; i < 500; ++i) {
+        Point o (150.f * u (rng), 150.f * u (rng), 150.f * u (rng));
+        Point target (100.f * u (rng), 100.f * u (rng), 100.f * u (rng));
+        Ray r (o, Normalize (target - o), 0.f);
+        Ray r4 = r, rBrute = r;
+        Intersection isect, isect4, isectBrute;
+
+        bool hitBrute = BruteForceIntersect (instances, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, tlas.Intersect (r, &isect));
+        ASSERT_EQ (hitBrute, tlas4.Intersect (r4, &isect4));
+        EXPECT_EQ (hitBrute, tlas.IntersectP (Ray (o, r.d, 0.f)));
+
+        if (hitBrute) {
+            ++hits;
+            EXPECT_EQ (isectBrute.tHit, isect.tHit);
+            EXPECT_EQ (isectBrute.tHit, isect4.tHit);
+            EXPECT_EQ (isectBrute.p, isect.p);
+        }
+    }
+
+    EXPECT_GT (hits, 20);
+}
+
+TEST_F(InstanceTest, InstancesShareTheirGeometry) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            RandomTriangles (1000, 6));
+    std::vector<std::shared_ptr<Primitive> > instances;
+
+    for (int i = 0; i < 1000; ++i)
+        instances.push_back (std::make_shared<TransformedPrimitive> (
+                blas, Translate (Vector (float (i), 0, 0))));
+
+    EXPECT_EQ (1001, blas.use_count());
+
+    // An instance costs a transform, a pointer and a box, independent of
+    // the size of what it instances.
+    EXPECT_LE (sizeof (TransformedPrimitive),
+               sizeof (Transform) + sizeof (blas) + sizeof (BBox) + 32);
+}
+
+TEST_F(InstanceTest, SpawnedRaysDontHitTheirOwnSurface) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            TriangleMesh::CreateTriangles (Grid (4, Transform())));
+    Transform objectToWorld = Translate (Vector (3000.f, 700.f, -1500.f)) *
+                              Rotate (40.f, Vector (0, 1, 1)) *
+                              Scale (7.f, 3.f, 1.f);
+    TransformedPrimitive instance (blas, objectToWorld);
+    std::mt19937 rng (7);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    BBox bounds = instance.WorldBound();
+    int hits = 0, selfHits = 0;
+
+    for (int i = 0; i < 2000; ++i) {
+        Point target = bounds.pMin + (bounds.pMax - bounds.pMin) *
+                                     ((u (rng) + 1.f) * .5f);
+        Point o = target + Vector (50.f * u (rng), 50.f * u (rng),
+                                   50.f * u (rng));
+        Ray r (o, target - o, 0.f);
+        Intersection isect;
+
+        if (!instance.Intersect (r, &isect))
+            continue;
+        ++hits;
+
+        Vector d = Normalize (r.d);
+        Vector n (isect.n);
+        Vector reflected = d - n * (2.f * Dot (d, n));
+
+        selfHits += instance.IntersectP (isect.SpawnRay (reflected));
+        selfHits += instance.IntersectP (isect.SpawnRay (-d));
+        selfHits += instance.IntersectP (isect.SpawnRay (d));
+        selfHits += instance.IntersectP (isect.SpawnRayTo (o));
+    }
+
+    EXPECT_GT (hits, 500);
+    EXPECT_EQ (0, selfHits);
+}
+
+TEST_F(InstanceTest, AnimatedInstanceMovesWithRayTime) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            TriangleMesh::CreateTriangles (Grid (1, Transform())));
+    AnimatedPrimitive instance (blas, AnimatedTransform (
+            Translate (Vector (0, 0, 0)), 0.f,
+            Translate (Vector (10, 0, 0)), 1.f));
+    Intersection isect;
+
+    // The unit square sweeps from [0, 1] to [10, 11] along x.
+    EXPECT_LE (instance.WorldBound().pMin.x, 0.f);
+    EXPECT_GE (instance.WorldBound().pMax.x, 11.f);
+
+    Ray atStart (Point (.5f, .5f, 1.f), Vector (0, 0, -1), 0.f, INFINITY, 0.f);
+    EXPECT_TRUE (instance.Intersect (atStart, &isect));
+    EXPECT_NEAR (1.f, isect.tHit, kTolerance);
+
+    Ray atEnd (Point (.5f, .5f, 1.f), Vector (0, 0, -1), 0.f, INFINITY, 1.f);
+    EXPECT_FALSE (instance.IntersectP (atEnd));
+
+    Ray midway (Point (5.5f, .5f, 1.f), Vector (0, 0, -1), 0.f, INFINITY, .5f);
+    EXPECT_TRUE (instance.Intersect (midway, &isect));
+    EXPECT_NEAR (5.5f, isect.p.x, kTolerance);
+    EXPECT_NEAR (1.f, isect.n.z * isect.n.z, kTolerance);
+}
+
+TEST_F(InstanceTest, TopLevelBVHFindsMovingInstancesAtAnyTime) {
+    std::shared_ptr<Primitive> blas = std::make_shared<BVHAccel> (
+            RandomTriangles (300, 8));
+    std::mt19937 rng (9);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    std::vector<std::shared_ptr<Primitive> > instances;
+
+    for (int i = 0; i < 100; ++i) {
+        Vector p (100.f * u (rng), 100.f * u (rng), 100.f * u (rng));
+        Vector axis (u (rng), u (rng), u (rng) + 2.f);
+        Transform t0 = Translate (p) * Rotate (180.f * u (rng), axis) *
+                       Scale (.5f, .5f, .5f);
+        Transform t1 = Translate (p + Vector (20.f * u (rng), 20.f * u (rng),
+                                              0.f)) *
+                       Rotate (180.f * u (rng), axis) * Scale (.5f, .5f, .5f);
+
+        instances.push_back (std::make_shared<AnimatedPrimitive> (
+                blas, AnimatedTransform (t0, 0.f, t1, 1.f)));
+    }
+
+    BVHAccel tlas (instances);
+    BVH4Accel tlas4 (tlas);
+    int hits = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        Point o (150.f * u (rng), 150.f * u (rng), 150.f * u (rng));
+        Point target (100.f * u (rng), 100.f * u (rng), 100.f * u (rng));
+        Ray r (o, Normalize (target - o), 0.f, INFINITY, (u (rng) + 1.f) * .5f);
+        Ray r4 = r, rBrute = r;
+        Intersection isect, isect4, isectBrute;
+
+        bool hitBrute = BruteForceIntersect (instances, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, tlas.Intersect (r, &isect));
+        ASSERT_EQ (hitBrute, tlas4.Intersect (r4, &isect4));
+        EXPECT_EQ (hitBrute, tlas.IntersectP (Ray (o, r.d, 0.f, INFINITY,
+                                                   r.time)));
+
+        if (hitBrute) {
+            ++hits;
+            EXPECT_EQ (isectBrute.tHit, isect.tHit);
+            EXPECT_EQ (isectBrute.tHit, isect4.tHit);
+        }
+    }
+
+    EXPECT_GT (hits, 20);
+}
@@ -237,3 +237,86 @@ TEST_F(Matrix4x4Test, TransposeWorks) {
     EXPECT_EQ (0, m2.m[3][2]);
     EXPECT_EQ (0, m2.m[3][3]);
 }
+
+TEST_F(Matrix4x4Test, InverseOfIdentityIsIdentity) {
+    Matrix4x4 m;
+
+    EXPECT_TRUE (Inverse (m) == m);
+}
+
+TEST_F(Matrix4x4Test, InverseWorks) {
+    Matrix4x4 m (2, 0, 0, 1,
+                 0, 0, 4, 2,
+                 0, 1, 0, 3,
+                 0, 0, 0, 1);
+
+    Matrix4x4 r = Matrix4x4::Mul (m, Inverse (m));
+
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (i == j ? 1.f : 0.f, r.m[i][j], 1e-6f);
+}
+
+TEST_F(Matrix4x4Test, InverseOfGeneralMatrixWorks) {
+    Matrix4x4 m (4, 7, 2, 3,
+                 3, 6, 1, 0,
+                 2, 5, 3, 1,
+                 1, 0, 2, 8);
+
+    Matrix4x4 r = Matrix4x4::Mul (Inverse (m), m);
+
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (i == j ? 1.f : 0.f, r.m[i][j], 1e-5f);
+}
+
+TEST_F(Matrix4x4Test, IsAffineWorks) {
+    Matrix4x4 affine (1, 2, 3, 4,
+                      5, 6, 7, 8,
+                      9, 1, 2, 3,
+                      0, 0, 0, 1);
+    Matrix4x4 projective (1, 0, 0, 0,
+                          0, 1, 0, 0,
+                          0, 0, 1, 0,
+                          0, 0, 1, 0);
+
+    EXPECT_TRUE (affine.IsAffine());
+    EXPECT_FALSE (projective.IsAffine());
+}
+
+TEST_F(Matrix4x4Test, AffineInverseWorks) {
+    Matrix4x4 m (0, -2, 0, 5,
+                 3, 0, 0, -1,
+                 0, 1, 4, 2,
+                 0, 0, 0, 1);
+
+    Matrix4x4 r = Matrix4x4::Mul (AffineInverse (m), m);
+
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (i == j ? 1.f : 0.f, r.m[i][j], 1e-6f);
+
+    EXPECT_TRUE (AffineInverse (m).IsAffine());
+}
+
+TEST_F(Matrix4x4Test, InverseOfProjectiveMatrixWorks) {
+    Matrix4x4 m (1, 0, 0, 0,
+                 0, 1, 0, 0,
+                 0, 0, 2, -1,
+                 0, 0, 1, 0);
+
+    Matrix4x4 r = Matrix4x4::Mul (m, Inverse (m));
+
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (i == j ? 1.f : 0.f, r.m[i][j], 1e-6f);
+}
+
+TEST_F(Matrix4x4Test, InverseOfSingularMatrixIsIdentity) {
+    Matrix4x4 m (1, 2, 3, 4,
+                 2, 4, 6, 8,
+                 0, 0, 1, 0,
+                 1, 0, 0, 1);
+
+    EXPECT_TRUE (Inverse (m) == Matrix4x4 ());
+}
@@ -0,0 +1,140 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Memory_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the memory management functions.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "Geometry.h"
+#include "Memory_Tests.h"
+
+
+TEST_F(MemoryTest, AllocAlignedStartsOnACacheLine) {
+    for (size_t size = 1; size < 4096; size = size * 3 + 1) {
+        void *p = AllocAligned (size);
+
+        ASSERT_TRUE (p != NULL);
+        EXPECT_EQ (0u, uintptr_t (p) % PB_RAY_L1_CACHE_LINE_SIZE);
+
+        FreeAligned (p);
+    }
+}
+
+TEST_F(MemoryTest, AllocAlignedArrayIsWritable) {
+    double *d = AllocAligned<double> (1000);
+
+    ASSERT_TRUE (d != NULL);
+    EXPECT_EQ (0u, uintptr_t (d) % PB_RAY_L1_CACHE_LINE_SIZE);
+
+    for (int i = 0; i < 1000; ++i)
+        d[i] = i;
+    EXPECT_EQ (999., d[999]);
+
+    FreeAligned (d);
+}
+
+TEST_F(MemoryTest, FreeAlignedAcceptsNull) {
+    FreeAligned (NULL);
+}
+
+TEST_F(MemoryTest, ArenaAllocationsAreAlignedAndDisjoint) {
+    MemoryArena arena (1024);
+    char *prev = NULL;
+    size_t prevSize = 0;
+
+    for (size_t size = 1; size < 300; size += 37) {
+        char *p = static_cast<char*> (arena.Alloc (size));
+
+        ASSERT_TRUE (p != NULL);
+        EXPECT_EQ (0u, uintptr_t (p) % 16);
+        memset (p, 0xAB, size);
+
+        // Either later in the same block or in a different one.
+        if (prev) {
+            EXPECT_TRUE (p >= prev + prevSize || p + size <= prev);
+        }
+
+        prev = p;
+        prevSize = size;
+    }
+
+    EXPECT_EQ (0u, uintptr_t (arena.Alloc (8, 64)) % 64);
+    EXPECT_EQ (0u, uintptr_t (arena.Alloc<CompactRay> (3)) % 32);
+}
+
+TEST_F(MemoryTest, ArenaConstructsObjects) {
+    MemoryArena arena;
+    Point *p = arena.Alloc<Point> (100);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ (0.f, p[i].x);
+        EXPECT_EQ (0.f, p[i].z);
+    }
+}
+
+TEST_F(MemoryTest, ArenaGrowsForLargeAllocations) {
+    MemoryArena arena (1024);
+    float *big = arena.Alloc<float> (10000);
+
+    big[9999] = 1.f;
+    EXPECT_GE (arena.TotalAllocated(), 10000 * sizeof (float));
+}
+
+TEST_F(MemoryTest, ArenaThrowsWhenOutOfMemory) {
+    MemoryArena arena (1024);
+    float *small = arena.Alloc<float> (10);
+
+    // More than any address space can hold.
+    EXPECT_THROW (arena.Alloc (size_t (1) << 62), std::bad_alloc);
+
+    // The arena still works after the failure.
+    float *after = arena.Alloc<float> (10);
+
+    after[9] = 1.f;
+    EXPECT_NE (small, after);
+}
+
+TEST_F(MemoryTest, FreeAllReusesTheBlocks) {
+    MemoryArena arena (4096);
+
+    for (int i = 0; i < 10; ++i)
+        arena.Alloc (1000);
+
+    size_t total = arena.TotalAllocated();
+
+    // After the first round the arena has all the memory it needs.
+    for (int round = 0; round < 5; ++round) {
+        arena.FreeAll();
+
+        for (int i = 0; i < 10; ++i)
+            arena.Alloc (1000);
+
+        EXPECT_EQ (total, arena.TotalAllocated());
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Morton_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the Morton code functions.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <random>
+
+#include "Morton_Tests.h"
+
+
+// Interleave the low nBits bits of x, y and z one bit at a time.
+static uint64_t NaiveMorton (uint64_t x, uint64_t y, uint64_t z, int nBits) {
+    uint64_t code = 0;
+
+    for (int i = 0; i < nBits; ++i) {
+        code |= ((x >> i) & 1) << (3 * i);
+        code |= ((y >> i) & 1) << (3 * i + 1);
+        code |= ((z >> i) & 1) << (3 * i + 2);
+    }
+
+    return code;
+}
+
+
+TEST_F(MortonTest, LeftShift3SpreadsTheBits) {
+    EXPECT_EQ (0u, LeftShift3 (0u));
+    EXPECT_EQ (1u, LeftShift3 (1u));
+    EXPECT_EQ (9u, LeftShift3 (3u));
+    EXPECT_EQ (0x09249249u, LeftShift3 (0x3FFu));
+
+    EXPECT_EQ (0x1249249249249249ull, LeftShift3 (uint64_t (0x1FFFFF)));
+}
+
+TEST_F(MortonTest, EachAxisHasItsOwnBit) {
+    EXPECT_EQ (1u, EncodeMorton3 (1u, 0u, 0u));
+    EXPECT_EQ (2u, EncodeMorton3 (0u, 1u, 0u));
+    EXPECT_EQ (4u, EncodeMorton3 (0u, 0u, 1u));
+    EXPECT_EQ ((1u << 30) - 1, EncodeMorton3 (0x3FFu, 0x3FFu, 0x3FFu));
+
+    EXPECT_EQ ((uint64_t (1) << 63) - 1,
+               EncodeMorton3 (uint64_t (0x1FFFFF), uint64_t (0x1FFFFF),
+                              uint64_t (0x1FFFFF)));
+}
+
+TEST_F(MortonTest, EncodeMatchesBitByBitInterleave) {
+    std::mt19937 rng (1);
+
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t x = rng() & 0x3FF, y = rng() & 0x3FF, z = rng() & 0x3FF;
+        EXPECT_EQ (NaiveMorton (x, y, z, 10), EncodeMorton3 (x, y, z));
+
+        uint64_t X = rng() & 0x1FFFFF, Y = rng() & 0x1FFFFF,
+                 Z = rng() & 0x1FFFFF;
+        EXPECT_EQ (NaiveMorton (X, Y, Z, 21), EncodeMorton3 (X, Y, Z));
+    }
+}
+
+TEST_F(MortonTest, Encode2MatchesBitByBitInterleave) {
+    std::mt19937 rng (2);
+
+    EXPECT_EQ (1u, EncodeMorton2 (1u, 0u));
+    EXPECT_EQ (2u, EncodeMorton2 (0u, 1u));
+    EXPECT_EQ (0xFFFFFFFFu, EncodeMorton2 (0xFFFFu, 0xFFFFu));
+
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t x = rng() & 0xFFFF, y = rng() & 0xFFFF;
+        uint32_t code = 0;
+
+        for (int b = 0; b < 16; ++b)
+            code |= (((x >> b) & 1) << (2 * b)) |
+                    (((y >> b) & 1) << (2 * b + 1));
+
+        EXPECT_EQ (code, EncodeMorton2 (x, y));
+    }
+}
+
+TEST_F(MortonTest, Log2IntFindsTheHighestBit) {
+    EXPECT_EQ (0, Log2Int (1));
+    EXPECT_EQ (1, Log2Int (3));
+    EXPECT_EQ (10, Log2Int (1024));
+    EXPECT_EQ (10, Log2Int (2047));
+    EXPECT_EQ (63, Log2Int (~uint64_t (0)));
+}
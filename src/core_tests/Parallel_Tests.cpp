@@ -0,0 +1,271 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Parallel_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the TaskScheduler and ParallelFor.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "Parallel_Tests.h"
+
+
+TEST_F(ParallelTest, DefaultSchedulerUsesAllHardwareThreads) {
+    TaskScheduler scheduler;
+
+    EXPECT_EQ (std::max (1, int (std::thread::hardware_concurrency())),
+               scheduler.NumThreads());
+}
+
+
+TEST_F(ParallelTest, SpawnedTasksAllRunBeforeWaitReturns) {
+    TaskScheduler scheduler (4);
+    TaskGroup group;
+    std::atomic<int> count (0);
+
+    for (int i = 0; i < 1000; ++i)
+        scheduler.Spawn (group, [&count]() { count.fetch_add (1); });
+
+    scheduler.Wait (group);
+
+    EXPECT_TRUE (group.Done());
+    EXPECT_EQ (1000, count.load());
+}
+
+
+// Recursive fork / join, the way the BVH builder uses the scheduler.
+static int64_t ParallelSum (TaskScheduler &scheduler, int64_t begin,
+                            int64_t end) {
+    if (end - begin <= 1000) {
+        int64_t sum = 0;
+        for (int64_t i = begin; i < end; ++i)
+            sum += i;
+        return sum;
+    }
+
+    int64_t mid = (begin + end) / 2;
+    int64_t left = 0;
+    TaskGroup group;
+
+    scheduler.Spawn (group, [&]() { left = ParallelSum (scheduler, begin, mid); });
+    int64_t right = ParallelSum (scheduler, mid, end);
+    scheduler.Wait (group);
+
+    return left + right;
+}
+
+TEST_F(ParallelTest, NestedSpawnAndWaitWorks) {
+    TaskScheduler scheduler (4);
+
+    EXPECT_EQ (int64_t (999999) * 1000000 / 2,
+               ParallelSum (scheduler, 0, 1000000));
+}
+
+
+TEST_F(ParallelTest, ParallelForVisitsEveryIndexOnce) {
+    TaskScheduler scheduler (4);
+    std::vector<int> visits (10007, 0);
+
+    ParallelFor (&scheduler, 0, int64_t (visits.size()), 64,
+                 [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i)
+            visits[i]++;
+    });
+
+    for (size_t i = 0; i < visits.size(); ++i)
+        ASSERT_EQ (1, visits[i]);
+}
+
+
+TEST_F(ParallelTest, ParallelForWithoutSchedulerRunsInline) {
+    int calls = 0;
+
+    ParallelFor (NULL, 5, 100, 10, [&](int64_t begin, int64_t end) {
+        EXPECT_EQ (5, begin);
+        EXPECT_EQ (100, end);
+        calls++;
+    });
+
+    EXPECT_EQ (1, calls);
+}
+
+
+TEST_F(ParallelTest, ThreadIndexIsZeroOutsideThePool) {
+    TaskScheduler scheduler (2);
+
+    EXPECT_EQ (0, scheduler.ThreadIndex());
+}
+
+
+TEST_F(ParallelTest, DequeOwnerPopsNewestThievesStealOldest) {
+    WorkStealingDeque<int> deque (2);
+    int items[5] = { 0, 1, 2, 3, 4 };
+
+    EXPECT_TRUE (deque.Pop() == NULL);
+    EXPECT_TRUE (deque.Steal() == NULL);
+
+    // Pushing past the capacity grows the buffer.
+    for (int i = 0; i < 5; ++i)
+        deque.Push (&items[i]);
+    EXPECT_EQ (5, deque.Size());
+
+    EXPECT_EQ (&items[4], deque.Pop());
+    EXPECT_EQ (&items[0], deque.Steal());
+    EXPECT_EQ (&items[1], deque.Steal());
+    EXPECT_EQ (&items[3], deque.Pop());
+    EXPECT_EQ (&items[2], deque.Pop());
+    EXPECT_TRUE (deque.Pop() == NULL);
+    EXPECT_TRUE (deque.Steal() == NULL);
+    EXPECT_EQ (0, deque.Size());
+}
+
+
+TEST_F(ParallelTest, DequeHandsOutEveryItemOnceUnderContention) {
+    const int nItems = 200000, nThieves = 3;
+    std::vector<int> items (nItems);
+    std::vector<std::atomic<int> > taken (nItems);
+    WorkStealingDeque<int> deque (16);
+    std::atomic<bool> done (false);
+    std::vector<std::thread> thieves;
+
+    for (int i = 0; i < nItems; ++i) {
+        items[i] = i;
+        taken[i] = 0;
+    }
+
+    for (int t = 0; t < nThieves; ++t) {
+        thieves.push_back (std::thread ([&]() {
+            while (!done.load()) {
+                if (int *item = deque.Steal())
+                    taken[*item].fetch_add (1);
+            }
+        }));
+    }
+
+    // The owner pushes in bursts and pops some back, so it races the
+    // thieves for the last item again and again.
+    for (int i = 0; i < nItems; ) {
+        for (int j = 0; j < 7 && i < nItems; ++j)
+            deque.Push (&items[i++]);
+
+        for (int j = 0; j < 3; ++j) {
+            if (int *item = deque.Pop())
+                taken[*item].fetch_add (1);
+        }
+    }
+
+    while (int *item = deque.Pop())
+        taken[*item].fetch_add (1);
+
+    done = true;
+    for (size_t t = 0; t < thieves.size(); ++t)
+        thieves[t].join();
+
+    for (int i = 0; i < nItems; ++i)
+        ASSERT_EQ (1, taken[i].load()) << "item " << i;
+}
+
+
+TEST_F(ParallelTest, ParallelFor2DCoversTheRangeInTiles) {
+    TaskScheduler scheduler (4);
+    std::vector<std::atomic<int> > visits (37 * 23);
+
+    for (size_t i = 0; i < visits.size(); ++i)
+        visits[i] = 0;
+
+    ParallelFor2D (&scheduler, 3, 2, 40, 25, 8,
+                   [&](int x0, int y0, int x1, int y1) {
+        EXPECT_LE (x1 - x0, 8);
+        EXPECT_LE (y1 - y0, 8);
+        EXPECT_EQ (0, (x0 - 3) % 8);
+        EXPECT_EQ (0, (y0 - 2) % 8);
+
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x)
+                visits[(y - 2) * 37 + (x - 3)].fetch_add (1);
+        }
+    });
+
+    for (size_t i = 0; i < visits.size(); ++i)
+        ASSERT_EQ (1, visits[i].load());
+}
+
+
+TEST_F(ParallelTest, ParallelReduceIsDeterministic) {
+    std::vector<float> values (100003);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = 1.f / (1.f + i);
+
+    auto sum = [&](int64_t begin, int64_t end) {
+        float s = 0.f;
+        for (int64_t i = begin; i < end; ++i)
+            s += values[i];
+        return s;
+    };
+    auto add = [](float a, float b) { return a + b; };
+
+    float serial = ParallelReduce (NULL, 0, int64_t (values.size()), 1000,
+                                   0.f, sum, add);
+
+    for (int threads = 1; threads <= 4; ++threads) {
+        TaskScheduler scheduler (threads);
+
+        EXPECT_EQ (serial, ParallelReduce (&scheduler, 0,
+                                           int64_t (values.size()), 1000,
+                                           0.f, sum, add));
+    }
+
+    EXPECT_NEAR (12.09, serial, .01);
+    EXPECT_EQ (7, ParallelReduce (NULL, 5, 5, 10, 7, sum, add));
+}
+
+
+TEST_F(ParallelTest, SharedSchedulerIsOnePool) {
+    TaskScheduler *shared = TaskScheduler::Shared();
+
+    EXPECT_EQ (shared, TaskScheduler::Shared (3));
+    EXPECT_GE (shared->NumThreads(), 1);
+}
+
+
+TEST_F(ParallelTest, TasksSpawnedFromWorkersRunOnTheirDeques) {
+    TaskScheduler scheduler (4);
+    TaskGroup outer;
+    std::atomic<int> count (0);
+
+    // Each outer task runs on a worker (or the waiting thread) and
+    // spawns its own children.
+    for (int i = 0; i < 16; ++i) {
+        scheduler.Spawn (outer, [&]() {
+            TaskGroup inner;
+
+            for (int j = 0; j < 100; ++j)
+                scheduler.Spawn (inner, [&]() { count.fetch_add (1); });
+            scheduler.Wait (inner);
+        });
+    }
+
+    scheduler.Wait (outer);
+    EXPECT_EQ (1600, count.load());
+}
@@ -115,6 +115,17 @@ TEST_F(PointTest, OperatorPlusReturningPointWorksWithNegativeValues) {
     EXPECT_EQ (-1, p3.z);
 }
 
+TEST_F(PointTest, OperatorPlusReturningPointAddsEachComponent) {
+    Point p1 (1, 2, 3);
+    Point p2 (10, 20, 30);
+
+    Point p3 = p1 + p2;
+
+    EXPECT_EQ (11, p3.x);
+    EXPECT_EQ (22, p3.y);
+    EXPECT_EQ (33, p3.z);
+}
+
 TEST_F(PointTest, OperatorPlusEqualsReturningPointWorksWithPositiveValues) {
     Point p1; // 0, 0, 0
     Point p2 (1, 1, 1);
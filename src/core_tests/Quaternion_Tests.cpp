@@ -0,0 +1,109 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Quaternion_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the Quaternion class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "Quaternion_Tests.h"
+
+
+static const float kTolerance = 1e-5f;
+
+static void ExpectMatrixNear (const Matrix4x4 &expected,
+                              const Matrix4x4 &actual) {
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR (expected.m[i][j], actual.m[i][j], kTolerance)
+                    << "entry " << i << ", " << j;
+}
+
+// q and -q are the same rotation.
+static void ExpectSameRotation (const Quaternion &expected,
+                                const Quaternion &actual) {
+    EXPECT_NEAR (1.f, fabsf (Dot (expected, actual)), kTolerance);
+}
+
+
+TEST_F(QuaternionTest, DefaultIsIdentity) {
+    EXPECT_TRUE (Quaternion().ToTransform().IsIdentity());
+}
+
+TEST_F(QuaternionTest, MatchesAxisAngle) {
+    Quaternion q (RotateZ (90.f));
+    float h = sqrtf (.5f);
+
+    ExpectSameRotation (Quaternion (Vector (0.f, 0.f, h), h), q);
+}
+
+TEST_F(QuaternionTest, RoundTripsRotations) {
+    // Angles near 180 degrees take the branch of the matrix conversion
+    // that doesn't divide by w.
+    const float angles[] = { 0.f, 10.f, 90.f, 135.f, 179.f, 180.f, -100.f };
+    const Vector axes[] = { Vector (1, 0, 0), Vector (0, 1, 0),
+                            Vector (0, 0, 1), Vector (1, -2, 3) };
+
+    for (float angle : angles) {
+        for (const Vector &axis : axes) {
+            Transform r = Rotate (angle, axis);
+            Quaternion q (r);
+
+            EXPECT_NEAR (1.f, Dot (q, q), kTolerance);
+            ExpectMatrixNear (r.GetMatrix(), q.ToTransform().GetMatrix());
+        }
+    }
+}
+
+TEST_F(QuaternionTest, ToTransformInverseIsTranspose) {
+    Transform t = Quaternion (Rotate (70.f, Vector (1, 1, 0))).ToTransform();
+
+    ExpectMatrixNear (Matrix4x4(),
+                      Matrix4x4::Mul (t.GetMatrix(), t.GetInverseMatrix()));
+}
+
+TEST_F(QuaternionTest, SlerpInterpolatesTheAngle) {
+    Quaternion q0, q1 (RotateX (120.f));
+
+    ExpectSameRotation (q0, Slerp (0.f, q0, q1));
+    ExpectSameRotation (q1, Slerp (1.f, q0, q1));
+    ExpectSameRotation (Quaternion (RotateX (30.f)), Slerp (.25f, q0, q1));
+    ExpectSameRotation (Quaternion (RotateX (90.f)), Slerp (.75f, q0, q1));
+}
+
+TEST_F(QuaternionTest, SlerpTakesTheShortWay) {
+    Quaternion q0, q1 (RotateY (60.f));
+
+    ExpectSameRotation (Slerp (.5f, q0, q1), Slerp (.5f, q0, -q1));
+    ExpectSameRotation (Quaternion (RotateY (30.f)), Slerp (.5f, q0, -q1));
+}
+
+TEST_F(QuaternionTest, SlerpOfNearlyEqualRotationsIsUnit) {
+    Quaternion q0 (RotateZ (10.f)), q1 (RotateZ (10.01f));
+    Quaternion q = Slerp (.5f, q0, q1);
+
+    EXPECT_NEAR (1.f, Dot (q, q), kTolerance);
+    ExpectSameRotation (Quaternion (RotateZ (10.005f)), q);
+}
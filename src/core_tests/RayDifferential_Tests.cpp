@@ -75,3 +75,69 @@ TEST_F(RayDifferentialTest, ConstructorWithRayWorks) {
 
     EXPECT_EQ (false, rd.hasDifferentials);
 }
+
+
+// CompactRayDifferential Tests
+
+TEST_F(RayDifferentialTest, CompactFormFitsACacheLine) {
+    EXPECT_EQ (64u, sizeof (CompactRayDifferential));
+    EXPECT_LT (sizeof (CompactRayDifferential), sizeof (RayDifferential));
+}
+
+TEST_F(RayDifferentialTest, CompactConstructorsWork) {
+    CompactRayDifferential empty;
+    CompactRayDifferential fromRay (Ray (Point (1, 2, 3), Vector (0, 0, 1),
+                                         0.f, 5.f, .5f));
+
+    EXPECT_FALSE (empty.hasDifferentials);
+    EXPECT_FALSE (fromRay.hasDifferentials);
+    EXPECT_EQ (Point (1, 2, 3), fromRay.o);
+    EXPECT_EQ (5.f, fromRay.maxt);
+    EXPECT_EQ (.5f, fromRay.time);
+}
+
+TEST_F(RayDifferentialTest, CompactFormRoundTrips) {
+    RayDifferential rd (Point (1, 2, 3), Normalize (Vector (.1f, .2f, 1)));
+    rd.hasDifferentials = true;
+    rd.rx = Ray (rd.o + Vector (.01f, 0, 0), rd.d + Vector (.001f, 0, 0));
+    rd.ry = Ray (rd.o + Vector (0, .01f, 0), rd.d + Vector (0, .001f, 0));
+
+    CompactRayDifferential crd (rd);
+    RayDifferential back = crd.Expand();
+
+    ASSERT_TRUE (crd.hasDifferentials);
+    EXPECT_EQ (rd.o, crd.o);
+    EXPECT_EQ (rd.d, crd.d);
+    EXPECT_TRUE (back.hasDifferentials);
+
+    // Only the differences are stored in half precision.
+    EXPECT_NEAR (rd.rx.o.x, back.rx.o.x, 1e-5f);
+    EXPECT_NEAR (rd.ry.o.y, back.ry.o.y, 1e-5f);
+    EXPECT_NEAR (rd.rx.d.x, back.rx.d.x, 1e-6f);
+    EXPECT_NEAR (rd.ry.d.y, back.ry.d.y, 1e-6f);
+    EXPECT_EQ (rd.o.z, back.rx.o.z);
+    EXPECT_EQ (rd.d.z, back.ry.d.z);
+}
+
+TEST_F(RayDifferentialTest, CompactFormWithoutDifferentialsExpandsWithout) {
+    CompactRayDifferential crd (Point (0, 0, 0), Vector (0, 0, 1));
+
+    EXPECT_FALSE (crd.Expand().hasDifferentials);
+
+    // Scaling missing differentials leaves them missing.
+    crd.ScaleDifferentials (.5f);
+    EXPECT_FALSE (crd.hasDifferentials);
+}
+
+TEST_F(RayDifferentialTest, CompactScaleDifferentialsWorks) {
+    CompactRayDifferential crd (Point (0, 0, 0), Vector (0, 0, 1));
+    crd.SetDifferentials (Vector (1, 0, 0), Vector (0, 1, 0),
+                          Vector (.25f, 0, 0), Vector (0, .25f, 0));
+
+    crd.ScaleDifferentials (.5f);
+
+    EXPECT_EQ (Vector (.5f, 0, 0), crd.DpDx());
+    EXPECT_EQ (Vector (0, .5f, 0), crd.DpDy());
+    EXPECT_EQ (Point (.5f, 0, 0), crd.RayX().o);
+    EXPECT_EQ (Vector (0, .125f, 1), crd.RayY().d);
+}
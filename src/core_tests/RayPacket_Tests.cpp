@@ -0,0 +1,161 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: RayPacket_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the RayPacket classes.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "RayPacket_Tests.h"
+
+// Build a ray that differs per lane so that round trips can be checked.
+static Ray LaneRay (int i) {
+    return Ray (Point (float (i), 1, 2), Vector (1, float (-i), .5f),
+                .25f * i, 10.f + i, .1f * i);
+}
+
+
+// Tests that a new packet has no active lanes.
+TEST_F(RayPacketTest, ConstructorLeavesAllLanesInactive) {
+    RayPacket4 p;
+
+    EXPECT_EQ (0u, p.activeMask);
+    EXPECT_EQ (4, RayPacket4::Width());
+}
+
+
+TEST_F(RayPacketTest, SetRayGetRayRoundTrips) {
+    RayPacket8 p;
+
+    for (int i = 0; i < 8; ++i)
+        p.SetRay (i, LaneRay (i));
+
+    EXPECT_EQ (0xffu, p.activeMask);
+
+    for (int i = 0; i < 8; ++i) {
+        Ray expected = LaneRay (i);
+        Ray r = p.GetRay (i);
+
+        EXPECT_EQ (expected.o, r.o);
+        EXPECT_EQ (expected.d, r.d);
+        EXPECT_EQ (expected.mint, r.mint);
+        EXPECT_EQ (expected.maxt, r.maxt);
+        EXPECT_EQ (expected.time, r.time);
+    }
+}
+
+
+TEST_F(RayPacketTest, DeactivateClearsOnlyThatLane) {
+    RayPacket4 p;
+
+    for (int i = 0; i < 4; ++i)
+        p.SetRay (i, LaneRay (i));
+
+    p.Deactivate (2);
+
+    EXPECT_TRUE (p.IsActive (1));
+    EXPECT_FALSE (p.IsActive (2));
+    EXPECT_EQ (0xbu, p.activeMask);
+}
+
+
+TEST_F(RayPacketTest, OperatorFunctionApplicatorWorks) {
+    RayPacket4 p;
+    float t[4] = { 0, 1, 2, 3 };
+
+    for (int i = 0; i < 4; ++i)
+        p.SetRay (i, LaneRay (i));
+
+    PointPacket<4> pts = p (t);
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ (LaneRay (i)(t[i]), pts[i]);
+}
+
+
+TEST_F(RayPacketTest, RayDifferentialRoundTrips) {
+    RayDifferentialPacket<4> p;
+
+    RayDifferential withDiffs (Point (0, 0, 0), Vector (0, 0, 1));
+    withDiffs.hasDifferentials = true;
+    withDiffs.rx = Ray (Point (1, 0, 0), Vector (0, 0, 1));
+    withDiffs.ry = Ray (Point (0, 1, 0), Vector (0, 0, 1));
+
+    RayDifferential withoutDiffs (Point (5, 5, 5), Vector (1, 0, 0));
+
+    p.SetRay (0, withDiffs);
+    p.SetRay (1, withoutDiffs);
+
+    RayDifferential r0 = p.GetRayDifferential (0);
+    RayDifferential r1 = p.GetRayDifferential (1);
+
+    EXPECT_TRUE (r0.hasDifferentials);
+    EXPECT_EQ (withDiffs.rx.o, r0.rx.o);
+    EXPECT_EQ (withDiffs.ry.o, r0.ry.o);
+
+    EXPECT_FALSE (r1.hasDifferentials);
+    EXPECT_EQ (withoutDiffs.o, r1.o);
+    EXPECT_EQ (0x3u, p.activeMask);
+    EXPECT_EQ (0x1u, p.hasDifferentials);
+}
+
+
+TEST_F(RayPacketTest, IntersectPMatchesSingleRayTest) {
+    BBox b (Point (-1, -1, -1), Point (1, 1, 1));
+    RayPacket16 p;
+
+    for (int i = 0; i < 16; ++i) {
+        float a = float (i) * .4f;
+        p.SetRay (i, Ray (Point (3 * cosf (a), 3 * sinf (a), .2f * i - 1.5f),
+                          Vector (-cosf (a + .1f * i), -sinf (a), .1f)));
+    }
+
+    float t0[16];
+    uint32_t hits = IntersectP (b, p, t0);
+
+    for (int i = 0; i < 16; ++i) {
+        float expectedT0;
+        bool expected = b.IntersectP (p.GetRay (i), &expectedT0);
+
+        EXPECT_EQ (expected, (hits & (1u << i)) != 0);
+        if (expected) {
+            EXPECT_FLOAT_EQ (expectedT0, t0[i]);
+        }
+    }
+}
+
+
+TEST_F(RayPacketTest, IntersectPIgnoresInactiveLanes) {
+    BBox b (Point (-1, -1, -1), Point (1, 1, 1));
+    RayPacket4 p;
+
+    for (int i = 0; i < 4; ++i)
+        p.SetRay (i, Ray (Point (0, 0, -5), Vector (0, 0, 1)));
+
+    p.Deactivate (0);
+    p.Deactivate (3);
+
+    EXPECT_EQ (0x6u, IntersectP (b, p));
+}
@@ -28,6 +28,8 @@
  *  Last Modified: Wed 22 May 2013 05:31:33 PM PDT
  */
 
+#include <random>
+
 #include "Ray_Tests.h"
 
 
@@ -109,3 +111,94 @@ TEST_F(RayTest, OperatorFunctionApplicatorWorks) {
     EXPECT_EQ (4, p.y);
     EXPECT_EQ (6, p.z);
 }
+
+TEST_F(RayTest, OffsetRayOriginClearsTheErrorBox) {
+    Point p (1, 2, 3);
+    Vector pError (.5f, .25f, .125f);
+    Normal n (0, 0, 1);
+
+    // Out along the normal by exactly its error, then one float further.
+    Point above = OffsetRayOrigin (p, pError, n, Vector (1, 0, 1));
+    EXPECT_EQ (1.f, above.x);
+    EXPECT_EQ (2.f, above.y);
+    EXPECT_GT (above.z, 3.125f);
+
+    Point below = OffsetRayOrigin (p, pError, n, Vector (0, 1, -1));
+    EXPECT_LT (below.z, 2.875f);
+
+    // An exact point is left where it is.
+    Point exact = OffsetRayOrigin (p, Vector (0, 0, 0), n, Vector (0, 0, 1));
+    EXPECT_EQ (p, exact);
+}
+
+
+// CompactRay Tests
+
+TEST_F(RayTest, CompactRayIs32AlignedBytes) {
+    CompactRay rays[2];
+
+    EXPECT_EQ (32u, sizeof (CompactRay));
+    EXPECT_EQ (0u, reinterpret_cast<uintptr_t> (&rays[1]) % 32);
+}
+
+TEST_F(RayTest, CompactRayRoundTrips) {
+    Ray r (Point (1.5f, -2, 3), Vector (.1f, .2f, -.3f), 0.f, 42.f, .5f);
+    Ray back = CompactRay (r).ToRay();
+
+    EXPECT_EQ (r.o, back.o);
+    EXPECT_EQ (r.d, back.d);
+    EXPECT_EQ (0.f, back.mint);
+    EXPECT_EQ (42.f, back.maxt);
+    EXPECT_EQ (.5f, back.time);
+
+    // Defaults survive too.
+    Ray def = CompactRay (Ray()).ToRay();
+    EXPECT_EQ (INFINITY, def.maxt);
+    EXPECT_LE (def.mint, RAY_EPSILON);
+    EXPECT_NEAR (RAY_EPSILON, def.mint, RAY_EPSILON / 128.f);
+}
+
+TEST_F(RayTest, CompactRayNeverRaisesMint) {
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> u (0.f, 10.f);
+
+    for (int i = 0; i < 1000; ++i) {
+        Ray r (Point (0, 0, 0), Vector (0, 0, 1), u (rng) * u (rng) * .01f);
+        float mint = CompactRay (r).MinT();
+
+        // Seven bits of mantissa are kept.
+        EXPECT_LE (mint, r.mint);
+        EXPECT_NEAR (r.mint, mint, r.mint / 128.f);
+    }
+
+    // The float's whole range is kept.
+    EXPECT_NEAR (1e30f, CompactRay (Ray (Point(), Vector(), 1e30f)).MinT(),
+                 1e30f / 128.f);
+    EXPECT_EQ (0.f, CompactRay (Ray (Point(), Vector(), 0.f)).MinT());
+}
+
+TEST_F(RayTest, CompactRayTimeIsQuantized) {
+    for (int i = 0; i <= 100; ++i) {
+        Ray r (Point (), Vector (0, 1, 0), 0.f, INFINITY, i / 100.f);
+
+        EXPECT_NEAR (r.time, CompactRay (r).Time(), 5e-4f);
+    }
+}
+
+#ifdef PB_RAY_SSE
+TEST_F(RayTest, CompactRayLoadsOriginAndDirection) {
+    CompactRay r (Ray (Point (1, 2, 3), Vector (4, 5, 6), 0.f, 7.f));
+    alignas(16) float o[4], d[4];
+
+    _mm_store_ps (o, r.LoadOrigin());
+    _mm_store_ps (d, r.LoadDirection());
+
+    EXPECT_EQ (1.f, o[0]);
+    EXPECT_EQ (2.f, o[1]);
+    EXPECT_EQ (3.f, o[2]);
+    EXPECT_EQ (4.f, d[0]);
+    EXPECT_EQ (5.f, d[1]);
+    EXPECT_EQ (6.f, d[2]);
+    EXPECT_EQ (7.f, d[3]);
+}
+#endif
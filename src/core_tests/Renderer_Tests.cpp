@@ -0,0 +1,290 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Renderer_Tests.cpp
+ *
+ *  Purpose: Test the tile renderer and its random number generator.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Renderer_Tests.h"
+
+
+// A few spheres over a big one, lit from above, seen from the side.
+struct TestScene {
+    TestScene (int xRes, int yRes)
+            : camera (Inverse (LookAt (Point (0, 2, -25), Point (0, 0, 0),
+                                       Vector (0, 1, 0))),
+                      50.f, xRes, yRes) {
+        std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (50, 4);
+        prims.push_back (std::make_shared<TestSphere> (Point (0, -1010, 0),
+                                                       1000.f));
+
+        scene.reset (new Scene (std::make_shared<BVHAccel> (prims),
+                                PointLight (Point (0, 30, -10), 900.f, 900.f,
+                                            900.f)));
+    }
+
+    PerspectiveCamera camera;
+    std::unique_ptr<Scene> scene;
+};
+
+static bool SameImage (const Film &a, const Film &b) {
+    for (int y = 0; y < a.YResolution(); ++y) {
+        for (int x = 0; x < a.XResolution(); ++x) {
+            for (int c = 0; c < 3; ++c) {
+                if (a.GetPixel (x, y)[c] != b.GetPixel (x, y)[c])
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+TEST_F(RendererTest, RNGIsRepeatable) {
+    RNG a (7), b (7);
+
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ (a.UniformUInt32(), b.UniformUInt32());
+}
+
+TEST_F(RendererTest, RNGSequencesDiffer) {
+    RNG a (7), b (8);
+    int same = 0;
+
+    for (int i = 0; i < 100; ++i)
+        same += a.UniformUInt32() == b.UniformUInt32();
+
+    EXPECT_LT (same, 2);
+}
+
+TEST_F(RendererTest, RNGFloatsAreInUnitInterval) {
+    RNG rng (3);
+    double sum = 0.;
+
+    for (int i = 0; i < 10000; ++i) {
+        float u = rng.UniformFloat();
+
+        ASSERT_GE (u, 0.f);
+        ASSERT_LT (u, 1.f);
+        sum += u;
+    }
+
+    EXPECT_NEAR (.5, sum / 10000., .02);
+}
+
+TEST_F(RendererTest, TilesCoverTheImageOnce) {
+    TestScene s (37, 21);
+    RenderOptions options;
+    options.tileSize = 8;
+    TileRenderer renderer (*s.scene, s.camera, options);
+    std::vector<int> covered (37 * 21, 0);
+
+    EXPECT_EQ (5 * 3, renderer.NumTiles());
+
+    for (int tile = 0; tile < renderer.NumTiles(); ++tile) {
+        int x0, y0, x1, y1;
+        renderer.TileBounds (tile, &x0, &y0, &x1, &y1);
+
+        EXPECT_LT (x0, x1);
+        EXPECT_LT (y0, y1);
+        EXPECT_LE (x1 - x0, 8);
+        EXPECT_LE (y1 - y0, 8);
+
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x)
+                ++covered[y * 37 + x];
+        }
+    }
+
+    for (size_t i = 0; i < covered.size(); ++i)
+        EXPECT_EQ (1, covered[i]);
+}
+
+TEST_F(RendererTest, RenderCountsRays) {
+    TestScene s (16, 12);
+    RenderOptions options;
+    options.samplesPerPixel = 3;
+    TileRenderer renderer (*s.scene, s.camera, options);
+    Film film (16, 12);
+
+    RenderStats stats = renderer.Render (&film, NULL);
+
+    EXPECT_EQ (16 * 12 * 3, stats.cameraRays);
+    EXPECT_GT (stats.shadowRays, 0);
+    EXPECT_LE (stats.shadowRays, stats.cameraRays);
+}
+
+TEST_F(RendererTest, ImageDoesNotDependOnThreadsOrTiles) {
+    TestScene s (48, 32);
+    RenderOptions options;
+    options.samplesPerPixel = 2;
+
+    Film reference (48, 32);
+    options.tileSize = 32;
+    TileRenderer (*s.scene, s.camera, options).Render (&reference, NULL);
+
+    options.tileSize = 5;
+    for (int threads = 1; threads <= 4; ++threads) {
+        TaskScheduler scheduler (threads);
+        Film film (48, 32);
+
+        TileRenderer (*s.scene, s.camera, options).Render (&film, &scheduler);
+        EXPECT_TRUE (SameImage (reference, film)) << threads << " threads";
+    }
+}
+
+TEST_F(RendererTest, ImageShowsSceneAndSky) {
+    TestScene s (32, 32);
+    TileRenderer renderer (*s.scene, s.camera);
+    Film film (32, 32);
+
+    renderer.Render (&film, NULL);
+
+    // The top row sees the sky, which is bluer than it is red; the bottom
+    // row sees the lit ground, which is grey.
+    const float *sky = film.GetPixel (16, 0);
+    const float *ground = film.GetPixel (16, 31);
+
+    EXPECT_GT (sky[2], sky[0]);
+    EXPECT_GT (ground[0], 0.f);
+    EXPECT_FLOAT_EQ (ground[0], ground[2]);
+}
+
+TEST_F(RendererTest, EveryTileOrderHandsOutEveryTileOnce) {
+    TestScene s (100, 70);
+    RenderOptions options;
+    options.tileSize = 8;
+
+    for (int order = RenderOptions::TileScanline;
+         order <= RenderOptions::TileMorton; ++order) {
+        options.tileOrder = RenderOptions::TileOrder (order);
+        TileRenderer renderer (*s.scene, s.camera, options);
+        std::vector<int> sequence = renderer.TileSequence();
+
+        ASSERT_EQ (size_t (renderer.NumTiles()), sequence.size());
+
+        std::sort (sequence.begin(), sequence.end());
+        for (int i = 0; i < renderer.NumTiles(); ++i)
+            EXPECT_EQ (i, sequence[i]) << "order " << order;
+    }
+}
+
+TEST_F(RendererTest, HilbertOrderStepsToNeighbors) {
+    // 8 x 8 tiles: the curve fills the grid exactly.
+    TestScene s (64, 64);
+    RenderOptions options;
+    options.tileSize = 8;
+    options.tileOrder = RenderOptions::TileHilbert;
+    TileRenderer renderer (*s.scene, s.camera, options);
+    const std::vector<int> &sequence = renderer.TileSequence();
+
+    EXPECT_EQ (0, sequence[0]);
+    for (size_t i = 1; i < sequence.size(); ++i) {
+        int dx = sequence[i] % 8 - sequence[i - 1] % 8;
+        int dy = sequence[i] / 8 - sequence[i - 1] / 8;
+
+        EXPECT_EQ (1, abs (dx) + abs (dy)) << "step " << i;
+    }
+}
+
+TEST_F(RendererTest, MortonOrderVisitsQuadrantsInTurn) {
+    TestScene s (32, 32);
+    RenderOptions options;
+    options.tileSize = 8;
+    options.tileOrder = RenderOptions::TileMorton;
+    TileRenderer renderer (*s.scene, s.camera, options);
+    const int expected[16] = { 0, 1, 4, 5, 2, 3, 6, 7,
+                               8, 9, 12, 13, 10, 11, 14, 15 };
+
+    ASSERT_EQ (16u, renderer.TileSequence().size());
+    for (int i = 0; i < 16; ++i)
+        EXPECT_EQ (expected[i], renderer.TileSequence()[i]);
+}
+
+TEST_F(RendererTest, SpiralOrderStartsInTheMiddle) {
+    TestScene s (50, 30);
+    RenderOptions options;
+    options.tileSize = 10;
+    options.tileOrder = RenderOptions::TileSpiral;
+    TileRenderer renderer (*s.scene, s.camera, options);
+    const std::vector<int> &sequence = renderer.TileSequence();
+
+    // 5 x 3 tiles: the center one, then the ring around it.
+    EXPECT_EQ (1 * 5 + 2, sequence[0]);
+    for (int i = 1; i < 9; ++i) {
+        int dx = sequence[i] % 5 - 2, dy = sequence[i] / 5 - 1;
+
+        EXPECT_LE (abs (dx), 1);
+        EXPECT_LE (abs (dy), 1);
+    }
+}
+
+TEST_F(RendererTest, ImageDoesNotDependOnTileOrder) {
+    TestScene s (40, 24);
+    RenderOptions options;
+    options.tileSize = 6;
+    options.samplesPerPixel = 1;
+
+    options.tileOrder = RenderOptions::TileScanline;
+    Film reference (40, 24);
+    TileRenderer (*s.scene, s.camera, options).Render (&reference, NULL);
+
+    TaskScheduler scheduler (3);
+    for (int order = RenderOptions::TileSpiral;
+         order <= RenderOptions::TileMorton; ++order) {
+        options.tileOrder = RenderOptions::TileOrder (order);
+        Film film (40, 24);
+
+        TileRenderer (*s.scene, s.camera, options).Render (&film, &scheduler);
+        EXPECT_TRUE (SameImage (reference, film)) << "order " << order;
+    }
+}
+
+TEST_F(RendererTest, FilteredImageDoesNotDependOnThreads) {
+    TestScene s (45, 30);
+    RenderOptions options;
+    options.tileSize = 7;
+    options.samplesPerPixel = 2;
+    std::shared_ptr<const Filter> filter =
+            std::make_shared<GaussianFilter> (1.5f, 1.5f, 2.f);
+
+    Film reference (45, 30, filter);
+    TileRenderer (*s.scene, s.camera, options).Render (&reference, NULL);
+
+    for (int threads = 2; threads <= 4; ++threads) {
+        TaskScheduler scheduler (threads);
+        Film film (45, 30, filter);
+
+        TileRenderer (*s.scene, s.camera, options).Render (&film, &scheduler);
+        EXPECT_TRUE (SameImage (reference, film)) << threads << " threads";
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Stats_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the statistics counters.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include <string>
+#include <thread>
+
+#include "parallel.h"
+#include "Stats_Tests.h"
+
+
+static StatCounter testCounter ("Test/Counter");
+static StatMemoryCounter testMemory ("Test/Memory");
+static StatDistribution testDistribution ("Test/Distribution");
+static StatRatio testRatio ("Test/Ratio", true);
+
+
+#ifndef PB_RAY_NO_STATS
+
+TEST_F(StatsTest, CounterCounts) {
+    ++testCounter;
+    testCounter += 4;
+
+    EXPECT_EQ (5, testCounter.Value());
+}
+
+TEST_F(StatsTest, LiveAndExitedThreadsAreMerged) {
+    {
+        TaskScheduler scheduler (4);
+
+        ParallelFor (&scheduler, 0, 10000, 16, [](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i)
+                ++testCounter;
+        });
+
+        // The workers are still running.
+        EXPECT_EQ (10000, testCounter.Value());
+    }
+
+    // The workers have exited.
+    EXPECT_EQ (10000, testCounter.Value());
+
+    std::thread thread ([]() { testCounter += 5; });
+    thread.join();
+
+    EXPECT_EQ (10005, testCounter.Value());
+}
+
+TEST_F(StatsTest, DistributionTracksAverageAndRange) {
+    EXPECT_EQ (0, testDistribution.Count());
+    EXPECT_EQ (0., testDistribution.Average());
+
+    testDistribution.ReportValue (3);
+    testDistribution.ReportValue (7);
+    testDistribution.ReportValue (5);
+
+    std::thread thread ([]() {
+        testDistribution.ReportValue (1);
+        testDistribution.ReportValue (10);
+    });
+    thread.join();
+
+    EXPECT_EQ (5, testDistribution.Count());
+    EXPECT_EQ (26, testDistribution.Sum());
+    EXPECT_EQ (1, testDistribution.Min());
+    EXPECT_EQ (10, testDistribution.Max());
+    EXPECT_DOUBLE_EQ (5.2, testDistribution.Average());
+}
+
+TEST_F(StatsTest, ThreadsWithoutValuesDontWidenTheRange) {
+    testDistribution.ReportValue (4);
+    testDistribution.ReportValue (6);
+
+    // This thread's distribution slots stay zero.
+    std::thread thread ([]() { ++testCounter; });
+    thread.join();
+
+    EXPECT_EQ (4, testDistribution.Min());
+    EXPECT_EQ (6, testDistribution.Max());
+}
+
+TEST_F(StatsTest, RatioAddsBothParts) {
+    testRatio.Add (1, 4);
+    testRatio.Add (0, 4);
+
+    EXPECT_EQ (1, testRatio.Numerator());
+    EXPECT_EQ (8, testRatio.Denominator());
+}
+
+TEST_F(StatsTest, ReportGroupsByCategory) {
+    testCounter += 42;
+    testMemory += 3 * 1024 * 1024;
+    testRatio.Add (1, 4);
+    testDistribution.ReportValue (2);
+
+    std::string report = StatsReport();
+
+    EXPECT_EQ (0u, report.find ("Statistics:\n"));
+    EXPECT_NE (std::string::npos, report.find ("\n    Test\n"));
+    EXPECT_NE (std::string::npos, report.find ("Counter"));
+    EXPECT_NE (std::string::npos, report.find (" 42\n"));
+    EXPECT_NE (std::string::npos, report.find ("3.00 MB"));
+    EXPECT_NE (std::string::npos, report.find ("1 / 4 (25.00%)"));
+    EXPECT_NE (std::string::npos, report.find ("2.000 avg [2 - 2]"));
+}
+
+TEST_F(StatsTest, ClearStatsResetsEverything) {
+    testCounter += 3;
+    testDistribution.ReportValue (9);
+
+    std::thread thread ([]() { testCounter += 2; });
+    thread.join();
+
+    ClearStats();
+
+    EXPECT_EQ (0, testCounter.Value());
+    EXPECT_EQ (0, testDistribution.Count());
+
+    testDistribution.ReportValue (1);
+    EXPECT_EQ (1, testDistribution.Max());
+}
+
+#else
+
+TEST_F(StatsTest, CompiledOutStatsCountNothing) {
+    ++testCounter;
+    testDistribution.ReportValue (3);
+
+    EXPECT_EQ (0, testCounter.Value());
+    EXPECT_EQ (0, testDistribution.Count());
+    EXPECT_EQ ("", StatsReport());
+}
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: Transform_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the Transform class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "Transform_Tests.h"
+
+
+TEST_F(TransformTest, DefaultIsIdentity) {
+    Transform t;
+
+    EXPECT_TRUE (t.IsIdentity());
+    EXPECT_EQ (Point (1, 2, 3), t (Point (1, 2, 3)));
+}
+
+
+TEST_F(TransformTest, TranslateMovesPointsButNotVectors) {
+    Transform t = Translate (Vector (1, 2, 3));
+
+    EXPECT_EQ (Point (2, 3, 4), t (Point (1, 1, 1)));
+    EXPECT_EQ (Vector (1, 1, 1), t (Vector (1, 1, 1)));
+}
+
+
+TEST_F(TransformTest, ConstructorFromMatrixComputesInverse) {
+    Matrix4x4 m (2, 0, 0, 1,
+                 0, 3, 0, 2,
+                 0, 0, 4, 3,
+                 0, 0, 0, 1);
+    Transform t (m);
+    Point p (1, 2, 3);
+
+    Point q = Inverse (t)(t (p));
+
+    EXPECT_FLOAT_EQ (p.x, q.x);
+    EXPECT_FLOAT_EQ (p.y, q.y);
+    EXPECT_FLOAT_EQ (p.z, q.z);
+}
+
+
+TEST_F(TransformTest, InverseSwapsMatrices) {
+    Transform t = Scale (2, 4, 8);
+    Transform inv = Inverse (t);
+
+    EXPECT_TRUE (inv.GetMatrix() == t.GetInverseMatrix());
+    EXPECT_TRUE (inv.GetInverseMatrix() == t.GetMatrix());
+}
+
+
+TEST_F(TransformTest, NormalsStayPerpendicularUnderNonUniformScale) {
+    Transform t = Scale (1, 4, 1);
+    Vector v (1, -1, 0);
+    Normal n (1, 1, 0);
+
+    EXPECT_FLOAT_EQ (0, Dot (v, n));
+    EXPECT_NEAR (0, Dot (t (v), t (n)), 1e-6f);
+}
+
+
+TEST_F(TransformTest, RotateZQuarterTurnWorks) {
+    Vector v = RotateZ (90)(Vector (1, 0, 0));
+
+    EXPECT_NEAR (0, v.x, 1e-6f);
+    EXPECT_NEAR (1, v.y, 1e-6f);
+    EXPECT_NEAR (0, v.z, 1e-6f);
+}
+
+
+TEST_F(TransformTest, RotateAboutAxisMatchesRotateX) {
+    Transform a = Rotate (30, Vector (1, 0, 0));
+    Transform b = RotateX (30);
+    Point p (1, 2, 3);
+
+    Point pa = a (p), pb = b (p);
+
+    EXPECT_NEAR (pb.x, pa.x, 1e-5f);
+    EXPECT_NEAR (pb.y, pa.y, 1e-5f);
+    EXPECT_NEAR (pb.z, pa.z, 1e-5f);
+}
+
+
+TEST_F(TransformTest, CompositionAppliesRightToLeft) {
+    Transform t = Translate (Vector (1, 0, 0)) * Scale (2, 2, 2);
+
+    EXPECT_EQ (Point (3, 2, 2), t (Point (1, 1, 1)));
+    EXPECT_EQ (Point (1, 1, 1), Inverse (t)(Point (3, 2, 2)));
+}
+
+
+TEST_F(TransformTest, RayKeepsItsRangeAndTime) {
+    Transform t = Translate (Vector (0, 0, 5));
+    Ray r (Point (0, 0, 0), Vector (0, 1, 0), .5f, 10.f, .25f);
+
+    Ray tr = t (r);
+
+    EXPECT_EQ (Point (0, 0, 5), tr.o);
+    EXPECT_EQ (Vector (0, 1, 0), tr.d);
+    EXPECT_EQ (.5f, tr.mint);
+    EXPECT_EQ (10.f, tr.maxt);
+    EXPECT_EQ (.25f, tr.time);
+}
+
+
+TEST_F(TransformTest, RayDifferentialTransformsAuxiliaryRays) {
+    Transform t = Translate (Vector (1, 0, 0));
+    RayDifferential r (Point (0, 0, 0), Vector (0, 0, 1));
+    r.hasDifferentials = true;
+    r.rx = Ray (Point (1, 0, 0), Vector (0, 0, 1));
+    r.ry = Ray (Point (0, 1, 0), Vector (0, 0, 1));
+
+    RayDifferential tr = t (r);
+
+    EXPECT_TRUE (tr.hasDifferentials);
+    EXPECT_EQ (Point (1, 0, 0), tr.o);
+    EXPECT_EQ (Point (2, 0, 0), tr.rx.o);
+    EXPECT_EQ (Point (1, 1, 0), tr.ry.o);
+}
+
+TEST_F(TransformTest, CompactRayDifferentialMatchesRayDifferential) {
+    RayDifferential r (Point (1, 2, 3), Vector (0, 0, 1));
+    r.hasDifferentials = true;
+    r.rx = Ray (Point (1.5f, 2, 3), Vector (.125f, 0, 1));
+    r.ry = Ray (Point (1, 2.5f, 3), Vector (0, .125f, 1));
+
+    Transform transforms[2] = {
+        Translate (Vector (1, 2, 3)) * RotateY (30) * Scale (1, 2, 3),
+        // Projective: w depends on z.
+        Transform (Matrix4x4 (1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0,
+                              0, 0, .5f, 1))
+    };
+
+    for (int i = 0; i < 2; ++i) {
+        RayDifferential expected = transforms[i] (r);
+        RayDifferential tr =
+                transforms[i] (CompactRayDifferential (r)).Expand();
+
+        ASSERT_TRUE (tr.hasDifferentials);
+        EXPECT_EQ (expected.o, tr.o);
+        for (int axis = 0; axis < 3; ++axis) {
+            EXPECT_NEAR (expected.rx.o[axis], tr.rx.o[axis], 2e-3f);
+            EXPECT_NEAR (expected.ry.o[axis], tr.ry.o[axis], 2e-3f);
+            EXPECT_NEAR (expected.rx.d[axis], tr.rx.d[axis], 2e-3f);
+            EXPECT_NEAR (expected.ry.d[axis], tr.ry.d[axis], 2e-3f);
+        }
+    }
+}
+
+
+TEST_F(TransformTest, BBoxMatchesTransformedCorners) {
+    Transform t = Translate (Vector (1, 2, 3)) * RotateY (30) *
+                  Scale (1, 2, 3);
+    BBox b (Point (-1, 0, 2), Point (1, 1, 3));
+
+    BBox expected;
+    for (int i = 0; i < 8; ++i)
+        expected = Union (expected, t (Point (b[i & 1].x, b[(i >> 1) & 1].y,
+                                              b[(i >> 2) & 1].z)));
+
+    BBox tb = t (b);
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR (expected.pMin[i], tb.pMin[i], 1e-5f);
+        EXPECT_NEAR (expected.pMax[i], tb.pMax[i], 1e-5f);
+    }
+}
+
+
+TEST_F(TransformTest, EmptyBBoxStaysEmpty) {
+    BBox tb = Translate (Vector (1, 1, 1))(BBox ());
+
+    EXPECT_EQ (INFINITY, tb.pMin.x);
+    EXPECT_EQ (-INFINITY, tb.pMax.x);
+}
+
+
+TEST_F(TransformTest, BatchPointsMatchSinglePoints) {
+    Transform t = Translate (Vector (1, 2, 3)) * RotateX (45) *
+                  Scale (2, 1, .5f);
+    Point in[11], out[11];
+
+    for (int i = 0; i < 11; ++i)
+        in[i] = Point (float (i), float (2 * i) - 3, 1.f / (i + 1));
+
+    t (in, out, 11);
+
+    for (int i = 0; i < 11; ++i) {
+        Point expected = t (in[i]);
+        EXPECT_FLOAT_EQ (expected.x, out[i].x);
+        EXPECT_FLOAT_EQ (expected.y, out[i].y);
+        EXPECT_FLOAT_EQ (expected.z, out[i].z);
+    }
+}
+
+
+TEST_F(TransformTest, BatchInPlaceVectorsAndNormalsWork) {
+    Transform t = RotateZ (20) * Scale (3, 1, 2);
+    Vector v[6];
+    Normal n[6];
+
+    for (int i = 0; i < 6; ++i) {
+        v[i] = Vector (1, float (i), 2);
+        n[i] = Normal (float (i), 1, -1);
+    }
+
+    t (v, v, 6);
+    t (n, n, 6);
+
+    for (int i = 0; i < 6; ++i) {
+        Vector ev = t (Vector (1, float (i), 2));
+        Normal en = t (Normal (float (i), 1, -1));
+
+        EXPECT_FLOAT_EQ (ev.x, v[i].x);
+        EXPECT_FLOAT_EQ (ev.y, v[i].y);
+        EXPECT_FLOAT_EQ (ev.z, v[i].z);
+        EXPECT_FLOAT_EQ (en.x, n[i].x);
+        EXPECT_FLOAT_EQ (en.y, n[i].y);
+        EXPECT_FLOAT_EQ (en.z, n[i].z);
+    }
+}
+
+
+TEST_F(TransformTest, SwapsHandednessDetectsMirroring) {
+    EXPECT_TRUE (Scale (-1, 1, 1).SwapsHandedness());
+    EXPECT_FALSE (RotateY (70).SwapsHandedness());
+}
+
+
+TEST_F(TransformTest, HasScaleWorks) {
+    EXPECT_TRUE (Scale (2, 1, 1).HasScale());
+    EXPECT_FALSE (RotateX (10).HasScale());
+}
@@ -0,0 +1,449 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: TriangleMesh_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the TriangleMesh class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "TriangleMesh_Tests.h"
+
+
+// The scalar and batched intersection tests do the same arithmetic, but
+// the compiler may fuse multiply-adds differently in the two (with -mfma),
+// so results are only compared to a few ulps.
+static const float kTolerance = 1e-5f;
+
+// One triangle, (0, 0, 0) (1, 0, 0) (0, 1, 0), moved by objectToWorld.
+static std::shared_ptr<TriangleMesh> UnitTriangle (
+        const Transform &objectToWorld, const Normal *N = NULL,
+        const float *uv = NULL) {
+    const int indices[3] = { 0, 1, 2 };
+    const Point P[3] = { Point (0, 0, 0), Point (1, 0, 0), Point (0, 1, 0) };
+
+    return std::make_shared<TriangleMesh> (objectToWorld, 1, indices, 3, P,
+                                           N, uv);
+}
+
+
+TEST_F(TriangleMeshTest, VerticesAreTransformedToWorldSpace) {
+    std::shared_ptr<TriangleMesh> mesh =
+            UnitTriangle (Translate (Vector (1, 2, 3)));
+
+    EXPECT_EQ (1, mesh->NumTriangles());
+    EXPECT_EQ (3, mesh->NumVertices());
+    EXPECT_FALSE (mesh->HasNormals());
+    EXPECT_FALSE (mesh->HasUVs());
+    EXPECT_EQ (Point (1, 2, 3), mesh->P (0));
+    EXPECT_EQ (Point (2, 2, 3), mesh->P (1));
+    EXPECT_EQ (Point (1, 3, 3), mesh->P (2));
+}
+
+TEST_F(TriangleMeshTest, TrianglesShareTheMesh) {
+    std::shared_ptr<TriangleMesh> mesh = UnitTriangle (Transform());
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (mesh);
+
+    ASSERT_EQ (1u, prims.size());
+    EXPECT_EQ (2, mesh.use_count());
+
+    const Triangle *tri = dynamic_cast<const Triangle*> (prims[0].get());
+    ASSERT_TRUE (tri != NULL);
+    EXPECT_EQ (mesh.get(), tri->Mesh());
+    EXPECT_EQ (0, tri->Index());
+
+    // The triangles keep the mesh alive.
+    mesh.reset();
+    EXPECT_EQ (Point (1, 1, 0), tri->WorldBound().pMax);
+}
+
+TEST_F(TriangleMeshTest, WorldBoundWorks) {
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (UnitTriangle (Scale (2, 3, 4)));
+    BBox b = prims[0]->WorldBound();
+
+    EXPECT_EQ (Point (0, 0, 0), b.pMin);
+    EXPECT_EQ (Point (2, 3, 0), b.pMax);
+}
+
+TEST_F(TriangleMeshTest, IntersectWorks) {
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (UnitTriangle (Transform()));
+    Ray r (Point (.25f, .5f, -2.f), Vector (0, 0, 1));
+    Intersection isect;
+
+    ASSERT_TRUE (prims[0]->Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (2.f, isect.tHit);
+    EXPECT_FLOAT_EQ (2.f, r.maxt);
+    EXPECT_FLOAT_EQ (.25f, isect.p.x);
+    EXPECT_FLOAT_EQ (.5f, isect.p.y);
+    EXPECT_FLOAT_EQ (0.f, isect.p.z);
+    EXPECT_FLOAT_EQ (1.f, fabsf (isect.n.z));
+    EXPECT_EQ (prims[0].get(), isect.primitive);
+
+    // Default uvs: (0, 0), (1, 0) and (1, 1) at the vertices.
+    EXPECT_FLOAT_EQ (.75f, isect.u);
+    EXPECT_FLOAT_EQ (.5f, isect.v);
+}
+
+TEST_F(TriangleMeshTest, MissesWork) {
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (UnitTriangle (Transform()));
+    Intersection isect;
+
+    // Outside the triangle, parallel to it, behind the origin and past
+    // maxt.
+    Ray outside (Point (.75f, .75f, -1.f), Vector (0, 0, 1));
+    Ray parallel (Point (0, 0, 1.f), Vector (1, 0, 0));
+    Ray behind (Point (.25f, .25f, 1.f), Vector (0, 0, 1));
+    Ray tooShort (Point (.25f, .25f, -1.f), Vector (0, 0, 1), 0.f, .5f);
+
+    EXPECT_FALSE (prims[0]->Intersect (outside, &isect));
+    EXPECT_FALSE (prims[0]->Intersect (parallel, &isect));
+    EXPECT_FALSE (prims[0]->Intersect (behind, &isect));
+    EXPECT_FALSE (prims[0]->Intersect (tooShort, &isect));
+    EXPECT_FALSE (prims[0]->IntersectP (outside));
+    EXPECT_FLOAT_EQ (.5f, tooShort.maxt);
+}
+
+TEST_F(TriangleMeshTest, UVsAndNormalsAreInterpolated) {
+    const Normal N[3] = { Normal (0, 0, -1), Normal (0, 0, -1),
+                          Normal (0, 0, -1) };
+    const float uv[6] = { 0.f, 0.f, 2.f, 0.f, 0.f, 4.f };
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (UnitTriangle (Transform(), N, uv));
+    Ray r (Point (.25f, .5f, -2.f), Vector (0, 0, 1));
+    Intersection isect;
+
+    ASSERT_TRUE (prims[0]->Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (.5f, isect.u);
+    EXPECT_FLOAT_EQ (2.f, isect.v);
+
+    // The geometric normal is flipped to the side of the shading normals.
+    EXPECT_FLOAT_EQ (-1.f, isect.n.z);
+}
+
+TEST_F(TriangleMeshTest, BatchedIntersectionMatchesScalar) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomTriangles (20, 1);
+    PackedTriangles packed;
+    packed.Pack (prims);
+
+    // Cover full batches, partial batches and runs of several batches,
+    // starting on and off batch boundaries and running up to the end.
+    for (int start = 0; start < 8; start += 3) {
+        for (int n = 1; start + n <= int (prims.size()); ++n) {
+            std::vector<std::shared_ptr<Primitive> > run (
+                    prims.begin() + start, prims.begin() + start + n);
+            std::mt19937 rng (100 * start + n);
+
+            for (int i = 0; i < 100; ++i) {
+                Ray r = RandomRay (rng);
+                Ray rScalar = r;
+                Intersection isect, isectScalar;
+
+                bool occluded = packed.IntersectP (start, n, r);
+                bool hit = packed.Intersect (&prims[0], start, n, r, &isect);
+                bool hitScalar = BruteForceIntersect (run, rScalar,
+                                                      &isectScalar);
+
+                ASSERT_EQ (hitScalar, hit);
+                EXPECT_EQ (hit, occluded);
+                if (hit) {
+                    EXPECT_EQ (isectScalar.primitive, isect.primitive);
+                    EXPECT_NEAR (isectScalar.tHit, isect.tHit,
+                                 kTolerance * isect.tHit);
+                    EXPECT_NEAR (isectScalar.u, isect.u, kTolerance);
+                    EXPECT_NEAR (isectScalar.v, isect.v, kTolerance);
+                    EXPECT_EQ (isect.tHit, r.maxt);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TriangleMeshTest, OnlyTrianglesArePacked) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 0), 1.f));
+    PackedTriangles packed;
+    packed.Pack (prims);
+
+    EXPECT_TRUE (packed.Empty());
+    EXPECT_EQ (0u, packed.BytesUsed());
+
+    // Other primitives are skipped: the sphere is in the way but is not
+    // hit.
+    std::vector<std::shared_ptr<Primitive> > tris =
+            TriangleMesh::CreateTriangles (UnitTriangle (
+                    Translate (Vector (0, 0, 5))));
+    prims.push_back (tris[0]);
+    packed.Pack (prims);
+
+    Ray r (Point (.25f, .25f, -5.f), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_FALSE (packed.Empty());
+    ASSERT_TRUE (packed.Intersect (&prims[0], 0, 2, r, &isect));
+    EXPECT_EQ (tris[0].get(), isect.primitive);
+    EXPECT_FLOAT_EQ (10.f, isect.tHit);
+}
+
+TEST_F(TriangleMeshTest, LeavesOfTrianglesAreFlagged) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomTriangles (500, 1);
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 0), 1.f));
+    BVHAccel bvh (prims);
+    int triangleLeaves = 0, otherLeaves = 0;
+
+    for (int i = 0; i < bvh.TotalNodes(); ++i) {
+        const LinearBVHNode &node = bvh.Nodes()[i];
+
+        if (node.nPrimitives == 0) {
+            EXPECT_EQ (0, node.flags);
+        }
+        else if (node.flags & kTriangleLeaf) {
+            ++triangleLeaves;
+        }
+        else {
+            ++otherLeaves;
+        }
+    }
+
+    EXPECT_GT (triangleLeaves, 0);
+    EXPECT_EQ (1, otherLeaves);
+}
+
+TEST_F(TriangleMeshTest, BVHsOverTrianglesFindTheClosestHit) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomTriangles (3000, 2);
+    BVHAccel bvh (prims);
+    BVH4Accel bvh4 (bvh);
+    BVH8Accel bvh8 (bvh);
+    std::mt19937 rng (3);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        Ray r4 = r, r8 = r, rBrute = r;
+        Intersection isect, isect4, isect8, isectBrute;
+
+        bool hitBrute = BruteForceIntersect (prims, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, bvh.Intersect (r, &isect));
+        ASSERT_EQ (hitBrute, bvh4.Intersect (r4, &isect4));
+        ASSERT_EQ (hitBrute, bvh8.Intersect (r8, &isect8));
+        EXPECT_EQ (hitBrute, bvh4.IntersectP (Ray (r.o, r.d, 0.f)));
+
+        if (hitBrute) {
+            EXPECT_EQ (isectBrute.primitive, isect.primitive);
+            EXPECT_EQ (isectBrute.primitive, isect4.primitive);
+            EXPECT_EQ (isectBrute.primitive, isect8.primitive);
+            EXPECT_NEAR (isectBrute.tHit, isect8.tHit,
+                         kTolerance * isect8.tHit);
+        }
+    }
+}
+
+TEST_F(TriangleMeshTest, RefitFollowsDeformedVertices) {
+    std::shared_ptr<TriangleMesh> mesh = RandomTriangleMesh (2000, 20);
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (mesh);
+    BVHAccel bvh (prims);
+
+    // Bend the soup: every vertex moves by a smooth function of its place.
+    std::vector<Point> P (mesh->NumVertices());
+    for (int v = 0; v < mesh->NumVertices(); ++v) {
+        Point p = mesh->P (v);
+        P[v] = p + Vector (sinf (p.y * .3f), .5f * cosf (p.z * .2f), .1f * p.x);
+    }
+
+    mesh->SetVertices (Transform(), &P[0]);
+    bvh.Refit();
+
+    EXPECT_EQ (P[7], mesh->P (7));
+    EXPECT_FALSE (bvh.Update());
+
+    std::mt19937 rng (21);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        Ray rBrute = r;
+        Intersection isect, isectBrute;
+
+        bool hitBrute = BruteForceIntersect (prims, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, bvh.Intersect (r, &isect));
+        EXPECT_EQ (hitBrute, bvh.IntersectP (Ray (r.o, r.d, 0.f)));
+
+        if (hitBrute) {
+            EXPECT_EQ (isectBrute.primitive, isect.primitive);
+            EXPECT_NEAR (isectBrute.tHit, isect.tHit,
+                         kTolerance * isect.tHit);
+        }
+    }
+}
+
+TEST_F(TriangleMeshTest, BytesUsedCountsTheBuffers) {
+    std::shared_ptr<TriangleMesh> mesh = UnitTriangle (Transform());
+
+    EXPECT_GE (mesh->BytesUsed(), sizeof (TriangleMesh) + 3 * sizeof (int) +
+                                  9 * sizeof (float) + sizeof (Triangle));
+}
+
+TEST_F(TriangleMeshTest, RaysThroughSharedEdgesAndVerticesHit) {
+    Transform objectToWorld = Translate (Vector (-3.7f, 1.3f, 5.1f)) *
+                              Rotate (33.f, Normalize (Vector (1, 2, 3)));
+    std::shared_ptr<TriangleMesh> mesh = Grid (6, objectToWorld);
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (mesh);
+    BVHAccel bvh (prims);
+    BVH8Accel bvh8 (bvh);
+    std::mt19937 rng (4);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+
+    // Aim at the interior vertices and at points along the interior edges,
+    // including the diagonals.
+    std::vector<Point> targets;
+    for (int y = 1; y < 6; ++y) {
+        for (int x = 1; x < 6; ++x) {
+            Point v = mesh->P (y * 7 + x);
+            Point right = mesh->P (y * 7 + x + 1);
+            Point up = mesh->P ((y + 1) * 7 + x);
+            Point diagonal = mesh->P ((y + 1) * 7 + x + 1);
+
+            targets.push_back (v);
+            for (int i = 1; i < 8; ++i) {
+                float f = i / 8.f;
+
+                targets.push_back (v * (1.f - f) + right * f);
+                targets.push_back (v * (1.f - f) + up * f);
+                targets.push_back (v * (1.f - f) + diagonal * f);
+            }
+        }
+    }
+
+    int misses = 0;
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        for (int j = 0; j < 4; ++j) {
+            Point o = targets[i] + Vector (20.f * u (rng), 20.f * u (rng),
+                                           20.f * u (rng));
+            Ray r (o, targets[i] - o, 0.f);
+            Ray r8 = r, rBrute = r;
+            Intersection isect, isect8, isectBrute;
+
+            misses += !BruteForceIntersect (prims, rBrute, &isectBrute);
+            misses += !bvh.Intersect (r, &isect);
+            misses += !bvh8.Intersect (r8, &isect8);
+        }
+    }
+
+    EXPECT_EQ (0, misses);
+}
+
+TEST_F(TriangleMeshTest, ErrorBoundsContainTheExactHitPoint) {
+    // Far from the origin, where the rounding error of hit points is
+    // largest.
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (Grid (2, Translate (
+                    Vector (1000.f, -2000.f, 500.f)) * Rotate (
+                    20.f, Vector (1, 1, 0))));
+    std::mt19937 rng (5);
+    std::uniform_real_distribution<float> u (0.f, 1.f);
+    int hits = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        const std::shared_ptr<Primitive> &prim = prims[i % prims.size()];
+        BBox b = prim->WorldBound();
+        Point target = b.pMin + (b.pMax - b.pMin) * u (rng);
+        Point o (0.f, 0.f, 0.f);
+        Ray r (o, target - o, 0.f);
+        Intersection isect;
+
+        if (!prim->Intersect (r, &isect))
+            continue;
+        ++hits;
+
+        // The exact hit point: intersect the ray with the triangle's
+        // plane in double precision.
+        const Triangle *tri = static_cast<const Triangle*> (prim.get());
+        const int *vi = tri->Mesh()->Indices (tri->Index());
+        Point p0 = tri->Mesh()->P (vi[0]);
+        Vector n = Cross (tri->Mesh()->P (vi[1]) - p0,
+                          tri->Mesh()->P (vi[2]) - p0);
+        double nx = n.x, ny = n.y, nz = n.z;
+        double t = (nx * (double (p0.x) - o.x) + ny * (double (p0.y) - o.y) +
+                    nz * (double (p0.z) - o.z)) /
+                   (nx * r.d.x + ny * r.d.y + nz * r.d.z);
+
+        for (int axis = 0; axis < 3; ++axis) {
+            double exact = o[axis] + t * r.d[axis];
+
+            // The double-precision plane itself is only good to a float's
+            // rounding of the vertices; allow for that.
+            EXPECT_LE (fabs (exact - isect.p[axis]),
+                       isect.pError[axis] + 1e-9 * fabs (exact));
+        }
+    }
+
+    EXPECT_GT (hits, 500);
+}
+
+TEST_F(TriangleMeshTest, SpawnedRaysDontHitTheirOwnSurface) {
+    std::vector<std::shared_ptr<Primitive> > prims =
+            TriangleMesh::CreateTriangles (Grid (4, Translate (
+                    Vector (3000.f, 700.f, -1500.f)) * Rotate (
+                    40.f, Vector (0, 1, 1))));
+    BVH4Accel bvh (prims);
+    std::mt19937 rng (6);
+    std::uniform_real_distribution<float> u (-1.f, 1.f);
+    BBox bounds = bvh.WorldBound();
+    int hits = 0, selfHits = 0;
+
+    for (int i = 0; i < 2000; ++i) {
+        Point target = bounds.pMin + (bounds.pMax - bounds.pMin) *
+                                     ((u (rng) + 1.f) * .5f);
+        Point o = target + Vector (50.f * u (rng), 50.f * u (rng),
+                                   50.f * u (rng));
+        Ray r (o, target - o, 0.f);
+        Intersection isect;
+
+        if (!bvh.Intersect (r, &isect))
+            continue;
+        ++hits;
+
+        // Leave the (flat) surface again: reflected, straight back, and
+        // transmitted through it. None of these can hit the grid.
+        Vector d = Normalize (r.d);
+        Vector n (isect.n);
+        Vector reflected = d - n * (2.f * Dot (d, n));
+
+        selfHits += bvh.IntersectP (isect.SpawnRay (reflected));
+        selfHits += bvh.IntersectP (isect.SpawnRay (-d));
+        selfHits += bvh.IntersectP (isect.SpawnRay (d));
+
+        // A shadow ray back to the origin is unoccluded too.
+        selfHits += bvh.IntersectP (isect.SpawnRayTo (o));
+    }
+
+    EXPECT_GT (hits, 500);
+    EXPECT_EQ (0, selfHits);
+}
@@ -0,0 +1,116 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: TriangleMesh_Tests.h
+ *
+ *  Purpose: Hold the test class for the TriangleMesh class.
+ *
+ *  Creation Date: 17-10-2026
+ */
+
+#include "trianglemesh.h"
+#include "widebvh.h"
+#include "BVH_Tests.h"
+#include "gtest/gtest.h"
+
+
+// A soup of n small random triangles in the [-10, 10]^3 cube, as one mesh
+// moved by objectToWorld.
+inline std::shared_ptr<TriangleMesh> RandomTriangleMesh (
+        int n, unsigned seed, const Transform &objectToWorld = Transform()) {
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<float> pos (-10.f, 10.f);
+    std::uniform_real_distribution<float> off (-1.f, 1.f);
+    std::vector<Point> P;
+    std::vector<int> indices;
+
+    for (int i = 0; i < n; ++i) {
+        Point c (pos (rng), pos (rng), pos (rng));
+
+        for (int j = 0; j < 3; ++j) {
+            indices.push_back (int (P.size()));
+            P.push_back (c + Vector (off (rng), off (rng), off (rng)));
+        }
+    }
+
+    return std::make_shared<TriangleMesh> (objectToWorld, n, &indices[0],
+                                           int (P.size()), &P[0]);
+}
+
+inline std::vector<std::shared_ptr<Primitive> > RandomTriangles (
+        int n, unsigned seed) {
+    return TriangleMesh::CreateTriangles (RandomTriangleMesh (n, seed));
+}
+
+// An n by n grid of unit squares, two triangles each, in the z = 0 plane
+// moved by objectToWorld.
+inline std::shared_ptr<TriangleMesh> Grid (int n,
+                                           const Transform &objectToWorld) {
+    std::vector<Point> P;
+    std::vector<int> indices;
+
+    for (int y = 0; y <= n; ++y) {
+        for (int x = 0; x <= n; ++x)
+            P.push_back (Point (float (x), float (y), 0.f));
+    }
+
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            int v = y * (n + 1) + x;
+            int quad[6] = { v, v + 1, v + n + 2, v, v + n + 2, v + n + 1 };
+
+            indices.insert (indices.end(), quad, quad + 6);
+        }
+    }
+
+    return std::make_shared<TriangleMesh> (objectToWorld, 2 * n * n,
+                                           &indices[0], int (P.size()),
+                                           &P[0]);
+}
+
+class TriangleMeshTest : public ::testing::Test {
+ protected:
+  // You can remove any or all of the following functions if its body
+  // is empty.
+
+  TriangleMeshTest() {
+    // You can do set-up work for each test here.
+  }
+
+  virtual ~TriangleMeshTest() {
+    // You can do clean-up work that doesn't throw exceptions here.
+  }
+
+  // If the constructor and destructor are not enough for setting up
+  // and cleaning up each test, you can define the following methods:
+
+  virtual void SetUp() {
+    // Code here will be called immediately after the constructor (right
+    // before each test).
+  }
+
+  virtual void TearDown() {
+    // Code here will be called immediately after each test (right
+    // before the destructor).
+  }
+
+  // Objects declared here can be used by all tests in the test case for Foo.
+};
@@ -0,0 +1,164 @@
+/*
+ *	pb_ray source code
+ *	
+ *	This file is part of pb_ray.
+ *	
+ *	pb_ray is free software; you can redistribute it and/or modify
+ *	it under the terms of The MIT License (opensource.org/licenses/MIT).
+ *	
+ *	pb_ray is based the book "Physically Based Rendering" written by Matt Pharr
+ *	and Greg Humphreys. The book and its contents are *not* licensed under
+ *	The MIT License.
+ *	
+ *	pb_ray is distributed in the hope that it will be useful,
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *	GNU General Public License for more details.
+ *	
+ *	You should have received a copy of The MIT License along with this program.
+ *	If not, see <http://www.opensource.org/licenses/MIT>
+ *
+ *
+ *  File Name: WideBVH_Tests.cpp
+ *
+ *  Purpose: Contain the tests for the WideBVHAccel class.
+ *
+ *  Creation Date: 17-10-2026
+ *
+ *  Last Modified:
+ */
+
+#include "WideBVH_Tests.h"
+
+
+// Check a wide BVH over prims against brute force.
+template <int N>
+static void ExpectClosestHits (
+        const std::vector<std::shared_ptr<Primitive> > &prims,
+        const BVHBuildOptions &options, unsigned seed) {
+    WideBVHAccel<N> bvh (prims, options);
+    std::mt19937 rng (seed);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        Ray rBrute = r;
+        Intersection isect, isectBrute;
+
+        bool hit = bvh.Intersect (r, &isect);
+        bool hitBrute = BruteForceIntersect (prims, rBrute, &isectBrute);
+
+        ASSERT_EQ (hitBrute, hit);
+        if (hit) {
+            EXPECT_EQ (isectBrute.primitive, isect.primitive);
+            EXPECT_FLOAT_EQ (isectBrute.tHit, isect.tHit);
+        }
+    }
+}
+
+template <int N>
+static void ExpectIntersectPMatchesIntersect (
+        const std::vector<std::shared_ptr<Primitive> > &prims,
+        unsigned seed) {
+    WideBVHAccel<N> bvh (prims);
+    std::mt19937 rng (seed);
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+        r.maxt = 12.f;
+        Intersection isect;
+
+        bool occluded = bvh.IntersectP (r);
+
+        EXPECT_EQ (bvh.Intersect (r, &isect), occluded);
+    }
+}
+
+
+TEST_F(WideBVHTest, EmptyBVHNeverHits) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    BVH4Accel bvh4 (prims);
+    BVH8Accel bvh8 (prims);
+    Ray r (Point (0, 0, 0), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_FALSE (bvh4.Intersect (r, &isect));
+    EXPECT_FALSE (bvh8.IntersectP (r));
+    EXPECT_EQ (0, bvh4.TotalNodes());
+    EXPECT_EQ (0, bvh8.TotalNodes());
+}
+
+TEST_F(WideBVHTest, SingleLeafRootWorks) {
+    std::vector<std::shared_ptr<Primitive> > prims;
+    prims.push_back (std::make_shared<TestSphere> (Point (0, 0, 5), 1.f));
+    BVH4Accel bvh (prims);
+
+    Ray r (Point (0, 0, 0), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_EQ (1, bvh.TotalNodes());
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (4.f, isect.tHit);
+    EXPECT_EQ (prims[0].get(), isect.primitive);
+}
+
+TEST_F(WideBVHTest, BVH4FindsTheClosestHit) {
+    ExpectClosestHits<4> (RandomSpheres (2000, 1), BVHBuildOptions(), 2);
+}
+
+TEST_F(WideBVHTest, BVH8FindsTheClosestHit) {
+    ExpectClosestHits<8> (RandomSpheres (2000, 3), BVHBuildOptions(), 4);
+}
+
+TEST_F(WideBVHTest, CollapsedLBVHFindsTheClosestHit) {
+    BVHBuildOptions options;
+    options.splitMethod = BVHBuildOptions::SplitLBVH;
+
+    ExpectClosestHits<4> (RandomSpheres (2000, 5), options, 6);
+    ExpectClosestHits<8> (RandomSpheres (2000, 5), options, 6);
+}
+
+TEST_F(WideBVHTest, IntersectPMatchesIntersect) {
+    ExpectIntersectPMatchesIntersect<4> (RandomSpheres (1000, 7), 8);
+    ExpectIntersectPMatchesIntersect<8> (RandomSpheres (1000, 7), 8);
+}
+
+TEST_F(WideBVHTest, WideTreesAreSmallerAndShallower) {
+    std::vector<std::shared_ptr<Primitive> > prims = RandomSpheres (5000, 9);
+    BVHAccel binary (prims);
+    BVH4Accel bvh4 (binary);
+    BVH8Accel bvh8 (binary);
+
+    EXPECT_EQ (binary.WorldBound().pMin, bvh4.WorldBound().pMin);
+    EXPECT_EQ (binary.WorldBound().pMax, bvh8.WorldBound().pMax);
+    EXPECT_GT ((binary.TotalNodes() - 1) / 2, bvh4.TotalNodes());
+    EXPECT_GT (bvh4.TotalNodes(), bvh8.TotalNodes());
+
+    std::mt19937 rng (10);
+    long binaryVisits = 0, visits4 = 0, visits8 = 0;
+
+    for (int i = 0; i < 500; ++i) {
+        Ray r = RandomRay (rng);
+
+        binaryVisits += binary.NodeVisits (r);
+        visits4 += bvh4.NodeVisits (r);
+        visits8 += bvh8.NodeVisits (r);
+    }
+
+    EXPECT_GT (binaryVisits, visits4);
+    EXPECT_GT (visits4, visits8);
+}
+
+TEST_F(WideBVHTest, RaysInASlabPlaneStillHit) {
+    // The ray runs exactly along the shared face of two boxes' slabs.
+    std::vector<std::shared_ptr<Primitive> > prims;
+    for (int i = 0; i < 16; ++i)
+        prims.push_back (std::make_shared<TestSphere> (
+                Point (float (i % 4), float (i / 4), 10.f), .5f));
+    BVH4Accel bvh (prims);
+
+    Ray r (Point (1.f, 1.f, 0.f), Vector (0, 0, 1));
+    Intersection isect;
+
+    EXPECT_TRUE (bvh.Intersect (r, &isect));
+    EXPECT_FLOAT_EQ (9.5f, isect.tHit);
+}
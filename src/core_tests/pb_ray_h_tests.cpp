@@ -48,3 +48,57 @@ TEST_F (PBRayHTest, LerpOneOneOne) {
     EXPECT_EQ (1, m);
 }
 
+
+TEST_F (PBRayHTest, GammaBoundsNOperations) {
+    EXPECT_EQ (0.f, Gamma (0));
+    EXPECT_GT (Gamma (1), MachineEpsilon);
+    EXPECT_LT (Gamma (3), 3.01f * MachineEpsilon);
+    EXPECT_LT (Gamma (3), Gamma (5));
+}
+
+TEST_F (PBRayHTest, NextFloatUpAndDownStepOneULP) {
+    EXPECT_GT (NextFloatUp (1.f), 1.f);
+    EXPECT_LT (NextFloatDown (1.f), 1.f);
+    EXPECT_EQ (1.f, NextFloatDown (NextFloatUp (1.f)));
+    EXPECT_EQ (-1.f, NextFloatUp (NextFloatDown (-1.f)));
+    EXPECT_EQ (FloatToBits (1.f) + 1, FloatToBits (NextFloatUp (1.f)));
+}
+
+TEST_F (PBRayHTest, NextFloatHandlesZerosAndInfinity) {
+    EXPECT_GT (NextFloatUp (0.f), 0.f);
+    EXPECT_GT (NextFloatUp (-0.f), 0.f);
+    EXPECT_LT (NextFloatDown (0.f), 0.f);
+    EXPECT_LT (NextFloatDown (-0.f), 0.f);
+    EXPECT_EQ (INFINITY, NextFloatUp (INFINITY));
+    EXPECT_EQ (-INFINITY, NextFloatDown (-INFINITY));
+}
+
+TEST_F (PBRayHTest, HalfRoundTripsExactValues) {
+    const float values[] = { 0.f, 1.f, -2.f, .5f, 1024.f, 65504.f,
+                             6.103515625e-5f, 5.9604645e-8f };
+
+    for (size_t i = 0; i < sizeof (values) / sizeof (values[0]); ++i)
+        EXPECT_EQ (values[i], HalfToFloat (FloatToHalf (values[i])));
+
+    EXPECT_EQ (0x3C00, FloatToHalf (1.f));
+    EXPECT_EQ (0x8000, FloatToHalf (-0.f));
+}
+
+TEST_F (PBRayHTest, HalfRoundsToNearestEven) {
+    // Halfway between 1 and the next half rounds down to the even 1; a
+    // hair above rounds up.
+    EXPECT_EQ (0x3C00, FloatToHalf (1.f + 1.f / 2048.f));
+    EXPECT_EQ (0x3C01, FloatToHalf (NextFloatUp (1.f + 1.f / 2048.f)));
+    EXPECT_EQ (0x3C02, FloatToHalf (1.f + 3.f / 2048.f));
+
+    EXPECT_NEAR (3.14159f, HalfToFloat (FloatToHalf (3.14159f)), 1e-3f);
+}
+
+TEST_F (PBRayHTest, HalfHandlesOverflowAndNaN) {
+    EXPECT_EQ (INFINITY, HalfToFloat (FloatToHalf (1e6f)));
+    EXPECT_EQ (-INFINITY, HalfToFloat (FloatToHalf (-INFINITY)));
+    EXPECT_TRUE (isnan (HalfToFloat (FloatToHalf (NAN))));
+
+    // Too small even for a denormal.
+    EXPECT_EQ (0.f, HalfToFloat (FloatToHalf (1e-9f)));
+}
@@ -21,7 +21,8 @@
  *
  *  File Name: pb_ray.cpp
  *
- *  Purpose:
+ *  Purpose: The renderer's entry point: build the scene, render it on
+ *           every core and write the image.
  *
  *  Creation Date:
  *
@@ -29,9 +30,291 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bvh.h"
+#include "camera.h"
+#include "film.h"
+#include "filter.h"
+#include "instance.h"
+#include "parallel.h"
+#include "renderer.h"
+#include "scene.h"
+#include "stats.h"
+#include "trianglemesh.h"
+
+
+////////////////////
+// struct: Options
+//
+// Purpose:
+//      What the command line asked for.
+////////////////////
+struct Options {
+    Options() : nThreads(0), xResolution(1280), yResolution(720),
+                output("pb_ray.ppm") { }
+
+    int nThreads;           // 0: one per hardware thread
+    int xResolution, yResolution;
+    RenderOptions render;
+    std::shared_ptr<const Filter> filter;   // NULL: box
+    std::string output;
+};
+
+
+static void Usage (const char *program) {
+    fprintf (stderr,
+             "usage: %s [options]\n"
+             "  --threads N     Render on N threads (default: one per "
+             "hardware thread)\n"
+             "  --tile N        Render N x N pixel tiles (default: 32)\n"
+             "  --tile-order O  Hand tiles out in scanline, spiral, hilbert "
+             "or morton\n"
+             "                  order (default: hilbert)\n"
+             "  --spp N         Take N samples per pixel (default: 4)\n"
+             "  --res WxH       Image resolution (default: 1280x720)\n"
+             "  --filter F      Reconstruct pixels with a box, triangle or "
+             "gaussian\n"
+             "                  filter (default: box)\n"
+             "  --output FILE   Write the image to FILE; .pfm for floats, "
+             "anything else\n"
+             "                  for an 8 bit PPM (default: pb_ray.ppm)\n",
+             program);
+}
+
+
+// Read a positive integer from arg into *value.
+static bool ParsePositive (const char *arg, int *value) {
+    char *end;
+    long v = strtol (arg, &end, 10);
+
+    if (end == arg || *end != '\0' || v <= 0 || v > (1 << 24))
+        return false;
+
+    *value = int (v);
+    return true;
+}
+
+
+// Read a tile order's name from arg into *order.
+static bool ParseTileOrder (const char *arg, RenderOptions::TileOrder *order) {
+    static const struct {
+        const char *name;
+        RenderOptions::TileOrder order;
+    } orders[] = {
+        { "scanline", RenderOptions::TileScanline },
+        { "spiral", RenderOptions::TileSpiral },
+        { "hilbert", RenderOptions::TileHilbert },
+        { "morton", RenderOptions::TileMorton }
+    };
+
+    for (size_t i = 0; i < sizeof (orders) / sizeof (orders[0]); ++i) {
+        if (!strcmp (arg, orders[i].name)) {
+            *order = orders[i].order;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Make the filter named arg in *filter.
+static bool ParseFilter (const char *arg,
+                         std::shared_ptr<const Filter> *filter) {
+    if (!strcmp (arg, "box"))
+        filter->reset (new BoxFilter (.5f, .5f));
+    else if (!strcmp (arg, "triangle"))
+        filter->reset (new TriangleFilter (1.f, 1.f));
+    else if (!strcmp (arg, "gaussian"))
+        filter->reset (new GaussianFilter (1.5f, 1.5f, 2.f));
+    else
+        return false;
+
+    return true;
+}
+
+
+// Fill in options from the command line. Returns false (having said why)
+// if it doesn't make sense.
+static bool ParseCommandLine (int argc, char *argv[], Options *options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+
+        if (!strcmp (arg, "--help") || !strcmp (arg, "-h")) {
+            Usage (argv[0]);
+            exit (0);
+        }
+        else if (!strcmp (arg, "--threads"))
+            ok = ok && ParsePositive (value, &options->nThreads);
+        else if (!strcmp (arg, "--tile"))
+            ok = ok && ParsePositive (value, &options->render.tileSize);
+        else if (!strcmp (arg, "--tile-order"))
+            ok = ok && ParseTileOrder (value, &options->render.tileOrder);
+        else if (!strcmp (arg, "--spp"))
+            ok = ok && ParsePositive (value,
+                                      &options->render.samplesPerPixel);
+        else if (!strcmp (arg, "--res")) {
+            ok = ok && sscanf (value, "%dx%d", &options->xResolution,
+                               &options->yResolution) == 2 &&
+                 options->xResolution > 0 && options->yResolution > 0;
+        }
+        else if (!strcmp (arg, "--filter"))
+            ok = ok && ParseFilter (value, &options->filter);
+        else if (!strcmp (arg, "--output"))
+            ok = ok && (options->output = value, true);
+        else {
+            fprintf (stderr, "%s: unknown option '%s'\n", argv[0], arg);
+            return false;
+        }
+
+        if (!ok) {
+            fprintf (stderr, "%s: %s needs a %s\n", argv[0], arg,
+                     !strcmp (arg, "--output") ? "file name" :
+                     !strcmp (arg, "--res") ? "resolution such as 640x480" :
+                     !strcmp (arg, "--tile-order") ? "tile order" :
+                     !strcmp (arg, "--filter") ? "filter" :
+                                             "positive number");
+            return false;
+        }
+
+        ++i;
+    }
+
+    return true;
+}
+
+
+// A unit sphere of nTheta x nPhi quads, split into triangles.
+static std::shared_ptr<TriangleMesh> MakeSphereMesh (int nTheta, int nPhi) {
+    std::vector<Point> P;
+    std::vector<Normal> N;
+    std::vector<int> indices;
+
+    for (int i = 0; i <= nTheta; ++i) {
+        float theta = float (M_PI) * i / nTheta;
+
+        for (int j = 0; j <= nPhi; ++j) {
+            float phi = 2.f * float (M_PI) * j / nPhi;
+            Point p (sinf (theta) * cosf (phi), cosf (theta),
+                     sinf (theta) * sinf (phi));
+
+            P.push_back (p);
+            N.push_back (Normal (p.x, p.y, p.z));
+        }
+    }
+
+    for (int i = 0; i < nTheta; ++i) {
+        for (int j = 0; j < nPhi; ++j) {
+            int v00 = i * (nPhi + 1) + j, v01 = v00 + 1;
+            int v10 = v00 + nPhi + 1, v11 = v10 + 1;
+            int quad[6] = { v00, v10, v11, v00, v11, v01 };
+
+            indices.insert (indices.end(), quad, quad + 6);
+        }
+    }
+
+    return std::make_shared<TriangleMesh> (
+            Transform(), int (indices.size() / 3), &indices[0],
+            int (P.size()), &P[0], &N[0]);
+}
+
+
+////////////////////
+// Function:
+//      MakeScene
+//
+// Purpose:
+//      Build the scene pb_ray renders until it can read scene files: a
+//      ground plane with a grid of instances of one finely tessellated
+//      sphere on it, lit by a point light. The sphere's BVH is shared by
+//      every instance, under a BVH of instances.
+////////////////////
+static std::shared_ptr<Scene> MakeScene (TaskScheduler *scheduler) {
+    BVHBuildOptions buildOptions;
+    buildOptions.scheduler = scheduler;
+
+    std::shared_ptr<Primitive> sphere = std::make_shared<BVHAccel> (
+            TriangleMesh::CreateTriangles (MakeSphereMesh (256, 512)),
+            buildOptions);
+
+    std::vector<std::shared_ptr<Primitive> > prims;
+    const int nGrid = 24;
+
+    for (int i = 0; i < nGrid; ++i) {
+        for (int j = 0; j < nGrid; ++j) {
+            float r = .3f + .2f * ((i * 7 + j * 13) % 5) / 4.f;
+            Transform objectToWorld =
+                    Translate (Vector (2.f * i - nGrid, r, 2.f * j - nGrid)) *
+                    Scale (r, r, r);
+
+            prims.push_back (std::make_shared<TransformedPrimitive> (
+                    sphere, objectToWorld));
+        }
+    }
+
+    const int groundIndices[6] = { 0, 1, 2, 0, 2, 3 };
+    const Point groundP[4] = { Point (-100, 0, -100), Point (100, 0, -100),
+                               Point (100, 0, 100), Point (-100, 0, 100) };
+    std::vector<std::shared_ptr<Primitive> > ground =
+            TriangleMesh::CreateTriangles (std::make_shared<TriangleMesh> (
+                    Transform(), 2, groundIndices, 4, groundP));
+
+    prims.insert (prims.end(), ground.begin(), ground.end());
+
+    return std::make_shared<Scene> (
+            std::make_shared<BVHAccel> (prims, buildOptions),
+            PointLight (Point (10, 30, -20), 900.f, 850.f, 800.f));
+}
+
 
 int main (int argc, char *argv[])
 {
-    printf ("Welcome to pb_ray!\n");
+    Options options;
+
+    if (!ParseCommandLine (argc, argv, &options)) {
+        Usage (argv[0]);
+        return 1;
+    }
+
+    TaskScheduler &scheduler = *TaskScheduler::Shared (options.nThreads);
+    std::shared_ptr<Scene> scene = MakeScene (&scheduler);
+
+    PerspectiveCamera camera (Inverse (LookAt (Point (-18, 9, -30),
+                                               Point (0, 0, 0),
+                                               Vector (0, 1, 0))),
+                              45.f, options.xResolution,
+                              options.yResolution);
+    Film film (options.xResolution, options.yResolution, options.filter);
+    TileRenderer renderer (*scene, camera, options.render);
+
+    printf ("Rendering %dx%d, %d spp, in %d tiles on %d threads\n",
+            options.xResolution, options.yResolution,
+            options.render.samplesPerPixel, renderer.NumTiles(),
+            scheduler.NumThreads());
+
+    RenderStats stats = renderer.Render (&film, &scheduler);
+
+    printf ("Rendered in %.3f s: %.2f M camera rays/s, "
+            "%.2f M shadow rays/s\n", stats.seconds,
+            stats.cameraRays / stats.seconds * 1e-6,
+            stats.shadowRays / stats.seconds * 1e-6);
+
+    if (!film.WriteImage (options.output)) {
+        fprintf (stderr, "%s: couldn't write %s\n", argv[0],
+                 options.output.c_str());
+        return 1;
+    }
+
+    // Empty when the statistics are compiled out.
+    PrintStats (stdout);
+
     return 0;
 }